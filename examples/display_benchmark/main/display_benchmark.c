@@ -0,0 +1,207 @@
+/*
+ * Display benchmark for the LilyGo T4 S3 BSP
+ *
+ * Runs the BSP microbenchmarks, then the LVGL benchmark scenes. Every result is logged as one
+ * "BENCH,<name>,<value>,<unit>" line, and LVGL logs its summary table at the end. Capture the log and feed it to
+ * tools/bsp_benchmark_readme.py to get JSON and to regenerate the table in the BSP README.
+ */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "driver/i2c_master.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "bsp/esp-bsp.h"
+#include "bsp/display.h"
+#include "bsp/touch.h"
+#include "lvgl.h"
+#include "lv_demos.h"
+
+static const char* TAG = "benchmark";
+
+// Frames pushed for each flush area size
+#define BENCH_FLUSH_FRAMES      (60)
+// Touch samples are collected this long, touch the screen meanwhile to get latency figures
+#define BENCH_TOUCH_MS          (3000)
+#define BENCH_I2C_ROUNDS        (200)
+// I2C address of the CST226SE touch controller
+#define BENCH_I2C_ADDR          (0x5A)
+#define BENCH_SPIFFS_FILE       BSP_SPIFFS_MOUNT_POINT "/bench.bin"
+#define BENCH_SPIFFS_BYTES      (256 * 1024)
+#define BENCH_SPIFFS_CHUNK      (4096)
+
+static void bench_report(const char* name, double value, const char* unit) {
+    ESP_LOGI(TAG, "BENCH,%s,%.2f,%s", name, value, unit);
+}
+
+static void bench_flush(lv_display_t* disp) {
+    static const int32_t sides[] = {16, 32, 64, 128, 256, 600};
+    char name[32];
+
+    bsp_display_lock(0);
+    lv_obj_t* scr = lv_obj_create(NULL);
+    lv_obj_remove_style_all(scr);
+    lv_obj_set_style_bg_color(scr, lv_color_black(), 0);
+    lv_obj_set_style_bg_opa(scr, LV_OPA_COVER, 0);
+    lv_obj_t* box = lv_obj_create(scr);
+    lv_obj_remove_style_all(box);
+    lv_obj_set_style_bg_opa(box, LV_OPA_COVER, 0);
+    lv_screen_load(scr);
+    lv_refr_now(disp);
+    bsp_display_unlock();
+
+    for (size_t s = 0; s < sizeof(sides) / sizeof(sides[0]); s++) {
+        // The last size is the whole screen
+        const int32_t w = LV_MIN(sides[s], lv_display_get_horizontal_resolution(disp));
+        const int32_t h = LV_MIN(sides[s], lv_display_get_vertical_resolution(disp));
+
+        bsp_display_lock(0);
+        lv_obj_set_size(box, w, h);
+        lv_refr_now(disp);
+        bsp_display_unlock();
+
+        bsp_display_flush_stats_t before;
+        bsp_display_flush_stats_t after;
+        bsp_display_get_flush_stats(&before);
+#if CONFIG_BSP_LCD_SIMULATED
+        bsp_display_sim_reset_stats();
+#endif
+        const int64_t start_us = esp_timer_get_time();
+        for (int i = 0; i < BENCH_FLUSH_FRAMES; i++) {
+            bsp_display_lock(0);
+            lv_obj_set_style_bg_color(box, (i & 1) ? lv_palette_main(LV_PALETTE_RED) :
+                                      lv_palette_main(LV_PALETTE_BLUE), 0);
+            lv_refr_now(disp);
+            bsp_display_unlock();
+        }
+        const int64_t elapsed_us = esp_timer_get_time() - start_us;
+        bsp_display_get_flush_stats(&after);
+
+        snprintf(name, sizeof(name), "flush %" PRId32 "x%" PRId32, w, h);
+        bench_report(name, (double)(after.total_bytes - before.total_bytes) / (double)elapsed_us, "MB/s");
+        snprintf(name, sizeof(name), "flush %" PRId32 "x%" PRId32 " frame", w, h);
+        bench_report(name, (double)elapsed_us / BENCH_FLUSH_FRAMES, "us");
+#if CONFIG_BSP_LCD_SIMULATED
+        // What the frames would take on the real QSPI link
+        bsp_display_sim_stats_t sim;
+        if (bsp_display_sim_get_stats(&sim) == ESP_OK) {
+            snprintf(name, sizeof(name), "flush %" PRId32 "x%" PRId32 " wire", w, h);
+            bench_report(name, (double)sim.wire_ns / 1000.0 / BENCH_FLUSH_FRAMES, "us");
+        }
+#endif
+    }
+
+    bsp_display_lock(0);
+    lv_obj_delete(box);
+    bsp_display_unlock();
+}
+
+static void bench_touch(void) {
+    bsp_touch_stats_t stats;
+
+    ESP_LOGI(TAG, "Touch the screen during the next %d ms for latency figures", BENCH_TOUCH_MS);
+    vTaskDelay(pdMS_TO_TICKS(BENCH_TOUCH_MS));
+    if (bsp_touch_get_stats(&stats) != ESP_OK) {
+        ESP_LOGW(TAG, "No touch controller, skipped");
+        return;
+    }
+
+    bench_report("touch reads", stats.i2c_reads_per_s, "1/s");
+    if (stats.samples == 0) {
+        ESP_LOGW(TAG, "No touch samples, latency skipped");
+        return;
+    }
+    bench_report("touch latency avg", stats.latency_avg_us, "us");
+    bench_report("touch latency max", stats.latency_max_us, "us");
+}
+
+static esp_err_t bench_i2c_probe(void* ctx) {
+    (void)ctx;
+    return i2c_master_probe(bsp_i2c_get_handle(), BENCH_I2C_ADDR, 50);
+}
+
+static void bench_i2c(void) {
+    int64_t total_us = 0;
+    int64_t max_us = 0;
+
+    // Through the bus manager, so queueing and the task switch are part of the round trip
+    for (int i = 0; i < BENCH_I2C_ROUNDS; i++) {
+        const int64_t start_us = esp_timer_get_time();
+        const esp_err_t ret = bsp_i2c_exec(BSP_I2C_PRIO_NORMAL, bench_i2c_probe, NULL);
+        const int64_t round_us = esp_timer_get_time() - start_us;
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "I2C probe failed (%s), skipped", esp_err_to_name(ret));
+            return;
+        }
+        total_us += round_us;
+        max_us = round_us > max_us ? round_us : max_us;
+    }
+
+    bench_report("i2c round trip avg", (double)total_us / BENCH_I2C_ROUNDS, "us");
+    bench_report("i2c round trip max", (double)max_us, "us");
+}
+
+static void bench_spiffs(void) {
+    static uint8_t chunk[BENCH_SPIFFS_CHUNK];
+
+    if (bsp_spiffs_mount() != ESP_OK) {
+        ESP_LOGW(TAG, "No SPIFFS partition, skipped");
+        return;
+    }
+    for (size_t i = 0; i < sizeof(chunk); i++) {
+        chunk[i] = (uint8_t)i;
+    }
+
+    FILE* f = fopen(BENCH_SPIFFS_FILE, "wb");
+    if (f == NULL) {
+        ESP_LOGW(TAG, "Cannot create %s, skipped", BENCH_SPIFFS_FILE);
+        bsp_spiffs_unmount();
+        return;
+    }
+    int64_t start_us = esp_timer_get_time();
+    for (size_t done = 0; done < BENCH_SPIFFS_BYTES; done += sizeof(chunk)) {
+        fwrite(chunk, 1, sizeof(chunk), f);
+    }
+    fclose(f);
+    const int64_t write_us = esp_timer_get_time() - start_us;
+
+    size_t read = 0;
+    f = fopen(BENCH_SPIFFS_FILE, "rb");
+    start_us = esp_timer_get_time();
+    while (f && fread(chunk, 1, sizeof(chunk), f) == sizeof(chunk)) {
+        read += sizeof(chunk);
+    }
+    const int64_t read_us = esp_timer_get_time() - start_us;
+    if (f) {
+        fclose(f);
+    }
+    remove(BENCH_SPIFFS_FILE);
+    bsp_spiffs_unmount();
+
+    bench_report("spiffs write", (double)BENCH_SPIFFS_BYTES / (double)write_us, "MB/s");
+    bench_report("spiffs read", (double)read / (double)read_us, "MB/s");
+}
+
+void app_main(void) {
+    lv_display_t* disp = bsp_display_start();
+    if (disp == NULL) {
+        ESP_LOGE(TAG, "Display start failed");
+        return;
+    }
+    bsp_display_backlight_on();
+    bench_report("pclk", bsp_display_get_pclk() / 1e6, "MHz");
+
+    bench_flush(disp);
+    bench_touch();
+    bench_i2c();
+    bench_spiffs();
+
+    // LVGL logs its summary table when the last scene is done
+    bsp_display_lock(0);
+    lv_demo_benchmark();
+    bsp_display_unlock();
+}
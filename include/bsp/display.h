@@ -9,6 +9,7 @@
  */
 
 #pragma once
+#include <stdbool.h>
 #include "esp_lcd_types.h"
 #include "esp_err.h"
 
@@ -35,7 +36,7 @@
 
 #else
 #define BSP_LCD_H_RES                 (BSP_LCD_H_HW_RES)
-#define BSP_LCD_V_RES                 (BSP_LCD_H_RES)
+#define BSP_LCD_V_RES                 (BSP_LCD_V_HW_RES)
 #define BSP_LCD_SWAP_XY               (0)
 #define BSP_LCD_MIRROR_X              (0)
 #define BSP_LCD_MIRROR_Y              (0)
@@ -51,7 +52,9 @@ extern "C" {
  *
  */
 typedef struct { // NOLINT(*-use-using)
-    int max_transfer_sz; /*!< Maximum transfer size, in bytes. */
+    int max_transfer_sz;        /*!< Largest single flush (usually the draw buffer), in bytes. The SPI bus is sized so
+                                     that it is sent in the fewest equally sized transactions. */
+    size_t trans_queue_depth;   /*!< Panel IO transaction queue depth, 0 selects CONFIG_BSP_LCD_TRANS_QUEUE_DEPTH */
 } bsp_display_config_t;
 
 /**
@@ -104,6 +107,21 @@ esp_err_t bsp_display_brightness_init(void);
  */
 esp_err_t bsp_display_brightness_set(int brightness_percent);
 
+/**
+ * @brief Fade display's brightness without blocking
+ *
+ * Returns right away, the brightness then changes in steps that look even to the eye. While LVGL is flushing,
+ * each step is sent between two windows. A new fade or bsp_display_brightness_set() replaces a running fade.
+ *
+ * @param[in] brightness_percent Target brightness in [%]
+ * @param[in] duration_ms        Fade duration in [ms], 0 behaves like bsp_display_brightness_set()
+ * @return
+ *      - ESP_OK                On success
+ *      - ESP_ERR_INVALID_ARG   Parameter error
+ *      - ESP_ERR_NO_MEM        No memory for the fade timer
+ */
+esp_err_t bsp_display_brightness_fade(int brightness_percent, uint32_t duration_ms);
+
 /**
  * @brief Set the display to full brightness
  *
@@ -126,6 +144,113 @@ esp_err_t bsp_display_backlight_on(void);
  */
 esp_err_t bsp_display_backlight_off(void);
 
+/**
+ * @brief Change the QSPI pixel clock of the display at runtime
+ *
+ * The panel IO is recreated at the new clock once all queued transfers have finished. Panel and IO handles
+ * returned by bsp_display_new() stay valid and the panel keeps its contents.
+ *
+ * @param[in] pclk_hz New clock in [Hz]
+ * @return
+ *      - ESP_OK                On success
+ *      - ESP_ERR_INVALID_STATE Display not initialized
+ *      - Else                  The clock was rejected by the SPI driver and the previous clock is restored. If
+ *                              the previous clock cannot be restored either, transfers to the panel fail with
+ *                              ESP_ERR_INVALID_STATE until a later call succeeds.
+ */
+esp_err_t bsp_display_set_pclk(uint32_t pclk_hz);
+
+/**
+ * @brief Get the current QSPI pixel clock of the display
+ *
+ * @return Clock in [Hz], 0 if the display is not initialized
+ */
+uint32_t bsp_display_get_pclk(void);
+
+/**
+ * @brief Result of one clock in bsp_display_pclk_sweep()
+ */
+typedef struct {
+    uint32_t pclk_hz;    /*!< Tested clock in [Hz] */
+    bool verified;       /*!< The panel ID could be read back, so stable reflects a register check */
+    bool stable;         /*!< No transfer errors and, if verified, the panel ID read back unchanged */
+    float mbytes_per_s;  /*!< Achieved pixel throughput in [MB/s] */
+    float fps;           /*!< Achieved full-screen frames per second */
+} bsp_display_pclk_result_t;
+
+/**
+ * @brief Measure the display link at a list of pixel clocks
+ *
+ * For each clock, full-screen test patterns are pushed and timed. The panel ID is then read back and compared
+ * with the one read at the current clock. The RM690B0 cannot read back pixel memory over QSPI, so this
+ * register check is the best available integrity test. The clock in use before the sweep is restored
+ * afterwards. Under LVGL, rendering is paused during the sweep and the screen is redrawn afterwards.
+ *
+ * @param[in]  pclk_hz Clocks to test in [Hz]
+ * @param[in]  count   Number of clocks
+ * @param[in]  frames  Full-screen frames pushed per clock
+ * @param[out] results One result per clock
+ * @return
+ *      - ESP_OK                On success
+ *      - ESP_ERR_INVALID_ARG   Parameter error
+ *      - ESP_ERR_INVALID_STATE Display not initialized
+ *      - ESP_ERR_NO_MEM        No memory for the test pattern
+ *      - Else                  The original clock could not be restored, see bsp_display_set_pclk()
+ */
+esp_err_t bsp_display_pclk_sweep(const uint32_t* pclk_hz, size_t count, uint32_t frames,
+                                 bsp_display_pclk_result_t* results);
+
+/**
+ * @brief Traffic seen by the simulated panel (CONFIG_BSP_LCD_SIMULATED)
+ */
+typedef struct {
+    uint32_t commands;      /*!< Command and parameter transactions, including CASET/RASET of every window */
+    uint32_t pixel_writes;  /*!< Pixel data transactions */
+    uint64_t pixel_bytes;   /*!< Pixel data bytes */
+    uint64_t wire_ns;       /*!< Time all transactions would take on the QSPI link at the current clock in [ns] */
+} bsp_display_sim_stats_t;
+
+/**
+ * @brief Get the traffic counters of the simulated panel
+ *
+ * wire_ns divided by the number of frames drawn gives the frame time the real link would need, so flush
+ * pipeline changes can be compared without a panel attached.
+ *
+ * @param[out] stats Counters since the last reset
+ * @return
+ *      - ESP_OK                On success
+ *      - ESP_ERR_INVALID_ARG   Parameter error
+ *      - ESP_ERR_INVALID_STATE The simulated panel is not in use
+ */
+esp_err_t bsp_display_sim_get_stats(bsp_display_sim_stats_t* stats);
+
+/**
+ * @brief Clear the traffic counters of the simulated panel
+ */
+void bsp_display_sim_reset_stats(void);
+
+/**
+ * @brief Get the memory of the simulated panel
+ *
+ * Pixels are stored row by row in the native 450x600 orientation, as sent on the wire (RGB565 big-endian
+ * or RGB888).
+ *
+ * @param[out] bits_per_pixel Pixel size, 16 or 24, may be NULL
+ * @return Framebuffer, NULL if the simulated panel is not in use
+ */
+const uint8_t* bsp_display_sim_get_framebuffer(uint32_t* bits_per_pixel);
+
+/**
+ * @brief Get the memory row the simulated panel shows on a screen row
+ *
+ * Panel memory and screen only differ while hardware scrolling moves the scroll area
+ * (bsp_display_hw_scroll_attach()).
+ *
+ * @param[in] row Screen row in the native orientation
+ * @return Row of the framebuffer returned by bsp_display_sim_get_framebuffer()
+ */
+uint32_t bsp_display_sim_get_screen_row(uint32_t row);
+
 #ifdef __cplusplus
 }
 #endif
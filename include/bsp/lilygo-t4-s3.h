@@ -76,7 +76,7 @@
 #define BSP_LCD_DATA1         (GPIO_NUM_10)
 #define BSP_LCD_DATA2         (GPIO_NUM_16)
 #define BSP_LCD_DATA3         (GPIO_NUM_12)
-#define BSP_LCD_TOUCH_INT     (GPIO_NUM_NC) // LiliGo docs say it's GPIO_NUM_8, but I could not get that to work on my T4 S3
+#define BSP_LCD_TOUCH_INT     (CONFIG_BSP_TOUCH_INT_GPIO) // LilyGo docs say it's GPIO_NUM_8, not confirmed to work on every T4 S3
 #define BSP_LCD_TOUCH_RST     (GPIO_NUM_17)
 
 /** @} */ // end of display
@@ -129,6 +129,164 @@ esp_err_t bsp_i2c_deinit(void);
  */
 i2c_master_bus_handle_t bsp_i2c_get_handle(void);
 
+/**************************************************************************************************
+ *
+ * I2C bus manager
+ *
+ * Devices added with bsp_i2c_add_device() share the bus through a BSP task. Jobs are served by priority,
+ * so touch reads never wait behind sensor traffic, and completion is reported through a callback. Queued
+ * register reads of the same device that touch or overlap are combined into one transaction.
+ **************************************************************************************************/
+
+/**
+ * @brief I2C job priority, lower values are served first
+ */
+typedef enum {
+    BSP_I2C_PRIO_TOUCH = 0,     /*!< Touch controller */
+    BSP_I2C_PRIO_HIGH,
+    BSP_I2C_PRIO_NORMAL,
+    BSP_I2C_PRIO_LOW,
+} bsp_i2c_priority_t;
+
+/**
+ * @brief I2C device configuration
+ */
+typedef struct {
+    uint16_t address;               /*!< 7-bit device address */
+    uint32_t scl_speed_hz;          /*!< SCL clock in [Hz] */
+    bsp_i2c_priority_t priority;    /*!< Priority of all jobs of this device */
+    bool batch_reads;               /*!< The device auto-increments the register address while reading, so
+                                         adjacent register reads may be combined */
+} bsp_i2c_device_config_t;
+
+typedef struct bsp_i2c_device* bsp_i2c_device_handle_t;
+
+/**
+ * @brief Job completion callback, called from the bus manager task
+ *
+ * It may queue more jobs, but must not call the blocking bsp_i2c_read_reg(), bsp_i2c_write() or bsp_i2c_exec(),
+ * which return ESP_ERR_INVALID_STATE there.
+ *
+ * @param result   ESP_OK, or the error returned by the I2C driver
+ * @param user_ctx User context passed on submit
+ */
+typedef void (*bsp_i2c_done_cb_t)(esp_err_t result, void* user_ctx);
+
+/**
+ * @brief Function run by the bus manager task with exclusive access to the bus
+ *
+ * Like a completion callback, it must not call the blocking bsp_i2c_* functions.
+ */
+typedef esp_err_t (*bsp_i2c_exec_fn_t)(void* ctx);
+
+/**
+ * @brief I2C bus statistics
+ */
+typedef struct {
+    uint32_t jobs;              /*!< Jobs completed */
+    uint32_t transactions;      /*!< Bus transactions, a combined read counts once */
+    uint32_t batched;           /*!< Jobs served by the combined read of another job */
+    uint32_t errors;            /*!< Transactions that failed */
+    uint64_t bytes;             /*!< Register and data bytes transferred, excluding function jobs */
+    uint64_t busy_us;           /*!< Time the bus was in use, in [us] */
+    float utilisation;          /*!< Fraction of time the bus was in use, over the last second or longer */
+    uint32_t max_wait_us;       /*!< Longest time a job waited in the queue, in [us] */
+    uint32_t max_depth;         /*!< Most jobs queued at once */
+} bsp_i2c_stats_t;
+
+/**
+ * @brief Add a device to the BSP I2C bus
+ *
+ * @param[in]  config  Device configuration
+ * @param[out] ret_dev Device handle
+ * @return
+ *      - ESP_OK              On success
+ *      - ESP_ERR_INVALID_ARG Parameter error
+ *      - ESP_ERR_NO_MEM      No memory for the device or the bus manager task
+ */
+esp_err_t bsp_i2c_add_device(const bsp_i2c_device_config_t* config, bsp_i2c_device_handle_t* ret_dev);
+
+/**
+ * @brief Queue a register read
+ *
+ * @param[in]  dev      Device
+ * @param[in]  reg      First register
+ * @param[out] data     Receive buffer, must stay valid until the callback
+ * @param[in]  len      Bytes to read
+ * @param[in]  cb       Completion callback, may be NULL
+ * @param[in]  user_ctx Passed to the callback
+ * @return
+ *      - ESP_OK              Job queued
+ *      - ESP_ERR_INVALID_ARG Parameter error
+ *      - ESP_ERR_NO_MEM      Too many jobs queued
+ */
+esp_err_t bsp_i2c_read_reg_async(bsp_i2c_device_handle_t dev, uint8_t reg, uint8_t* data, size_t len,
+                                 bsp_i2c_done_cb_t cb, void* user_ctx);
+
+/**
+ * @brief Queue a write
+ *
+ * @param[in] dev      Device
+ * @param[in] data     Bytes to write, usually a register address followed by values. Must stay valid until
+ *                     the callback
+ * @param[in] len      Bytes to write
+ * @param[in] cb       Completion callback, may be NULL
+ * @param[in] user_ctx Passed to the callback
+ * @return
+ *      - ESP_OK              Job queued
+ *      - ESP_ERR_INVALID_ARG Parameter error
+ *      - ESP_ERR_NO_MEM      Too many jobs queued
+ */
+esp_err_t bsp_i2c_write_async(bsp_i2c_device_handle_t dev, const uint8_t* data, size_t len, bsp_i2c_done_cb_t cb,
+                              void* user_ctx);
+
+/**
+ * @brief Read registers and wait for the result
+ *
+ * @return
+ *      - ESP_OK                On success
+ *      - ESP_ERR_INVALID_ARG   Parameter error
+ *      - ESP_ERR_INVALID_STATE Called from a completion callback or function job, on the bus manager task
+ *      - Otherwise the error returned by the I2C driver
+ */
+esp_err_t bsp_i2c_read_reg(bsp_i2c_device_handle_t dev, uint8_t reg, uint8_t* data, size_t len);
+
+/**
+ * @brief Write and wait for the result
+ *
+ * @return
+ *      - ESP_OK                On success
+ *      - ESP_ERR_INVALID_ARG   Parameter error
+ *      - ESP_ERR_INVALID_STATE Called from a completion callback or function job, on the bus manager task
+ *      - Otherwise the error returned by the I2C driver
+ */
+esp_err_t bsp_i2c_write(bsp_i2c_device_handle_t dev, const uint8_t* data, size_t len);
+
+/**
+ * @brief Run a function with exclusive access to the bus and wait for its result
+ *
+ * For drivers that talk to the bus through their own I2C handles, such as esp_lcd_touch. The function is
+ * scheduled like any other job of the given priority. Queued reads of any device wait for it rather than being
+ * batched past it.
+ *
+ * @param[in] priority Job priority
+ * @param[in] fn       Function to run from the bus manager task
+ * @param[in] ctx      Passed to fn
+ * @return Result of fn, ESP_ERR_NO_MEM if the bus manager could not be started, or ESP_ERR_INVALID_STATE when
+ *         called from a completion callback or function job
+ */
+esp_err_t bsp_i2c_exec(bsp_i2c_priority_t priority, bsp_i2c_exec_fn_t fn, void* ctx);
+
+/**
+ * @brief Get I2C bus statistics
+ *
+ * @param[out] stats Statistics snapshot
+ * @return
+ *      - ESP_OK              On success
+ *      - ESP_ERR_INVALID_ARG stats is NULL
+ */
+esp_err_t bsp_i2c_get_stats(bsp_i2c_stats_t* stats);
+
 /** @} */ // end of i2c
 
 /** @defgroup g02_storage SD Card and SPIFFS
@@ -174,6 +332,185 @@ esp_err_t bsp_spiffs_mount(void);
  */
 esp_err_t bsp_spiffs_unmount(void);
 
+/**************************************************************************************************
+ *
+ * Flash assets
+ *
+ * A raw data partition (BSP_FLASH_ASSETS_PARTITION_LABEL) built with tools/bsp_flash_assets.py, mapped into
+ * the address space as a whole. Images and fonts are used in place from flash, so looking them up costs no
+ * heap and no copy. Lookups are a binary search over an index sorted at build time.
+ * \code{.c}
+ * static lv_image_dsc_t logo;
+ * bsp_flash_assets_mount();
+ * bsp_flash_assets_get_image("logo", &logo);
+ * lv_image_set_src(img, &logo);
+ * \endcode
+ **************************************************************************************************/
+
+/**
+ * @brief Map the asset partition and validate its index
+ *
+ * @return
+ *      - ESP_OK                On success
+ *      - ESP_ERR_INVALID_STATE Already mounted
+ *      - ESP_ERR_NOT_FOUND     No data partition with the configured label
+ *      - ESP_ERR_INVALID_CRC   The partition holds no valid asset index
+ *      - other error codes from esp_partition_mmap()
+ */
+esp_err_t bsp_flash_assets_mount(void);
+
+/**
+ * @brief Unmap the asset partition
+ *
+ * Images and fonts taken from it must no longer be in use.
+ *
+ * @return
+ *      - ESP_OK                On success
+ *      - ESP_ERR_INVALID_STATE Not mounted
+ */
+esp_err_t bsp_flash_assets_unmount(void);
+
+/**
+ * @brief Get the bytes of any asset
+ *
+ * @param[in]  name Asset name
+ * @param[out] data Start of the asset in mapped flash
+ * @param[out] size Size in bytes
+ * @return
+ *      - ESP_OK                On success
+ *      - ESP_ERR_INVALID_ARG   Parameter error
+ *      - ESP_ERR_INVALID_STATE Not mounted
+ *      - ESP_ERR_NOT_FOUND     No asset of that name
+ */
+esp_err_t bsp_flash_assets_get_data(const char* name, const void** data, size_t* size);
+
+#if (BSP_CONFIG_NO_GRAPHIC_LIB == 0)
+/**
+ * @brief Describe an image asset for LVGL
+ *
+ * The pixels stay in mapped flash. dsc is filled in and must outlive every widget using it.
+ *
+ * @param[in]  name Asset name
+ * @param[out] dsc  Image descriptor to pass to lv_image_set_src()
+ * @return
+ *      - ESP_OK                On success
+ *      - ESP_ERR_INVALID_ARG   Parameter error, or the asset is not an image
+ *      - ESP_ERR_INVALID_STATE Not mounted
+ *      - ESP_ERR_NOT_FOUND     No asset of that name
+ */
+esp_err_t bsp_flash_assets_get_image(const char* name, lv_image_dsc_t* dsc);
+
+/**
+ * @brief Create an LVGL font from a TrueType asset
+ *
+ * Needs LV_USE_TINY_TTF. The font file is read in place from flash, but unlike images this is not free of
+ * heap: the font object and its glyph cache are allocated, and glyphs are rasterised on first use. Free it
+ * with lv_tiny_ttf_destroy().
+ *
+ * @param[in] name    Asset name
+ * @param[in] size_px Font size in pixels
+ * @return Font, or NULL on error
+ */
+lv_font_t* bsp_flash_assets_create_font(const char* name, int32_t size_px);
+
+/**************************************************************************************************
+ *
+ * Image assets
+ *
+ * Images packed with tools/bsp_assets_pack.py into one blob, usually stored on SPIFFS. Each image is split
+ * into compressed strips of full-width lines (tiles). LVGL decodes only the tiles it draws, and decoded tiles
+ * are kept in a small LRU cache in PSRAM. Show an image with:
+ * \code{.c}
+ * bsp_assets_open(BSP_SPIFFS_MOUNT_POINT "/assets.bin");
+ * lv_image_set_src(img, BSP_ASSET("logo"));
+ * \endcode
+ **************************************************************************************************/
+#define BSP_ASSETS_PREFIX           "bsp:"
+#define BSP_ASSET(name)             (BSP_ASSETS_PREFIX name)
+
+/**
+ * @brief Tile cache counters
+ */
+typedef struct {
+    uint32_t hits;          /*!< Tiles found in the cache */
+    uint32_t misses;        /*!< Tiles read and decoded */
+    uint32_t evictions;     /*!< Cached tiles dropped for another one */
+    uint64_t bytes_read;    /*!< Compressed bytes read from the blob */
+    uint64_t read_us;       /*!< Time spent reading, in [us] */
+    uint64_t decode_us;     /*!< Time spent decoding, in [us] */
+} bsp_assets_stats_t;
+
+/**
+ * @brief Result of bsp_assets_benchmark()
+ */
+typedef struct {
+    uint32_t tiles;             /*!< Tiles decoded */
+    uint64_t compressed_bytes;  /*!< Bytes read */
+    uint64_t decoded_bytes;     /*!< Bytes of decoded pixels */
+    uint64_t read_us;           /*!< Time spent reading, in [us] */
+    uint64_t decode_us;         /*!< Time spent decoding, in [us] */
+    float decode_mb_s;          /*!< Decoded MB/s while decoding */
+    float load_mb_s;            /*!< Decoded MB/s including the reads */
+} bsp_assets_bench_t;
+
+/**
+ * @brief Open an asset blob and register its image decoder with LVGL
+ *
+ * Call after bsp_display_start() and, for a blob on SPIFFS, bsp_spiffs_mount(). The blob stays open, which
+ * takes one of the BSP_SPIFFS_MAX_FILES file handles. The index is read into RAM, the images are read on demand.
+ *
+ * @param[in] path Blob path in the virtual file system
+ * @return
+ *      - ESP_OK                  On success
+ *      - ESP_ERR_INVALID_ARG     path is NULL
+ *      - ESP_ERR_INVALID_STATE   A blob is already open
+ *      - ESP_ERR_NOT_FOUND       The file does not exist
+ *      - ESP_ERR_INVALID_VERSION Not an asset blob, or of another version
+ *      - ESP_ERR_INVALID_SIZE    The index does not match the file
+ *      - ESP_ERR_NO_MEM          No memory for the index or the tile cache
+ */
+esp_err_t bsp_assets_open(const char* path);
+
+/**
+ * @brief Close the asset blob and free the tile cache
+ *
+ * Delete or change the images showing assets first.
+ *
+ * @return
+ *      - ESP_OK                On success
+ *      - ESP_ERR_INVALID_STATE No blob open
+ */
+esp_err_t bsp_assets_close(void);
+
+/**
+ * @brief Get tile cache counters
+ *
+ * @param[out] stats Counters since the blob was opened
+ * @return
+ *      - ESP_OK                On success
+ *      - ESP_ERR_INVALID_ARG   stats is NULL
+ *      - ESP_ERR_INVALID_STATE No blob open
+ */
+esp_err_t bsp_assets_get_stats(bsp_assets_stats_t* stats);
+
+/**
+ * @brief Measure read and decode throughput of one asset
+ *
+ * Every tile of the asset is read and decoded rounds times, bypassing the cache.
+ *
+ * @param[in]  name   Asset name, without BSP_ASSETS_PREFIX
+ * @param[in]  rounds Times the asset is decoded
+ * @param[out] result Throughput
+ * @return
+ *      - ESP_OK                   On success
+ *      - ESP_ERR_INVALID_ARG      Parameter error
+ *      - ESP_ERR_INVALID_STATE    No blob open
+ *      - ESP_ERR_NOT_FOUND        No asset of that name
+ *      - ESP_ERR_INVALID_RESPONSE A tile is corrupt
+ */
+esp_err_t bsp_assets_benchmark(const char* name, uint32_t rounds, bsp_assets_bench_t* result);
+#endif // BSP_CONFIG_NO_GRAPHIC_LIB == 0
+
 /** @} */ // end of storage
 
 /** \addtogroup g04_display
@@ -199,8 +536,20 @@ esp_err_t bsp_spiffs_unmount(void);
  #define BSP_LCD_SPI_NUM            (SPI3_HOST)
 
 #if (BSP_CONFIG_NO_GRAPHIC_LIB == 0)
+// Draw buffer of bsp_display_start() in full-width lines, also the fallback when BSP_LCD_DRAW_BUFF_BUDGET is set
+#if defined(CONFIG_BSP_LCD_DRAW_BUFF_LINES)
+#define BSP_LCD_DRAW_BUFF_LINES    (CONFIG_BSP_LCD_DRAW_BUFF_LINES)
+#else
+#define BSP_LCD_DRAW_BUFF_LINES    (BSP_LCD_V_RES / 10)
+#endif
+// Bytes bsp_display_start() tunes the draw buffers to, 0 keeps BSP_LCD_DRAW_BUFF_LINES
+#if defined(CONFIG_BSP_LCD_DRAW_BUFF_AUTO)
+#define BSP_LCD_DRAW_BUFF_BUDGET   (CONFIG_BSP_LCD_DRAW_BUFF_BUDGET_KB * 1024)
+#else
+#define BSP_LCD_DRAW_BUFF_BUDGET   (0)
+#endif
 //BSP_LCD_DRAW_BUFF_SIZE is in *pixels*
-#define BSP_LCD_DRAW_BUFF_SIZE     (BSP_LCD_H_RES * BSP_LCD_V_RES / 10)
+#define BSP_LCD_DRAW_BUFF_SIZE     (BSP_LCD_H_RES * BSP_LCD_DRAW_BUFF_LINES)
 #define BSP_LCD_DRAW_BUFF_DOUBLE   (1)
 
 /**
@@ -208,12 +557,33 @@ esp_err_t bsp_spiffs_unmount(void);
  */
 typedef struct {
     lvgl_port_cfg_t lvgl_port_cfg; /*!< LVGL port configuration */
-    uint32_t buffer_size; /*!< Size of the buffer for the screen in pixels */
+    uint32_t buffer_size; /*!< Size of the buffer for the screen in pixels, used if buffer_budget and
+                               buffer_lines are both 0 */
+    uint32_t buffer_lines; /*!< Height of the buffer in full-width lines, rounded down to an even count. Takes
+                                precedence over buffer_size */
+    size_t buffer_budget; /*!< Bytes all buffers together may take. The BSP picks the height with the fewest
+                               flushes and SPI transactions per frame that fits, and what the heap can still give.
+                               Takes precedence over buffer_lines and buffer_size */
     bool double_buffer; /*!< True if two buffers should be allocated */
     struct {
         unsigned int buff_dma : 1; /*!< Allocated LVGL buffer will be DMA capable */
         unsigned int buff_spiram : 1; /*!< Allocated LVGL buffer will be in PSRAM */
+        unsigned int full_frame : 1; /*!< Render into a full-screen PSRAM framebuffer and stream only the changed rows
+                                          through small DMA bounce buffers. buffer_size, double_buffer and the other
+                                          buffer flags are ignored. */
+        unsigned int flush_task : 1; /*!< Rotate, convert and send windows from a BSP task pinned to
+                                          flush_task.core, so LVGL renders the next buffer meanwhile. Pin the
+                                          LVGL task to the other core with lvgl_port_cfg.task_affinity. Ignored
+                                          with full_frame. */
+        unsigned int fast_start : 1; /*!< Reset and probe the touch controller, and mount SPIFFS if
+                                          CONFIG_BSP_DISPLAY_FAST_START_SPIFFS is set, in a helper task while the
+                                          panel goes through its reset and init delays */
     } flags;
+    struct {
+        int core;                /*!< Core the flush task is pinned to */
+        UBaseType_t priority;    /*!< Flush task priority, 0 selects the BSP default */
+        uint32_t stack_size;     /*!< Flush task stack size in bytes, 0 selects the BSP default */
+    } flush_task;                /*!< Flush task settings, used with flags.flush_task */
 } bsp_display_cfg_t;
 
 /**
@@ -238,6 +608,43 @@ lv_display_t* bsp_display_start(void);
  */
 lv_display_t* bsp_display_start_with_config(const bsp_display_cfg_t* cfg);
 
+/**
+ * @brief Stages of bsp_display_start_with_config()
+ */
+typedef enum {
+    BSP_BOOT_START,         /*!< bsp_display_start_with_config() called */
+    BSP_BOOT_LVGL,          /*!< LVGL task running */
+    BSP_BOOT_PANEL,         /*!< Panel reset, initialised and switched on */
+    BSP_BOOT_FIRST_PIXEL,   /*!< First image on the panel: the splash, or else the first LVGL frame */
+    BSP_BOOT_TOUCH,         /*!< Touch controller reset and probed */
+    BSP_BOOT_STORAGE,       /*!< SPIFFS mounted by the fast start */
+    BSP_BOOT_READY,         /*!< bsp_display_start_with_config() returns */
+    BSP_BOOT_STAGES,
+} bsp_boot_stage_t;
+
+/**
+ * @brief Completion time of every boot stage
+ */
+typedef struct {
+    int64_t at_us[BSP_BOOT_STAGES]; /*!< Time since esp_timer started, early in the application startup, in [us].
+                                         0 if the stage has not completed. */
+} bsp_boot_timeline_t;
+
+/**
+ * @brief Get the boot timeline
+ *
+ * @param[out] timeline Stage completion times
+ * @return
+ *      - ESP_OK              On success
+ *      - ESP_ERR_INVALID_ARG timeline is NULL
+ */
+esp_err_t bsp_boot_get_timeline(bsp_boot_timeline_t* timeline);
+
+/**
+ * @brief Write the boot timeline to the log
+ */
+void bsp_boot_log_timeline(void);
+
 /**
  * @brief Take LVGL mutex
  *
@@ -253,6 +660,470 @@ bool bsp_display_lock(uint32_t timeout_ms);
  */
 void bsp_display_unlock(void);
 
+/**
+ * @brief Rotate screen
+ *
+ * Display must be already initialized by calling bsp_display_start(), and the LVGL mutex must be held.
+ * The rotation is applied on top of the one selected in Kconfig. The RM690B0 is rotated in hardware through
+ * its MADCTL register. If the panel driver cannot swap or mirror, the flush stage rotates pixels in software.
+ *
+ * @param[in] disp     Pointer to LVGL display
+ * @param[in] rotation Angle of the display rotation
+ */
+void bsp_display_rotate(lv_display_t* disp, lv_display_rotation_t rotation);
+
+/**
+ * @brief Flush statistics of the BSP flush stage
+ *
+ * Per-frame values describe the last frame LVGL finished flushing.
+ */
+typedef struct {
+    uint32_t frames;      /*!< Frames flushed since the display was started */
+    uint32_t areas_in;    /*!< Invalidated areas LVGL produced in the last frame */
+    uint32_t areas_out;   /*!< Areas left after coalescing */
+    uint32_t windows;     /*!< CASET/RASET + RAMWR windows issued in the last frame */
+    uint32_t bytes;       /*!< Pixel bytes pushed to the panel in the last frame */
+    uint64_t total_bytes; /*!< Pixel bytes pushed since the display was started */
+    uint32_t transactions;          /*!< SPI transactions (CASET, RASET and pixel data) in the last frame */
+    uint32_t bytes_per_transaction; /*!< Average pixel payload per pixel data transaction in the last frame */
+    uint64_t overlap_us;  /*!< Time windows were on the wire while LVGL was free to render, in [us] */
+    uint64_t wait_us;     /*!< Time LVGL was blocked waiting for a window transfer to finish, in [us] */
+} bsp_display_flush_stats_t;
+
+/**
+ * @brief Get flush statistics
+ *
+ * @param[out] stats Statistics snapshot
+ * @return
+ *      - ESP_OK              On success
+ *      - ESP_ERR_INVALID_ARG stats is NULL
+ */
+esp_err_t bsp_display_get_flush_stats(bsp_display_flush_stats_t* stats);
+
+/**
+ * @brief Draw buffer geometry the display was started with
+ *
+ * In full-frame mode this describes the bounce buffers the changed rows are streamed through.
+ */
+typedef struct {
+    uint32_t lines;        /*!< Full-width lines per buffer */
+    uint32_t buffer_size;  /*!< Pixels per buffer */
+    uint32_t buffers;      /*!< 1, or 2 when double buffered */
+    size_t bytes;          /*!< Memory of all buffers */
+    uint32_t flushes;      /*!< Flush calls for a full-screen frame */
+    uint32_t transactions; /*!< Pixel data SPI transactions for a full-screen frame */
+} bsp_display_buffer_info_t;
+
+/**
+ * @brief Get the draw buffer geometry
+ *
+ * @param[out] info Geometry chosen when the display was started
+ * @return
+ *      - ESP_OK                On success
+ *      - ESP_ERR_INVALID_ARG   info is NULL
+ *      - ESP_ERR_INVALID_STATE Display not started
+ */
+esp_err_t bsp_display_get_buffer_info(bsp_display_buffer_info_t* info);
+
+/**
+ * @brief Counters of tear-free present, see CONFIG_BSP_LCD_TE
+ */
+typedef struct {
+    uint32_t windows;     /*!< Windows scheduled against the panel scan */
+    uint32_t delayed;     /*!< Windows held back until the scan was clear of them */
+    uint32_t unsynced;    /*!< Windows too large to fit between two passes of the scan, sent right away */
+    uint64_t wait_us;     /*!< Time windows were held back, in [us] */
+    uint32_t wait_max_us; /*!< Longest time a window was held back, in [us] */
+    uint32_t period_us;   /*!< Refresh period the scan model follows, in [us] */
+} bsp_display_te_stats_t;
+
+/**
+ * @brief Get tear-free present counters
+ *
+ * @param[out] stats Counters since the display was started
+ * @return
+ *      - ESP_OK                On success
+ *      - ESP_ERR_INVALID_ARG   stats is NULL
+ *      - ESP_ERR_INVALID_STATE Tear-free present is off
+ */
+esp_err_t bsp_display_get_te_stats(bsp_display_te_stats_t* stats);
+
+/** Frames kept by bsp_display_get_stats() */
+#define BSP_DISPLAY_STATS_FRAMES        (64)
+/** Histogram buckets per metric */
+#define BSP_DISPLAY_STATS_BUCKETS       (16)
+
+/**
+ * @brief One metric over the frames kept by the BSP
+ */
+typedef struct {
+    uint32_t last;      /*!< Last frame */
+    uint32_t min;
+    uint32_t max;
+    uint32_t avg;
+    uint32_t p50;       /*!< Median */
+    uint32_t p95;       /*!< 95th percentile */
+    uint16_t histogram[BSP_DISPLAY_STATS_BUCKETS]; /*!< Frames per bucket. Bucket 0 counts zeros, bucket i counts
+                                                        values in [2^(i-1), 2^i), the last bucket everything above */
+} bsp_display_metric_t;
+
+/**
+ * @brief Frame timing of the last BSP_DISPLAY_STATS_FRAMES frames
+ */
+typedef struct {
+    uint32_t frames;                    /*!< Frames the values below describe */
+    uint32_t total_frames;              /*!< Frames recorded since the display was started */
+    float fps;                          /*!< Frame rate over the kept frames */
+    bsp_display_metric_t render_us;     /*!< Refresh start to the last flush call, without time blocked on the bus,
+                                             in [us] */
+    bsp_display_metric_t flush_us;      /*!< First flush call to the end of the last transfer, in [us] */
+    bsp_display_metric_t bytes;         /*!< Pixel bytes sent to the panel */
+    bsp_display_metric_t areas;         /*!< Areas flushed after coalescing */
+    bsp_display_metric_t dma_wait_us;   /*!< Time LVGL waited for a transfer to finish, in [us] */
+    bsp_display_metric_t lock_wait_us;  /*!< Time tasks waited in bsp_display_lock(), in [us] */
+} bsp_display_stats_t;
+
+/**
+ * @brief Format of bsp_display_dump_stats()
+ */
+typedef enum {
+    BSP_DISPLAY_STATS_CSV,      /*!< Header line, then one line per frame */
+    BSP_DISPLAY_STATS_BINARY,   /*!< Base64 lines between "BEGIN"/"END" markers, see bsp_display_dump_stats() */
+} bsp_display_stats_format_t;
+
+/**
+ * @brief Get frame timing statistics
+ *
+ * The BSP records every frame in a fixed ring of BSP_DISPLAY_STATS_FRAMES entries. A frame is recorded once
+ * its last window has left the wire.
+ *
+ * @param[out] stats Statistics snapshot
+ * @return
+ *      - ESP_OK              On success
+ *      - ESP_ERR_INVALID_ARG stats is NULL
+ */
+esp_err_t bsp_display_get_stats(bsp_display_stats_t* stats);
+
+/**
+ * @brief Write the kept frames to the log, oldest first
+ *
+ * CSV columns are frame, timestamp_us, render_us, flush_us, bytes, areas, dma_wait_us and lock_wait_us.
+ *
+ * The binary format is little-endian: the magic "BSPF", a version byte (1), the number of metrics per frame
+ * (6) and the number of frames (uint16_t), then per frame the timestamp relative to the first frame in [us]
+ * and the metrics in CSV order, all uint32_t. It is written as base64, 48 bytes per log line.
+ *
+ * @param[in] format Output format
+ * @return
+ *      - ESP_OK              On success
+ *      - ESP_ERR_INVALID_ARG Unknown format
+ */
+esp_err_t bsp_display_dump_stats(bsp_display_stats_format_t format);
+
+/** Longest text carried by bsp_display_post_text(), including the terminating NUL */
+#define BSP_DISPLAY_POST_TEXT_MAX       (32)
+
+/**
+ * @brief Argument of a posted UI update
+ */
+typedef union {
+    int32_t value;
+    void* ptr;
+    char text[BSP_DISPLAY_POST_TEXT_MAX];
+} bsp_display_post_arg_t;
+
+/**
+ * @brief Apply a posted UI update, called from the LVGL task with the LVGL lock held
+ */
+typedef void (*bsp_display_post_cb_t)(lv_obj_t* obj, const bsp_display_post_arg_t* arg);
+
+/**
+ * @brief Post a UI update without taking the LVGL lock
+ *
+ * The update is copied into a lock-free queue and applied by the LVGL task at the start of its next refresh,
+ * so it shows up in that frame. Any number of tasks may post at once, posting never blocks. With coalesce
+ * set, an update is skipped if a newer one for the same object and callback is already queued behind it,
+ * so a value updated faster than the frame rate costs one LVGL call per frame.
+ *
+ * The object must stay alive until its queued updates were applied.
+ *
+ * @param[in] obj      Object to update
+ * @param[in] cb       Function applying the update
+ * @param[in] arg      Argument handed to cb, copied. May be NULL, cb then gets a zeroed argument.
+ * @param[in] coalesce Allow this update to be replaced by a newer one
+ * @return
+ *      - ESP_OK                On success
+ *      - ESP_ERR_INVALID_ARG   Parameter error
+ *      - ESP_ERR_INVALID_STATE Display not started
+ *      - ESP_ERR_NO_MEM        Queue full, the update was dropped
+ */
+esp_err_t bsp_display_post(lv_obj_t* obj, bsp_display_post_cb_t cb, const bsp_display_post_arg_t* arg,
+                           bool coalesce);
+
+/**
+ * @brief Post a new label text, coalesced
+ *
+ * Text longer than BSP_DISPLAY_POST_TEXT_MAX - 1 characters is truncated.
+ *
+ * @param[in] label Label
+ * @param[in] text  Text, copied
+ * @return See bsp_display_post()
+ */
+esp_err_t bsp_display_post_text(lv_obj_t* label, const char* text);
+
+/**
+ * @brief Post a new value for a bar, slider or arc, coalesced
+ *
+ * @param[in] obj   Bar, slider or arc
+ * @param[in] value New value, applied without animation
+ * @return See bsp_display_post()
+ */
+esp_err_t bsp_display_post_value(lv_obj_t* obj, int32_t value);
+
+/**
+ * @brief Counters of the UI update queue
+ */
+typedef struct {
+    uint32_t posted;        /*!< Updates queued */
+    uint32_t applied;       /*!< Updates applied by the LVGL task */
+    uint32_t coalesced;     /*!< Updates skipped because a newer one for the same object and callback followed */
+    uint32_t dropped;       /*!< Updates rejected because the queue was full */
+    uint32_t contended;     /*!< Times a posting task lost a queue slot to another one and retried */
+    uint32_t depth;         /*!< Updates waiting now */
+    uint32_t max_depth;     /*!< Most updates seen waiting at once */
+    uint32_t drain_us_max;  /*!< Longest time spent applying updates in one refresh, in [us] */
+} bsp_display_post_stats_t;
+
+/**
+ * @brief Get UI update queue counters
+ *
+ * @param[out] stats Counters since the display was started
+ * @return
+ *      - ESP_OK              On success
+ *      - ESP_ERR_INVALID_ARG stats is NULL
+ */
+esp_err_t bsp_display_get_post_stats(bsp_display_post_stats_t* stats);
+
+/**
+ * @brief Counters of the BSP draw unit
+ *
+ * The draw unit takes solid rectangle fills and unscaled opaque image copies away from the LVGL software
+ * renderer, see CONFIG_BSP_DISPLAY_DRAW_UNIT.
+ */
+typedef struct {
+    uint32_t fills;         /*!< Fills drawn */
+    uint32_t blits;         /*!< Image copies drawn */
+    uint32_t declined;      /*!< Fills and images left to the software renderer */
+    uint64_t cpu_bytes;     /*!< Bytes written by the CPU */
+    uint64_t dma_bytes;     /*!< Bytes written by GDMA */
+    uint32_t dma_timeouts;  /*!< Waits for GDMA that overran 100 ms. After the first, jobs are drawn by the CPU only */
+} bsp_display_draw_stats_t;
+
+/**
+ * @brief Get draw unit counters
+ *
+ * @param[out] stats Counters since the display was started
+ * @return
+ *      - ESP_OK              On success
+ *      - ESP_ERR_INVALID_ARG stats is NULL
+ */
+esp_err_t bsp_display_get_draw_stats(bsp_display_draw_stats_t* stats);
+
+/**
+ * @brief Display power states, from the most to the least power drawn
+ */
+typedef enum {
+    BSP_DISPLAY_POWER_ACTIVE,       /*!< Panel on at the brightness set with bsp_display_brightness_set() */
+    BSP_DISPLAY_POWER_DIMMED,       /*!< Panel on at the dim brightness, a touch restores the brightness */
+    BSP_DISPLAY_POWER_SLEEP,        /*!< Panel in sleep-in, QSPI idle and LVGL paused. A touch wakes it. */
+    BSP_DISPLAY_POWER_LIGHT_SLEEP,  /*!< Panel asleep and the chip in light sleep, woken by the touch INT line */
+    BSP_DISPLAY_POWER_STATES,       /*!< Number of states */
+} bsp_display_power_state_t;
+
+/**
+ * @brief Power manager timeouts
+ *
+ * Timeouts count from the last touch or bsp_display_power_activity() call. A timeout of 0 skips its state.
+ */
+typedef struct {
+    uint32_t dim_ms;            /*!< Idle time before the panel is dimmed */
+    uint32_t sleep_ms;          /*!< Idle time before the panel goes to sleep */
+    uint32_t light_sleep_ms;    /*!< Idle time before light sleep. Needs sleep_ms and the touch INT line. */
+    uint8_t dim_percent;        /*!< Brightness while dimmed in [%] */
+} bsp_display_power_cfg_t;
+
+#define BSP_DISPLAY_POWER_CFG_DEFAULT() \
+    {                                   \
+        .dim_ms = 15000,                \
+        .sleep_ms = 30000,              \
+        .light_sleep_ms = 0,            \
+        .dim_percent = 20,              \
+    }
+
+/**
+ * @brief Power manager counters and transition timings
+ */
+typedef struct {
+    bsp_display_power_state_t state;                    /*!< Current state */
+    uint32_t entered[BSP_DISPLAY_POWER_STATES];         /*!< Times each state was entered */
+    uint64_t time_us[BSP_DISPLAY_POWER_STATES];         /*!< Time spent in each state in [us] */
+    uint32_t sleep_in_us;       /*!< Last time from stopping LVGL to the panel in sleep-in, in [us] */
+    uint32_t sleep_in_max_us;   /*!< Longest sleep-in time in [us] */
+    uint32_t wake_us;           /*!< Last time from the waking touch to the panel on and LVGL running, in [us] */
+    uint32_t wake_max_us;       /*!< Longest wake time in [us] */
+    uint32_t swallowed;         /*!< Touch samples not passed to LVGL because they only woke the panel */
+} bsp_display_power_stats_t;
+
+/**
+ * @brief Start the display power manager, or change its timeouts
+ *
+ * Steps the display from active to dimmed, panel sleep and light sleep while nothing touches the screen.
+ * The touch that wakes a sleeping panel is not passed to LVGL. Animations do not count as activity, call
+ * bsp_display_power_activity() to keep the display on while the application shows something that moves.
+ *
+ * @param[in] cfg Timeouts and dim level
+ * @return
+ *      - ESP_OK                On success
+ *      - ESP_ERR_INVALID_ARG   Invalid timeouts or dim level
+ *      - ESP_ERR_NOT_SUPPORTED Light sleep without the touch INT line
+ *      - ESP_ERR_INVALID_STATE The display is not started
+ *      - ESP_ERR_NO_MEM        No memory for the power manager task
+ */
+esp_err_t bsp_display_power_start(const bsp_display_power_cfg_t* cfg);
+
+/**
+ * @brief Report activity other than touch, waking the display if needed
+ */
+void bsp_display_power_activity(void);
+
+/**
+ * @brief Get the current power state
+ *
+ * @return Power state, BSP_DISPLAY_POWER_ACTIVE while the power manager is not started
+ */
+bsp_display_power_state_t bsp_display_power_get_state(void);
+
+/**
+ * @brief Get power manager counters and transition timings
+ *
+ * @param[out] stats Counters since the power manager was started
+ * @return
+ *      - ESP_OK              On success
+ *      - ESP_ERR_INVALID_ARG stats is NULL
+ */
+esp_err_t bsp_display_power_get_stats(bsp_display_power_stats_t* stats);
+
+/**
+ * @brief Frame governor rates
+ *
+ * The rates pace the LVGL refresh cycle: how often LVGL looks for invalidated areas and renders them. They cap
+ * how often changes are rendered, a change after a static screen is rendered at the next cycle.
+ */
+typedef struct {
+    uint32_t target_hz;     /*!< Rate while the UI changes */
+    uint32_t idle_hz;       /*!< Lowest rate for changes that run on without touch, like a looping animation */
+    uint32_t boost_hz;      /*!< Rate while a finger is down, and for boost_ms after it is lifted */
+    uint32_t idle_ms;       /*!< Time of changes without touch before each halving of the rate, 0 keeps target_hz */
+    uint32_t boost_ms;      /*!< Time the boost lasts after the finger is lifted */
+} bsp_display_governor_cfg_t;
+
+#define BSP_DISPLAY_GOVERNOR_CFG_DEFAULT() \
+    {                                      \
+        .target_hz = 30,                   \
+        .idle_hz = 10,                     \
+        .boost_hz = 60,                    \
+        .idle_ms = 1000,                   \
+        .boost_ms = 300,                   \
+    }
+
+/**
+ * @brief Frame governor counters
+ */
+typedef struct {
+    uint32_t hz;            /*!< Current refresh rate */
+    uint32_t rate_changes;  /*!< Times the rate was changed */
+    uint32_t frames;        /*!< Refresh cycles that had something to render */
+    uint32_t idle_cycles;   /*!< Refresh cycles that found nothing to render */
+    uint32_t paced;         /*!< Frames not rendered because the rate held running changes below LVGL's own pace */
+    uint64_t saved_us;      /*!< Render time of those frames in [us], CPU time left to the application */
+    uint32_t render_us;     /*!< Averaged time a refresh cycle with changes takes in [us] */
+    uint32_t dropped;       /*!< Frames lost because rendering and flushing overran the refresh period */
+    uint64_t late_us;       /*!< Time those frames ran past the refresh period, in [us] */
+    uint32_t boosts;        /*!< Touches that started a boost */
+} bsp_display_governor_stats_t;
+
+/**
+ * @brief Start the frame governor, or change its rates
+ *
+ * Renders changes at target_hz at most instead of LVGL's own pace. Changes that keep running on every cycle
+ * without touch are paced down further, the rate halves after every idle_ms down to idle_hz. A cycle with
+ * nothing to render brings the rate back to target_hz. A touch raises it to boost_hz at once.
+ *
+ * @param[in] cfg Rates
+ * @return
+ *      - ESP_OK                On success
+ *      - ESP_ERR_INVALID_ARG   Rates not in the order idle_hz <= target_hz <= boost_hz, or above 1000 Hz
+ *      - ESP_ERR_INVALID_STATE The display is not started
+ */
+esp_err_t bsp_display_governor_start(const bsp_display_governor_cfg_t* cfg);
+
+/**
+ * @brief Get frame governor counters
+ *
+ * @param[out] stats Counters since the governor was started
+ * @return
+ *      - ESP_OK              On success
+ *      - ESP_ERR_INVALID_ARG stats is NULL
+ */
+esp_err_t bsp_display_governor_get_stats(bsp_display_governor_stats_t* stats);
+
+/**
+ * @brief Hardware scrolling counters
+ */
+typedef struct {
+    uint32_t steps;         /*!< Scroll steps moved by the panel, only the uncovered rows were rendered */
+    uint32_t fallbacks;     /*!< Scroll steps rendered in full */
+    uint64_t rows_saved;    /*!< Rows not rendered and not sent thanks to those steps */
+} bsp_display_hw_scroll_stats_t;
+
+/**
+ * @brief Let the panel scroll an object in hardware
+ *
+ * While the object scrolls vertically, the panel moves the rows it shows (VSCRDEF/VSCSAD) and LVGL only renders
+ * and sends the rows that scroll into view. This works for a full-width object on an opaque background without
+ * gradient, image, border, radius or shadow, with the screen at 0 or 180 degrees. Scroll steps that do not fit
+ * (horizontal scrolling, an overlay on top of the object, a floating child, a screen transition or anything else
+ * changing inside the object before the step) are rendered in full as usual. Only one object at a time, its
+ * scrollbar is turned off as it would move with the content.
+ *
+ * @param[in] obj Scrollable object
+ * @return
+ *      - ESP_OK                On success
+ *      - ESP_ERR_INVALID_ARG   obj is NULL
+ *      - ESP_ERR_INVALID_STATE The display is not started
+ */
+esp_err_t bsp_display_hw_scroll_attach(lv_obj_t* obj);
+
+/**
+ * @brief Stop scrolling the attached object in hardware
+ *
+ * Also done when the object is deleted.
+ *
+ * @return
+ *      - ESP_OK On success
+ */
+esp_err_t bsp_display_hw_scroll_detach(void);
+
+/**
+ * @brief Get hardware scrolling counters
+ *
+ * @param[out] stats Counters since start-up
+ * @return
+ *      - ESP_OK              On success
+ *      - ESP_ERR_INVALID_ARG stats is NULL
+ */
+esp_err_t bsp_display_hw_scroll_get_stats(bsp_display_hw_scroll_stats_t* stats);
+
 #endif // BSP_CONFIG_NO_GRAPHIC_LIB == 0
 
 /** @} */ // end of display
@@ -9,6 +9,7 @@
  */
 
 #pragma once
+#include <stdbool.h>
 #include "esp_lcd_touch.h"
 
 #ifdef __cplusplus
@@ -44,6 +45,37 @@ typedef struct {
  */
 esp_err_t bsp_touch_new(const bsp_touch_config_t *config, esp_lcd_touch_handle_t *ret_touch);
 
+/**
+ * @brief Touch input statistics
+ *
+ * Available once bsp_display_start() has started the touch reader.
+ */
+typedef struct {
+    bool interrupt_mode;        /*!< Reads are triggered by the touch INT line, otherwise the controller is polled.
+                                     Turns false if the line stays silent during a contact */
+    uint32_t i2c_reads;         /*!< Touch controller reads since start */
+    float i2c_reads_per_s;      /*!< Touch controller reads per second over the last second or longer */
+    uint32_t samples;           /*!< Touch samples delivered to LVGL */
+    uint32_t dropped;           /*!< Samples dropped because LVGL did not read them in time */
+    uint32_t latency_us;        /*!< Touch-to-event latency of the last sample, in [us] */
+    uint32_t latency_max_us;    /*!< Largest touch-to-event latency, in [us] */
+    uint32_t latency_avg_us;    /*!< Average touch-to-event latency, in [us] */
+} bsp_touch_stats_t;
+
+/**
+ * @brief Get touch input statistics
+ *
+ * The touch-to-event latency runs from the INT edge (or from the read, when polling) to the moment LVGL
+ * takes the sample.
+ *
+ * @param[out] stats Statistics snapshot
+ * @return
+ *      - ESP_OK                On success
+ *      - ESP_ERR_INVALID_ARG   stats is NULL
+ *      - ESP_ERR_INVALID_STATE Touch reader not running
+ */
+esp_err_t bsp_touch_get_stats(bsp_touch_stats_t *stats);
+
 /** @} */ // end of display
 #ifdef __cplusplus
 }
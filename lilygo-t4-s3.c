@@ -4,6 +4,12 @@
 #include "esp_spiffs.h"
 #include "esp_lcd_panel_io.h"
 #include "esp_lcd_panel_ops.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include <string.h>
 
 #include "bsp/lilygo-t4-s3.h"
 #include "bsp/display.h"
@@ -11,7 +17,20 @@
 #include "esp_lcd_touch_cst226se.h"
 #include "esp_lcd_rm690b0.h"
 #include "esp_lvgl_port.h"
+#include "bsp_boot.h"
+#include "bsp_brightness.h"
+#include "bsp_color.h"
+#include "bsp_draw_buf.h"
+#include "bsp_draw_unit.h"
 #include "bsp_err_check.h"
+#include "bsp_flush.h"
+#include "bsp_i2c.h"
+#include "bsp_lcd_io.h"
+#include "bsp_power.h"
+#include "bsp_sim_panel.h"
+#include "bsp_touch.h"
+#include "bsp_ui_queue.h"
+#include "driver/gpio.h"
 #include "esp_lcd_panel_interface.h"
 
 // NOLINTBEGIN (*-avoid-non-const-global-variables)
@@ -19,11 +38,18 @@ static const char* TAG = "T4 S3";
 
 #if (BSP_CONFIG_NO_GRAPHIC_LIB == 0)
 
-#ifdef CONFIG_BSP_LV_COLOR_FORMAT_RGB565
+#if defined(CONFIG_BSP_LV_COLOR_FORMAT_RGB565)
 #define BSP_LCD_COLOR_FORMAT                (LV_COLOR_FORMAT_RGB565)
-#define BSP_LCD_BITS_PER_PIXEL   (16)
+#elif defined(CONFIG_BSP_LV_COLOR_FORMAT_XRGB8888)
+#define BSP_LCD_COLOR_FORMAT                (LV_COLOR_FORMAT_XRGB8888)
 #else
 #define BSP_LCD_COLOR_FORMAT                (LV_COLOR_FORMAT_RGB888)
+#endif
+
+// Pixel size on the wire, the flush stage converts from the LVGL color format
+#if defined(CONFIG_BSP_LV_COLOR_FORMAT_RGB565) || defined(CONFIG_BSP_LCD_TRANSFER_RGB565)
+#define BSP_LCD_BITS_PER_PIXEL   (16)
+#else
 #define BSP_LCD_BITS_PER_PIXEL   (24)
 #endif
 
@@ -67,6 +93,7 @@ esp_err_t bsp_i2c_init(void) {
     };
 
     BSP_ERROR_CHECK_RETURN_ERR(i2c_new_master_bus(&i2c_config, &i2c_handle));
+    BSP_ERROR_CHECK_RETURN_ERR(bsp_i2c_sched_start());
 
     i2c_initialized = true;
     return ESP_OK;
@@ -83,6 +110,23 @@ i2c_master_bus_handle_t bsp_i2c_get_handle(void) {
     return i2c_handle;
 }
 
+// Longest transaction the ESP32-S3 GP-SPI can send with DMA (18-bit bit-length register)
+#define BSP_LCD_SPI_MAX_TRANS_SZ    (32768)
+
+/**
+ * @brief Pick the SPI transaction size for a draw buffer
+ *
+ * A flush of a whole buffer is split into the fewest transactions the SPI peripheral allows, all of about
+ * the same size, instead of one full transaction followed by a small remainder.
+ */
+static uint32_t bsp_spi_trans_size(uint32_t buffer_bytes) {
+    const uint32_t transactions = (buffer_bytes + BSP_LCD_SPI_MAX_TRANS_SZ - 1) / BSP_LCD_SPI_MAX_TRANS_SZ;
+    const uint32_t trans_size = (buffer_bytes + transactions - 1) / transactions;
+
+    // Keep DMA transfers word-aligned
+    return (trans_size + 3) & ~3U;
+}
+
 static esp_err_t bsp_spi_init(uint32_t max_transfer_sz) {
     /* SPI was initialized before */
     if (spi_initialized) {
@@ -100,6 +144,7 @@ static esp_err_t bsp_spi_init(uint32_t max_transfer_sz) {
         .data5_io_num = -1,
         .data6_io_num = -1,
         .data7_io_num = -1,
+        .max_transfer_sz = (int)max_transfer_sz,
         .flags = SPICOMMON_BUSFLAG_MASTER | SPICOMMON_BUSFLAG_GPIO_PINS,
     };
 
@@ -150,8 +195,20 @@ esp_err_t bsp_display_brightness_init(void) {
 }
 
 esp_err_t bsp_display_brightness_set(int brightness_percent) {
-    const uint8_t brightness = brightness_percent * 255 / 100;
+    // Deferred by the power manager while the panel is dimmed or asleep
+    return bsp_power_brightness_set(brightness_percent, 0);
+}
+
+esp_err_t bsp_display_brightness_fade(int brightness_percent, uint32_t duration_ms) {
+    return bsp_power_brightness_set(brightness_percent, duration_ms);
+}
+
+esp_err_t bsp_display_brightness_write(uint8_t brightness) {
+#ifdef CONFIG_BSP_LCD_SIMULATED
+    return esp_lcd_panel_io_tx_param(bsp_lcd_io_get(), BSP_LCD_QSPI_CMD_WRITE(BSP_LCD_CMD_WRDISBV), &brightness, 1);
+#else
     return esp_lcd_panel_rm690b0_set_brightness(lcd_panel, brightness);
+#endif
 }
 
 esp_err_t bsp_display_backlight_off(void) {
@@ -168,17 +225,30 @@ esp_err_t bsp_display_new(const bsp_display_config_t* config, esp_lcd_panel_hand
     assert(config != NULL && config->max_transfer_sz > 0);
 
     /* Initialize SPI */
-    ESP_RETURN_ON_ERROR(bsp_spi_init(config->max_transfer_sz), TAG, "");
+    const uint32_t trans_size = bsp_spi_trans_size(config->max_transfer_sz);
+#ifndef CONFIG_BSP_LCD_SIMULATED
+    ESP_RETURN_ON_ERROR(bsp_spi_init(trans_size), TAG, "");
+#endif
+
+    const size_t trans_queue_depth = config->trans_queue_depth ? config->trans_queue_depth
+                                                               : CONFIG_BSP_LCD_TRANS_QUEUE_DEPTH;
+    const uint32_t buffer_transactions = (config->max_transfer_sz + trans_size - 1) / trans_size;
+    if (trans_queue_depth < buffer_transactions) {
+        ESP_LOGW(TAG, "Panel IO queue (%d) is shorter than a full buffer (%lu transactions), flushes will block",
+                 (int)trans_queue_depth, (unsigned long)buffer_transactions);
+    }
+    ESP_LOGD(TAG, "SPI transactions of %lu bytes, %lu per buffer", (unsigned long)trans_size,
+             (unsigned long)buffer_transactions);
 
     ESP_LOGD(TAG, "Install panel IO");
     const esp_lcd_panel_io_spi_config_t io_config = {
         .dc_gpio_num = -1,
         .cs_gpio_num = BSP_LCD_CS,
         .spi_mode = 0,
-        .pclk_hz = rm690b0_spi_clock_hz,
+        .pclk_hz = CONFIG_BSP_LCD_PCLK_HZ ? CONFIG_BSP_LCD_PCLK_HZ : rm690b0_spi_clock_hz,
         .lcd_cmd_bits = LCD_CMD_BITS,
         .lcd_param_bits = LCD_PARAM_BITS,
-        .trans_queue_depth = 10,
+        .trans_queue_depth = trans_queue_depth,
         .cs_ena_pretrans = 0,
         .cs_ena_posttrans = 0,
         .flags = {
@@ -193,9 +263,12 @@ esp_err_t bsp_display_new(const bsp_display_config_t* config, esp_lcd_panel_hand
         }
     };
 
-    ESP_GOTO_ON_ERROR(esp_lcd_new_panel_io_spi(BSP_LCD_SPI_NUM, &io_config, ret_io), err, TAG,
-                      "New panel IO failed");
+    ESP_GOTO_ON_ERROR(bsp_lcd_io_new(BSP_LCD_SPI_NUM, &io_config, ret_io), err, TAG, "New panel IO failed");
 
+#ifdef CONFIG_BSP_LCD_SIMULATED
+    ESP_LOGI(TAG, "Using the simulated panel");
+    ESP_GOTO_ON_ERROR(bsp_sim_panel_new(*ret_io, BSP_LCD_BITS_PER_PIXEL, ret_panel), err, TAG, "New panel failed");
+#else
     ESP_LOGD(TAG, "Install LCD driver");
     rm960b0_vendor_config_t vendor_config = {
         .en_gpio_num = BSP_LCD_EN,
@@ -209,6 +282,7 @@ esp_err_t bsp_display_new(const bsp_display_config_t* config, esp_lcd_panel_hand
     };
 
     ESP_GOTO_ON_ERROR(esp_lcd_new_panel_rm690b0(*ret_io, &panel_config, ret_panel), err, TAG, "New panel failed");
+#endif
 
     lcd_panel = *ret_panel;
     esp_lcd_panel_reset(*ret_panel);
@@ -222,7 +296,102 @@ err:
     if (*ret_io) {
         esp_lcd_panel_io_del(*ret_io);
     }
+#ifndef CONFIG_BSP_LCD_SIMULATED
     spi_bus_free(BSP_LCD_SPI_NUM);
+#endif
+    return ret;
+}
+
+esp_err_t bsp_display_set_pclk(uint32_t pclk_hz) {
+    return bsp_lcd_io_set_pclk(pclk_hz);
+}
+
+uint32_t bsp_display_get_pclk(void) {
+    return bsp_lcd_io_get_pclk();
+}
+
+// Height of the test pattern strip pushed by bsp_display_pclk_sweep()
+#define BSP_LCD_SWEEP_LINES    (20)
+
+static esp_err_t bsp_display_read_id(uint8_t id[3]) {
+    return esp_lcd_panel_io_rx_param(bsp_lcd_io_get(), BSP_LCD_QSPI_CMD_READ(BSP_LCD_CMD_RDDID), id, 3);
+}
+
+static esp_err_t bsp_display_push_frames(const uint8_t* strip, uint32_t frames) {
+    esp_err_t ret = ESP_OK;
+    for (uint32_t frame = 0; frame < frames && ret == ESP_OK; frame++) {
+        for (int y = 0; y < BSP_LCD_V_RES && ret == ESP_OK; y += BSP_LCD_SWEEP_LINES) {
+            ret = esp_lcd_panel_draw_bitmap(lcd_panel, 0, y, BSP_LCD_H_RES, y + BSP_LCD_SWEEP_LINES, strip);
+        }
+    }
+    return ret == ESP_OK ? bsp_lcd_io_wait_idle() : ret;
+}
+
+esp_err_t bsp_display_pclk_sweep(const uint32_t* pclk_hz, size_t count, uint32_t frames,
+                                 bsp_display_pclk_result_t* results) {
+    ESP_RETURN_ON_FALSE(pclk_hz && results && count > 0 && frames > 0, ESP_ERR_INVALID_ARG, TAG, "Invalid arguments");
+    ESP_RETURN_ON_FALSE(lcd_panel, ESP_ERR_INVALID_STATE, TAG, "Display not initialized");
+
+    const size_t bytes_per_pixel = BSP_LCD_BITS_PER_PIXEL / 8;
+    const size_t strip_size = BSP_LCD_H_RES * BSP_LCD_SWEEP_LINES * bytes_per_pixel;
+    uint8_t* strip = heap_caps_malloc(strip_size, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    ESP_RETURN_ON_FALSE(strip, ESP_ERR_NO_MEM, TAG, "No memory for test pattern");
+
+    // Toggle every data line on every clock edge, the worst case for signal integrity
+    for (size_t i = 0; i < strip_size; i++) {
+        strip[i] = (i & 1) ? 0xA5 : 0x5A; // NOLINT(*-avoid-magic-numbers)
+    }
+
+#if (BSP_CONFIG_NO_GRAPHIC_LIB == 0)
+    if (lv_display) {
+        lvgl_port_lock(0);
+    }
+#endif
+    // The flush stage must not see completions of windows it did not issue
+    bsp_lcd_io_wait_idle();
+    bsp_lcd_io_mute_callbacks(true);
+
+    const uint32_t base_pclk_hz = bsp_lcd_io_get_pclk();
+    uint8_t ref_id[3] = {0};
+    const bool can_verify = bsp_display_read_id(ref_id) == ESP_OK && (ref_id[0] | ref_id[1] | ref_id[2]) != 0;
+
+    for (size_t i = 0; i < count; i++) {
+        bsp_display_pclk_result_t* res = &results[i];
+        memset(res, 0, sizeof(*res));
+        res->pclk_hz = pclk_hz[i];
+        res->verified = can_verify;
+
+        if (bsp_lcd_io_set_pclk(pclk_hz[i]) != ESP_OK) {
+            continue;
+        }
+
+        const int64_t start_us = esp_timer_get_time();
+        const esp_err_t ret = bsp_display_push_frames(strip, frames);
+        const int64_t elapsed_us = esp_timer_get_time() - start_us;
+
+        uint8_t id[3] = {0};
+        res->stable = ret == ESP_OK
+                      && (!can_verify || (bsp_display_read_id(id) == ESP_OK && memcmp(id, ref_id, sizeof(id)) == 0));
+        if (ret == ESP_OK && elapsed_us > 0) {
+            const float bytes = (float)frames * BSP_LCD_H_RES * BSP_LCD_V_RES * bytes_per_pixel;
+            res->mbytes_per_s = bytes / (float)elapsed_us;
+            res->fps = (float)frames * 1000000.0f / (float)elapsed_us; // NOLINT(*-avoid-magic-numbers)
+        }
+
+        ESP_LOGI(TAG, "PCLK %lu Hz: %s, %.2f MB/s, %.1f FPS", (unsigned long)res->pclk_hz,
+                 res->stable ? (can_verify ? "stable" : "no errors") : "UNSTABLE", res->mbytes_per_s, res->fps);
+    }
+
+    const esp_err_t ret = bsp_lcd_io_set_pclk(base_pclk_hz);
+    bsp_lcd_io_mute_callbacks(false);
+#if (BSP_CONFIG_NO_GRAPHIC_LIB == 0)
+    if (lv_display) {
+        lv_obj_invalidate(lv_display_get_screen_active(lv_display));
+        lvgl_port_unlock();
+    }
+#endif
+
+    free(strip);
     return ret;
 }
 
@@ -247,7 +416,13 @@ esp_err_t bsp_touch_new(const bsp_touch_config_t* _, esp_lcd_touch_handle_t* ret
         },
     };
 
-    return esp_lcd_touch_new_i2c_cst226se(bsp_i2c_get_handle(), &tp_config, ret_touch);
+    BSP_ERROR_CHECK_RETURN_ERR(esp_lcd_touch_new_i2c_cst226se(bsp_i2c_get_handle(), &tp_config, ret_touch));
+
+    // The CST226SE drives INT open-drain, without a pull-up the edge never arrives
+    if (BSP_LCD_TOUCH_INT != GPIO_NUM_NC) {
+        gpio_pullup_en(BSP_LCD_TOUCH_INT);
+    }
+    return ESP_OK;
 }
 
 static void lvgl_round_cb(lv_area_t* area) {
@@ -269,24 +444,164 @@ static void lvgl_round_cb(lv_area_t* area) {
 }
 
 #if (BSP_CONFIG_NO_GRAPHIC_LIB == 0)
+// Lines per strip of the splash, even to keep windows aligned to the 2-pixel RM690B0 rule
+#define BSP_SPLASH_LINES        (16)
+
+/**
+ * @brief Show an image from the flash asset partition before LVGL renders anything
+ *
+ * The image is centred on a black screen in the native panel orientation and must already be in the wire pixel
+ * format. Strips are composed in one buffer while the other one is on the bus.
+ */
+static esp_err_t bsp_display_splash(esp_lcd_panel_handle_t panel, const char* name) {
+    const esp_err_t mount_ret = bsp_flash_assets_mount();
+    ESP_RETURN_ON_FALSE(mount_ret == ESP_OK || mount_ret == ESP_ERR_INVALID_STATE, mount_ret, TAG,
+                        "No flash assets for the splash");
+    lv_image_dsc_t img;
+    ESP_RETURN_ON_ERROR(bsp_flash_assets_get_image(name, &img), TAG, "No splash image %s", name);
+
+    const uint32_t bytes_per_pixel = BSP_LCD_BITS_PER_PIXEL / 8;
+    const lv_color_format_t wire_cf = bytes_per_pixel == 2 ? LV_COLOR_FORMAT_RGB565 : LV_COLOR_FORMAT_RGB888;
+    ESP_RETURN_ON_FALSE(img.header.cf == wire_cf && img.header.w <= BSP_LCD_H_HW_RES &&
+                        img.header.h <= BSP_LCD_V_HW_RES, ESP_ERR_INVALID_SIZE, TAG,
+                        "Splash must be at most %dx%d in the %d-bit panel format", BSP_LCD_H_HW_RES, BSP_LCD_V_HW_RES,
+                        (int)BSP_LCD_BITS_PER_PIXEL);
+
+    const size_t line_bytes = BSP_LCD_H_HW_RES * bytes_per_pixel;
+    const size_t strip_size = line_bytes * BSP_SPLASH_LINES;
+    uint8_t* strips = heap_caps_malloc(2 * strip_size, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    ESP_RETURN_ON_FALSE(strips, ESP_ERR_NO_MEM, TAG, "No memory for the splash");
+
+    const int32_t x0 = (BSP_LCD_H_HW_RES - img.header.w) / 2;
+    const int32_t y0 = (BSP_LCD_V_HW_RES - img.header.h) / 2;
+    esp_err_t ret = ESP_OK;
+    for (int32_t y = 0, i = 0; y < BSP_LCD_V_HW_RES && ret == ESP_OK; y += BSP_SPLASH_LINES, i ^= 1) {
+        uint8_t* strip = strips + i * strip_size;
+        const int32_t lines = LV_MIN(BSP_SPLASH_LINES, BSP_LCD_V_HW_RES - y);
+        memset(strip, 0, line_bytes * lines);
+        for (int32_t l = 0; l < lines; l++) {
+            const int32_t src_y = y + l - y0;
+            if (src_y >= 0 && src_y < (int32_t)img.header.h) {
+                memcpy(strip + l * line_bytes + x0 * bytes_per_pixel, img.data + src_y * img.header.stride,
+                       img.header.w * bytes_per_pixel);
+            }
+        }
+#ifdef CONFIG_BSP_LCD_SWAP_BYTES
+        if (bytes_per_pixel == 2) {
+            bsp_color_swap_rgb565(strip, strip, BSP_LCD_H_HW_RES * lines);
+        }
+#endif
+        // The strip composed before this one may still be on the bus, this one is only reused after it
+        if (y > 0) {
+            bsp_lcd_io_wait_idle();
+        }
+        ret = esp_lcd_panel_draw_bitmap(panel, 0, y, BSP_LCD_H_HW_RES, y + lines, strip);
+    }
+    if (ret == ESP_OK) {
+        ret = bsp_lcd_io_wait_idle();
+    }
+
+    free(strips);
+    if (ret == ESP_OK) {
+        bsp_boot_mark(BSP_BOOT_FIRST_PIXEL);
+    }
+    return ret;
+}
+
+// The flush task only converts pixels and queues transfers, it runs just above the LVGL task
+#define BSP_FLUSH_TASK_PRIORITY     (5)
+#define BSP_FLUSH_TASK_STACK        (3072)
+
+// Lines lvgl_round_cb() aligns every window to
+#define BSP_LCD_DRAW_BUFF_ALIGN     (2)
+
+// Draw buffer geometry chosen by bsp_display_lcd_init()
+static bsp_display_buffer_info_t buffer_info;
+
+/**
+ * @brief Work out the draw buffer size in pixels
+ *
+ * buffer_budget wins over buffer_lines, which wins over buffer_size. In full-frame mode the geometry reported
+ * is that of the bounce buffers, each chunk is a window of its own.
+ */
+static uint32_t bsp_display_buffer_pixels(const bsp_display_cfg_t* cfg, uint32_t bounce_lines) {
+    const bool full_frame = cfg->flags.full_frame;
+    const bsp_draw_buf_cfg_t buf_cfg = {
+        .width = BSP_LCD_H_RES,
+        .height = BSP_LCD_V_RES,
+        // Bounce buffers hold pixels already converted for the wire
+        .bytes_per_pixel = full_frame ? BSP_LCD_BITS_PER_PIXEL / 8 : lv_color_format_get_size(BSP_LCD_COLOR_FORMAT),
+        .wire_bytes_per_pixel = BSP_LCD_BITS_PER_PIXEL / 8,
+        .buffers = (full_frame || cfg->double_buffer) ? 2 : 1,
+        .align = BSP_LCD_DRAW_BUFF_ALIGN,
+        .max_trans_bytes = BSP_LCD_SPI_MAX_TRANS_SZ,
+    };
+
+    bsp_draw_buf_geom_t geom;
+    if (full_frame) {
+        bsp_draw_buf_eval(&buf_cfg, bounce_lines, &geom);
+    } else {
+        bsp_draw_buf_req_t req = {
+            .budget = cfg->buffer_budget,
+            .max_buffer = SIZE_MAX,
+            .lines = cfg->buffer_lines,
+            .pixels = cfg->buffer_size,
+        };
+        // Every buffer is one allocation, in internal RAM unless the buffers go to PSRAM
+        if (req.budget && !cfg->flags.buff_spiram) {
+            const uint32_t caps = cfg->flags.buff_dma ? MALLOC_CAP_DMA : MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+            req.budget = LV_MIN(req.budget, heap_caps_get_free_size(caps));
+            req.max_buffer = heap_caps_get_largest_free_block(caps);
+        }
+        if (!bsp_draw_buf_select(&buf_cfg, &req, &geom)) {
+            ESP_LOGW(TAG, "Draw buffer budget of %u bytes too small", (unsigned)req.budget);
+        }
+    }
+    // Whole lines, so the draw buffer size matches the geometry reported
+    const uint32_t pixels = full_frame ? 0 : geom.lines * BSP_LCD_H_RES;
+
+    buffer_info = (bsp_display_buffer_info_t){
+        .lines = geom.lines,
+        .buffer_size = full_frame ? geom.lines * LV_MAX(BSP_LCD_H_RES, BSP_LCD_V_RES) : pixels,
+        .buffers = buf_cfg.buffers,
+        .bytes = geom.bytes,
+        .flushes = geom.flushes,
+        .transactions = geom.transactions,
+    };
+    ESP_LOGI(TAG, "%s of %lu lines (%u bytes), %lu windows and %lu transactions per full frame",
+             full_frame ? "Bounce buffers" : "Draw buffers", (unsigned long)geom.lines, (unsigned)geom.bytes,
+             (unsigned long)geom.flushes, (unsigned long)geom.transactions);
+    return pixels;
+}
+
 static lv_display_t* bsp_display_lcd_init(const bsp_display_cfg_t* cfg) {
     assert(cfg != NULL);
     esp_lcd_panel_io_handle_t io_handle = NULL;
     esp_lcd_panel_handle_t panel_handle = NULL;
+    const bool full_frame = cfg->flags.full_frame;
+    const uint32_t bounce_lines = CONFIG_BSP_LCD_BOUNCE_BUFFER_LINES & ~1U;
+    const uint32_t buffer_size = bsp_display_buffer_pixels(cfg, bounce_lines);
+
+    // Size the bus after the largest window a single flush can send
+    const uint32_t flush_pixels = full_frame ? LV_MAX(BSP_LCD_H_RES, BSP_LCD_V_RES) * bounce_lines : buffer_size;
     const bsp_display_config_t bsp_disp_cfg = {
-        .max_transfer_sz = BSP_LCD_DRAW_BUFF_SIZE * (BSP_LCD_BITS_PER_PIXEL / 8),
+        .max_transfer_sz = (int)(flush_pixels * (BSP_LCD_BITS_PER_PIXEL / 8)),
     };
     BSP_ERROR_CHECK_RETURN_NULL(bsp_display_new(&bsp_disp_cfg, &panel_handle, &io_handle));
 
     esp_lcd_panel_disp_on_off(panel_handle, true);
+    bsp_boot_mark(BSP_BOOT_PANEL);
+    if (CONFIG_BSP_DISPLAY_SPLASH[0] != '\0' && bsp_display_splash(panel_handle, CONFIG_BSP_DISPLAY_SPLASH) != ESP_OK) {
+        ESP_LOGW(TAG, "Starting without a splash");
+    }
 
     /* Add LCD screen */
     ESP_LOGD(TAG, "Add LCD screen");
     const lvgl_port_display_cfg_t disp_cfg = {
         .io_handle = io_handle,
         .panel_handle = panel_handle,
-        .buffer_size = cfg->buffer_size,
-        .double_buffer = cfg->double_buffer,
+        .buffer_size = full_frame ? BSP_LCD_H_RES * BSP_LCD_V_RES : buffer_size,
+        .double_buffer = full_frame ? false : cfg->double_buffer,
         .hres = BSP_LCD_H_RES,
         .vres = BSP_LCD_V_RES,
         .monochrome = false,
@@ -298,60 +613,177 @@ static lv_display_t* bsp_display_lcd_init(const bsp_display_cfg_t* cfg) {
         .rounder_cb = lvgl_round_cb,
         .color_format = BSP_LCD_COLOR_FORMAT,
         .flags = {
-            .buff_dma = cfg->flags.buff_dma,
-            .buff_spiram = cfg->flags.buff_spiram,
-            .swap_bytes = false,
+            .buff_dma = full_frame ? false : cfg->flags.buff_dma,
+            .buff_spiram = full_frame ? true : cfg->flags.buff_spiram,
+            .swap_bytes = false, // Done by the flush stage, see CONFIG_BSP_LCD_SWAP_BYTES
+            .direct_mode = full_frame,
         }
     };
 
     lv_display = lvgl_port_add_disp(&disp_cfg);
     assert(lv_display);
 
+    const bsp_flush_config_t flush_cfg = {
+        .panel = panel_handle,
+        .io = io_handle,
+        .bits_per_pixel = BSP_LCD_BITS_PER_PIXEL,
+#ifdef CONFIG_BSP_LCD_SWAP_BYTES
+        .swap_bytes = true,
+#endif
+#ifdef CONFIG_BSP_LCD_DITHER
+        .dither = true,
+#endif
+        .max_transfer_sz = bsp_spi_trans_size(bsp_disp_cfg.max_transfer_sz),
+        .buffer_size = buffer_size,
+        .rotation = {
+            .swap_xy = BSP_LCD_SWAP_XY,
+            .mirror_x = BSP_LCD_MIRROR_X,
+            .mirror_y = BSP_LCD_MIRROR_Y,
+        },
+        .full_frame = full_frame,
+        .bounce_lines = bounce_lines,
+        .flush_task = cfg->flags.flush_task,
+        .flush_task_core = cfg->flush_task.core,
+        .flush_task_priority = cfg->flush_task.priority ? cfg->flush_task.priority : BSP_FLUSH_TASK_PRIORITY,
+        .flush_task_stack = cfg->flush_task.stack_size ? cfg->flush_task.stack_size : BSP_FLUSH_TASK_STACK,
+#if defined(CONFIG_BSP_LCD_TE_GPIO_SYNC)
+        .te = BSP_FLUSH_TE_GPIO,
+        .te_gpio = CONFIG_BSP_LCD_TE_GPIO,
+#elif defined(CONFIG_BSP_LCD_TE_SCANLINE)
+        .te = BSP_FLUSH_TE_SCANLINE,
+#endif
+        .refresh_hz = CONFIG_BSP_LCD_REFRESH_HZ,
+    };
+#ifdef CONFIG_BSP_DISPLAY_DRAW_UNIT
+    BSP_ERROR_CHECK_RETURN_NULL(bsp_draw_unit_init());
+#endif
+    // Updates posted by other tasks are applied first, so the flush stage sees the areas they invalidate
+    BSP_ERROR_CHECK_RETURN_NULL(bsp_ui_queue_attach(lv_display));
+    BSP_ERROR_CHECK_RETURN_NULL(bsp_flush_attach(lv_display, &flush_cfg));
+
     return lv_display;
 }
 
+esp_err_t bsp_display_get_buffer_info(bsp_display_buffer_info_t* info) {
+    ESP_RETURN_ON_FALSE(info, ESP_ERR_INVALID_ARG, TAG, "info is NULL");
+    ESP_RETURN_ON_FALSE(lv_display, ESP_ERR_INVALID_STATE, TAG, "Display not started");
+    *info = buffer_info;
+    return ESP_OK;
+}
+
 static lv_indev_t* bsp_display_indev_touch_init(lv_display_t* disp) {
-    BSP_ERROR_CHECK_RETURN_NULL(bsp_touch_new(NULL, &tp));
+    // Already probed by the fast start
+    if (tp == NULL) {
+        BSP_ERROR_CHECK_RETURN_NULL(bsp_touch_new(NULL, &tp));
+        bsp_boot_mark(BSP_BOOT_TOUCH);
+    }
     assert(tp);
 
-    /* Add touch input (for selected screen) */
-    const lvgl_port_touch_cfg_t touch_cfg = {
-        .disp = disp,
-        .handle = tp,
-    };
-
-    return lvgl_port_add_touch(&touch_cfg);
+    /* Add touch input (for selected screen), fed by the touch reader task instead of LVGL polling I2C */
+    return bsp_touch_indev_create(disp, tp);
 }
 
 lv_display_t* bsp_display_start(void) {
     bsp_display_cfg_t cfg = {
         .lvgl_port_cfg = ESP_LVGL_PORT_INIT_CONFIG(),
         .buffer_size = BSP_LCD_DRAW_BUFF_SIZE,
+        .buffer_lines = BSP_LCD_DRAW_BUFF_LINES,
+        .buffer_budget = BSP_LCD_DRAW_BUFF_BUDGET,
         .double_buffer = BSP_LCD_DRAW_BUFF_DOUBLE,
         .flags = {
             .buff_dma = true,
             .buff_spiram = false,
-        }
+#ifdef CONFIG_BSP_LCD_FULL_FRAME
+            .full_frame = true,
+#endif
+#ifdef CONFIG_BSP_DISPLAY_DUAL_CORE
+            .flush_task = true,
+#endif
+#ifdef CONFIG_BSP_DISPLAY_FAST_START
+            .fast_start = true,
+#endif
+        },
+#ifdef CONFIG_BSP_DISPLAY_DUAL_CORE
+        .flush_task = {
+            .core = !CONFIG_BSP_DISPLAY_RENDER_CORE,
+        },
+#endif
     };
+#ifdef CONFIG_BSP_DISPLAY_DUAL_CORE
+    // Rendering gets a core of its own, the flush, touch and I2C tasks share the other one
+    cfg.lvgl_port_cfg.task_affinity = CONFIG_BSP_DISPLAY_RENDER_CORE;
+#endif
 
     return bsp_display_start_with_config(&cfg);
 }
 
+// The touch and SPIFFS bring-up of the fast start only waits on I2C and flash, a small stack is enough
+#define BSP_BOOT_TASK_STACK     (4096)
+
+typedef struct {
+    SemaphoreHandle_t done;
+    StaticSemaphore_t done_buf;
+    esp_err_t touch_ret;
+} bsp_boot_job_t;
+
+static void bsp_boot_task(void* arg) {
+    bsp_boot_job_t* job = arg;
+
+    job->touch_ret = bsp_touch_new(NULL, &tp);
+    if (job->touch_ret == ESP_OK) {
+        bsp_boot_mark(BSP_BOOT_TOUCH);
+    }
+#ifdef CONFIG_BSP_DISPLAY_FAST_START_SPIFFS
+    // Not fatal for the display, the application sees the error when it opens a file
+    if (bsp_spiffs_mount() == ESP_OK) {
+        bsp_boot_mark(BSP_BOOT_STORAGE);
+    }
+#endif
+
+    xSemaphoreGive(job->done);
+    vTaskDelete(NULL);
+}
+
 lv_display_t* bsp_display_start_with_config(const bsp_display_cfg_t* cfg) {
     assert(cfg != NULL);
+    bsp_boot_mark(BSP_BOOT_START);
     BSP_ERROR_CHECK_RETURN_NULL(lvgl_port_init(&cfg->lvgl_port_cfg));
+    bsp_boot_mark(BSP_BOOT_LVGL);
 
     BSP_ERROR_CHECK_RETURN_NULL(bsp_display_brightness_init());
 
+    // The CST226SE reset and the SPIFFS mount overlap the RM690B0 reset and sleep-out delays
+    static bsp_boot_job_t boot_job;
+    const bool fast_start = cfg->flags.fast_start && tp == NULL;
+    if (fast_start) {
+        boot_job.done = xSemaphoreCreateBinaryStatic(&boot_job.done_buf);
+        BSP_NULL_CHECK(xTaskCreate(bsp_boot_task, "bsp_boot", BSP_BOOT_TASK_STACK, &boot_job,
+                                   uxTaskPriorityGet(NULL), NULL) == pdPASS ? boot_job.done : NULL, NULL);
+    }
+
     BSP_NULL_CHECK((lv_display = bsp_display_lcd_init(cfg)), NULL);
 
+    if (fast_start) {
+        xSemaphoreTake(boot_job.done, portMAX_DELAY);
+        BSP_ERROR_CHECK_RETURN_NULL(boot_job.touch_ret);
+    }
     BSP_NULL_CHECK((disp_indev_touch = bsp_display_indev_touch_init(lv_display)), NULL);
+    BSP_ERROR_CHECK_RETURN_NULL(bsp_power_attach(lv_display, lcd_panel, tp));
 
+    bsp_boot_mark(BSP_BOOT_READY);
     return lv_display;
 }
 
+void bsp_display_rotate(lv_display_t* disp, lv_display_rotation_t rotation) {
+    // The flush stage reprograms the panel, or falls back to software rotation, on the resolution change
+    lv_display_set_rotation(disp, rotation);
+}
+
 bool bsp_display_lock(uint32_t timeout_ms) {
-    return lvgl_port_lock(timeout_ms);
+    const int64_t start_us = esp_timer_get_time();
+    const bool locked = lvgl_port_lock(timeout_ms);
+    bsp_flush_add_lock_wait((uint32_t)(esp_timer_get_time() - start_us));
+    return locked;
 }
 
 void bsp_display_unlock(void) {
@@ -0,0 +1,95 @@
+/**
+ * @file
+ * @brief Dirty-region coalescing for the RM690B0 flush stage
+ *
+ * This module is plain C with no ESP-IDF or LVGL dependencies, so the merge logic can be built and
+ * exercised on a Linux host against recorded area lists.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Rectangle with inclusive corners, laid out like lv_area_t
+ */
+typedef struct {
+    int32_t x1;
+    int32_t y1;
+    int32_t x2;
+    int32_t y2;
+} bsp_area_t;
+
+/**
+ * @brief Cost model used when deciding whether two areas should be sent as one window
+ *
+ * The cost of a window is its pixel payload plus a fixed overhead that stands for the CASET, RASET and
+ * RAMWR transactions needed to open it. Two areas are merged whenever their bounding box costs no more than
+ * sending them separately.
+ */
+typedef struct {
+    uint32_t bytes_per_pixel; /*!< Size of one pixel on the wire */
+    uint32_t window_overhead; /*!< Cost of opening one window, expressed in payload bytes */
+    uint32_t align;           /*!< Coordinate alignment (1 or a power of two), 2 for the RM690B0 */
+} bsp_area_merge_cfg_t;
+
+static inline int32_t bsp_area_width(const bsp_area_t* area) {
+    return area->x2 - area->x1 + 1;
+}
+
+static inline int32_t bsp_area_height(const bsp_area_t* area) {
+    return area->y2 - area->y1 + 1;
+}
+
+static inline uint32_t bsp_area_size(const bsp_area_t* area) {
+    return (uint32_t)bsp_area_width(area) * (uint32_t)bsp_area_height(area);
+}
+
+/**
+ * @brief Grow an area so that its origin and size are multiples of align
+ *
+ * With align == 2 this is the same rule lvgl_round_cb() applies to every invalidated area.
+ */
+void bsp_area_align(bsp_area_t* area, uint32_t align);
+
+/**
+ * @brief Bounding box of two areas
+ */
+void bsp_area_union(bsp_area_t* res, const bsp_area_t* a, const bsp_area_t* b);
+
+/**
+ * @brief Check whether inner lies completely inside outer
+ */
+bool bsp_area_contains(const bsp_area_t* outer, const bsp_area_t* inner);
+
+/**
+ * @brief Cost of sending an area as one window, see bsp_area_merge_cfg_t
+ */
+uint64_t bsp_area_cost(const bsp_area_t* area, const bsp_area_merge_cfg_t* cfg);
+
+/**
+ * @brief Coalesce a list of areas into the cheapest set of windows
+ *
+ * Areas are aligned first, then areas contained in another one are dropped and the pair whose bounding box
+ * saves the most is merged repeatedly until no merge pays off. Two areas, whether they overlap, touch or lie
+ * apart, are merged only when their bounding box costs no more than both of them: the window overhead saved
+ * must cover the pixels the bounding box adds beyond the two areas, counting an overlap once for each. Areas
+ * that line up side by side or one above the other add nothing and are always merged. Other touching or
+ * overlapping areas may stay separate, for example an L shape whose bounding box fills in a large corner.
+ *
+ * @param[inout] areas Areas to coalesce, rewritten in place
+ * @param[in]    count Number of areas
+ * @param[in]    cfg   Cost model
+ * @return Number of areas left at the front of the array
+ */
+size_t bsp_area_merge(bsp_area_t* areas, size_t count, const bsp_area_merge_cfg_t* cfg);
+
+#ifdef __cplusplus
+}
+#endif
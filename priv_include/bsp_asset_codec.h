@@ -0,0 +1,108 @@
+/**
+ * @file
+ * @brief Asset blob format and tile decoder
+ *
+ * An asset blob packs many images into one file. All values are little-endian.
+ *
+ * | Offset | Size | Content                                                           |
+ * |--------|------|-------------------------------------------------------------------|
+ * | 0      | 16   | Header: "BSPA", u16 version, u16 asset count, u16 tile lines,     |
+ * |        |      | u16 reserved, u32 largest compressed tile in bytes                |
+ * | 16     | 32*n | Index: name[20], u16 width, u16 height, u8 format, u8 reserved,   |
+ * |        |      | u16 tiles, u32 offset of the tile table                           |
+ * | ...    |      | Per asset, a table of tiles + 1 u32 offsets from the blob start,  |
+ * |        |      | tile i spans [offset[i], offset[i + 1]), followed by the tiles    |
+ *
+ * Every tile holds up to `tile lines` full-width lines, compressed independently so any tile can be decoded on
+ * its own. The codec works on whole pixels of 2 (RGB565, as LVGL stores it) or 3 (RGB888, blue first) bytes
+ * and keeps the previous pixel and a 64-entry table of recently seen pixels:
+ *
+ * | Op          | Meaning                                                                       |
+ * |-------------|-------------------------------------------------------------------------------|
+ * | 00iiiiii    | Pixel from table entry i                                                      |
+ * | 01nnnnnn    | Previous pixel n + 1 times                                                    |
+ * | 10nnnnnn    | n + 1 literal pixels follow, each is stored in the table                      |
+ * | 11nnnnnn N  | Previous pixel (n << 8 | N) + 65 times                                        |
+ *
+ * This module is plain C with no ESP-IDF or LVGL dependencies.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BSP_ASSET_MAGIC             "BSPA"
+#define BSP_ASSET_VERSION           (1)
+#define BSP_ASSET_HEADER_SIZE       (16)
+#define BSP_ASSET_ENTRY_SIZE        (32)
+#define BSP_ASSET_NAME_LEN          (20)
+
+typedef enum {
+    BSP_ASSET_FORMAT_RGB565 = 1,
+    BSP_ASSET_FORMAT_RGB888 = 2,
+} bsp_asset_format_t;
+
+/**
+ * @brief Blob header
+ */
+typedef struct {
+    uint16_t version;
+    uint16_t count;             /*!< Assets in the index */
+    uint16_t tile_lines;        /*!< Lines per tile, the last tile of an asset may have fewer */
+    uint32_t max_tile_bytes;    /*!< Largest compressed tile */
+} bsp_asset_header_t;
+
+/**
+ * @brief Index entry of one asset
+ */
+typedef struct {
+    char name[BSP_ASSET_NAME_LEN + 1];
+    uint16_t width;
+    uint16_t height;
+    uint8_t format;             /*!< bsp_asset_format_t */
+    uint16_t tiles;
+    uint32_t table_offset;      /*!< Offset of the tile offset table from the blob start */
+} bsp_asset_entry_t;
+
+/**
+ * @brief Bytes per pixel of an asset format, 0 if the format is unknown
+ */
+static inline uint8_t bsp_asset_bytes_per_pixel(uint8_t format) {
+    return format == BSP_ASSET_FORMAT_RGB565 ? 2 : format == BSP_ASSET_FORMAT_RGB888 ? 3 : 0;
+}
+
+/**
+ * @brief Parse the blob header
+ *
+ * @return false if the magic or version does not match
+ */
+bool bsp_asset_parse_header(const uint8_t raw[BSP_ASSET_HEADER_SIZE], bsp_asset_header_t* header);
+
+/**
+ * @brief Parse one index entry
+ *
+ * @return false if the entry is malformed
+ */
+bool bsp_asset_parse_entry(const uint8_t raw[BSP_ASSET_ENTRY_SIZE], bsp_asset_entry_t* entry);
+
+/**
+ * @brief Decode one tile
+ *
+ * @param[in]  src             Compressed tile
+ * @param[in]  src_len         Compressed size
+ * @param[out] dst             Decoded pixels, tightly packed
+ * @param[in]  pixels          Pixels in the tile
+ * @param[in]  bytes_per_pixel 2 or 3
+ * @return false if the tile is truncated or decodes to a different number of pixels
+ */
+bool bsp_asset_decode(const uint8_t* src, size_t src_len, uint8_t* dst, size_t pixels, uint8_t bytes_per_pixel);
+
+#ifdef __cplusplus
+}
+#endif
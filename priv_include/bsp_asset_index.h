@@ -0,0 +1,104 @@
+/**
+ * @file
+ * @brief Index of the memory-mapped asset partition
+ *
+ * The partition starts with an index built at packing time by tools/bsp_flash_assets.py. All values are
+ * little-endian.
+ *
+ * | Offset | Size | Content                                                                   |
+ * |--------|------|---------------------------------------------------------------------------|
+ * | 0      | 16   | "BSPM", u16 version, u16 entry count, u32 image size, u32 CRC-32 of the   |
+ * |        |      | entries                                                                   |
+ * | 16     | 48*n | Entries sorted by name: name[24], u8 kind, u8 format, u16 width,          |
+ * |        |      | u16 height, u16 reserved, u32 stride, u32 offset, u32 size, u32 reserved  |
+ * | ...    |      | Asset data, each aligned to 16 bytes                                      |
+ *
+ * Assets are used in place, so a valid index is all that is needed before pointing LVGL at them. This module
+ * is plain C with no ESP-IDF or LVGL dependencies.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BSP_ASSET_INDEX_MAGIC       "BSPM"
+#define BSP_ASSET_INDEX_VERSION     (1)
+#define BSP_ASSET_INDEX_HEADER_SIZE (16)
+#define BSP_ASSET_INDEX_ENTRY_SIZE  (48)
+#define BSP_ASSET_INDEX_NAME_LEN    (24)
+#define BSP_ASSET_INDEX_ALIGN       (16)
+
+typedef enum {
+    BSP_ASSET_KIND_DATA = 0,    /*!< Raw bytes */
+    BSP_ASSET_KIND_IMAGE = 1,   /*!< Uncompressed pixels */
+    BSP_ASSET_KIND_FONT = 2,    /*!< TrueType font file */
+} bsp_asset_kind_t;
+
+typedef enum {
+    BSP_ASSET_PIXEL_NONE = 0,
+    BSP_ASSET_PIXEL_RGB565 = 1,     /*!< As LVGL stores it, little-endian */
+    BSP_ASSET_PIXEL_RGB888 = 2,     /*!< Blue first */
+    BSP_ASSET_PIXEL_ARGB8888 = 3,   /*!< Blue first, alpha last */
+} bsp_asset_pixel_t;
+
+/**
+ * @brief One asset of the partition
+ */
+typedef struct {
+    char name[BSP_ASSET_INDEX_NAME_LEN + 1];
+    uint8_t kind;       /*!< bsp_asset_kind_t */
+    uint8_t format;     /*!< bsp_asset_pixel_t, images only */
+    uint16_t width;     /*!< Images only */
+    uint16_t height;    /*!< Images only */
+    uint32_t stride;    /*!< Bytes per line, images only */
+    uint32_t offset;    /*!< From the start of the partition */
+    uint32_t size;      /*!< Bytes */
+} bsp_asset_index_entry_t;
+
+/**
+ * @brief Index found at the start of a partition
+ */
+typedef struct {
+    const uint8_t* base;
+    uint32_t count;
+    uint32_t image_size;    /*!< Bytes of the partition used by the index and the assets */
+} bsp_asset_index_t;
+
+/**
+ * @brief CRC-32 as computed by zlib.crc32()
+ */
+uint32_t bsp_asset_index_crc32(const uint8_t* data, size_t len);
+
+/**
+ * @brief Validate the index at the start of a mapped partition
+ *
+ * Checks the header, the CRC of the entries, name order, data bounds and alignment, and image sizes.
+ *
+ * @param[in]  base  Start of the partition
+ * @param[in]  size  Partition size
+ * @param[out] index Index, valid if true is returned
+ * @return true if the index is valid
+ */
+bool bsp_asset_index_open(const uint8_t* base, size_t size, bsp_asset_index_t* index);
+
+/**
+ * @brief Read entry i
+ */
+void bsp_asset_index_entry(const bsp_asset_index_t* index, uint32_t i, bsp_asset_index_entry_t* entry);
+
+/**
+ * @brief Find an asset by name, with a binary search over the sorted entries
+ *
+ * @return true if found
+ */
+bool bsp_asset_index_find(const bsp_asset_index_t* index, const char* name, bsp_asset_index_entry_t* entry);
+
+#ifdef __cplusplus
+}
+#endif
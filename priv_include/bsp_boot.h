@@ -0,0 +1,29 @@
+/**
+ * @file
+ * @brief Boot timeline of the BSP display start
+ */
+
+#pragma once
+
+#include "bsp/lilygo-t4-s3.h"
+
+#if (BSP_CONFIG_NO_GRAPHIC_LIB == 0)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Record that a stage completed now
+ *
+ * Only the first call per stage is kept, later ones are ignored. Safe to call from an ISR.
+ *
+ * @param[in] stage Completed stage
+ */
+void bsp_boot_mark(bsp_boot_stage_t stage);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BSP_CONFIG_NO_GRAPHIC_LIB == 0
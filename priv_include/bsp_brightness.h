@@ -0,0 +1,52 @@
+/**
+ * @file
+ * @brief Panel brightness ramps
+ *
+ * Brightness changes run as ramps stepped by an esp_timer. Steps are even in perceived brightness, not in
+ * register value. While LVGL is flushing, each step is sent ahead of the next window instead of as a command
+ * of its own, see bsp_flush_queue_brightness().
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* WRDISBV value for a brightness in [%] */
+#define BSP_BRIGHTNESS_LEVEL(percent)   ((uint8_t)((percent) * 255 / 100))
+
+/**
+ * @brief Write a WRDISBV value to the panel and wait for it to be sent
+ *
+ * Implemented next to bsp_display_brightness_set().
+ *
+ * @param[in] level Brightness register value
+ * @return
+ *      - ESP_OK On success
+ *      - Error from the panel IO otherwise
+ */
+esp_err_t bsp_display_brightness_write(uint8_t level);
+
+/**
+ * @brief Ramp the panel brightness to a new value
+ *
+ * Starts from the last value sent to the panel and returns right away. A ramp started while another one
+ * runs continues from where that one got to.
+ *
+ * @param[in] brightness_percent Target brightness in [%]
+ * @param[in] duration_ms        Ramp duration in [ms], 0 cancels any ramp and writes the value before returning
+ * @return
+ *      - ESP_OK              On success
+ *      - ESP_ERR_INVALID_ARG brightness_percent out of range
+ *      - ESP_ERR_NO_MEM      No memory for the ramp timer
+ *      - Error from the panel IO when duration_ms is 0
+ */
+esp_err_t bsp_brightness_ramp(int brightness_percent, uint32_t duration_ms);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,82 @@
+/**
+ * @file
+ * @brief Pixel format conversion between LVGL and the RM690B0
+ *
+ * The kernels work on 32-bit words whenever source and destination are word aligned, and fall back to plain
+ * per-pixel code otherwise. They may run in place: the destination can be the source itself, or start
+ * before it, as long as it is not larger than the source. This module is plain C with no ESP-IDF or LVGL
+ * dependencies.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Conversion of one line of pixels from the LVGL format to the panel format
+ */
+typedef struct {
+    uint8_t src_bytes_per_pixel; /*!< 2 (RGB565), 3 (RGB888) or 4 (XRGB8888) */
+    uint8_t dst_bytes_per_pixel; /*!< 2 (RGB565) or 3 (RGB888) */
+    bool swap_bytes;             /*!< RGB565 output is sent most significant byte first */
+    bool dither;                 /*!< Ordered dithering when reducing to RGB565 */
+} bsp_color_conv_t;
+
+/**
+ * @brief Check whether a conversion leaves the pixels untouched
+ */
+static inline bool bsp_color_conv_is_copy(const bsp_color_conv_t* conv) {
+    return conv->src_bytes_per_pixel == conv->dst_bytes_per_pixel && !(conv->dst_bytes_per_pixel == 2 &&
+            conv->swap_bytes);
+}
+
+/**
+ * @brief Swap the two bytes of every RGB565 pixel
+ */
+void bsp_color_swap_rgb565(const void* src, void* dst, size_t count);
+
+/**
+ * @brief Drop the unused byte of XRGB8888 pixels
+ */
+void bsp_color_pack_xrgb8888(const void* src, void* dst, size_t count);
+
+/**
+ * @brief Reduce RGB888 or XRGB8888 pixels to RGB565
+ *
+ * With dithering, a 4x4 ordered (Bayer) threshold is added before the low bits are dropped. The threshold
+ * depends on the screen position of each pixel, so static content does not flicker between frames.
+ *
+ * @param[in]  src             First pixel
+ * @param[in]  src_bytes_per_pixel 3 or 4
+ * @param[out] dst             First RGB565 pixel
+ * @param[in]  count           Number of pixels
+ * @param[in]  x               Screen column of the first pixel
+ * @param[in]  y               Screen row of the pixels
+ * @param[in]  swap_bytes      Store pixels most significant byte first
+ * @param[in]  dither          Apply ordered dithering
+ */
+void bsp_color_to_rgb565(const void* src, uint32_t src_bytes_per_pixel, void* dst, size_t count, int32_t x,
+                         int32_t y, bool swap_bytes, bool dither);
+
+/**
+ * @brief Convert one line of pixels
+ *
+ * @param[in]  conv  Conversion
+ * @param[in]  src   First pixel in the LVGL format
+ * @param[out] dst   First pixel in the panel format
+ * @param[in]  count Number of pixels
+ * @param[in]  x     Screen column of the first pixel, used for dithering
+ * @param[in]  y     Screen row of the line, used for dithering
+ */
+void bsp_color_convert(const bsp_color_conv_t* conv, const void* src, void* dst, size_t count, int32_t x,
+                       int32_t y);
+
+#ifdef __cplusplus
+}
+#endif
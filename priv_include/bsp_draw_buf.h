@@ -0,0 +1,91 @@
+/**
+ * @file
+ * @brief Draw buffer geometry
+ *
+ * LVGL renders a partial frame as stripes of full-width lines, one flush call per stripe, and the flush stage
+ * splits each stripe into SPI transactions of at most the bus limit. This module works out what a buffer of a
+ * given number of lines costs per full-screen frame, and picks the line count for a RAM budget. This module is
+ * plain C with no ESP-IDF or LVGL dependencies.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Screen and bus the buffers are sized for
+ */
+typedef struct {
+    uint32_t width;                 /*!< Pixels per line */
+    uint32_t height;                /*!< Lines per frame */
+    uint32_t bytes_per_pixel;       /*!< Size of a pixel in the draw buffer */
+    uint32_t wire_bytes_per_pixel;  /*!< Size of a pixel on the wire */
+    uint32_t buffers;               /*!< 1, or 2 when double buffered */
+    uint32_t align;                 /*!< Windows start and end on multiples of this many lines */
+    uint32_t max_trans_bytes;       /*!< Largest SPI transaction, a multiple of 4 */
+} bsp_draw_buf_cfg_t;
+
+/**
+ * @brief Cost of a buffer geometry
+ */
+typedef struct {
+    uint32_t lines;                 /*!< Lines per buffer */
+    size_t bytes;                   /*!< Memory of all buffers */
+    uint32_t flushes;               /*!< Flush calls for a full-screen frame */
+    uint32_t transactions;          /*!< Pixel data transactions for a full-screen frame */
+    uint32_t trans_bytes;           /*!< SPI transaction size the bus is set up with */
+} bsp_draw_buf_geom_t;
+
+/**
+ * @brief Requested draw buffer size, as set in the display configuration
+ */
+typedef struct {
+    size_t budget;                  /*!< Bytes all buffers together may take, 0 to size by lines or pixels */
+    size_t max_buffer;              /*!< Bytes a single buffer may take when sizing by budget */
+    uint32_t lines;                 /*!< Lines per buffer, 0 to size by pixels */
+    uint32_t pixels;                /*!< Pixels per buffer */
+} bsp_draw_buf_req_t;
+
+/**
+ * @brief Evaluate a buffer of a given height
+ *
+ * @param[in]  lines Lines per buffer, rounded down to the alignment and clamped to the screen
+ * @param[out] geom  Cost of the buffer
+ */
+void bsp_draw_buf_eval(const bsp_draw_buf_cfg_t* cfg, uint32_t lines, bsp_draw_buf_geom_t* geom);
+
+/**
+ * @brief Pick the buffer height for a memory budget
+ *
+ * Takes the fewest flush calls per frame the budget allows, then the fewest transactions among the heights
+ * that keep that flush count, then the smallest such height, so the rest of the budget stays free.
+ *
+ * @param[in]  budget     Bytes all buffers together may take
+ * @param[in]  max_buffer Bytes a single buffer may take, for example the largest free heap block
+ * @param[out] geom       Chosen geometry
+ * @return False if not even one aligned stripe fits
+ */
+bool bsp_draw_buf_tune(const bsp_draw_buf_cfg_t* cfg, size_t budget, size_t max_buffer, bsp_draw_buf_geom_t* geom);
+
+/**
+ * @brief Pick the buffer height for a request
+ *
+ * A budget takes precedence over lines, and lines over pixels, which are rounded down to whole lines. The
+ * buffer always holds whole aligned lines, so LVGL never renders a stripe the flush stage would have to split.
+ * If the budget does not fit one aligned stripe, the smallest buffer is taken.
+ *
+ * @param[in]  req  Requested size
+ * @param[out] geom Chosen geometry, geom->lines * cfg->width pixels per buffer
+ * @return False if the budget was too small
+ */
+bool bsp_draw_buf_select(const bsp_draw_buf_cfg_t* cfg, const bsp_draw_buf_req_t* req, bsp_draw_buf_geom_t* geom);
+
+#ifdef __cplusplus
+}
+#endif
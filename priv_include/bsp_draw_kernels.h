@@ -0,0 +1,59 @@
+/**
+ * @file
+ * @brief Fill and copy kernels of the BSP draw unit
+ *
+ * Solid fills are written one 32-bit word at a time once the destination is word aligned, with a pattern that
+ * repeats every one (RGB565, XRGB8888) or three (RGB888) words. Pixels are opaque and already in the byte
+ * order of the target buffer. This module is plain C with no ESP-IDF or LVGL dependencies.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Fill one line with a pixel
+ *
+ * @param[out] dst             First pixel
+ * @param[in]  count           Number of pixels
+ * @param[in]  pixel           Pixel bytes in memory order
+ * @param[in]  bytes_per_pixel 2, 3 or 4
+ */
+void bsp_draw_fill_line(uint8_t* dst, size_t count, const uint8_t* pixel, uint8_t bytes_per_pixel);
+
+/**
+ * @brief Fill a rectangle with a pixel
+ *
+ * @param[out] dst             First pixel of the rectangle
+ * @param[in]  stride          Bytes between the starts of two lines
+ * @param[in]  width           Pixels per line
+ * @param[in]  height          Number of lines
+ * @param[in]  pixel           Pixel bytes in memory order
+ * @param[in]  bytes_per_pixel 2, 3 or 4
+ */
+void bsp_draw_fill(uint8_t* dst, uint32_t stride, int32_t width, int32_t height, const uint8_t* pixel,
+                   uint8_t bytes_per_pixel);
+
+/**
+ * @brief Copy a rectangle between two buffers of the same pixel format
+ *
+ * Lines that are contiguous in both buffers are copied with a single memcpy().
+ *
+ * @param[out] dst        First byte of the destination rectangle
+ * @param[in]  dst_stride Bytes between two destination lines
+ * @param[in]  src        First byte of the source rectangle
+ * @param[in]  src_stride Bytes between two source lines
+ * @param[in]  line_bytes Bytes per line
+ * @param[in]  height     Number of lines
+ */
+void bsp_draw_copy(uint8_t* dst, uint32_t dst_stride, const uint8_t* src, uint32_t src_stride, size_t line_bytes,
+                   int32_t height);
+
+#ifdef __cplusplus
+}
+#endif
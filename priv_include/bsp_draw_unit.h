@@ -0,0 +1,37 @@
+/**
+ * @file
+ * @brief LVGL draw unit for opaque fills and image copies
+ *
+ * The unit claims solid rectangle fills and unscaled opaque RGB565/RGB888 image copies before the software
+ * renderer sees them. Everything else, and anything the unit cannot draw exactly as the software renderer
+ * would, stays with the software renderer. Large jobs in DMA-capable memory are split between the CPU and a
+ * GDMA memory-to-memory channel.
+ */
+
+#pragma once
+
+#include "bsp/config.h"
+
+#if (BSP_CONFIG_NO_GRAPHIC_LIB == 0)
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Register the draw unit with LVGL
+ *
+ * Call once after lvgl_port_init(). Without a free GDMA channel the unit still runs, on the CPU only.
+ *
+ * @return
+ *      - ESP_OK         On success
+ *      - ESP_ERR_NO_MEM No memory for the draw unit
+ */
+esp_err_t bsp_draw_unit_init(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BSP_CONFIG_NO_GRAPHIC_LIB == 0
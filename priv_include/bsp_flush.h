@@ -0,0 +1,137 @@
+/**
+ * @file
+ * @brief BSP flush stage between LVGL and the RM690B0 panel
+ *
+ * The flush stage replaces the flush callback installed by esp_lvgl_port. It coalesces the areas LVGL
+ * invalidates in one refresh cycle into the fewest CASET/RASET/RAMWR windows, converts pixels from the LVGL
+ * color format to the one used on the wire and keeps per-frame counters. Optionally it schedules windows
+ * against the panel scan, so none of them tears.
+ */
+
+#pragma once
+
+#include "bsp/config.h"
+
+#if (BSP_CONFIG_NO_GRAPHIC_LIB == 0)
+#include "esp_err.h"
+#include "esp_lcd_types.h"
+#include "lvgl.h"
+#include "bsp_rotate.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Source of the panel scan position for tear-free present
+ */
+typedef enum {
+    BSP_FLUSH_TE_OFF,        /*!< Windows are sent as soon as they are ready */
+    BSP_FLUSH_TE_GPIO,       /*!< TE line on a GPIO */
+    BSP_FLUSH_TE_SCANLINE,   /*!< GSCAN read once per frame */
+} bsp_flush_te_t;
+
+/**
+ * @brief Flush stage configuration
+ */
+typedef struct {
+    esp_lcd_panel_handle_t panel;    /*!< Panel the windows are written to */
+    esp_lcd_panel_io_handle_t io;    /*!< Panel IO used by the panel */
+    uint32_t bits_per_pixel;         /*!< Pixel size on the wire, 16 or 24. May be smaller than the LVGL format */
+    bool swap_bytes;                 /*!< Send RGB565 pixels most significant byte first */
+    bool dither;                     /*!< Dither when reducing LVGL RGB888/XRGB8888 to RGB565 on the wire */
+    uint32_t max_transfer_sz;        /*!< Largest SPI transaction the panel IO issues, in bytes */
+    uint32_t buffer_size;            /*!< LVGL draw buffer size in pixels (partial mode) */
+    bsp_rotate_t rotation;           /*!< Panel transform for LV_DISPLAY_ROTATION_0 */
+    bool full_frame;                 /*!< The display renders in direct mode into a full framebuffer */
+    uint32_t bounce_lines;           /*!< Lines per bounce buffer in full-frame mode, must be even */
+    bool flush_task;                 /*!< Rotate, convert and send windows from a task of their own (partial mode) */
+    int flush_task_core;             /*!< Core the flush task is pinned to */
+    uint32_t flush_task_priority;    /*!< Flush task priority */
+    uint32_t flush_task_stack;       /*!< Flush task stack size in bytes */
+    bsp_flush_te_t te;               /*!< Tear-free present source */
+    int te_gpio;                     /*!< TE GPIO for BSP_FLUSH_TE_GPIO, -1 falls back to scanline reads */
+    uint32_t refresh_hz;             /*!< Nominal panel refresh rate */
+} bsp_flush_config_t;
+
+/**
+ * @brief Take over the flush path of an LVGL display created by lvgl_port_add_disp()
+ *
+ * @param[in] disp   LVGL display
+ * @param[in] config Flush stage configuration
+ * @return
+ *      - ESP_OK              On success
+ *      - ESP_ERR_INVALID_ARG Parameter error
+ *      - ESP_ERR_NO_MEM      No memory for buffers or the flush task
+ */
+esp_err_t bsp_flush_attach(lv_display_t* disp, const bsp_flush_config_t* config);
+
+/**
+ * @brief Wait until no window is being flushed and the panel IO queue is empty
+ *
+ * Call with LVGL stopped, otherwise a new refresh may start right after this returns.
+ *
+ * @param[in] timeout_ms Longest time to wait in [ms]
+ * @return
+ *      - ESP_OK                On success
+ *      - ESP_ERR_INVALID_STATE The flush stage is not attached
+ *      - ESP_ERR_TIMEOUT       A window was still being flushed after timeout_ms
+ */
+esp_err_t bsp_flush_wait_idle(uint32_t timeout_ms);
+
+/**
+ * @brief Send a brightness value ahead of the next window
+ *
+ * The WRDISBV command then goes out between two windows, in the gap where the flush stage switches windows
+ * anyway, instead of competing with pixel data for the bus. Only one value waits at a time, a newer one
+ * replaces it.
+ *
+ * @param[in] level Brightness register value, or -1 to drop a waiting one
+ * @return True if the value will be sent, false if no window was flushed since the previous call. The caller
+ *         then writes the value itself, the bus is idle.
+ */
+bool bsp_flush_queue_brightness(int32_t level);
+
+/**
+ * @brief Account time a task waited for the LVGL lock, reported with the next frame
+ *
+ * @param[in] wait_us Wait time in [us]
+ */
+void bsp_flush_add_lock_wait(uint32_t wait_us);
+
+/**
+ * @brief Set the rows the panel scrolls in hardware
+ *
+ * The band is sent with the next refresh, starting without an offset. Windows are written wherever the band
+ * maps their rows, so the screen stays right whatever is drawn. Must be called with the LVGL lock held, the
+ * band is removed when the display is rotated.
+ *
+ * @param[in] y1 First LVGL row
+ * @param[in] y2 Last LVGL row, below y1 to remove the band
+ * @return
+ *      - ESP_OK                Band set
+ *      - ESP_ERR_INVALID_ARG   Rows outside the display
+ *      - ESP_ERR_NOT_SUPPORTED LVGL rows are panel columns at this rotation
+ *      - ESP_ERR_INVALID_STATE Flush stage not attached
+ */
+esp_err_t bsp_flush_set_scroll_band(int32_t y1, int32_t y2);
+
+/**
+ * @brief Scroll the band, sent with the next refresh
+ *
+ * Must be called with the LVGL lock held.
+ *
+ * @param[in] dy LVGL rows the content moves up, negative moves it down
+ */
+void bsp_flush_scroll(int32_t dy);
+
+/**
+ * @brief Rows scrolled since the last refresh, not sent yet
+ */
+int32_t bsp_flush_scroll_pending(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BSP_CONFIG_NO_GRAPHIC_LIB == 0
@@ -0,0 +1,114 @@
+/**
+ * @file
+ * @brief Rolling per-frame history of the BSP display
+ *
+ * The last BSP_FRAME_STATS_FRAMES frame records are kept in a fixed ring. A power-of-two histogram of every
+ * metric is updated as frames enter and leave the ring, so it always describes the same window as the ring.
+ * Nothing is allocated. This module is plain C with no ESP-IDF or LVGL dependencies.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BSP_FRAME_STATS_FRAMES      (64)
+#define BSP_FRAME_STATS_BUCKETS     (16)
+
+typedef enum {
+    BSP_FRAME_RENDER_US,    /*!< Refresh start to the last flush call, without time blocked on the bus */
+    BSP_FRAME_FLUSH_US,     /*!< First flush call to the end of the last transfer */
+    BSP_FRAME_BYTES,        /*!< Pixel bytes sent */
+    BSP_FRAME_AREAS,        /*!< Areas flushed after coalescing */
+    BSP_FRAME_DMA_WAIT_US,  /*!< Time LVGL waited for a transfer to finish */
+    BSP_FRAME_LOCK_WAIT_US, /*!< Time tasks waited for the LVGL lock */
+    BSP_FRAME_METRICS,
+} bsp_frame_metric_t;
+
+/**
+ * @brief One frame
+ */
+typedef struct {
+    int64_t timestamp_us;                   /*!< Refresh start */
+    uint32_t value[BSP_FRAME_METRICS];
+} bsp_frame_record_t;
+
+/**
+ * @brief Frame ring
+ */
+typedef struct {
+    bsp_frame_record_t frames[BSP_FRAME_STATS_FRAMES];
+    uint16_t histogram[BSP_FRAME_METRICS][BSP_FRAME_STATS_BUCKETS];
+    uint32_t count;     /*!< Frames in the ring */
+    uint32_t total;     /*!< Frames pushed since init, the newest one has sequence number total - 1 */
+} bsp_frame_stats_t;
+
+/**
+ * @brief Summary of one metric over the frames in the ring
+ */
+typedef struct {
+    uint32_t last;
+    uint32_t min;
+    uint32_t max;
+    uint32_t avg;
+    uint32_t p50;
+    uint32_t p95;
+} bsp_frame_summary_t;
+
+/**
+ * @brief Empty the ring
+ */
+void bsp_frame_stats_init(bsp_frame_stats_t* stats);
+
+/**
+ * @brief Add a frame, replacing the oldest one when the ring is full
+ */
+void bsp_frame_stats_push(bsp_frame_stats_t* stats, const bsp_frame_record_t* frame);
+
+/**
+ * @brief Get a frame by sequence number
+ *
+ * @return Frame, NULL if it has not been pushed yet or has already left the ring
+ */
+const bsp_frame_record_t* bsp_frame_stats_get(const bsp_frame_stats_t* stats, uint32_t seq);
+
+/**
+ * @brief Histogram bucket of a value: 0 for 0, else 1 + floor(log2(value)), capped to the last bucket
+ */
+uint32_t bsp_frame_stats_bucket(uint32_t value);
+
+/**
+ * @brief Copy one metric of every frame in the ring, oldest first
+ *
+ * @param[in]  stats  Ring
+ * @param[in]  metric Metric
+ * @param[out] values At least BSP_FRAME_STATS_FRAMES entries
+ * @return Number of values
+ */
+size_t bsp_frame_stats_values(const bsp_frame_stats_t* stats, bsp_frame_metric_t metric, uint32_t* values);
+
+/**
+ * @brief Summarize values copied by bsp_frame_stats_values(), all zero when count is 0
+ *
+ * @param[inout] values Values, oldest first, sorted on return
+ * @param[in]    count  Number of values
+ * @param[out]   out    Summary
+ */
+void bsp_frame_stats_summary(uint32_t* values, size_t count, bsp_frame_summary_t* out);
+
+/**
+ * @brief Encode bytes as base64, NUL terminated
+ *
+ * @param[in]  src Data
+ * @param[in]  len Length of the data
+ * @param[out] dst Output, at least 4 * ((len + 2) / 3) + 1 bytes
+ */
+void bsp_frame_stats_base64(const uint8_t* src, size_t len, char* dst);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,39 @@
+/**
+ * @file
+ * @brief Frame governor hooks
+ *
+ * The frame governor (bsp_display_governor_start()) follows touch interaction through this hook. Without LVGL
+ * there is no governor and the hook does nothing.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "bsp/config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if (BSP_CONFIG_NO_GRAPHIC_LIB == 0)
+/**
+ * @brief Report a touch sample to the frame governor
+ *
+ * Called by the LVGL touch input for every sample it reads, in the LVGL task. A touch that starts a boost
+ * raises the refresh rate and makes the refresh timer ready at once.
+ *
+ * @param[in] event_us Time of the touch event in [us]
+ * @param[in] pressed  A finger is down
+ */
+void bsp_governor_touch(int64_t event_us, bool pressed);
+#else
+static inline void bsp_governor_touch(int64_t event_us, bool pressed) {
+    (void)event_us;
+    (void)pressed;
+}
+#endif // BSP_CONFIG_NO_GRAPHIC_LIB == 0
+
+#ifdef __cplusplus
+}
+#endif
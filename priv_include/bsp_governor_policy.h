@@ -0,0 +1,77 @@
+/**
+ * @file
+ * @brief Refresh rate policy of the frame governor
+ *
+ * Picks the LVGL refresh rate from what happened recently: the boost rate while a finger is down and shortly
+ * after, and the target rate otherwise. Changes that keep running on every refresh cycle without anyone
+ * touching the screen, like a spinner or a looping animation, are paced down further: the rate halves after
+ * every idle period down to the idle rate. This module is plain C with no ESP-IDF or LVGL dependencies.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Policy configuration
+ */
+typedef struct {
+    uint32_t target_hz;     /*!< Rate while the UI changes */
+    uint32_t idle_hz;       /*!< Lowest rate for changes that run on without touch */
+    uint32_t boost_hz;      /*!< Rate during touch interaction */
+    uint32_t idle_ms;       /*!< Time of changes without touch before each halving of the rate */
+    uint32_t boost_ms;      /*!< Time the boost lasts after the finger is lifted */
+} bsp_governor_policy_cfg_t;
+
+/**
+ * @brief Policy state
+ */
+typedef struct {
+    bsp_governor_policy_cfg_t cfg;
+    int64_t run_us;         /*!< First of the current run of refresh cycles with changes, 0 without one */
+    int64_t boost_until_us; /*!< End of the boost after the last release */
+    bool pressed;
+} bsp_governor_policy_t;
+
+/**
+ * @brief Initialize the policy, starting at the target rate
+ *
+ * Rates are clamped so that idle_hz <= target_hz <= boost_hz.
+ */
+void bsp_governor_policy_init(bsp_governor_policy_t* policy, const bsp_governor_policy_cfg_t* cfg);
+
+/**
+ * @brief Record a refresh cycle
+ *
+ * A cycle with nothing to render ends the current run of changes.
+ *
+ * @param[in] now_us  Time of the cycle in [us]
+ * @param[in] changed The cycle had something to render
+ */
+void bsp_governor_policy_frame(bsp_governor_policy_t* policy, int64_t now_us, bool changed);
+
+/**
+ * @brief Record a touch sample
+ *
+ * @param[in] now_us  Time of the sample in [us]
+ * @param[in] pressed A finger is down
+ * @return True if this sample started a boost
+ */
+bool bsp_governor_policy_touch(bsp_governor_policy_t* policy, int64_t now_us, bool pressed);
+
+/**
+ * @brief Refresh rate for now
+ *
+ * @param[in] now_us Time in [us]
+ * @return Rate in [Hz]
+ */
+uint32_t bsp_governor_policy_rate(const bsp_governor_policy_t* policy, int64_t now_us);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,21 @@
+/**
+ * @file
+ * @brief BSP I2C bus manager internals
+ */
+
+#pragma once
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Start the bus manager task, called once the I2C bus exists
+ */
+esp_err_t bsp_i2c_sched_start(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,84 @@
+/**
+ * @file
+ * @brief Scheduling core of the BSP I2C bus manager
+ *
+ * Jobs wait in one FIFO per priority, and the highest priority is always served first. A register read
+ * from a device that allows batching picks up every other queued read of the same device whose register
+ * range touches or overlaps its own, so they all go out as one bus transaction. Reads never move ahead of a
+ * write to the same device, nor of any function job, which may talk to any device. This module only orders
+ * jobs and never touches the bus. It is plain C with no ESP-IDF dependencies.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BSP_I2C_QUEUE_PRIORITIES    (4)
+
+typedef enum {
+    BSP_I2C_JOB_READ_REG,   /*!< Write a register address, then read len bytes */
+    BSP_I2C_JOB_WRITE,      /*!< Write len bytes */
+    BSP_I2C_JOB_EXEC,       /*!< Run a function that accesses the bus itself, e.g. a vendor driver */
+} bsp_i2c_job_kind_t;
+
+/**
+ * @brief Queued job, embedded in the caller's own job structure
+ */
+typedef struct bsp_i2c_job {
+    struct bsp_i2c_job* next;
+    const void* dev;        /*!< Device the job talks to, compared by identity only, NULL for EXEC */
+    bsp_i2c_job_kind_t kind;
+    uint8_t priority;       /*!< 0 is served first */
+    bool batchable;         /*!< READ_REG only: the device auto-increments register addresses */
+    uint8_t reg;
+    size_t len;
+} bsp_i2c_job_t;
+
+/**
+ * @brief Job queue
+ */
+typedef struct {
+    bsp_i2c_job_t* head[BSP_I2C_QUEUE_PRIORITIES];
+    bsp_i2c_job_t* tail[BSP_I2C_QUEUE_PRIORITIES];
+    size_t depth;
+} bsp_i2c_queue_t;
+
+/**
+ * @brief One bus transaction, serving one or more jobs
+ */
+typedef struct {
+    bsp_i2c_job_t* jobs;    /*!< Served jobs linked through next, the first job followed by the joined ones */
+    size_t count;           /*!< Number of jobs */
+    uint8_t reg;            /*!< READ_REG: first register of the combined read */
+    size_t len;             /*!< READ_REG: length of the combined read */
+} bsp_i2c_batch_t;
+
+/**
+ * @brief Initialize an empty queue
+ */
+void bsp_i2c_queue_init(bsp_i2c_queue_t* queue);
+
+/**
+ * @brief Append a job behind the other jobs of its priority
+ */
+void bsp_i2c_queue_push(bsp_i2c_queue_t* queue, bsp_i2c_job_t* job);
+
+/**
+ * @brief Take the next transaction
+ *
+ * @param[in]  queue     Queue
+ * @param[in]  max_bytes Largest combined read
+ * @param[out] batch     Jobs served by the transaction
+ * @return false if the queue is empty
+ */
+bool bsp_i2c_queue_pop(bsp_i2c_queue_t* queue, size_t max_bytes, bsp_i2c_batch_t* batch);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,84 @@
+/**
+ * @file
+ * @brief Re-clockable panel IO for the RM690B0
+ *
+ * esp_lcd has no way to change the clock of an SPI panel IO. The BSP therefore hands the panel driver and the
+ * user a proxy IO that forwards to an SPI panel IO it owns. Changing the clock replaces the SPI IO underneath
+ * while every handle the rest of the system holds stays valid, and the panel keeps its on-chip state.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_lcd_panel_io.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* RM690B0 QSPI command framing: opcode in bits 31..24, DCS command in bits 15..8 */
+#define BSP_LCD_QSPI_CMD_WRITE(cmd)     ((0x02U << 24) | ((uint32_t)(cmd) << 8))
+#define BSP_LCD_QSPI_CMD_READ(cmd)      ((0x03U << 24) | ((uint32_t)(cmd) << 8))
+
+#define BSP_LCD_CMD_NOP                 (0x00)
+#define BSP_LCD_CMD_RDDID               (0x04)
+#define BSP_LCD_CMD_VSCRDEF             (0x33)
+#define BSP_LCD_CMD_TEON                (0x35)
+#define BSP_LCD_CMD_VSCSAD              (0x37)
+#define BSP_LCD_CMD_GSCAN               (0x45)
+#define BSP_LCD_CMD_WRDISBV             (0x51)
+
+/* Lines of vertical blanking the RM690B0 scans after TE and before row 0, GSCAN counts them */
+#define BSP_LCD_TE_BLANK_ROWS           (16)
+
+/**
+ * @brief Create the proxy panel IO
+ *
+ * Only one instance exists, calling this again after bsp_lcd_io_del() is allowed.
+ *
+ * @param[in]  host   SPI host the panel is attached to
+ * @param[in]  config SPI panel IO configuration, copied
+ * @param[out] ret_io Proxy IO handle
+ * @return
+ *      - ESP_OK                On success
+ *      - ESP_ERR_INVALID_STATE The proxy already exists
+ *      - Else                  esp_lcd failure
+ */
+esp_err_t bsp_lcd_io_new(spi_host_device_t host, const esp_lcd_panel_io_spi_config_t* config,
+                         esp_lcd_panel_io_handle_t* ret_io);
+
+/**
+ * @brief Get the proxy IO, or NULL if it does not exist
+ */
+esp_lcd_panel_io_handle_t bsp_lcd_io_get(void);
+
+/**
+ * @brief Recreate the SPI panel IO with a new pixel clock
+ *
+ * Waits for all queued transactions, including pixel data, to finish first. If the new clock is rejected, the
+ * previous one is restored. If that fails too, the proxy stays without an SPI IO and its transfers return
+ * ESP_ERR_INVALID_STATE until a later call succeeds.
+ */
+esp_err_t bsp_lcd_io_set_pclk(uint32_t pclk_hz);
+
+/**
+ * @brief Current pixel clock in [Hz]
+ */
+uint32_t bsp_lcd_io_get_pclk(void);
+
+/**
+ * @brief Wait until every queued transaction, including pixel data, has been sent
+ */
+esp_err_t bsp_lcd_io_wait_idle(void);
+
+/**
+ * @brief Stop delivering transfer-done callbacks to the registered listener
+ *
+ * Used while the BSP itself pushes pixels the flush stage did not issue.
+ */
+void bsp_lcd_io_mute_callbacks(bool mute);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,76 @@
+/**
+ * @file
+ * @brief Display power manager hooks
+ *
+ * The power manager (bsp_display_power_start()) follows touch activity and brightness changes through these
+ * hooks. Without LVGL there is no power manager and the hooks pass everything through.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_lcd_types.h"
+#include "esp_lcd_touch.h"
+#include "bsp/config.h"
+#include "bsp_brightness.h"
+
+#if (BSP_CONFIG_NO_GRAPHIC_LIB == 0)
+#include "lvgl.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if (BSP_CONFIG_NO_GRAPHIC_LIB == 0)
+/**
+ * @brief Hand the started display to the power manager
+ *
+ * @param[in] disp  LVGL display paused while the panel sleeps
+ * @param[in] panel RM690B0 panel
+ * @param[in] tp    Touch controller, its INT line wakes the chip from light sleep
+ * @return
+ *      - ESP_OK              On success
+ *      - ESP_ERR_INVALID_ARG disp or panel is NULL
+ */
+esp_err_t bsp_power_attach(lv_display_t* disp, esp_lcd_panel_handle_t panel, esp_lcd_touch_handle_t tp);
+
+/**
+ * @brief Report a touch to the power manager
+ *
+ * Called by the touch reader for every sample with a finger down. Wakes the panel if it is asleep.
+ *
+ * @param[in] event_us Time of the touch event in [us]
+ * @return True if the panel was on, false if the touch only woke it and must not reach LVGL
+ */
+bool bsp_power_touch_activity(int64_t event_us);
+
+/**
+ * @brief Set the brightness level of the active state
+ *
+ * Ramped to right away while the display is active, otherwise restored when it wakes up.
+ *
+ * @param[in] brightness_percent Brightness in [%]
+ * @param[in] fade_ms            Ramp duration in [ms], 0 writes the value before returning
+ * @return
+ *      - ESP_OK              On success
+ *      - ESP_ERR_INVALID_ARG brightness_percent out of range
+ *      - Error from the panel IO otherwise
+ */
+esp_err_t bsp_power_brightness_set(int brightness_percent, uint32_t fade_ms);
+#else
+static inline bool bsp_power_touch_activity(int64_t event_us) {
+    (void)event_us;
+    return true;
+}
+
+static inline esp_err_t bsp_power_brightness_set(int brightness_percent, uint32_t fade_ms) {
+    return bsp_brightness_ramp(brightness_percent, fade_ms);
+}
+#endif // BSP_CONFIG_NO_GRAPHIC_LIB == 0
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,64 @@
+/**
+ * @file
+ * @brief Software rotation for panels that cannot rotate in hardware
+ *
+ * The transform matches esp_lcd_panel_swap_xy() followed by esp_lcd_panel_mirror(): coordinates are swapped
+ * first, then mirrored inside the physical panel. This module is plain C with no ESP-IDF or LVGL dependencies.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "bsp_area.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Coordinate transform from LVGL to panel coordinates
+ */
+typedef struct {
+    bool swap_xy;
+    bool mirror_x;
+    bool mirror_y;
+} bsp_rotate_t;
+
+static inline bool bsp_rotate_is_identity(const bsp_rotate_t* rot) {
+    return !rot->swap_xy && !rot->mirror_x && !rot->mirror_y;
+}
+
+/**
+ * @brief Map an area from LVGL to panel coordinates
+ *
+ * @param[in]  rot      Transform
+ * @param[in]  area     Area in LVGL coordinates
+ * @param[in]  hor_res  LVGL horizontal resolution
+ * @param[in]  ver_res  LVGL vertical resolution
+ * @param[out] res      Area in panel coordinates
+ */
+void bsp_rotate_area(const bsp_rotate_t* rot, const bsp_area_t* area, int32_t hor_res, int32_t ver_res,
+                     bsp_area_t* res);
+
+/**
+ * @brief Copy a block of pixels into panel order
+ *
+ * The source is processed in small square tiles, so both the reads and the strided writes of a tile stay
+ * within a few cache lines.
+ *
+ * @param[in]  rot             Transform
+ * @param[in]  src             First pixel of the block
+ * @param[in]  src_stride      Source line length in bytes
+ * @param[in]  width           Block width in pixels
+ * @param[in]  height          Block height in pixels
+ * @param[in]  bytes_per_pixel 2, 3 or 4
+ * @param[out] dst             Packed destination, (swap_xy ? height : width) pixels per line
+ */
+void bsp_rotate_blit(const bsp_rotate_t* rot, const void* src, size_t src_stride, int32_t width, int32_t height,
+                     uint32_t bytes_per_pixel, void* dst);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,119 @@
+/**
+ * @file
+ * @brief Command decoder and wire model of the simulated RM690B0
+ *
+ * Decodes CASET/RASET windows, MADCTL, COLMOD and the scroll registers, writes RAMWR payloads into a
+ * framebuffer in the native panel orientation, and accounts the time every transaction would take on the QSPI
+ * link. bsp_sim_panel.c wraps it in esp_lcd panel and IO handles.
+ *
+ * This module is plain C with no ESP-IDF or LVGL dependencies, so window planning can be replayed against it on
+ * a Linux host.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BSP_SIM_CMD_SLPIN       (0x10)
+#define BSP_SIM_CMD_SLPOUT      (0x11)
+#define BSP_SIM_CMD_INVOFF      (0x20)
+#define BSP_SIM_CMD_INVON       (0x21)
+#define BSP_SIM_CMD_DISPOFF     (0x28)
+#define BSP_SIM_CMD_DISPON      (0x29)
+#define BSP_SIM_CMD_CASET       (0x2A)
+#define BSP_SIM_CMD_RASET       (0x2B)
+#define BSP_SIM_CMD_RAMWR       (0x2C)
+#define BSP_SIM_CMD_VSCRDEF     (0x33)
+#define BSP_SIM_CMD_MADCTL      (0x36)
+#define BSP_SIM_CMD_VSCSAD      (0x37)
+#define BSP_SIM_CMD_COLMOD      (0x3A)
+#define BSP_SIM_CMD_RAMWRC      (0x3C)
+
+#define BSP_SIM_MADCTL_MY       (0x80)
+#define BSP_SIM_MADCTL_MX       (0x40)
+#define BSP_SIM_MADCTL_MV       (0x20)
+
+#define BSP_SIM_COLMOD_RGB565   (0x55)
+#define BSP_SIM_COLMOD_RGB888   (0x77)
+
+/**
+ * @brief Traffic counters, laid out like bsp_display_sim_stats_t
+ */
+typedef struct {
+    uint32_t commands;      /*!< Command and parameter transactions */
+    uint32_t pixel_writes;  /*!< Pixel data transactions */
+    uint64_t pixel_bytes;   /*!< Pixel data bytes */
+    uint64_t wire_ns;       /*!< Time of all transactions on the link in [ns] */
+} bsp_sim_stats_t;
+
+/**
+ * @brief State of one simulated panel
+ */
+typedef struct {
+    uint8_t* fb;                /*!< Panel memory, h_res x v_res pixels of 3 bytes at most, may be NULL */
+    uint16_t h_res;             /*!< Native columns */
+    uint16_t v_res;             /*!< Native rows */
+    uint32_t pclk_hz;           /*!< Link clock */
+    uint32_t trans_overhead_ns; /*!< Fixed cost of every transaction */
+    uint32_t bytes_per_pixel;
+    uint8_t madctl;
+    bool display_on;
+    uint16_t x0, x1, y0, y1;    /*!< Current window, inclusive, in addressing coordinates */
+    uint16_t cx, cy;            /*!< Write cursor inside the window */
+    uint16_t scroll_top;        /*!< VSCRDEF top fixed rows */
+    uint16_t scroll_rows;       /*!< VSCRDEF scroll area rows */
+    uint16_t scroll_start;      /*!< VSCSAD, memory row shown at the top of the scroll area */
+    bsp_sim_stats_t stats;
+} bsp_sim_core_t;
+
+/**
+ * @brief Reset a panel to its power-on state, RGB565 with no window, and clear its counters
+ *
+ * @param[out] core  Panel
+ * @param[in]  fb    Framebuffer of h_res * v_res * 3 bytes, may be NULL to only model the link
+ */
+void bsp_sim_core_init(bsp_sim_core_t* core, uint8_t* fb, uint16_t h_res, uint16_t v_res, uint32_t pclk_hz,
+                       uint32_t trans_overhead_ns);
+
+/**
+ * @brief Time one transaction takes on the link
+ *
+ * Every transaction carries a 32-clock opcode and address phase on one line, then its payload on one or four
+ * lines, plus the fixed overhead.
+ */
+uint64_t bsp_sim_core_wire_ns(const bsp_sim_core_t* core, size_t bytes, bool quad);
+
+/**
+ * @brief Add one transaction to the counters
+ *
+ * @param[in] pixel_bytes Pixel payload, 0 for a command or parameter transaction
+ */
+void bsp_sim_core_account(bsp_sim_core_t* core, size_t pixel_bytes, size_t bytes, bool quad);
+
+/**
+ * @brief Apply a command with its parameters, the caller accounts the transaction
+ */
+void bsp_sim_core_tx_param(bsp_sim_core_t* core, uint8_t cmd, const uint8_t* param, size_t size);
+
+/**
+ * @brief Write RAMWR or RAMWRC pixel data at the write cursor, the caller accounts the transaction
+ *
+ * RAMWR restarts at the top left of the window, RAMWRC continues. Data wraps to the top of the window after
+ * its last row like on the RM690B0.
+ */
+void bsp_sim_core_tx_color(bsp_sim_core_t* core, uint8_t cmd, const uint8_t* data, size_t size);
+
+/**
+ * @brief Memory row shown on a screen row, see bsp_display_sim_get_screen_row()
+ */
+uint32_t bsp_sim_core_screen_row(const bsp_sim_core_t* core, uint32_t row);
+
+#ifdef __cplusplus
+}
+#endif
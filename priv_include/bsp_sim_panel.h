@@ -0,0 +1,44 @@
+/**
+ * @file
+ * @brief Simulated RM690B0 panel IO and panel
+ *
+ * The simulated IO decodes the same QSPI command stream the real panel receives. It tracks CASET/RASET
+ * windows and MADCTL, writes RAMWR payloads into an in-memory framebuffer, and models the time every
+ * transaction would take on the QSPI link at the configured clock. Pixel transfers complete immediately.
+ * The simulated panel replaces esp_lcd_rm690b0, so no GPIO or SPI peripheral is touched.
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include "esp_lcd_panel_io.h"
+#include "esp_lcd_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Create the simulated panel IO
+ *
+ * Only one instance exists at a time. pclk_hz, quad_mode, on_color_trans_done and user_ctx of the SPI
+ * configuration are honoured.
+ *
+ * @param[in]  config SPI panel IO configuration
+ * @param[out] ret_io Simulated IO handle
+ */
+esp_err_t bsp_sim_io_new(const esp_lcd_panel_io_spi_config_t* config, esp_lcd_panel_io_handle_t* ret_io);
+
+/**
+ * @brief Create the simulated panel on top of a panel IO
+ *
+ * @param[in]  io             Panel IO, usually the BSP proxy IO over the simulated IO
+ * @param[in]  bits_per_pixel 16 or 24
+ * @param[out] ret_panel      Panel handle
+ */
+esp_err_t bsp_sim_panel_new(esp_lcd_panel_io_handle_t io, uint32_t bits_per_pixel,
+                            esp_lcd_panel_handle_t* ret_panel);
+
+#ifdef __cplusplus
+}
+#endif
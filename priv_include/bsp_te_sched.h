@@ -0,0 +1,99 @@
+/**
+ * @file
+ * @brief Race-the-beam scheduling of panel writes
+ *
+ * The RM690B0 refreshes the AMOLED from its own memory, top to bottom, once per frame. A window written while
+ * the scan passes through it shows part of the old and part of the new content: a tear. This module models the
+ * scan position from tearing-effect (TE) events or scanline reads, and finds the earliest time a window can be
+ * written without its write and the scan crossing. This module is plain C with no ESP-IDF or LVGL dependencies.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Panel scan timing
+ */
+typedef struct {
+    uint32_t frame_us;      /*!< Nominal refresh period in [us] */
+    int32_t rows;           /*!< Active rows, scanned from row 0 */
+    int32_t blank_rows;     /*!< Rows of vertical blanking between TE and row 0 */
+} bsp_te_sched_cfg_t;
+
+/**
+ * @brief Scan model
+ */
+typedef struct {
+    bsp_te_sched_cfg_t cfg;
+    int64_t te_us;          /*!< Time of the last TE, 0 until one was seen */
+    uint32_t period_us;     /*!< Refresh period, follows the TE events */
+    uint32_t period_x8;     /*!< Averaged period in [us / 8], so the average does not round towards one side */
+    uint32_t slack_us;      /*!< How far the modeled scan may be off the real one in [us] */
+} bsp_te_sched_t;
+
+/**
+ * @brief Initialize the model with the nominal period and no known scan position
+ */
+void bsp_te_sched_init(bsp_te_sched_t* sched, const bsp_te_sched_cfg_t* cfg);
+
+/**
+ * @brief Record a TE event, the start of vertical blanking
+ *
+ * The period follows the time between consecutive events. Intervals far from the current period, after a
+ * missed event or a panel sleep, only move the scan position. How far events land from where the model
+ * expected them widens the margin of bsp_te_sched_start().
+ *
+ * @param[in] te_us Time of the event in [us]
+ */
+void bsp_te_sched_on_te(bsp_te_sched_t* sched, int64_t te_us);
+
+/**
+ * @brief Record a scanline read
+ *
+ * The scan may be anywhere on the reported line, the model puts it in the middle and widens the margin of
+ * bsp_te_sched_start() by half a line.
+ *
+ * @param[in] now_us Time of the read in [us]
+ * @param[in] line   Line the panel reported, counted from TE and including blanking
+ */
+void bsp_te_sched_on_scanline(bsp_te_sched_t* sched, int64_t now_us, int32_t line);
+
+/**
+ * @brief How many lines ago the scan passed a row
+ *
+ * Sorting windows by this value, smallest first, writes them in the order the scan left them.
+ *
+ * @param[in] now_us Time in [us]
+ * @param[in] row    Active row
+ * @return Lines in [0, rows + blank_rows), 0 without a known scan position
+ */
+int32_t bsp_te_sched_lines_behind(const bsp_te_sched_t* sched, int64_t now_us, int32_t row);
+
+/**
+ * @brief Earliest time a window can be written without tearing
+ *
+ * A progressive write fills rows top to bottom at a constant rate, as the panel does for a window without
+ * row swap or vertical mirroring. It may start as soon as the scan has left its first row, as long as it
+ * neither catches up with the scan nor is caught by the scan of the next frame. Any other write must happen
+ * entirely while the scan is outside the window.
+ *
+ * @param[in]  earliest_us Earliest time the write can start in [us]
+ * @param[in]  row1        First row of the window
+ * @param[in]  row2        Last row of the window
+ * @param[in]  write_us    Time the write takes on the bus in [us]
+ * @param[in]  progressive Rows are written top to bottom
+ * @param[out] synced      False if no start time avoids the scan, or the scan position is unknown
+ * @return Start time in [us], earliest_us when not synced
+ */
+int64_t bsp_te_sched_start(const bsp_te_sched_t* sched, int64_t earliest_us, int32_t row1, int32_t row2,
+                           uint32_t write_us, bool progressive, bool* synced);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,70 @@
+/**
+ * @file
+ * @brief BSP touch reader between the CST226SE and LVGL
+ *
+ * A reader task owns the I2C traffic to the touch controller. It is woken by the controller INT line, or
+ * polls with a period that backs off while no finger is down. Samples are filtered (see bsp_touch_filter.h) and
+ * queued. LVGL only drains the queue, so its indev read period no longer costs any I2C transactions.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_lcd_touch.h"
+#include "bsp/config.h"
+
+#if (BSP_CONFIG_NO_GRAPHIC_LIB == 0)
+#include "lvgl.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief One touch sample
+ */
+typedef struct {
+    uint16_t x;
+    uint16_t y;
+    bool pressed;
+    int64_t timestamp_us;   /*!< Time of the touch event: INT edge, or the read when polling */
+} bsp_touch_sample_t;
+
+/**
+ * @brief Start the reader task
+ *
+ * The interrupt mode is used when the touch handle was created with an INT GPIO, polling otherwise.
+ *
+ * @param[in] tp Touch handle
+ * @return
+ *      - ESP_OK                On success
+ *      - ESP_ERR_INVALID_STATE The reader is already running
+ *      - ESP_ERR_NO_MEM        No memory for the task or the queue
+ */
+esp_err_t bsp_touch_reader_start(esp_lcd_touch_handle_t tp);
+
+/**
+ * @brief Take the oldest queued sample without blocking
+ *
+ * @param[out] sample Sample
+ * @return true if a sample was taken
+ */
+bool bsp_touch_reader_take(bsp_touch_sample_t* sample);
+
+#if (BSP_CONFIG_NO_GRAPHIC_LIB == 0)
+/**
+ * @brief Create an LVGL pointer input device fed by the reader task
+ *
+ * @param[in] disp LVGL display
+ * @param[in] tp   Touch handle
+ * @return Input device, NULL on error
+ */
+lv_indev_t* bsp_touch_indev_create(lv_display_t* disp, esp_lcd_touch_handle_t tp);
+#endif // BSP_CONFIG_NO_GRAPHIC_LIB == 0
+
+#ifdef __cplusplus
+}
+#endif
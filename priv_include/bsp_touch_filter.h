@@ -0,0 +1,75 @@
+/**
+ * @file
+ * @brief Touch sample filtering and prediction
+ *
+ * Each new contact runs through an optional median filter against single-sample spikes, then an optional
+ * 1-euro filter. That filter smooths strongly while the finger is slow and follows closely while it moves
+ * fast. Finally, the point can be moved ahead along the finger velocity to hide the latency between reading
+ * the controller and showing the frame. This module is plain C with no ESP-IDF or LVGL dependencies.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BSP_TOUCH_FILTER_MAX_TAPS   (5)
+
+/**
+ * @brief Filter configuration
+ */
+typedef struct {
+    uint8_t median_taps;    /*!< Median window, 1 (off), 3 or 5 */
+    bool one_euro;          /*!< Enable the 1-euro filter */
+    float min_cutoff_hz;    /*!< 1-euro cutoff at rest, lower removes more jitter */
+    float beta;             /*!< 1-euro cutoff increase per px/s of speed, higher reduces lag */
+    float d_cutoff_hz;      /*!< Cutoff of the velocity estimate */
+    uint32_t predict_us;    /*!< Move the point this far ahead along the velocity, 0 disables prediction */
+    uint16_t x_max;         /*!< Predicted points are clamped to [0, x_max] */
+    uint16_t y_max;         /*!< Predicted points are clamped to [0, y_max] */
+} bsp_touch_filter_cfg_t;
+
+typedef struct {
+    uint16_t window[BSP_TOUCH_FILTER_MAX_TAPS];
+    float value;
+    float velocity;
+} bsp_touch_filter_axis_t;
+
+/**
+ * @brief Filter state
+ */
+typedef struct {
+    bsp_touch_filter_cfg_t cfg;
+    bsp_touch_filter_axis_t axis[2];
+    uint8_t taps;
+    uint8_t head;
+    int64_t last_us;
+    bool tracking;
+} bsp_touch_filter_t;
+
+/**
+ * @brief Initialize a filter
+ */
+void bsp_touch_filter_init(bsp_touch_filter_t* filter, const bsp_touch_filter_cfg_t* cfg);
+
+/**
+ * @brief Filter one sample
+ *
+ * The first sample of a contact passes unchanged. A release keeps the last filtered, unpredicted position
+ * and ends the contact.
+ *
+ * @param[in]     filter    Filter state
+ * @param[in]     t_us      Time of the sample in [us]
+ * @param[in]     pressed   A finger is down
+ * @param[in,out] x         Raw column in, filtered column out
+ * @param[in,out] y         Raw row in, filtered row out
+ */
+void bsp_touch_filter_apply(bsp_touch_filter_t* filter, int64_t t_us, bool pressed, uint16_t* x, uint16_t* y);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,37 @@
+/**
+ * @file
+ * @brief UI update queue drained by the LVGL task
+ *
+ * Backs bsp_display_post(). Updates wait in a lock-free ring (see bsp_ui_ring.h) and are applied at the
+ * start of each refresh, before LVGL lays out and renders the screen.
+ */
+
+#pragma once
+
+#include "bsp/config.h"
+
+#if (BSP_CONFIG_NO_GRAPHIC_LIB == 0)
+#include "esp_err.h"
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Start draining the queue at the start of every refresh of a display
+ *
+ * Attach before the flush stage, so updates applied in a refresh are part of the areas it coalesces.
+ *
+ * @param[in] disp LVGL display
+ * @return
+ *      - ESP_OK              On success
+ *      - ESP_ERR_INVALID_ARG disp is NULL
+ */
+esp_err_t bsp_ui_queue_attach(lv_display_t* disp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BSP_CONFIG_NO_GRAPHIC_LIB == 0
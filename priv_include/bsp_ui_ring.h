@@ -0,0 +1,94 @@
+/**
+ * @file
+ * @brief Lock-free multi-producer, single-consumer ring of UI update messages
+ *
+ * Bounded ring with a sequence number per cell. Producers claim a cell with a compare-and-swap on the tail and
+ * publish it by advancing its sequence number, so a producer never waits for another one or for the
+ * consumer: a full ring is reported instead. The single consumer reads published cells in order and may
+ * look ahead before releasing them. This module is plain C11 with no ESP-IDF or LVGL dependencies.
+ */
+
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BSP_UI_RING_TEXT_MAX    (32)
+
+/**
+ * @brief UI update message
+ */
+typedef struct {
+    void* obj;              /*!< Target object */
+    void (*apply)(void);    /*!< Function applying the update, cast back by the consumer */
+    bool coalesce;          /*!< A later message with the same obj and apply replaces this one */
+    union {
+        int32_t value;
+        void* ptr;
+        char text[BSP_UI_RING_TEXT_MAX];
+    } arg;
+} bsp_ui_msg_t;
+
+typedef struct {
+    _Atomic uint32_t seq;
+    bsp_ui_msg_t msg;
+} bsp_ui_cell_t;
+
+/**
+ * @brief Ring over caller-provided cells
+ */
+typedef struct {
+    bsp_ui_cell_t* cells;
+    uint32_t mask;
+    _Atomic uint32_t tail;  /*!< Next position a producer claims */
+    _Atomic uint32_t head;  /*!< Next position the consumer reads, only written by the consumer */
+} bsp_ui_ring_t;
+
+/**
+ * @brief Initialize an empty ring
+ *
+ * @param[in] ring     Ring
+ * @param[in] cells    Storage
+ * @param[in] capacity Number of cells, a power of two
+ */
+void bsp_ui_ring_init(bsp_ui_ring_t* ring, bsp_ui_cell_t* cells, uint32_t capacity);
+
+/**
+ * @brief Add a message, safe from any number of producers at once
+ *
+ * @param[in]    ring    Ring
+ * @param[in]    msg     Message, copied
+ * @param[inout] retries Incremented for every lost race against another producer
+ * @return false if the ring is full
+ */
+bool bsp_ui_ring_push(bsp_ui_ring_t* ring, const bsp_ui_msg_t* msg, uint32_t* retries);
+
+/**
+ * @brief Number of published messages the consumer can read, in order, up to max
+ */
+size_t bsp_ui_ring_ready(const bsp_ui_ring_t* ring, size_t max);
+
+/**
+ * @brief Message at an offset from the oldest unreleased one, offset below bsp_ui_ring_ready()
+ */
+bsp_ui_msg_t* bsp_ui_ring_at(bsp_ui_ring_t* ring, size_t offset);
+
+/**
+ * @brief Hand the oldest count messages back to the producers
+ */
+void bsp_ui_ring_release(bsp_ui_ring_t* ring, size_t count);
+
+/**
+ * @brief Messages claimed by producers and not released yet
+ */
+uint32_t bsp_ui_ring_depth(const bsp_ui_ring_t* ring);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,89 @@
+/**
+ * @file
+ * @brief Panel memory layout under hardware vertical scrolling
+ *
+ * The RM690B0 can scroll a band of rows (VSCRDEF) by showing it from a start row in its memory (VSCSAD), wrapping
+ * around inside the band. Panel memory then no longer matches the screen row for row: the band is a ring. This
+ * module tracks the band and the scroll offset, and maps screen rows to the memory rows a write has to go to.
+ * Rows are physical panel rows, counted in scan order. This module is plain C with no ESP-IDF or LVGL
+ * dependencies.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* A row range maps to at most this many runs: above the band, two inside it and below it */
+#define BSP_VSCROLL_MAX_SPANS   (4)
+
+/**
+ * @brief Scroll state
+ */
+typedef struct {
+    int32_t rows;           /*!< Panel rows */
+    int32_t top;            /*!< First row of the band */
+    int32_t height;         /*!< Rows in the band, 0 without one */
+    int32_t offset;         /*!< Screen row top shows memory row top + offset */
+} bsp_vscroll_t;
+
+/**
+ * @brief Screen rows written to consecutive memory rows
+ */
+typedef struct {
+    int32_t row1;           /*!< First screen row */
+    int32_t row2;           /*!< Last screen row */
+    int32_t mem_row1;       /*!< Memory row of row1, the run continues row for row */
+} bsp_vscroll_span_t;
+
+/**
+ * @brief Initialize without a band, memory matches the screen
+ *
+ * @param[in] rows Panel rows
+ */
+void bsp_vscroll_init(bsp_vscroll_t* vscroll, int32_t rows);
+
+/**
+ * @brief Define the band, with no offset
+ *
+ * @param[in] top    First row, clamped to the panel
+ * @param[in] height Rows, clamped to the panel. 0 removes the band.
+ */
+void bsp_vscroll_set_band(bsp_vscroll_t* vscroll, int32_t top, int32_t height);
+
+/**
+ * @brief Move the content of the band
+ *
+ * @param[in] dy Rows the content moves towards row 0, negative moves it the other way
+ */
+void bsp_vscroll_scroll(bsp_vscroll_t* vscroll, int32_t dy);
+
+/**
+ * @brief VSCRDEF parameters
+ *
+ * @param[out] def Top fixed rows, band rows and bottom fixed rows. A panel without a band scrolls all rows.
+ */
+void bsp_vscroll_def(const bsp_vscroll_t* vscroll, uint16_t def[3]);
+
+/**
+ * @brief VSCSAD parameter, the memory row shown at the top of the band
+ */
+uint16_t bsp_vscroll_start(const bsp_vscroll_t* vscroll);
+
+/**
+ * @brief Map screen rows to memory rows
+ *
+ * @param[in]  row1  First screen row
+ * @param[in]  row2  Last screen row, not below row1
+ * @param[out] spans Runs in screen order, BSP_VSCROLL_MAX_SPANS entries
+ * @return Number of runs, 1 when nothing is scrolled
+ */
+size_t bsp_vscroll_map(const bsp_vscroll_t* vscroll, int32_t row1, int32_t row2, bsp_vscroll_span_t* spans);
+
+#ifdef __cplusplus
+}
+#endif
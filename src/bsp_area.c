@@ -0,0 +1,89 @@
+#include "bsp_area.h"
+
+void bsp_area_align(bsp_area_t* area, uint32_t align) {
+    if (align <= 1) {
+        return;
+    }
+
+    const int32_t mask = (int32_t)align - 1;
+    area->x1 &= ~mask;
+    area->y1 &= ~mask;
+    area->x2 |= mask;
+    area->y2 |= mask;
+}
+
+void bsp_area_union(bsp_area_t* res, const bsp_area_t* a, const bsp_area_t* b) {
+    res->x1 = a->x1 < b->x1 ? a->x1 : b->x1;
+    res->y1 = a->y1 < b->y1 ? a->y1 : b->y1;
+    res->x2 = a->x2 > b->x2 ? a->x2 : b->x2;
+    res->y2 = a->y2 > b->y2 ? a->y2 : b->y2;
+}
+
+bool bsp_area_contains(const bsp_area_t* outer, const bsp_area_t* inner) {
+    return inner->x1 >= outer->x1 && inner->y1 >= outer->y1 && inner->x2 <= outer->x2 && inner->y2 <= outer->y2;
+}
+
+uint64_t bsp_area_cost(const bsp_area_t* area, const bsp_area_merge_cfg_t* cfg) {
+    return (uint64_t)bsp_area_size(area) * cfg->bytes_per_pixel + cfg->window_overhead;
+}
+
+static size_t remove_area(bsp_area_t* areas, size_t count, size_t idx) {
+    areas[idx] = areas[count - 1];
+    return count - 1;
+}
+
+static size_t drop_contained(bsp_area_t* areas, size_t count) {
+    size_t i = 0;
+    while (i < count) {
+        bool contained = false;
+        for (size_t j = 0; j < count && !contained; j++) {
+            contained = j != i && bsp_area_contains(&areas[j], &areas[i]);
+        }
+
+        if (contained) {
+            count = remove_area(areas, count, i);
+        } else {
+            i++;
+        }
+    }
+    return count;
+}
+
+size_t bsp_area_merge(bsp_area_t* areas, size_t count, const bsp_area_merge_cfg_t* cfg) {
+    for (size_t i = 0; i < count; i++) {
+        bsp_area_align(&areas[i], cfg->align);
+    }
+
+    count = drop_contained(areas, count);
+
+    while (count > 1) {
+        size_t best_i = 0;
+        size_t best_j = 0;
+        int64_t best_gain = -1;
+
+        for (size_t i = 0; i < count; i++) {
+            const uint64_t cost_i = bsp_area_cost(&areas[i], cfg);
+            for (size_t j = i + 1; j < count; j++) {
+                bsp_area_t merged;
+                bsp_area_union(&merged, &areas[i], &areas[j]);
+                const int64_t gain = (int64_t)(cost_i + bsp_area_cost(&areas[j], cfg))
+                                     - (int64_t)bsp_area_cost(&merged, cfg);
+                if (gain > best_gain) {
+                    best_gain = gain;
+                    best_i = i;
+                    best_j = j;
+                }
+            }
+        }
+
+        if (best_gain < 0) {
+            break;
+        }
+
+        bsp_area_union(&areas[best_i], &areas[best_i], &areas[best_j]);
+        count = remove_area(areas, count, best_j);
+        count = drop_contained(areas, count);
+    }
+
+    return count;
+}
@@ -0,0 +1,95 @@
+#include <string.h>
+#include "bsp_asset_codec.h"
+#include "bsp_draw_kernels.h"
+
+#define ASSET_OP_MASK           (0xC0U)
+#define ASSET_OP_INDEX          (0x00U)
+#define ASSET_OP_RUN            (0x40U)
+#define ASSET_OP_LITERAL        (0x80U)
+#define ASSET_OP_LONG_RUN       (0xC0U)
+#define ASSET_LONG_RUN_BIAS     (65)
+
+static inline uint16_t asset_rd16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t asset_rd32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline uint32_t asset_hash(uint32_t px) {
+    return (px * 0x9E3779B1U) >> 26;
+}
+
+bool bsp_asset_parse_header(const uint8_t raw[BSP_ASSET_HEADER_SIZE], bsp_asset_header_t* header) {
+    if (memcmp(raw, BSP_ASSET_MAGIC, 4) != 0) {
+        return false;
+    }
+    header->version = asset_rd16(raw + 4);
+    header->count = asset_rd16(raw + 6);
+    header->tile_lines = asset_rd16(raw + 8);
+    header->max_tile_bytes = asset_rd32(raw + 12);
+    return header->version == BSP_ASSET_VERSION && header->tile_lines > 0;
+}
+
+bool bsp_asset_parse_entry(const uint8_t raw[BSP_ASSET_ENTRY_SIZE], bsp_asset_entry_t* entry) {
+    memcpy(entry->name, raw, BSP_ASSET_NAME_LEN);
+    entry->name[BSP_ASSET_NAME_LEN] = '\0';
+    entry->width = asset_rd16(raw + 20);
+    entry->height = asset_rd16(raw + 22);
+    entry->format = raw[24];
+    entry->tiles = asset_rd16(raw + 26);
+    entry->table_offset = asset_rd32(raw + 28);
+    return entry->name[0] != '\0' && entry->width > 0 && entry->height > 0 && entry->tiles > 0 &&
+           bsp_asset_bytes_per_pixel(entry->format) != 0;
+}
+
+bool bsp_asset_decode(const uint8_t* src, size_t src_len, uint8_t* dst, size_t pixels, uint8_t bytes_per_pixel) {
+    const uint8_t* const end = src + src_len;
+    uint32_t table[64] = {0};
+    uint32_t prev = 0;
+
+    while (pixels && src < end) {
+        const uint8_t op = *src++;
+        size_t count = (op & 0x3FU) + 1;
+
+        switch (op & ASSET_OP_MASK) {
+        case ASSET_OP_INDEX:
+            prev = table[op & 0x3FU];
+            memcpy(dst, &prev, bytes_per_pixel);
+            dst += bytes_per_pixel;
+            pixels--;
+            break;
+        case ASSET_OP_LITERAL:
+            if (count > pixels || (size_t)(end - src) < count * bytes_per_pixel) {
+                return false;
+            }
+            // Literal pixels are copied as they are, only the table needs them one at a time
+            memcpy(dst, src, count * bytes_per_pixel);
+            for (size_t i = 0; i < count; i++) {
+                prev = 0;
+                memcpy(&prev, src, bytes_per_pixel);
+                table[asset_hash(prev)] = prev;
+                src += bytes_per_pixel;
+            }
+            dst += count * bytes_per_pixel;
+            pixels -= count;
+            break;
+        case ASSET_OP_LONG_RUN:
+            if (src == end) {
+                return false;
+            }
+            count = ((size_t)(op & 0x3FU) << 8 | *src++) + ASSET_LONG_RUN_BIAS;
+            // fall through
+        default:
+            if (count > pixels) {
+                return false;
+            }
+            bsp_draw_fill_line(dst, count, (const uint8_t*)&prev, bytes_per_pixel);
+            dst += count * bytes_per_pixel;
+            pixels -= count;
+            break;
+        }
+    }
+    return pixels == 0 && src == end;
+}
@@ -0,0 +1,124 @@
+#include <string.h>
+#include "bsp_asset_index.h"
+
+static inline uint16_t index_rd16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t index_rd32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static const uint8_t* index_entry_raw(const bsp_asset_index_t* index, uint32_t i) {
+    return index->base + BSP_ASSET_INDEX_HEADER_SIZE + (size_t)i * BSP_ASSET_INDEX_ENTRY_SIZE;
+}
+
+static uint8_t index_bytes_per_pixel(uint8_t format) {
+    switch (format) {
+    case BSP_ASSET_PIXEL_RGB565:
+        return 2;
+    case BSP_ASSET_PIXEL_RGB888:
+        return 3;
+    case BSP_ASSET_PIXEL_ARGB8888:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+uint32_t bsp_asset_index_crc32(const uint8_t* data, size_t len) {
+    // Bitwise, the index is a few KB at most and is checked once
+    uint32_t crc = 0xFFFFFFFFU;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int b = 0; b < 8; b++) {
+            crc = (crc >> 1) ^ (0xEDB88320U & (0U - (crc & 1U)));
+        }
+    }
+    return ~crc;
+}
+
+void bsp_asset_index_entry(const bsp_asset_index_t* index, uint32_t i, bsp_asset_index_entry_t* entry) {
+    const uint8_t* raw = index_entry_raw(index, i);
+    memcpy(entry->name, raw, BSP_ASSET_INDEX_NAME_LEN);
+    entry->name[BSP_ASSET_INDEX_NAME_LEN] = '\0';
+    entry->kind = raw[24];
+    entry->format = raw[25];
+    entry->width = index_rd16(raw + 26);
+    entry->height = index_rd16(raw + 28);
+    entry->stride = index_rd32(raw + 32);
+    entry->offset = index_rd32(raw + 36);
+    entry->size = index_rd32(raw + 40);
+}
+
+static bool index_entry_valid(const bsp_asset_index_t* index, const bsp_asset_index_entry_t* entry) {
+    const size_t data_start = BSP_ASSET_INDEX_HEADER_SIZE + (size_t)index->count * BSP_ASSET_INDEX_ENTRY_SIZE;
+    if (entry->name[0] == '\0' || entry->offset < data_start || entry->offset % BSP_ASSET_INDEX_ALIGN != 0 ||
+        entry->size > index->image_size - entry->offset) {
+        return false;
+    }
+    switch (entry->kind) {
+    case BSP_ASSET_KIND_IMAGE: {
+        const uint8_t bytes_per_pixel = index_bytes_per_pixel(entry->format);
+        return bytes_per_pixel != 0 && entry->width > 0 && entry->height > 0 &&
+               entry->stride >= (uint32_t)entry->width * bytes_per_pixel &&
+               entry->size == entry->stride * entry->height;
+    }
+    case BSP_ASSET_KIND_DATA:
+    case BSP_ASSET_KIND_FONT:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool bsp_asset_index_open(const uint8_t* base, size_t size, bsp_asset_index_t* index) {
+    if (size < BSP_ASSET_INDEX_HEADER_SIZE || memcmp(base, BSP_ASSET_INDEX_MAGIC, 4) != 0 ||
+        index_rd16(base + 4) != BSP_ASSET_INDEX_VERSION) {
+        return false;
+    }
+
+    index->base = base;
+    index->count = index_rd16(base + 6);
+    index->image_size = index_rd32(base + 8);
+    const size_t entries_size = (size_t)index->count * BSP_ASSET_INDEX_ENTRY_SIZE;
+    if (index->image_size > size || BSP_ASSET_INDEX_HEADER_SIZE + entries_size > index->image_size ||
+        bsp_asset_index_crc32(base + BSP_ASSET_INDEX_HEADER_SIZE, entries_size) != index_rd32(base + 12)) {
+        return false;
+    }
+
+    bsp_asset_index_entry_t prev;
+    for (uint32_t i = 0; i < index->count; i++) {
+        bsp_asset_index_entry_t entry;
+        bsp_asset_index_entry(index, i, &entry);
+        // Strictly ascending names keep the binary search exact
+        if (!index_entry_valid(index, &entry) || (i > 0 && strcmp(prev.name, entry.name) >= 0)) {
+            return false;
+        }
+        prev = entry;
+    }
+    return true;
+}
+
+bool bsp_asset_index_find(const bsp_asset_index_t* index, const char* name, bsp_asset_index_entry_t* entry) {
+    if (strlen(name) > BSP_ASSET_INDEX_NAME_LEN) {
+        return false;
+    }
+
+    uint32_t lo = 0;
+    uint32_t hi = index->count;
+    while (lo < hi) {
+        const uint32_t mid = lo + (hi - lo) / 2;
+        const int cmp = strncmp(name, (const char*)index_entry_raw(index, mid), BSP_ASSET_INDEX_NAME_LEN);
+        if (cmp == 0) {
+            bsp_asset_index_entry(index, mid, entry);
+            return true;
+        }
+        if (cmp < 0) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,455 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "bsp/lilygo-t4-s3.h"
+#include "bsp_asset_codec.h"
+
+#if (BSP_CONFIG_NO_GRAPHIC_LIB == 0)
+#if LV_VERSION_CHECK(9, 2, 0)
+// Image decoder descriptors moved to the private headers in LVGL 9.2
+#include "lvgl_private.h"
+#endif
+
+// NOLINTBEGIN (*-avoid-non-const-global-variables)
+static const char* TAG = "T4 S3 assets";
+
+#define ASSETS_PREFIX_LEN       (sizeof(BSP_ASSETS_PREFIX) - 1)
+// Tile buffers start on a PSRAM cache line
+#define ASSETS_SLOT_ALIGN       (64)
+
+/* One decoded tile in the cache */
+typedef struct {
+    int32_t asset;              /* -1 while the slot is empty */
+    int32_t tile;
+    uint32_t last_used;
+    uint32_t pins;              /* Open images currently drawing from this tile */
+    lv_draw_buf_t buf;
+} assets_slot_t;
+
+/* State of one opened image, kept in the decoder descriptor */
+typedef struct {
+    int32_t asset;
+    assets_slot_t* slot;
+} assets_open_t;
+
+typedef struct {
+    FILE* file;
+    bsp_asset_header_t header;
+    bsp_asset_entry_t* entries;
+    uint32_t** tables;          /* Per asset, tiles + 1 offsets */
+    uint8_t* scratch;           /* One compressed tile */
+    uint8_t* slot_mem;
+    size_t slot_size;
+    assets_slot_t slots[CONFIG_BSP_ASSETS_CACHE_TILES];
+    uint32_t clock;
+    lv_image_decoder_t* decoder;
+
+    /* Serialises file access and the cache, draw threads may decode in parallel */
+    SemaphoreHandle_t lock;
+    StaticSemaphore_t lock_buf;
+    bsp_assets_stats_t stats;
+} bsp_assets_ctx_t;
+
+static bsp_assets_ctx_t assets_ctx;
+
+static lv_color_format_t assets_color_format(const bsp_asset_entry_t* entry) {
+    return entry->format == BSP_ASSET_FORMAT_RGB565 ? LV_COLOR_FORMAT_RGB565 : LV_COLOR_FORMAT_RGB888;
+}
+
+static int32_t assets_find(const bsp_assets_ctx_t* ctx, const char* name) {
+    for (uint32_t i = 0; i < ctx->header.count; i++) {
+        if (strcmp(ctx->entries[i].name, name) == 0) {
+            return (int32_t)i;
+        }
+    }
+    return -1;
+}
+
+/* Resolve a BSP_ASSET() image source, -1 if it is not one or the asset does not exist */
+static int32_t assets_find_src(const bsp_assets_ctx_t* ctx, const void* src, lv_image_src_t src_type) {
+    if (src_type != LV_IMAGE_SRC_FILE || strncmp(src, BSP_ASSETS_PREFIX, ASSETS_PREFIX_LEN) != 0) {
+        return -1;
+    }
+    return assets_find(ctx, (const char*)src + ASSETS_PREFIX_LEN);
+}
+
+static size_t assets_tile_lines(const bsp_assets_ctx_t* ctx, const bsp_asset_entry_t* entry, int32_t tile) {
+    const uint32_t first = (uint32_t)tile * ctx->header.tile_lines;
+    return LV_MIN(ctx->header.tile_lines, entry->height - first);
+}
+
+/* Read and decode a tile. Called with the lock held. */
+static esp_err_t assets_read_tile(bsp_assets_ctx_t* ctx, int32_t asset, int32_t tile, uint8_t* dst,
+                                  int64_t* read_us, int64_t* decode_us) {
+    const bsp_asset_entry_t* entry = &ctx->entries[asset];
+    const uint32_t offset = ctx->tables[asset][tile];
+    const size_t len = ctx->tables[asset][tile + 1] - offset;
+
+    const int64_t start_us = esp_timer_get_time();
+    ESP_RETURN_ON_FALSE(fseek(ctx->file, (long)offset, SEEK_SET) == 0 && fread(ctx->scratch, 1, len, ctx->file) == len,
+                        ESP_FAIL, TAG, "Reading tile %d of %s failed", (int)tile, entry->name);
+    const int64_t read_end_us = esp_timer_get_time();
+
+    const size_t pixels = assets_tile_lines(ctx, entry, tile) * entry->width;
+    const bool ok = bsp_asset_decode(ctx->scratch, len, dst, pixels, bsp_asset_bytes_per_pixel(entry->format));
+    const int64_t end_us = esp_timer_get_time();
+
+    *read_us += read_end_us - start_us;
+    *decode_us += end_us - read_end_us;
+    ESP_RETURN_ON_FALSE(ok, ESP_ERR_INVALID_RESPONSE, TAG, "Tile %d of %s is corrupt", (int)tile, entry->name);
+    return ESP_OK;
+}
+
+/* Find a tile in the cache or decode it into the least recently used free slot, and pin it. Lock held. */
+static assets_slot_t* assets_get_tile(bsp_assets_ctx_t* ctx, int32_t asset, int32_t tile) {
+    assets_slot_t* victim = NULL;
+    ctx->clock++;
+
+    for (size_t i = 0; i < CONFIG_BSP_ASSETS_CACHE_TILES; i++) {
+        assets_slot_t* slot = &ctx->slots[i];
+        if (slot->asset == asset && slot->tile == tile) {
+            slot->last_used = ctx->clock;
+            slot->pins++;
+            ctx->stats.hits++;
+            return slot;
+        }
+        // Prefer empty slots, then the least recently used one
+        if (slot->pins == 0 && (victim == NULL || (victim->asset >= 0 &&
+                                                   (slot->asset < 0 || slot->last_used < victim->last_used)))) {
+            victim = slot;
+        }
+    }
+
+    ctx->stats.misses++;
+    if (victim == NULL) {
+        ESP_LOGW(TAG, "All %d cached tiles are in use", CONFIG_BSP_ASSETS_CACHE_TILES);
+        return NULL;
+    }
+    if (victim->asset >= 0) {
+        ctx->stats.evictions++;
+    }
+
+    const bsp_asset_entry_t* entry = &ctx->entries[asset];
+    uint8_t* data = victim->buf.data;
+    victim->asset = -1;
+    int64_t read_us = 0;
+    int64_t decode_us = 0;
+    const esp_err_t ret = assets_read_tile(ctx, asset, tile, data, &read_us, &decode_us);
+    ctx->stats.read_us += read_us;
+    ctx->stats.decode_us += decode_us;
+    if (ret != ESP_OK) {
+        return NULL;
+    }
+    ctx->stats.bytes_read += ctx->tables[asset][tile + 1] - ctx->tables[asset][tile];
+
+    const uint32_t stride = entry->width * bsp_asset_bytes_per_pixel(entry->format);
+    lv_draw_buf_init(&victim->buf, entry->width, assets_tile_lines(ctx, entry, tile), assets_color_format(entry), stride,
+                     data, ctx->slot_size);
+    victim->asset = asset;
+    victim->tile = tile;
+    victim->last_used = ctx->clock;
+    victim->pins = 1;
+    return victim;
+}
+
+static lv_result_t assets_info(const void* src, lv_image_src_t src_type, lv_image_header_t* header) {
+    bsp_assets_ctx_t* ctx = &assets_ctx;
+    const int32_t asset = assets_find_src(ctx, src, src_type);
+    if (asset < 0) {
+        return LV_RESULT_INVALID;
+    }
+
+    const bsp_asset_entry_t* entry = &ctx->entries[asset];
+    memset(header, 0, sizeof(*header));
+    header->magic = LV_IMAGE_HEADER_MAGIC;
+    header->cf = assets_color_format(entry);
+    header->w = entry->width;
+    header->h = entry->height;
+    header->stride = entry->width * bsp_asset_bytes_per_pixel(entry->format);
+    return LV_RESULT_OK;
+}
+
+#if LV_VERSION_CHECK(9, 2, 0)
+static lv_result_t assets_info_cb(lv_image_decoder_t* decoder, lv_image_decoder_dsc_t* dsc, lv_image_header_t* header) {
+    (void)decoder;
+    return assets_info(dsc->src, dsc->src_type, header);
+}
+#else
+static lv_result_t assets_info_cb(lv_image_decoder_t* decoder, const void* src, lv_image_header_t* header) {
+    (void)decoder;
+    return assets_info(src, lv_image_src_get_type(src), header);
+}
+#endif
+
+static lv_result_t assets_open_cb(lv_image_decoder_t* decoder, lv_image_decoder_dsc_t* dsc) {
+    (void)decoder;
+    const int32_t asset = assets_find_src(&assets_ctx, dsc->src, dsc->src_type);
+    if (asset < 0) {
+        return LV_RESULT_INVALID;
+    }
+
+    assets_open_t* open = lv_malloc(sizeof(assets_open_t));
+    if (open == NULL) {
+        return LV_RESULT_INVALID;
+    }
+    open->asset = asset;
+    open->slot = NULL;
+    dsc->user_data = open;
+    // No whole image, LVGL draws it tile by tile through assets_get_area_cb()
+    dsc->decoded = NULL;
+    return LV_RESULT_OK;
+}
+
+static lv_result_t assets_get_area_cb(lv_image_decoder_t* decoder, lv_image_decoder_dsc_t* dsc,
+                                      const lv_area_t* full_area, lv_area_t* decoded_area) {
+    (void)decoder;
+    bsp_assets_ctx_t* ctx = &assets_ctx;
+    assets_open_t* open = dsc->user_data;
+    const bsp_asset_entry_t* entry = &ctx->entries[open->asset];
+
+    // Continue below the tile decoded last, only the tiles that cross full_area are decoded
+    const int32_t y = decoded_area->y1 == LV_COORD_MIN ? full_area->y1 : decoded_area->y2 + 1;
+    if (y > full_area->y2 || y >= entry->height) {
+        return LV_RESULT_INVALID;
+    }
+    const int32_t tile = y / ctx->header.tile_lines;
+
+    xSemaphoreTake(ctx->lock, portMAX_DELAY);
+    if (open->slot) {
+        open->slot->pins--;
+    }
+    open->slot = assets_get_tile(ctx, open->asset, tile);
+    xSemaphoreGive(ctx->lock);
+    if (open->slot == NULL) {
+        return LV_RESULT_INVALID;
+    }
+
+    decoded_area->x1 = 0;
+    decoded_area->x2 = entry->width - 1;
+    decoded_area->y1 = tile * ctx->header.tile_lines;
+    decoded_area->y2 = decoded_area->y1 + (int32_t)assets_tile_lines(ctx, entry, tile) - 1;
+    dsc->decoded = &open->slot->buf;
+    return LV_RESULT_OK;
+}
+
+static void assets_close_cb(lv_image_decoder_t* decoder, lv_image_decoder_dsc_t* dsc) {
+    (void)decoder;
+    bsp_assets_ctx_t* ctx = &assets_ctx;
+    assets_open_t* open = dsc->user_data;
+
+    if (open->slot) {
+        xSemaphoreTake(ctx->lock, portMAX_DELAY);
+        open->slot->pins--;
+        xSemaphoreGive(ctx->lock);
+    }
+    lv_free(open);
+    dsc->user_data = NULL;
+}
+
+static void assets_free(bsp_assets_ctx_t* ctx) {
+    if (ctx->file) {
+        fclose(ctx->file);
+    }
+    if (ctx->tables) {
+        free(ctx->tables[0]);
+    }
+    free(ctx->tables);
+    free(ctx->entries);
+    free(ctx->scratch);
+    heap_caps_free(ctx->slot_mem);
+    ctx->file = NULL;
+    ctx->tables = NULL;
+    ctx->entries = NULL;
+    ctx->scratch = NULL;
+    ctx->slot_mem = NULL;
+}
+
+/* Read the index and every tile table, and check they describe the file */
+static esp_err_t assets_load_index(bsp_assets_ctx_t* ctx, long file_size) {
+    uint8_t raw[BSP_ASSET_ENTRY_SIZE];
+    const bsp_asset_header_t* header = &ctx->header;
+
+    ESP_RETURN_ON_FALSE(fread(raw, 1, BSP_ASSET_HEADER_SIZE, ctx->file) == BSP_ASSET_HEADER_SIZE &&
+                        bsp_asset_parse_header(raw, &ctx->header) && header->count > 0, ESP_ERR_INVALID_VERSION,
+                        TAG, "Not an asset blob of version %d", BSP_ASSET_VERSION);
+
+    ctx->entries = calloc(header->count, sizeof(bsp_asset_entry_t));
+    ctx->tables = calloc(header->count, sizeof(uint32_t*));
+    ESP_RETURN_ON_FALSE(ctx->entries && ctx->tables, ESP_ERR_NO_MEM, TAG, "No memory for the index");
+
+    size_t table_words = 0;
+    for (uint32_t i = 0; i < header->count; i++) {
+        bsp_asset_entry_t* entry = &ctx->entries[i];
+        ESP_RETURN_ON_FALSE(fread(raw, 1, BSP_ASSET_ENTRY_SIZE, ctx->file) == BSP_ASSET_ENTRY_SIZE &&
+                            bsp_asset_parse_entry(raw, entry) &&
+                            entry->tiles == (entry->height + header->tile_lines - 1) / header->tile_lines,
+                            ESP_ERR_INVALID_SIZE, TAG, "Index entry %u is malformed", (unsigned)i);
+        table_words += entry->tiles + 1;
+    }
+
+    // All tables in one block, freed through tables[0]
+    uint32_t* words = malloc(table_words * sizeof(uint32_t));
+    ESP_RETURN_ON_FALSE(words, ESP_ERR_NO_MEM, TAG, "No memory for the tile tables");
+    ctx->tables[0] = words;
+    for (uint32_t i = 0; i < header->count; i++) {
+        const bsp_asset_entry_t* entry = &ctx->entries[i];
+        const size_t count = entry->tiles + 1;
+        ctx->tables[i] = words;
+        ESP_RETURN_ON_FALSE(fseek(ctx->file, (long)entry->table_offset, SEEK_SET) == 0 &&
+                            fread(words, sizeof(uint32_t), count, ctx->file) == count, ESP_ERR_INVALID_SIZE, TAG,
+                            "Tile table of %s is truncated", entry->name);
+        for (size_t t = 0; t < entry->tiles; t++) {
+            ESP_RETURN_ON_FALSE(words[t] <= words[t + 1] && words[t + 1] <= (uint32_t)file_size &&
+                                words[t + 1] - words[t] <= header->max_tile_bytes, ESP_ERR_INVALID_SIZE, TAG,
+                                "Tile %u of %s is out of bounds", (unsigned)t, entry->name);
+        }
+        words += count;
+    }
+    return ESP_OK;
+}
+
+esp_err_t bsp_assets_open(const char* path) {
+    ESP_RETURN_ON_FALSE(path, ESP_ERR_INVALID_ARG, TAG, "Invalid arguments");
+    bsp_assets_ctx_t* ctx = &assets_ctx;
+    ESP_RETURN_ON_FALSE(ctx->decoder == NULL, ESP_ERR_INVALID_STATE, TAG, "An asset blob is already open");
+
+    ctx->file = fopen(path, "rb");
+    ESP_RETURN_ON_FALSE(ctx->file, ESP_ERR_NOT_FOUND, TAG, "Cannot open %s", path);
+
+    esp_err_t ret = ESP_OK;
+    long file_size = -1;
+    if (fseek(ctx->file, 0, SEEK_END) == 0) {
+        file_size = ftell(ctx->file);
+    }
+    ESP_GOTO_ON_FALSE(file_size > 0 && fseek(ctx->file, 0, SEEK_SET) == 0, ESP_FAIL, err, TAG, "Cannot read %s",
+                      path);
+    ESP_GOTO_ON_ERROR(assets_load_index(ctx, file_size), err, TAG, "Invalid asset blob %s", path);
+
+    // Every slot fits the largest tile of the blob
+    size_t slot_size = 0;
+    for (uint32_t i = 0; i < ctx->header.count; i++) {
+        const bsp_asset_entry_t* entry = &ctx->entries[i];
+        slot_size = LV_MAX(slot_size, (size_t)entry->width * LV_MIN(ctx->header.tile_lines, entry->height) *
+                           bsp_asset_bytes_per_pixel(entry->format));
+    }
+    ctx->slot_size = (slot_size + ASSETS_SLOT_ALIGN - 1) & ~(size_t)(ASSETS_SLOT_ALIGN - 1);
+
+    ctx->scratch = malloc(LV_MAX(ctx->header.max_tile_bytes, 1));
+    ctx->slot_mem = heap_caps_aligned_alloc(ASSETS_SLOT_ALIGN, ctx->slot_size * CONFIG_BSP_ASSETS_CACHE_TILES,
+                                            MALLOC_CAP_SPIRAM);
+    if (ctx->slot_mem == NULL) {
+        ctx->slot_mem = heap_caps_aligned_alloc(ASSETS_SLOT_ALIGN, ctx->slot_size * CONFIG_BSP_ASSETS_CACHE_TILES,
+                                                MALLOC_CAP_DEFAULT);
+    }
+    ESP_GOTO_ON_FALSE(ctx->scratch && ctx->slot_mem, ESP_ERR_NO_MEM, err, TAG, "No memory for the tile cache");
+    for (size_t i = 0; i < CONFIG_BSP_ASSETS_CACHE_TILES; i++) {
+        ctx->slots[i] = (assets_slot_t){
+            .asset = -1,
+            .buf = {.data = ctx->slot_mem + i * ctx->slot_size},
+        };
+    }
+
+    if (ctx->lock == NULL) {
+        ctx->lock = xSemaphoreCreateMutexStatic(&ctx->lock_buf);
+    }
+    memset(&ctx->stats, 0, sizeof(ctx->stats));
+    ctx->clock = 0;
+
+    lvgl_port_lock(0);
+    ctx->decoder = lv_image_decoder_create();
+    if (ctx->decoder) {
+        lv_image_decoder_set_info_cb(ctx->decoder, assets_info_cb);
+        lv_image_decoder_set_open_cb(ctx->decoder, assets_open_cb);
+        lv_image_decoder_set_get_area_cb(ctx->decoder, assets_get_area_cb);
+        lv_image_decoder_set_close_cb(ctx->decoder, assets_close_cb);
+    }
+    lvgl_port_unlock();
+    ESP_GOTO_ON_FALSE(ctx->decoder, ESP_ERR_NO_MEM, err, TAG, "No memory for the image decoder");
+
+    ESP_LOGI(TAG, "%s: %u assets, %d tiles of %u bytes cached", path, (unsigned)ctx->header.count,
+             CONFIG_BSP_ASSETS_CACHE_TILES, (unsigned)ctx->slot_size);
+    return ESP_OK;
+
+err:
+    assets_free(ctx);
+    return ret;
+}
+
+esp_err_t bsp_assets_close(void) {
+    bsp_assets_ctx_t* ctx = &assets_ctx;
+    ESP_RETURN_ON_FALSE(ctx->decoder, ESP_ERR_INVALID_STATE, TAG, "No asset blob open");
+
+    lvgl_port_lock(0);
+    lv_image_decoder_delete(ctx->decoder);
+    ctx->decoder = NULL;
+    lvgl_port_unlock();
+
+    xSemaphoreTake(ctx->lock, portMAX_DELAY);
+    assets_free(ctx);
+    xSemaphoreGive(ctx->lock);
+    return ESP_OK;
+}
+
+esp_err_t bsp_assets_get_stats(bsp_assets_stats_t* stats) {
+    ESP_RETURN_ON_FALSE(stats, ESP_ERR_INVALID_ARG, TAG, "Invalid arguments");
+    bsp_assets_ctx_t* ctx = &assets_ctx;
+    ESP_RETURN_ON_FALSE(ctx->decoder, ESP_ERR_INVALID_STATE, TAG, "No asset blob open");
+
+    xSemaphoreTake(ctx->lock, portMAX_DELAY);
+    *stats = ctx->stats;
+    xSemaphoreGive(ctx->lock);
+    return ESP_OK;
+}
+
+esp_err_t bsp_assets_benchmark(const char* name, uint32_t rounds, bsp_assets_bench_t* result) {
+    ESP_RETURN_ON_FALSE(name && rounds && result, ESP_ERR_INVALID_ARG, TAG, "Invalid arguments");
+    bsp_assets_ctx_t* ctx = &assets_ctx;
+    ESP_RETURN_ON_FALSE(ctx->decoder, ESP_ERR_INVALID_STATE, TAG, "No asset blob open");
+
+    const int32_t asset = assets_find(ctx, name);
+    ESP_RETURN_ON_FALSE(asset >= 0, ESP_ERR_NOT_FOUND, TAG, "No asset named %s", name);
+    const bsp_asset_entry_t* entry = &ctx->entries[asset];
+
+    // Decoded into a buffer of its own, so the cache is left as it is
+    uint8_t* dst = heap_caps_malloc(ctx->slot_size, MALLOC_CAP_SPIRAM);
+    if (dst == NULL) {
+        dst = malloc(ctx->slot_size);
+    }
+    ESP_RETURN_ON_FALSE(dst, ESP_ERR_NO_MEM, TAG, "No memory for the benchmark");
+
+    int64_t read_us = 0;
+    int64_t decode_us = 0;
+    esp_err_t ret = ESP_OK;
+    xSemaphoreTake(ctx->lock, portMAX_DELAY);
+    for (uint32_t r = 0; r < rounds && ret == ESP_OK; r++) {
+        for (int32_t t = 0; t < entry->tiles && ret == ESP_OK; t++) {
+            ret = assets_read_tile(ctx, asset, t, dst, &read_us, &decode_us);
+        }
+    }
+    xSemaphoreGive(ctx->lock);
+    free(dst);
+    ESP_RETURN_ON_ERROR(ret, TAG, "Benchmark of %s failed", name);
+
+    const uint64_t decoded = (uint64_t)entry->width * entry->height * bsp_asset_bytes_per_pixel(entry->format) *
+                             rounds;
+    *result = (bsp_assets_bench_t){
+        .tiles = entry->tiles * rounds,
+        .compressed_bytes = (uint64_t)(ctx->tables[asset][entry->tiles] - ctx->tables[asset][0]) * rounds,
+        .decoded_bytes = decoded,
+        .read_us = read_us,
+        .decode_us = decode_us,
+        .decode_mb_s = decode_us ? (float)decoded / (float)decode_us : 0.0f,
+        .load_mb_s = (read_us + decode_us) ? (float)decoded / (float)(read_us + decode_us) : 0.0f,
+    };
+    return ESP_OK;
+}
+// NOLINTEND (*-avoid-non-const-global-variables)
+#endif // (BSP_CONFIG_NO_GRAPHIC_LIB == 0)
@@ -0,0 +1,62 @@
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+#include "bsp/lilygo-t4-s3.h"
+#include "bsp_boot.h"
+
+#if (BSP_CONFIG_NO_GRAPHIC_LIB == 0)
+
+// NOLINTBEGIN (*-avoid-non-const-global-variables)
+static const char* TAG = "T4 S3 boot";
+
+static const char* const boot_stage_names[BSP_BOOT_STAGES] = {
+    [BSP_BOOT_START] = "start",
+    [BSP_BOOT_LVGL] = "LVGL",
+    [BSP_BOOT_PANEL] = "panel",
+    [BSP_BOOT_FIRST_PIXEL] = "first pixel",
+    [BSP_BOOT_TOUCH] = "touch",
+    [BSP_BOOT_STORAGE] = "storage",
+    [BSP_BOOT_READY] = "ready",
+};
+
+static portMUX_TYPE boot_lock = portMUX_INITIALIZER_UNLOCKED;
+static bsp_boot_timeline_t boot_timeline;
+
+void bsp_boot_mark(bsp_boot_stage_t stage) {
+    const int64_t now_us = esp_timer_get_time();
+
+    portENTER_CRITICAL_SAFE(&boot_lock);
+    if (boot_timeline.at_us[stage] == 0) {
+        boot_timeline.at_us[stage] = now_us;
+    }
+    portEXIT_CRITICAL_SAFE(&boot_lock);
+}
+
+esp_err_t bsp_boot_get_timeline(bsp_boot_timeline_t* timeline) {
+    ESP_RETURN_ON_FALSE(timeline, ESP_ERR_INVALID_ARG, TAG, "Invalid arguments");
+
+    portENTER_CRITICAL(&boot_lock);
+    *timeline = boot_timeline;
+    portEXIT_CRITICAL(&boot_lock);
+    return ESP_OK;
+}
+
+void bsp_boot_log_timeline(void) {
+    bsp_boot_timeline_t timeline;
+    bsp_boot_get_timeline(&timeline);
+
+    const int64_t start_us = timeline.at_us[BSP_BOOT_START];
+    for (int stage = 0; stage < BSP_BOOT_STAGES; stage++) {
+        if (timeline.at_us[stage] == 0) {
+            ESP_LOGI(TAG, "%-12s -", boot_stage_names[stage]);
+            continue;
+        }
+        ESP_LOGI(TAG, "%-12s %7.1f ms since boot, +%6.1f ms", boot_stage_names[stage],
+                 (double)timeline.at_us[stage] / 1000.0, (double)(timeline.at_us[stage] - start_us) / 1000.0);
+    }
+}
+// NOLINTEND (*-avoid-non-const-global-variables)
+#endif // (BSP_CONFIG_NO_GRAPHIC_LIB == 0)
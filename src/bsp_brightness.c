@@ -0,0 +1,143 @@
+#include <math.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "bsp/lilygo-t4-s3.h"
+#include "bsp_brightness.h"
+#include "bsp_flush.h"
+
+// NOLINTBEGIN (*-avoid-non-const-global-variables)
+static const char* TAG = "T4 S3 brightness";
+
+// One step per panel refresh at 60 Hz
+#define BRIGHTNESS_STEP_US      (16667)
+// Perceived brightness follows the register value roughly with this exponent
+#define BRIGHTNESS_GAMMA        (2.2f)
+
+typedef struct {
+    portMUX_TYPE init_lock;     /* Guards creating the lock on concurrent first calls */
+    SemaphoreHandle_t lock;     /* Serializes ramp steps with new ramps */
+    StaticSemaphore_t lock_buf;
+    esp_timer_handle_t timer;
+    bool running;               /* A step that fires after the ramp was stopped is dropped */
+    uint8_t level;              /* Last value sent or queued for the panel */
+    float from;                 /* Ramp ends as perceived brightness, 0 to 1 */
+    float to;
+    int64_t start_us;
+    int64_t duration_us;
+} bsp_brightness_ctx_t;
+
+// The panel comes out of its init sequence at full brightness
+static bsp_brightness_ctx_t brightness_ctx = {
+    .init_lock = portMUX_INITIALIZER_UNLOCKED,
+    .level = 255,
+};
+
+static float brightness_perceived(uint8_t level) {
+    return powf((float)level / 255.0f, 1.0f / BRIGHTNESS_GAMMA);
+}
+
+static uint8_t brightness_level(float perceived) {
+    return (uint8_t)lroundf(255.0f * powf(perceived, BRIGHTNESS_GAMMA));
+}
+
+/**
+ * Hand a step to the flush stage, or write it when nothing is being flushed
+ */
+static esp_err_t brightness_send(uint8_t level) {
+#if (BSP_CONFIG_NO_GRAPHIC_LIB == 0)
+    if (bsp_flush_queue_brightness(level)) {
+        return ESP_OK;
+    }
+#endif
+    return bsp_display_brightness_write(level);
+}
+
+static void brightness_timer_cb(void* arg) {
+    bsp_brightness_ctx_t* ctx = arg;
+
+    // The esp_timer task must not block, a step is skipped while a new ramp or a write holds the lock
+    if (xSemaphoreTake(ctx->lock, 0) != pdTRUE) {
+        return;
+    }
+    if (!ctx->running) {
+        xSemaphoreGive(ctx->lock);
+        return;
+    }
+    const int64_t elapsed_us = esp_timer_get_time() - ctx->start_us;
+    const bool done = elapsed_us >= ctx->duration_us;
+    const float t = done ? 1.0f : (float)elapsed_us / (float)ctx->duration_us;
+    const uint8_t level = brightness_level(ctx->from + (ctx->to - ctx->from) * t);
+
+    if (done) {
+        // The last step must not wait for a window that may never come
+        esp_timer_stop(ctx->timer);
+        ctx->running = false;
+#if (BSP_CONFIG_NO_GRAPHIC_LIB == 0)
+        bsp_flush_queue_brightness(-1);
+#endif
+        bsp_display_brightness_write(level);
+        ctx->level = level;
+    } else if (level != ctx->level) {
+        brightness_send(level);
+        ctx->level = level;
+    }
+    xSemaphoreGive(ctx->lock);
+}
+
+static esp_err_t brightness_init(bsp_brightness_ctx_t* ctx) {
+    // A static mutex needs no allocation, so it can be created inside the critical section
+    portENTER_CRITICAL(&ctx->init_lock);
+    if (ctx->lock == NULL) {
+        ctx->lock = xSemaphoreCreateMutexStatic(&ctx->lock_buf);
+    }
+    portEXIT_CRITICAL(&ctx->init_lock);
+
+    esp_err_t ret = ESP_OK;
+    xSemaphoreTake(ctx->lock, portMAX_DELAY);
+    if (ctx->timer == NULL) {
+        const esp_timer_create_args_t timer_args = {
+            .callback = brightness_timer_cb,
+            .arg = ctx,
+            .name = "bsp_brightness",
+        };
+        ret = esp_timer_create(&timer_args, &ctx->timer);
+    }
+    xSemaphoreGive(ctx->lock);
+    return ret;
+}
+
+esp_err_t bsp_brightness_ramp(int brightness_percent, uint32_t duration_ms) {
+    bsp_brightness_ctx_t* ctx = &brightness_ctx;
+    ESP_RETURN_ON_FALSE(brightness_percent >= 0 && brightness_percent <= 100, ESP_ERR_INVALID_ARG, TAG,
+                        "Invalid brightness");
+    ESP_RETURN_ON_ERROR(brightness_init(ctx), TAG, "No memory for the ramp timer");
+
+    const uint8_t target = BSP_BRIGHTNESS_LEVEL(brightness_percent);
+    esp_err_t ret = ESP_OK;
+
+    xSemaphoreTake(ctx->lock, portMAX_DELAY);
+    esp_timer_stop(ctx->timer);
+    ctx->running = duration_ms > 0;
+    if (duration_ms == 0) {
+#if (BSP_CONFIG_NO_GRAPHIC_LIB == 0)
+        bsp_flush_queue_brightness(-1);
+#endif
+        ret = bsp_display_brightness_write(target);
+        ctx->level = target;
+    } else {
+        ctx->from = brightness_perceived(ctx->level);
+        ctx->to = brightness_perceived(target);
+        ctx->start_us = esp_timer_get_time();
+        ctx->duration_us = (int64_t)duration_ms * 1000;
+        ret = esp_timer_start_periodic(ctx->timer, BRIGHTNESS_STEP_US);
+    }
+    xSemaphoreGive(ctx->lock);
+    return ret;
+}
+// NOLINTEND (*-avoid-non-const-global-variables)
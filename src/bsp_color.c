@@ -0,0 +1,212 @@
+#include <string.h>
+#include "bsp_color.h"
+
+#define COLOR_IS_ALIGNED(ptr)   ((((uintptr_t)(ptr)) & 3U) == 0)
+
+// 4x4 Bayer matrix, thresholds 0..15
+static const uint8_t bayer4[4][4] = {
+    {0, 8, 2, 10},
+    {12, 4, 14, 6},
+    {3, 11, 1, 9},
+    {15, 7, 13, 5},
+};
+
+static inline uint32_t color_swap16x2(uint32_t w) {
+    return ((w & 0x00FF00FFU) << 8) | ((w >> 8) & 0x00FF00FFU);
+}
+
+void bsp_color_swap_rgb565(const void* src, void* dst, size_t count) {
+    const uint8_t* s = src;
+    uint8_t* d = dst;
+
+    // Both pointers step by the same amount, so one pixel is enough to align them if they can be aligned
+    if (count && !COLOR_IS_ALIGNED(s) && COLOR_IS_ALIGNED(s + 2) && COLOR_IS_ALIGNED(d + 2)) {
+        const uint8_t lo = s[0];
+        d[0] = s[1];
+        d[1] = lo;
+        s += 2;
+        d += 2;
+        count--;
+    }
+
+    if (COLOR_IS_ALIGNED(s) && COLOR_IS_ALIGNED(d)) {
+        const uint32_t* s32 = (const uint32_t*)s;
+        uint32_t* d32 = (uint32_t*)d;
+        for (; count >= 8; count -= 8) {
+            const uint32_t w0 = s32[0];
+            const uint32_t w1 = s32[1];
+            const uint32_t w2 = s32[2];
+            const uint32_t w3 = s32[3];
+            d32[0] = color_swap16x2(w0);
+            d32[1] = color_swap16x2(w1);
+            d32[2] = color_swap16x2(w2);
+            d32[3] = color_swap16x2(w3);
+            s32 += 4;
+            d32 += 4;
+        }
+        for (; count >= 2; count -= 2) {
+            *d32++ = color_swap16x2(*s32++);
+        }
+        s = (const uint8_t*)s32;
+        d = (uint8_t*)d32;
+    }
+
+    for (; count; count--) {
+        const uint8_t lo = s[0];
+        d[0] = s[1];
+        d[1] = lo;
+        s += 2;
+        d += 2;
+    }
+}
+
+void bsp_color_pack_xrgb8888(const void* src, void* dst, size_t count) {
+    const uint8_t* s = src;
+    uint8_t* d = dst;
+
+    if (COLOR_IS_ALIGNED(s) && COLOR_IS_ALIGNED(d)) {
+        const uint32_t* s32 = (const uint32_t*)s;
+        uint32_t* d32 = (uint32_t*)d;
+        // Four pixels fit in three words
+        for (; count >= 4; count -= 4) {
+            const uint32_t p0 = s32[0];
+            const uint32_t p1 = s32[1];
+            const uint32_t p2 = s32[2];
+            const uint32_t p3 = s32[3];
+            d32[0] = (p0 & 0x00FFFFFFU) | (p1 << 24);
+            d32[1] = ((p1 >> 8) & 0x0000FFFFU) | (p2 << 16);
+            d32[2] = ((p2 >> 16) & 0x000000FFU) | (p3 << 8);
+            s32 += 4;
+            d32 += 3;
+        }
+        s = (const uint8_t*)s32;
+        d = (uint8_t*)d32;
+    }
+
+    for (; count; count--) {
+        d[0] = s[0];
+        d[1] = s[1];
+        d[2] = s[2];
+        s += 4;
+        d += 3;
+    }
+}
+
+/**
+ * Add a threshold to all three channels of a 0x00RRGGBB pixel at once, saturating every channel at 0xFF.
+ * Thresholds are below 0x80, so the low seven bits of each channel can be added without carrying over.
+ */
+static inline uint32_t color_add_sat(uint32_t c, uint32_t t) {
+    const uint32_t sum = ((c & 0x7F7F7F7FU) + t) ^ (c & 0x80808080U);
+    const uint32_t overflow = c & ~sum & 0x80808080U;
+    return sum | ((overflow >> 7) * 0xFFU);
+}
+
+static inline uint32_t color_to_rgb565(uint32_t c) {
+    return ((c >> 8) & 0xF800U) | ((c >> 5) & 0x07E0U) | ((c >> 3) & 0x001FU);
+}
+
+static inline uint32_t color_load(const uint8_t* s) {
+    return s[0] | (s[1] << 8) | (s[2] << 16);
+}
+
+static inline uint32_t color_store_pair(uint32_t p0, uint32_t p1, bool swap_bytes) {
+    const uint32_t w = p0 | (p1 << 16);
+    return swap_bytes ? color_swap16x2(w) : w;
+}
+
+static inline void color_store_one(const uint8_t* s, uint8_t* d, uint32_t threshold, bool swap_bytes) {
+    const uint32_t p = color_to_rgb565(color_add_sat(color_load(s), threshold));
+    d[swap_bytes ? 1 : 0] = (uint8_t)p;
+    d[swap_bytes ? 0 : 1] = (uint8_t)(p >> 8);
+}
+
+void bsp_color_to_rgb565(const void* src, uint32_t src_bytes_per_pixel, void* dst, size_t count, int32_t x,
+                         int32_t y, bool swap_bytes, bool dither) {
+    const uint8_t* s = src;
+    uint8_t* d = dst;
+
+    // Thresholds for the next four columns: 3 bits are dropped from red and blue, 2 from green
+    uint32_t thresholds[4] = {0};
+    if (dither) {
+        for (int i = 0; i < 4; i++) {
+            const uint32_t t = bayer4[y & 3][(x + i) & 3];
+            thresholds[i] = ((t >> 1) << 16) | ((t >> 2) << 8) | (t >> 1);
+        }
+    }
+
+    size_t i = 0;
+
+    // Pixels until the source is word aligned, then four pixels per loop
+    for (; i < count && !COLOR_IS_ALIGNED(s); i++) {
+        color_store_one(s, d, dither ? thresholds[i & 3] : 0, swap_bytes);
+        s += src_bytes_per_pixel;
+        d += 2;
+    }
+
+    if (COLOR_IS_ALIGNED(s) && COLOR_IS_ALIGNED(d) && i + 4 <= count) {
+        // Rotate the thresholds so that index 0 belongs to the next pixel
+        const uint32_t t0 = thresholds[i & 3];
+        const uint32_t t1 = thresholds[(i + 1) & 3];
+        const uint32_t t2 = thresholds[(i + 2) & 3];
+        const uint32_t t3 = thresholds[(i + 3) & 3];
+        const uint32_t* s32 = (const uint32_t*)s;
+        uint32_t* d32 = (uint32_t*)d;
+
+        for (; i + 4 <= count; i += 4) {
+            uint32_t c0, c1, c2, c3;
+            if (src_bytes_per_pixel == 4) {
+                c0 = s32[0];
+                c1 = s32[1];
+                c2 = s32[2];
+                c3 = s32[3];
+                s32 += 4;
+            } else {
+                // B0 G0 R0 B1 | G1 R1 B2 G2 | R2 B3 G3 R3
+                const uint32_t w0 = s32[0];
+                const uint32_t w1 = s32[1];
+                const uint32_t w2 = s32[2];
+                c0 = w0;
+                c1 = (w0 >> 24) | (w1 << 8);
+                c2 = (w1 >> 16) | (w2 << 16);
+                c3 = w2 >> 8;
+                s32 += 3;
+            }
+            c0 &= 0x00FFFFFFU;
+            c1 &= 0x00FFFFFFU;
+            c2 &= 0x00FFFFFFU;
+            c3 &= 0x00FFFFFFU;
+            if (dither) {
+                c0 = color_add_sat(c0, t0);
+                c1 = color_add_sat(c1, t1);
+                c2 = color_add_sat(c2, t2);
+                c3 = color_add_sat(c3, t3);
+            }
+            // Both stores land at or below the words just read, so the conversion can run in place
+            d32[0] = color_store_pair(color_to_rgb565(c0), color_to_rgb565(c1), swap_bytes);
+            d32[1] = color_store_pair(color_to_rgb565(c2), color_to_rgb565(c3), swap_bytes);
+            d32 += 2;
+        }
+        s = (const uint8_t*)s32;
+        d = (uint8_t*)d32;
+    }
+
+    for (; i < count; i++) {
+        color_store_one(s, d, dither ? thresholds[i & 3] : 0, swap_bytes);
+        s += src_bytes_per_pixel;
+        d += 2;
+    }
+}
+
+void bsp_color_convert(const bsp_color_conv_t* conv, const void* src, void* dst, size_t count, int32_t x,
+                       int32_t y) {
+    if (conv->dst_bytes_per_pixel == 2 && conv->src_bytes_per_pixel > 2) {
+        bsp_color_to_rgb565(src, conv->src_bytes_per_pixel, dst, count, x, y, conv->swap_bytes, conv->dither);
+    } else if (conv->dst_bytes_per_pixel == 2 && conv->swap_bytes) {
+        bsp_color_swap_rgb565(src, dst, count);
+    } else if (conv->src_bytes_per_pixel == 4) {
+        bsp_color_pack_xrgb8888(src, dst, count);
+    } else if (src != dst) {
+        memmove(dst, src, count * conv->src_bytes_per_pixel);
+    }
+}
@@ -0,0 +1,92 @@
+#include "bsp_draw_buf.h"
+
+static uint32_t draw_buf_div_up(uint32_t a, uint32_t b) {
+    return (a + b - 1) / b;
+}
+
+/**
+ * Same split as the BSP SPI setup: the fewest transactions for a full buffer, all of about the same size and
+ * word-aligned
+ */
+static uint32_t draw_buf_trans_bytes(const bsp_draw_buf_cfg_t* cfg, uint32_t buffer_bytes) {
+    const uint32_t transactions = draw_buf_div_up(buffer_bytes, cfg->max_trans_bytes);
+    return (draw_buf_div_up(buffer_bytes, transactions) + 3) & ~3U;
+}
+
+static uint32_t draw_buf_max_lines(const bsp_draw_buf_cfg_t* cfg) {
+    // A last stripe of the screen shorter than the alignment still takes a whole aligned window
+    return draw_buf_div_up(cfg->height, cfg->align) * cfg->align;
+}
+
+void bsp_draw_buf_eval(const bsp_draw_buf_cfg_t* cfg, uint32_t lines, bsp_draw_buf_geom_t* geom) {
+    const uint32_t line_bytes = cfg->width * cfg->wire_bytes_per_pixel;
+
+    lines -= lines % cfg->align;
+    if (lines < cfg->align) {
+        lines = cfg->align;
+    }
+    if (lines > draw_buf_max_lines(cfg)) {
+        lines = draw_buf_max_lines(cfg);
+    }
+
+    const uint32_t trans_bytes = draw_buf_trans_bytes(cfg, lines * line_bytes);
+    uint32_t transactions = 0;
+    for (uint32_t y = 0; y < cfg->height; y += lines) {
+        const uint32_t stripe = cfg->height - y < lines ? cfg->height - y : lines;
+        transactions += draw_buf_div_up(stripe * line_bytes, trans_bytes);
+    }
+
+    *geom = (bsp_draw_buf_geom_t){
+        .lines = lines,
+        .bytes = (size_t)lines * cfg->width * cfg->bytes_per_pixel * cfg->buffers,
+        .flushes = draw_buf_div_up(cfg->height, lines),
+        .transactions = transactions,
+        .trans_bytes = trans_bytes,
+    };
+}
+
+bool bsp_draw_buf_tune(const bsp_draw_buf_cfg_t* cfg, size_t budget, size_t max_buffer, bsp_draw_buf_geom_t* geom) {
+    const size_t line_bytes = (size_t)cfg->width * cfg->bytes_per_pixel;
+    size_t fit = budget / cfg->buffers;
+    if (max_buffer < fit) {
+        fit = max_buffer;
+    }
+
+    size_t lines = fit / line_bytes;
+    lines -= lines % cfg->align;
+    if (lines < cfg->align) {
+        return false;
+    }
+    if (lines > draw_buf_max_lines(cfg)) {
+        lines = draw_buf_max_lines(cfg);
+    }
+
+    // The shortest buffer that still needs no more flushes than the tallest one that fits
+    bsp_draw_buf_eval(cfg, (uint32_t)lines, geom);
+    const uint32_t flushes = geom->flushes;
+    const uint32_t shortest = draw_buf_div_up(draw_buf_div_up(cfg->height, flushes), cfg->align) * cfg->align;
+
+    bsp_draw_buf_geom_t candidate;
+    for (uint32_t l = shortest; l <= lines; l += cfg->align) {
+        bsp_draw_buf_eval(cfg, l, &candidate);
+        if (candidate.flushes == flushes && (candidate.transactions < geom->transactions ||
+                                             (candidate.transactions == geom->transactions &&
+                                              candidate.lines < geom->lines))) {
+            *geom = candidate;
+        }
+    }
+    return true;
+}
+
+bool bsp_draw_buf_select(const bsp_draw_buf_cfg_t* cfg, const bsp_draw_buf_req_t* req, bsp_draw_buf_geom_t* geom) {
+    if (req->budget) {
+        if (bsp_draw_buf_tune(cfg, req->budget, req->max_buffer, geom)) {
+            return true;
+        }
+        bsp_draw_buf_eval(cfg, cfg->align, geom);
+        return false;
+    }
+    // LVGL fills any pixel count with stripes of as many full-width lines as fit
+    bsp_draw_buf_eval(cfg, req->lines ? req->lines : req->pixels / cfg->width, geom);
+    return true;
+}
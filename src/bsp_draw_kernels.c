@@ -0,0 +1,100 @@
+#include <string.h>
+#include "bsp_draw_kernels.h"
+
+#define DRAW_IS_ALIGNED(ptr)    ((((uintptr_t)(ptr)) & 3U) == 0)
+
+void bsp_draw_fill_line(uint8_t* dst, size_t count, const uint8_t* pixel, uint8_t bytes_per_pixel) {
+    // RGB565 at an odd address never reaches word alignment, the others get there within three pixels
+    while (count && !DRAW_IS_ALIGNED(dst) && (bytes_per_pixel != 2 || ((uintptr_t)dst & 1U) == 0)) {
+        memcpy(dst, pixel, bytes_per_pixel);
+        dst += bytes_per_pixel;
+        count--;
+    }
+
+    if (count && DRAW_IS_ALIGNED(dst)) {
+        // Twelve bytes hold a whole number of pixels of every supported size
+        union {
+            uint8_t bytes[12];
+            uint32_t words[3];
+        } pattern;
+        for (size_t i = 0; i < sizeof(pattern.bytes); i += bytes_per_pixel) {
+            memcpy(&pattern.bytes[i], pixel, bytes_per_pixel);
+        }
+
+        uint32_t* d32 = (uint32_t*)dst;
+        size_t words = count * bytes_per_pixel / 4;
+        if (bytes_per_pixel == 3) {
+            const uint32_t w0 = pattern.words[0];
+            const uint32_t w1 = pattern.words[1];
+            const uint32_t w2 = pattern.words[2];
+            for (; words >= 6; words -= 6) {
+                d32[0] = w0;
+                d32[1] = w1;
+                d32[2] = w2;
+                d32[3] = w0;
+                d32[4] = w1;
+                d32[5] = w2;
+                d32 += 6;
+            }
+            for (; words >= 3; words -= 3) {
+                d32[0] = w0;
+                d32[1] = w1;
+                d32[2] = w2;
+                d32 += 3;
+            }
+            // Whole pixels only, the remaining words are written by the per-pixel tail
+            words = 0;
+        } else {
+            const uint32_t w = pattern.words[0];
+            for (; words >= 8; words -= 8) {
+                d32[0] = w;
+                d32[1] = w;
+                d32[2] = w;
+                d32[3] = w;
+                d32[4] = w;
+                d32[5] = w;
+                d32[6] = w;
+                d32[7] = w;
+                d32 += 8;
+            }
+            for (; words; words--) {
+                *d32++ = w;
+            }
+        }
+        const size_t filled = ((uint8_t*)d32 - dst) / bytes_per_pixel;
+        dst = (uint8_t*)d32;
+        count -= filled;
+    }
+
+    for (; count; count--) {
+        memcpy(dst, pixel, bytes_per_pixel);
+        dst += bytes_per_pixel;
+    }
+}
+
+void bsp_draw_fill(uint8_t* dst, uint32_t stride, int32_t width, int32_t height, const uint8_t* pixel,
+                   uint8_t bytes_per_pixel) {
+    if (width <= 0) {
+        return;
+    }
+    for (int32_t y = 0; y < height; y++) {
+        bsp_draw_fill_line(dst, (size_t)width, pixel, bytes_per_pixel);
+        dst += stride;
+    }
+}
+
+void bsp_draw_copy(uint8_t* dst, uint32_t dst_stride, const uint8_t* src, uint32_t src_stride, size_t line_bytes,
+                   int32_t height) {
+    if (height <= 0 || line_bytes == 0) {
+        return;
+    }
+    if (dst_stride == line_bytes && src_stride == line_bytes) {
+        memcpy(dst, src, line_bytes * (size_t)height);
+        return;
+    }
+    for (int32_t y = 0; y < height; y++) {
+        memcpy(dst, src, line_bytes);
+        dst += dst_stride;
+        src += src_stride;
+    }
+}
@@ -0,0 +1,373 @@
+#include <stdint.h>
+#include <string.h>
+#include "esp_attr.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_memory_utils.h"
+#include "esp_async_memcpy.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "bsp/lilygo-t4-s3.h"
+#include "bsp_draw_kernels.h"
+#include "bsp_draw_unit.h"
+
+#if (BSP_CONFIG_NO_GRAPHIC_LIB == 0)
+#if LV_VERSION_CHECK(9, 2, 0)
+// Draw units and draw tasks moved to the private headers in LVGL 9.2
+#include "lvgl_private.h"
+#endif
+
+// NOLINTBEGIN (*-avoid-non-const-global-variables)
+static const char* TAG = "T4 S3 draw";
+
+// Any ID not used by the LVGL draw units
+#define DRAW_UNIT_ID_BSP        (40)
+// Below the 100 the software renderer claims every task with, above nothing else
+#define DRAW_UNIT_SCORE         (80)
+// GDMA transactions queued at once, one per line unless the lines are contiguous
+#define DRAW_DMA_BACKLOG        (16)
+// Shorter lines cost more in descriptor setup than the CPU needs to copy them
+#define DRAW_DMA_MIN_LINE       (64)
+#define DRAW_DMA_TIMEOUT_MS     (100)
+
+#ifdef CONFIG_BSP_DISPLAY_DRAW_DMA
+#define DRAW_DMA_MIN_BYTES      (CONFIG_BSP_DISPLAY_DRAW_DMA_MIN_BYTES)
+#else
+#define DRAW_DMA_MIN_BYTES      (SIZE_MAX)
+#endif
+
+#define DRAW_IS_ALIGNED(ptr)    ((((uintptr_t)(ptr)) & 3U) == 0)
+
+typedef struct {
+    lv_draw_unit_t base;
+} bsp_draw_unit_t;
+
+typedef struct {
+    bsp_draw_unit_t* unit;
+    async_memcpy_handle_t dma;
+    SemaphoreHandle_t dma_done;
+    StaticSemaphore_t dma_done_buf;
+    bool dma_failed;                /* A GDMA copy overran DRAW_DMA_TIMEOUT_MS, jobs are drawn by the CPU only */
+
+    portMUX_TYPE stats_lock;
+    bsp_display_draw_stats_t stats;
+} bsp_draw_ctx_t;
+
+static bsp_draw_ctx_t draw_ctx = {
+    .stats_lock = portMUX_INITIALIZER_UNLOCKED,
+};
+
+static lv_layer_t* draw_task_layer(const lv_draw_task_t* t) {
+    return ((const lv_draw_dsc_base_t*)t->draw_dsc)->layer;
+}
+
+static bool draw_fill_supported(const lv_draw_task_t* t, lv_color_format_t cf) {
+    const lv_draw_fill_dsc_t* dsc = t->draw_dsc;
+    if (dsc->radius != 0 || dsc->opa < LV_OPA_MAX || dsc->grad.dir != LV_GRAD_DIR_NONE) {
+        return false;
+    }
+    return cf == LV_COLOR_FORMAT_RGB565 || cf == LV_COLOR_FORMAT_RGB888 || cf == LV_COLOR_FORMAT_XRGB8888 ||
+           cf == LV_COLOR_FORMAT_ARGB8888;
+}
+
+static bool draw_image_supported(const lv_draw_task_t* t, lv_color_format_t cf) {
+    const lv_draw_image_dsc_t* dsc = t->draw_dsc;
+    // Opaque formats only, the software renderer copies these pixels unchanged
+    if (cf != LV_COLOR_FORMAT_RGB565 && cf != LV_COLOR_FORMAT_RGB888) {
+        return false;
+    }
+    if (dsc->header.cf != cf || (dsc->header.flags & LV_IMAGE_FLAGS_COMPRESSED) ||
+        lv_image_src_get_type(dsc->src) != LV_IMAGE_SRC_VARIABLE) {
+        return false;
+    }
+    if (dsc->rotation != 0 || dsc->scale_x != LV_SCALE_NONE || dsc->scale_y != LV_SCALE_NONE ||
+        dsc->skew_x != 0 || dsc->skew_y != 0) {
+        return false;
+    }
+    if (dsc->opa < LV_OPA_MAX || dsc->blend_mode != LV_BLEND_MODE_NORMAL || dsc->recolor_opa > LV_OPA_MIN ||
+        dsc->tile || dsc->bitmap_mask_src != NULL || dsc->sup != NULL) {
+        return false;
+    }
+    // Rounded clipping needs a mask
+    if (dsc->clip_radius != 0) {
+        return false;
+    }
+#if LV_VERSION_CHECK(9, 2, 0)
+    // The task may draw only part of the image, the copy assumes the image starts at the task area
+    if (!lv_area_is_equal(&dsc->image_area, &t->area)) {
+        return false;
+    }
+#endif
+    return lv_area_get_width(&t->area) == (int32_t)dsc->header.w &&
+           lv_area_get_height(&t->area) == (int32_t)dsc->header.h;
+}
+
+static int32_t draw_evaluate_cb(lv_draw_unit_t* draw_unit, lv_draw_task_t* t) {
+    (void)draw_unit;
+    bsp_draw_ctx_t* ctx = &draw_ctx;
+
+    if (t->type != LV_DRAW_TASK_TYPE_FILL && t->type != LV_DRAW_TASK_TYPE_IMAGE) {
+        return 0;
+    }
+    if (t->preference_score <= DRAW_UNIT_SCORE) {
+        return 0;
+    }
+
+    const lv_color_format_t cf = draw_task_layer(t)->color_format;
+    const bool supported = t->type == LV_DRAW_TASK_TYPE_FILL ? draw_fill_supported(t, cf) :
+                           draw_image_supported(t, cf);
+    if (!supported) {
+        portENTER_CRITICAL(&ctx->stats_lock);
+        ctx->stats.declined++;
+        portEXIT_CRITICAL(&ctx->stats_lock);
+        return 0;
+    }
+
+    t->preference_score = DRAW_UNIT_SCORE;
+    t->preferred_draw_unit_id = DRAW_UNIT_ID_BSP;
+    return 1;
+}
+
+static bool IRAM_ATTR draw_dma_done_cb(async_memcpy_handle_t mcp, async_memcpy_event_t* event, void* cb_args) {
+    (void)mcp;
+    (void)event;
+    BaseType_t need_yield = pdFALSE;
+    xSemaphoreGiveFromISR((SemaphoreHandle_t)cb_args, &need_yield);
+    return need_yield == pdTRUE;
+}
+
+/**
+ * Queue lines [first, height) on GDMA. A src_stride of 0 copies the same source line into every line. Returns
+ * the number of transactions queued and sets *queued_lines, the lines from first on that GDMA will write.
+ */
+static uint32_t draw_dma_start(bsp_draw_ctx_t* ctx, uint8_t* dst, uint32_t dst_stride, const uint8_t* src,
+                               uint32_t src_stride, size_t line_bytes, int32_t first, int32_t height,
+                               int32_t* queued_lines) {
+    *queued_lines = 0;
+    if (dst_stride == line_bytes && src_stride == line_bytes) {
+        const size_t bytes = line_bytes * (size_t)(height - first);
+        if (esp_async_memcpy(ctx->dma, dst + first * dst_stride, (void*)(src + first * src_stride), bytes,
+                             draw_dma_done_cb, ctx->dma_done) != ESP_OK) {
+            return 0;
+        }
+        *queued_lines = height - first;
+        return 1;
+    }
+
+    uint32_t transactions = 0;
+    for (int32_t y = first; y < height && transactions < DRAW_DMA_BACKLOG; y++) {
+        if (esp_async_memcpy(ctx->dma, dst + y * dst_stride, (void*)(src + y * src_stride), line_bytes,
+                             draw_dma_done_cb, ctx->dma_done) != ESP_OK) {
+            break;
+        }
+        transactions++;
+    }
+    *queued_lines = (int32_t)transactions;
+    return transactions;
+}
+
+static void draw_dma_wait(bsp_draw_ctx_t* ctx, uint32_t transactions) {
+    // GDMA writes into the draw buffer until its last transaction is done, so a stalled copy is waited out
+    // rather than left to finish into a buffer LVGL has moved on with
+    while (transactions) {
+        if (xSemaphoreTake(ctx->dma_done, pdMS_TO_TICKS(DRAW_DMA_TIMEOUT_MS)) == pdTRUE) {
+            transactions--;
+            continue;
+        }
+        if (!ctx->dma_failed) {
+            ESP_LOGE(TAG, "GDMA copy timed out, drawing on the CPU only from now on");
+            ctx->dma_failed = true;
+        }
+        portENTER_CRITICAL(&ctx->stats_lock);
+        ctx->stats.dma_timeouts++;
+        portEXIT_CRITICAL(&ctx->stats_lock);
+    }
+}
+
+/**
+ * GDMA pays off for large jobs whose buffers it can reach. It takes the lower half of the lines while the CPU
+ * draws the upper half.
+ */
+static int32_t draw_dma_first_line(const bsp_draw_ctx_t* ctx, const uint8_t* dst, uint32_t dst_stride,
+                                   const uint8_t* src, uint32_t src_stride, size_t line_bytes, int32_t height) {
+    if (ctx->dma == NULL || ctx->dma_failed || height < 2 || line_bytes < DRAW_DMA_MIN_LINE ||
+        line_bytes * (size_t)height < DRAW_DMA_MIN_BYTES) {
+        return height;
+    }
+    if (!esp_ptr_dma_capable(dst) || !esp_ptr_dma_capable(src) || !DRAW_IS_ALIGNED(dst) ||
+        !DRAW_IS_ALIGNED(src) || !DRAW_IS_ALIGNED(dst_stride) || !DRAW_IS_ALIGNED(src_stride) ||
+        !DRAW_IS_ALIGNED(line_bytes)) {
+        return height;
+    }
+    return height / 2;
+}
+
+static size_t draw_fill(bsp_draw_ctx_t* ctx, lv_draw_task_t* t, uint8_t* dst, uint32_t stride, int32_t width,
+                        int32_t height, lv_color_format_t cf) {
+    const lv_draw_fill_dsc_t* dsc = t->draw_dsc;
+    uint8_t pixel[4];
+    uint8_t bytes_per_pixel;
+
+    // Same conversion as the software renderer, so both draw identical pixels
+    if (cf == LV_COLOR_FORMAT_RGB565) {
+        const uint16_t c16 = lv_color_to_u16(dsc->color);
+        memcpy(pixel, &c16, sizeof(c16));
+        bytes_per_pixel = 2;
+    } else {
+        pixel[0] = dsc->color.blue;
+        pixel[1] = dsc->color.green;
+        pixel[2] = dsc->color.red;
+        pixel[3] = 0xFF;
+        bytes_per_pixel = cf == LV_COLOR_FORMAT_RGB888 ? 3 : 4;
+    }
+
+    const size_t line_bytes = (size_t)width * bytes_per_pixel;
+    // GDMA copies the first line, which the CPU fills before anything else
+    const int32_t dma_first = draw_dma_first_line(ctx, dst, stride, dst, 0, line_bytes, height);
+    int32_t dma_lines = 0;
+    uint32_t transactions = 0;
+    if (dma_first < height) {
+        bsp_draw_fill_line(dst, (size_t)width, pixel, bytes_per_pixel);
+        transactions = draw_dma_start(ctx, dst, stride, dst, 0, line_bytes, dma_first, height, &dma_lines);
+        bsp_draw_fill(dst + stride, stride, width, dma_first - 1, pixel, bytes_per_pixel);
+    } else {
+        bsp_draw_fill(dst, stride, width, dma_first, pixel, bytes_per_pixel);
+    }
+    bsp_draw_fill(dst + (dma_first + dma_lines) * stride, stride, width, height - dma_first - dma_lines, pixel,
+                  bytes_per_pixel);
+    draw_dma_wait(ctx, transactions);
+
+    return line_bytes * (size_t)dma_lines;
+}
+
+static size_t draw_blit(bsp_draw_ctx_t* ctx, lv_draw_task_t* t, const lv_area_t* area, uint8_t* dst,
+                        uint32_t stride, lv_color_format_t cf) {
+    const lv_draw_image_dsc_t* dsc = t->draw_dsc;
+    const lv_image_dsc_t* img = dsc->src;
+    const uint32_t bytes_per_pixel = lv_color_format_get_size(cf);
+    const uint32_t src_stride = img->header.stride ? img->header.stride :
+                                lv_draw_buf_width_to_stride(img->header.w, cf);
+    const uint8_t* src = img->data + (area->y1 - t->area.y1) * src_stride + (area->x1 - t->area.x1) * bytes_per_pixel;
+    const size_t line_bytes = (size_t)lv_area_get_width(area) * bytes_per_pixel;
+    const int32_t height = lv_area_get_height(area);
+
+    const int32_t dma_first = draw_dma_first_line(ctx, dst, stride, src, src_stride, line_bytes, height);
+    int32_t dma_lines = 0;
+    uint32_t transactions = 0;
+    if (dma_first < height) {
+        transactions = draw_dma_start(ctx, dst, stride, src, src_stride, line_bytes, dma_first, height,
+                                      &dma_lines);
+    }
+    bsp_draw_copy(dst, stride, src, src_stride, line_bytes, dma_first);
+    const int32_t rest = dma_first + dma_lines;
+    bsp_draw_copy(dst + rest * stride, stride, src + rest * src_stride, src_stride, line_bytes, height - rest);
+    draw_dma_wait(ctx, transactions);
+
+    return line_bytes * (size_t)dma_lines;
+}
+
+static void draw_execute(bsp_draw_ctx_t* ctx, lv_draw_task_t* t, lv_layer_t* layer) {
+    lv_area_t area;
+    if (!lv_area_intersect(&area, &t->area, &t->clip_area) || !lv_area_intersect(&area, &area, &layer->buf_area)) {
+        return;
+    }
+
+    lv_draw_buf_t* buf = layer->draw_buf;
+    const lv_color_format_t cf = layer->color_format;
+    uint8_t* dst = lv_draw_buf_goto_xy(buf, area.x1 - layer->buf_area.x1, area.y1 - layer->buf_area.y1);
+    const int32_t width = lv_area_get_width(&area);
+    const int32_t height = lv_area_get_height(&area);
+    const size_t bytes = (size_t)width * height * lv_color_format_get_size(cf);
+
+    size_t dma_bytes;
+    if (t->type == LV_DRAW_TASK_TYPE_FILL) {
+        dma_bytes = draw_fill(ctx, t, dst, buf->header.stride, width, height, cf);
+    } else {
+        dma_bytes = draw_blit(ctx, t, &area, dst, buf->header.stride, cf);
+    }
+
+    portENTER_CRITICAL(&ctx->stats_lock);
+    if (t->type == LV_DRAW_TASK_TYPE_FILL) {
+        ctx->stats.fills++;
+    } else {
+        ctx->stats.blits++;
+    }
+    ctx->stats.dma_bytes += dma_bytes;
+    ctx->stats.cpu_bytes += bytes - dma_bytes;
+    portEXIT_CRITICAL(&ctx->stats_lock);
+}
+
+static int32_t draw_dispatch_cb(lv_draw_unit_t* draw_unit, lv_layer_t* layer) {
+    bsp_draw_ctx_t* ctx = &draw_ctx;
+
+#if LV_VERSION_CHECK(9, 3, 0)
+    lv_draw_task_t* t = lv_draw_get_available_task(layer, NULL, DRAW_UNIT_ID_BSP);
+#else
+    lv_draw_task_t* t = lv_draw_get_next_available_task(layer, NULL, DRAW_UNIT_ID_BSP);
+#endif
+    if (t == NULL || t->preferred_draw_unit_id != DRAW_UNIT_ID_BSP) {
+        return LV_DRAW_UNIT_IDLE;
+    }
+    if (lv_draw_layer_alloc_buf(layer) == NULL) {
+        return LV_DRAW_UNIT_IDLE;
+    }
+
+    t->state = LV_DRAW_TASK_STATE_IN_PROGRESS;
+#if LV_VERSION_CHECK(9, 3, 0)
+    t->draw_unit = draw_unit;
+#else
+    draw_unit->target_layer = layer;
+    draw_unit->clip_area = &t->clip_area;
+#endif
+
+    // The job is finished before returning, GDMA only shares the work with the CPU
+    draw_execute(ctx, t, layer);
+
+    t->state = LV_DRAW_TASK_STATE_READY;
+    lv_draw_dispatch_request();
+    return 1;
+}
+
+esp_err_t bsp_draw_unit_init(void) {
+    bsp_draw_ctx_t* ctx = &draw_ctx;
+    if (ctx->unit) {
+        return ESP_OK;
+    }
+
+#ifdef CONFIG_BSP_DISPLAY_DRAW_DMA
+    async_memcpy_config_t dma_cfg = ASYNC_MEMCPY_DEFAULT_CONFIG();
+    dma_cfg.backlog = DRAW_DMA_BACKLOG;
+    const esp_err_t ret = esp_async_memcpy_install(&dma_cfg, &ctx->dma);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "No GDMA channel for the draw unit (%s), drawing on the CPU only", esp_err_to_name(ret));
+        ctx->dma = NULL;
+    }
+    ctx->dma_done = xSemaphoreCreateCountingStatic(DRAW_DMA_BACKLOG, 0, &ctx->dma_done_buf);
+#endif
+
+    lvgl_port_lock(0);
+    bsp_draw_unit_t* unit = lv_draw_create_unit(sizeof(bsp_draw_unit_t));
+    if (unit) {
+        unit->base.dispatch_cb = draw_dispatch_cb;
+        unit->base.evaluate_cb = draw_evaluate_cb;
+    }
+    lvgl_port_unlock();
+    ESP_RETURN_ON_FALSE(unit, ESP_ERR_NO_MEM, TAG, "No memory for the draw unit");
+
+    ctx->unit = unit;
+    return ESP_OK;
+}
+
+esp_err_t bsp_display_get_draw_stats(bsp_display_draw_stats_t* stats) {
+    ESP_RETURN_ON_FALSE(stats, ESP_ERR_INVALID_ARG, TAG, "Invalid arguments");
+    bsp_draw_ctx_t* ctx = &draw_ctx;
+
+    portENTER_CRITICAL(&ctx->stats_lock);
+    *stats = ctx->stats;
+    portEXIT_CRITICAL(&ctx->stats_lock);
+    return ESP_OK;
+}
+// NOLINTEND (*-avoid-non-const-global-variables)
+#endif // (BSP_CONFIG_NO_GRAPHIC_LIB == 0)
@@ -0,0 +1,120 @@
+#include <string.h>
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_partition.h"
+
+#include "bsp/lilygo-t4-s3.h"
+#include "bsp_asset_index.h"
+
+// NOLINTBEGIN (*-avoid-non-const-global-variables)
+static const char* TAG = "T4 S3 flash assets";
+
+typedef struct {
+    esp_partition_mmap_handle_t mmap;
+    bsp_asset_index_t index;
+    bool mounted;
+} bsp_flash_assets_ctx_t;
+
+static bsp_flash_assets_ctx_t flash_assets_ctx;
+
+esp_err_t bsp_flash_assets_mount(void) {
+    bsp_flash_assets_ctx_t* ctx = &flash_assets_ctx;
+    ESP_RETURN_ON_FALSE(!ctx->mounted, ESP_ERR_INVALID_STATE, TAG, "Already mounted");
+
+    const esp_partition_t* part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                                           CONFIG_BSP_FLASH_ASSETS_PARTITION_LABEL);
+    ESP_RETURN_ON_FALSE(part, ESP_ERR_NOT_FOUND, TAG, "No partition labelled %s",
+                        CONFIG_BSP_FLASH_ASSETS_PARTITION_LABEL);
+
+    // The whole partition goes through the MMU once, assets are then plain pointers into flash
+    const void* base = NULL;
+    ESP_RETURN_ON_ERROR(esp_partition_mmap(part, 0, part->size, ESP_PARTITION_MMAP_DATA, &base, &ctx->mmap), TAG,
+                        "Mapping %s failed", part->label);
+
+    if (!bsp_asset_index_open(base, part->size, &ctx->index)) {
+        esp_partition_munmap(ctx->mmap);
+        ESP_LOGE(TAG, "%s holds no valid asset index, build it with tools/bsp_flash_assets.py", part->label);
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    ctx->mounted = true;
+    ESP_LOGI(TAG, "%s: %u assets, %u of %u bytes", part->label, (unsigned)ctx->index.count,
+             (unsigned)ctx->index.image_size, (unsigned)part->size);
+    return ESP_OK;
+}
+
+esp_err_t bsp_flash_assets_unmount(void) {
+    bsp_flash_assets_ctx_t* ctx = &flash_assets_ctx;
+    ESP_RETURN_ON_FALSE(ctx->mounted, ESP_ERR_INVALID_STATE, TAG, "Not mounted");
+
+    esp_partition_munmap(ctx->mmap);
+    ctx->mounted = false;
+    return ESP_OK;
+}
+
+static esp_err_t flash_assets_find(const char* name, bsp_asset_kind_t kind, bsp_asset_index_entry_t* entry) {
+    const bsp_flash_assets_ctx_t* ctx = &flash_assets_ctx;
+    ESP_RETURN_ON_FALSE(name, ESP_ERR_INVALID_ARG, TAG, "Invalid arguments");
+    ESP_RETURN_ON_FALSE(ctx->mounted, ESP_ERR_INVALID_STATE, TAG, "Not mounted");
+    ESP_RETURN_ON_FALSE(bsp_asset_index_find(&ctx->index, name, entry), ESP_ERR_NOT_FOUND, TAG, "No asset named %s",
+                        name);
+    ESP_RETURN_ON_FALSE(entry->kind == kind || kind == BSP_ASSET_KIND_DATA, ESP_ERR_INVALID_ARG, TAG,
+                        "%s is not of the requested kind", name);
+    return ESP_OK;
+}
+
+esp_err_t bsp_flash_assets_get_data(const char* name, const void** data, size_t* size) {
+    ESP_RETURN_ON_FALSE(data && size, ESP_ERR_INVALID_ARG, TAG, "Invalid arguments");
+    bsp_asset_index_entry_t entry;
+    ESP_RETURN_ON_ERROR(flash_assets_find(name, BSP_ASSET_KIND_DATA, &entry), TAG, "Lookup failed");
+
+    *data = flash_assets_ctx.index.base + entry.offset;
+    *size = entry.size;
+    return ESP_OK;
+}
+
+#if (BSP_CONFIG_NO_GRAPHIC_LIB == 0)
+esp_err_t bsp_flash_assets_get_image(const char* name, lv_image_dsc_t* dsc) {
+    ESP_RETURN_ON_FALSE(dsc, ESP_ERR_INVALID_ARG, TAG, "Invalid arguments");
+    bsp_asset_index_entry_t entry;
+    ESP_RETURN_ON_ERROR(flash_assets_find(name, BSP_ASSET_KIND_IMAGE, &entry), TAG, "Lookup failed");
+
+    lv_color_format_t cf = LV_COLOR_FORMAT_RGB565;
+    if (entry.format == BSP_ASSET_PIXEL_RGB888) {
+        cf = LV_COLOR_FORMAT_RGB888;
+    } else if (entry.format == BSP_ASSET_PIXEL_ARGB8888) {
+        cf = LV_COLOR_FORMAT_ARGB8888;
+    }
+
+    *dsc = (lv_image_dsc_t){
+        .header = {
+            .magic = LV_IMAGE_HEADER_MAGIC,
+            .cf = cf,
+            .w = entry.width,
+            .h = entry.height,
+            .stride = entry.stride,
+        },
+        .data_size = entry.size,
+        .data = flash_assets_ctx.index.base + entry.offset,
+    };
+    return ESP_OK;
+}
+
+lv_font_t* bsp_flash_assets_create_font(const char* name, int32_t size_px) {
+#if LV_USE_TINY_TTF
+    bsp_asset_index_entry_t entry;
+    if (flash_assets_find(name, BSP_ASSET_KIND_FONT, &entry) != ESP_OK) {
+        return NULL;
+    }
+    // Glyphs are rasterised straight from the mapped font file, only the glyph cache is allocated
+    return lv_tiny_ttf_create_data(flash_assets_ctx.index.base + entry.offset, entry.size, size_px);
+#else
+    (void)name;
+    (void)size_px;
+    ESP_LOGE(TAG, "Fonts need LV_USE_TINY_TTF");
+    return NULL;
+#endif
+}
+#endif // (BSP_CONFIG_NO_GRAPHIC_LIB == 0)
+// NOLINTEND (*-avoid-non-const-global-variables)
@@ -0,0 +1,1188 @@
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_lcd_panel_io.h"
+#include "esp_lcd_panel_ops.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_rom_sys.h"
+#include "driver/gpio.h"
+#include <stdatomic.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+#include "bsp/lilygo-t4-s3.h"
+#include "bsp_area.h"
+#include "bsp_boot.h"
+#include "bsp_color.h"
+#include "bsp_flush.h"
+#include "bsp_frame_stats.h"
+#include "bsp_lcd_io.h"
+#include "bsp_rotate.h"
+#include "bsp_te_sched.h"
+#include "bsp_vscroll.h"
+#include "bsp/display.h"
+
+#if (BSP_CONFIG_NO_GRAPHIC_LIB == 0)
+#include "src/display/lv_display_private.h"
+
+// NOLINTBEGIN (*-avoid-non-const-global-variables)
+static const char* TAG = "T4 S3 flush";
+
+// Alignment enforced by lvgl_round_cb(), the RM690B0 only accepts even window coordinates
+#define FLUSH_AREA_ALIGN        (2)
+// Tear-free waits shorter than this are spun, waking up from an esp_timer takes about as long
+#define FLUSH_TE_SPIN_US        (100)
+// Bus time of a window besides its pixels: CASET, RASET and the RAMWR command
+#define FLUSH_TE_WINDOW_US      (20)
+
+/* One partial-mode window, handed from the LVGL task to the flush task */
+typedef struct {
+    bsp_area_t area;
+    uint8_t* px_map;
+    uint32_t stride;
+    int32_t hor_res;
+    int32_t ver_res;
+    bool sw_rotate;
+    bsp_rotate_t sw_rotation;
+    bsp_rotate_t panel_rotation;
+    bsp_vscroll_span_t spans[BSP_VSCROLL_MAX_SPANS];
+    size_t span_count;
+} flush_job_t;
+
+typedef struct {
+    lv_display_t* disp;
+    esp_lcd_panel_handle_t panel;
+    esp_lcd_panel_io_handle_t io;
+    uint32_t bytes_per_pixel;         /* LVGL color format */
+    uint32_t wire_bytes_per_pixel;    /* Panel color format */
+    bsp_color_conv_t conv;
+    bool convert;
+    bsp_area_merge_cfg_t merge_cfg;
+
+    /* Window currently on the wire. in_flight, done_us and chunks_done are written from the panel IO ISR */
+    volatile bool in_flight;
+    volatile int64_t done_us;
+    uint32_t chunks_sent;
+    volatile uint32_t chunks_done;
+    int64_t submit_us;
+    bool overlap_pending;
+    SemaphoreHandle_t done_sem;
+    StaticSemaphore_t done_sem_buf;
+
+    /* Rotation the panel cannot do in hardware, applied by copying pixels into rotate_buf. panel_rotation is the
+       whole transform from LVGL to panel memory, however it is applied. */
+    bsp_rotate_t base_rotation;
+    bsp_rotate_t panel_rotation;
+    bsp_rotate_t sw_rotation;
+    bool sw_rotate;
+    uint8_t* rotate_buf;
+    size_t rotate_buf_size;
+
+    /* Flush task on the other core, jobs is NULL when windows are sent from the LVGL task. LVGL never has
+       more than one window in flight, so one slot is enough. */
+    QueueHandle_t jobs;
+    StaticQueue_t jobs_buf;
+    uint8_t jobs_storage[sizeof(flush_job_t)];
+
+    /* Full-frame mode: LVGL renders into a PSRAM framebuffer, changed rows go out through bounce buffers */
+    bool full_frame;
+    int32_t bounce_lines;
+    uint8_t* bounce[2];
+    uint32_t bounce_seq[2];           /* chunks_sent after the last chunk sent from each bounce buffer */
+    uint32_t bounce_idx;
+    lv_area_t frame_areas[LV_INV_BUF_SIZE];
+    uint32_t frame_area_cnt;
+
+    /* Counters of the frame being flushed, only touched from the LVGL task */
+    uint32_t frame_areas_in;
+    uint32_t frame_areas_out;
+    uint32_t frame_windows;
+    uint32_t frame_bytes;
+    uint32_t frame_transactions;
+    uint32_t frame_data_transactions;
+    uint32_t max_transfer_sz;
+    int64_t frame_start_us;
+    int64_t frame_first_flush_us;
+    uint32_t frame_wait_us;
+    uint32_t trace_frame;
+
+    /* Brightness step carried by the next window, -1 when none. Windows count the chances to carry one. */
+    _Atomic int32_t brightness;
+    _Atomic uint32_t brightness_windows;
+    uint32_t brightness_windows_seen;
+
+    /* Hardware vertical scroll. Windows of a frame are written in the vscroll layout, changes requested meanwhile
+       are sent to the panel at the start of the next refresh. Only touched from the LVGL task. */
+    bsp_vscroll_t vscroll;
+    bool scroll_band_pending;
+    int32_t scroll_band_top;
+    int32_t scroll_band_height;
+    int32_t scroll_dy;
+
+    /* Tear-free present. te is updated from the TE ISR or the scanline read, under te_lock. */
+    bsp_flush_te_t te_source;
+    portMUX_TYPE te_lock;
+    bsp_te_sched_t te;
+    int64_t te_bus_free_us;           /* When the windows already queued are expected to be off the bus */
+    esp_timer_handle_t te_timer;
+    SemaphoreHandle_t te_sem;
+    StaticSemaphore_t te_sem_buf;
+
+    portMUX_TYPE stats_lock;
+    bsp_display_flush_stats_t stats;
+    bsp_display_te_stats_t te_stats;
+
+    /* Frame history, under stats_lock. A frame is recorded when its last chunk completes. */
+    bsp_frame_stats_t history;
+    bsp_frame_record_t pending;
+    bool pending_valid;
+    uint32_t pending_last_chunk;
+    int64_t pending_first_flush_us;
+    uint32_t lock_wait_us;
+} bsp_flush_ctx_t;
+
+static bsp_flush_ctx_t flush_ctx = {
+    .brightness = -1,
+    .te_lock = portMUX_INITIALIZER_UNLOCKED,
+    .stats_lock = portMUX_INITIALIZER_UNLOCKED,
+};
+
+static void flush_te_isr(void* arg) {
+    bsp_flush_ctx_t* ctx = arg;
+    const int64_t now_us = esp_timer_get_time();
+
+    portENTER_CRITICAL_ISR(&ctx->te_lock);
+    bsp_te_sched_on_te(&ctx->te, now_us);
+    portEXIT_CRITICAL_ISR(&ctx->te_lock);
+}
+
+static void flush_te_timer_cb(void* arg) {
+    bsp_flush_ctx_t* ctx = arg;
+    xSemaphoreGive(ctx->te_sem);
+}
+
+static bsp_te_sched_t flush_te_get(bsp_flush_ctx_t* ctx) {
+    portENTER_CRITICAL(&ctx->te_lock);
+    const bsp_te_sched_t sched = ctx->te;
+    portEXIT_CRITICAL(&ctx->te_lock);
+    return sched;
+}
+
+/**
+ * Place the scan from a GSCAN read. The read waits for queued pixels first, so the bus is drained before the
+ * clock starts.
+ */
+static void flush_te_read_scanline(bsp_flush_ctx_t* ctx) {
+    uint8_t line[2];
+
+    bsp_lcd_io_wait_idle();
+    const int64_t start_us = esp_timer_get_time();
+    const esp_err_t ret = esp_lcd_panel_io_rx_param(ctx->io, BSP_LCD_QSPI_CMD_READ(BSP_LCD_CMD_GSCAN), line,
+                                                    sizeof(line));
+    if (ret != ESP_OK) {
+        ESP_LOGD(TAG, "Scanline read failed (%s)", esp_err_to_name(ret));
+        return;
+    }
+    // The panel latches the line somewhere during the read
+    const int64_t now_us = (start_us + esp_timer_get_time()) / 2;
+
+    portENTER_CRITICAL(&ctx->te_lock);
+    bsp_te_sched_on_scanline(&ctx->te, now_us, ((line[0] << 8) | line[1]) & 0x3FF); // NOLINT(*-magic-numbers)
+    portEXIT_CRITICAL(&ctx->te_lock);
+}
+
+/**
+ * Order the windows of a frame by how long ago the scan left their first row. Each window then gets the most
+ * time before the scan comes back to it.
+ */
+static void flush_te_order(bsp_flush_ctx_t* ctx, bsp_area_t* areas, size_t count) {
+    const int32_t hor_res = lv_display_get_horizontal_resolution(ctx->disp);
+    const int32_t ver_res = lv_display_get_vertical_resolution(ctx->disp);
+    const bsp_te_sched_t sched = flush_te_get(ctx);
+    const int64_t now_us = esp_timer_get_time();
+    int32_t behind[LV_INV_BUF_SIZE];
+
+    for (size_t i = 0; i < count; i++) {
+        bsp_area_t native;
+        bsp_rotate_area(&ctx->panel_rotation, &areas[i], hor_res, ver_res, &native);
+        behind[i] = bsp_te_sched_lines_behind(&sched, now_us, native.y1);
+    }
+
+    // At most LV_INV_BUF_SIZE windows, an insertion sort is plenty
+    for (size_t i = 1; i < count; i++) {
+        const bsp_area_t area = areas[i];
+        const int32_t key = behind[i];
+        size_t j = i;
+        for (; j > 0 && behind[j - 1] > key; j--) {
+            areas[j] = areas[j - 1];
+            behind[j] = behind[j - 1];
+        }
+        areas[j] = area;
+        behind[j] = key;
+    }
+}
+
+/**
+ * Hold a window back until its write cannot cross the panel scan. The area is in LVGL coordinates, rot is the
+ * transform to panel memory and bytes the pixel data on the wire.
+ */
+static void flush_te_wait(bsp_flush_ctx_t* ctx, const bsp_area_t* area, int32_t hor_res, int32_t ver_res,
+                          const bsp_rotate_t* rot, bool sw_rotate, uint32_t bytes) {
+    if (ctx->te_source == BSP_FLUSH_TE_OFF) {
+        return;
+    }
+
+    bsp_area_t native;
+    bsp_rotate_area(rot, area, hor_res, ver_res, &native);
+    // Rotated in software the pixels are already in panel order, in hardware only an unswapped and unmirrored
+    // window is filled top to bottom
+    const bool progressive = sw_rotate || (!rot->swap_xy && !rot->mirror_y);
+    // Four data lines, two clocks per byte
+    const uint32_t write_us = FLUSH_TE_WINDOW_US + (uint32_t)((uint64_t)bytes * 2000000U / bsp_lcd_io_get_pclk());
+
+    const bsp_te_sched_t sched = flush_te_get(ctx);
+    const int64_t now_us = esp_timer_get_time();
+    const int64_t earliest_us = LV_MAX(now_us, ctx->te_bus_free_us);
+    bool synced;
+    const int64_t start_us = bsp_te_sched_start(&sched, earliest_us, native.y1, native.y2, write_us, progressive,
+                                                &synced);
+    ctx->te_bus_free_us = start_us + write_us;
+
+    // Queued behind windows still on the bus, the write starts at earliest_us without our help
+    if (start_us > earliest_us) {
+        const int64_t wait_us = start_us - now_us;
+        if (wait_us >= FLUSH_TE_SPIN_US && esp_timer_start_once(ctx->te_timer, wait_us) == ESP_OK) {
+            xSemaphoreTake(ctx->te_sem, portMAX_DELAY);
+        } else {
+            esp_rom_delay_us((uint32_t)wait_us);
+        }
+    }
+    const uint32_t waited_us = start_us > earliest_us ? (uint32_t)(esp_timer_get_time() - now_us) : 0;
+
+    portENTER_CRITICAL(&ctx->stats_lock);
+    ctx->te_stats.windows++;
+    ctx->te_stats.unsynced += synced ? 0 : 1;
+    if (waited_us) {
+        ctx->te_stats.delayed++;
+        ctx->te_stats.wait_us += waited_us;
+        ctx->te_stats.wait_max_us = LV_MAX(ctx->te_stats.wait_max_us, waited_us);
+    }
+    portEXIT_CRITICAL(&ctx->stats_lock);
+}
+
+static esp_err_t flush_te_init(bsp_flush_ctx_t* ctx, const bsp_flush_config_t* config) {
+    ESP_RETURN_ON_FALSE(config->refresh_hz, ESP_ERR_INVALID_ARG, TAG, "No refresh rate");
+    const bsp_te_sched_cfg_t sched_cfg = {
+        .frame_us = 1000000 / config->refresh_hz,
+        .rows = BSP_LCD_V_HW_RES,
+        .blank_rows = BSP_LCD_TE_BLANK_ROWS,
+    };
+    bsp_te_sched_init(&ctx->te, &sched_cfg);
+
+    ctx->te_sem = xSemaphoreCreateBinaryStatic(&ctx->te_sem_buf);
+    const esp_timer_create_args_t timer_args = {
+        .callback = flush_te_timer_cb,
+        .arg = ctx,
+        .name = "bsp_flush_te",
+    };
+    ESP_RETURN_ON_ERROR(esp_timer_create(&timer_args, &ctx->te_timer), TAG, "No memory for the TE timer");
+
+    bsp_flush_te_t source = config->te;
+    if (source == BSP_FLUSH_TE_GPIO && config->te_gpio < 0) {
+        ESP_LOGW(TAG, "No TE GPIO configured, reading the scanline instead");
+        source = BSP_FLUSH_TE_SCANLINE;
+    }
+    if (source == BSP_FLUSH_TE_GPIO) {
+        const gpio_config_t te_cfg = {
+            .pin_bit_mask = BIT64(config->te_gpio),
+            .mode = GPIO_MODE_INPUT,
+            .intr_type = GPIO_INTR_POSEDGE,
+        };
+        ESP_RETURN_ON_ERROR(gpio_config(&te_cfg), TAG, "TE GPIO config failed");
+        // The touch driver may have installed the service already
+        const esp_err_t ret = gpio_install_isr_service(0);
+        ESP_RETURN_ON_FALSE(ret == ESP_OK || ret == ESP_ERR_INVALID_STATE, ret, TAG, "No GPIO ISR service");
+        ESP_RETURN_ON_ERROR(gpio_isr_handler_add(config->te_gpio, flush_te_isr, ctx), TAG, "TE ISR add failed");
+
+        // TE output on, vertical blanking only
+        const uint8_t mode = 0;
+        ESP_RETURN_ON_ERROR(esp_lcd_panel_io_tx_param(ctx->io, BSP_LCD_QSPI_CMD_WRITE(BSP_LCD_CMD_TEON), &mode, 1),
+                            TAG, "TEON failed");
+    }
+
+    ctx->te_source = source;
+    ESP_LOGI(TAG, "Tear-free present from %s", source == BSP_FLUSH_TE_GPIO ? "TE" : "scanline reads");
+    return ESP_OK;
+}
+
+/**
+ * Wait until at most max_pending chunks are still on the wire
+ */
+static void flush_wait_chunks(bsp_flush_ctx_t* ctx, uint32_t max_pending) {
+    if (ctx->chunks_sent - ctx->chunks_done <= max_pending) {
+        return;
+    }
+
+    const int64_t wait_start_us = esp_timer_get_time();
+    while (ctx->chunks_sent - ctx->chunks_done > max_pending) {
+        xSemaphoreTake(ctx->done_sem, pdMS_TO_TICKS(100)); // NOLINT(*-avoid-magic-numbers)
+    }
+
+    const uint32_t wait_us = esp_timer_get_time() - wait_start_us;
+    ctx->frame_wait_us += wait_us;
+    portENTER_CRITICAL(&ctx->stats_lock);
+    ctx->stats.wait_us += wait_us;
+    portEXIT_CRITICAL(&ctx->stats_lock);
+}
+
+/**
+ * Send the scroll band and offset requested since the last refresh. The windows of the previous frame were
+ * written in the old layout, the last of them may still be on the wire.
+ */
+static void flush_apply_scroll(bsp_flush_ctx_t* ctx) {
+    if (!ctx->scroll_band_pending && ctx->scroll_dy == 0) {
+        return;
+    }
+
+    // The flush task may still be sending, the panel IO takes one transfer at a time
+    flush_wait_chunks(ctx, 0);
+
+    esp_err_t ret = ESP_OK;
+    if (ctx->scroll_band_pending) {
+        // Everything in the old and the new band was invalidated, the new band starts without an offset
+        ctx->scroll_band_pending = false;
+        bsp_vscroll_set_band(&ctx->vscroll, ctx->scroll_band_top, ctx->scroll_band_height);
+        uint16_t def[3];
+        bsp_vscroll_def(&ctx->vscroll, def);
+        const uint8_t param[6] = {def[0] >> 8, def[0] & 0xFF, def[1] >> 8, def[1] & 0xFF, def[2] >> 8, def[2] & 0xFF};
+        ret = esp_lcd_panel_io_tx_param(ctx->io, BSP_LCD_QSPI_CMD_WRITE(BSP_LCD_CMD_VSCRDEF), param, sizeof(param));
+    }
+    // Content moving towards LVGL row 0 moves away from panel row 0 when the rows are mirrored
+    bsp_vscroll_scroll(&ctx->vscroll, ctx->panel_rotation.mirror_y ? -ctx->scroll_dy : ctx->scroll_dy);
+    ctx->scroll_dy = 0;
+
+    const uint16_t start = bsp_vscroll_start(&ctx->vscroll);
+    const uint8_t param[2] = {start >> 8, start & 0xFF};
+    if (ret == ESP_OK) {
+        ret = esp_lcd_panel_io_tx_param(ctx->io, BSP_LCD_QSPI_CMD_WRITE(BSP_LCD_CMD_VSCSAD), param, sizeof(param));
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Scroll update failed (%s)", esp_err_to_name(ret));
+    }
+}
+
+/**
+ * Panel rows of an area, split where the scroll band maps them apart. The band only exists while the rotation
+ * keeps LVGL rows on panel rows.
+ */
+static size_t flush_scroll_spans(const bsp_flush_ctx_t* ctx, const bsp_area_t* area, int32_t ver_res,
+                                 bsp_vscroll_span_t* spans) {
+    const bool flip = ctx->panel_rotation.mirror_y;
+    const int32_t row1 = flip ? ver_res - 1 - area->y2 : area->y1;
+    const int32_t row2 = flip ? ver_res - 1 - area->y1 : area->y2;
+    return bsp_vscroll_map(&ctx->vscroll, row1, row2, spans);
+}
+
+#ifdef CONFIG_BSP_LCD_FLUSH_TRACE
+/**
+ * Log the areas of one refresh cycle in the format test/host/test_sim_replay.c reads
+ */
+static void flush_trace_areas(bsp_flush_ctx_t* ctx, const bsp_area_t* areas, size_t count) {
+    if (ctx->trace_frame == 0) {
+        ESP_LOGI(TAG, "SCREEN,%ld,%ld", (long)lv_display_get_horizontal_resolution(ctx->disp),
+                 (long)lv_display_get_vertical_resolution(ctx->disp));
+    }
+    for (size_t i = 0; i < count; i++) {
+        ESP_LOGI(TAG, "AREA,%lu,%ld,%ld,%ld,%ld", (unsigned long)ctx->trace_frame, (long)areas[i].x1,
+                 (long)areas[i].y1, (long)areas[i].x2, (long)areas[i].y2);
+    }
+    ctx->trace_frame++;
+}
+#endif
+
+/**
+ * Runs before LVGL joins and renders the invalidated areas of a refresh cycle. The areas are replaced with
+ * the coalesced set, so LVGL renders and flushes exactly the windows we want on the wire.
+ */
+static void flush_refr_start_cb(lv_event_t* e) {
+    bsp_flush_ctx_t* ctx = lv_event_get_user_data(e);
+    lv_display_t* disp = ctx->disp;
+
+    ctx->frame_start_us = esp_timer_get_time();
+    flush_apply_scroll(ctx);
+
+    bsp_area_t areas[LV_INV_BUF_SIZE];
+    size_t count = 0;
+    for (uint32_t i = 0; i < disp->inv_p; i++) {
+        if (disp->inv_area_joined[i]) {
+            continue;
+        }
+        const lv_area_t* area = &disp->inv_areas[i];
+        areas[count++] = (bsp_area_t){area->x1, area->y1, area->x2, area->y2};
+    }
+
+    if (count == 0) {
+        return;
+    }
+
+#ifdef CONFIG_BSP_LCD_FLUSH_TRACE
+    flush_trace_areas(ctx, areas, count);
+#endif
+    ctx->frame_areas_in = count;
+    count = bsp_area_merge(areas, count, &ctx->merge_cfg);
+    ctx->frame_areas_out = count;
+
+    if (ctx->te_source == BSP_FLUSH_TE_SCANLINE) {
+        flush_te_read_scanline(ctx);
+    }
+    if (ctx->te_source != BSP_FLUSH_TE_OFF) {
+        flush_te_order(ctx, areas, count);
+    }
+
+    const int32_t hor_max = lv_display_get_horizontal_resolution(disp) - 1;
+    const int32_t ver_max = lv_display_get_vertical_resolution(disp) - 1;
+    for (size_t i = 0; i < count; i++) {
+        lv_area_set(&disp->inv_areas[i], LV_MAX(areas[i].x1, 0), LV_MAX(areas[i].y1, 0),
+                    LV_MIN(areas[i].x2, hor_max), LV_MIN(areas[i].y2, ver_max));
+        disp->inv_area_joined[i] = 0;
+    }
+    disp->inv_p = count;
+}
+
+/**
+ * Record the pending frame once its last chunk is done. Called with stats_lock held.
+ */
+static void flush_record_frame(bsp_flush_ctx_t* ctx, int64_t done_us) {
+    if (!ctx->pending_valid || (int32_t)(ctx->chunks_done - ctx->pending_last_chunk) < 0) {
+        return;
+    }
+    ctx->pending_valid = false;
+
+    const int64_t flush_us = done_us - ctx->pending_first_flush_us;
+    ctx->pending.value[BSP_FRAME_FLUSH_US] = flush_us > 0 ? (uint32_t)flush_us : 0;
+    bsp_frame_stats_push(&ctx->history, &ctx->pending);
+    // No-op after the first frame, or after a splash
+    bsp_boot_mark(BSP_BOOT_FIRST_PIXEL);
+}
+
+static void flush_frame_done(bsp_flush_ctx_t* ctx, int64_t last_flush_us, uint32_t render_wait_us) {
+    const int64_t start_us = ctx->frame_start_us ? ctx->frame_start_us : ctx->frame_first_flush_us;
+    const int64_t render_us = last_flush_us - start_us - render_wait_us;
+
+    portENTER_CRITICAL(&ctx->stats_lock);
+    ctx->stats.frames++;
+    ctx->stats.areas_in = ctx->frame_areas_in;
+    ctx->stats.areas_out = ctx->frame_areas_out;
+    ctx->stats.windows = ctx->frame_windows;
+    ctx->stats.bytes = ctx->frame_bytes;
+    ctx->stats.total_bytes += ctx->frame_bytes;
+    ctx->stats.transactions = ctx->frame_transactions;
+    ctx->stats.bytes_per_transaction = ctx->frame_data_transactions ?
+                                       ctx->frame_bytes / ctx->frame_data_transactions : 0;
+
+    // A frame whose last chunk never completed is dropped rather than blocking the history
+    ctx->pending = (bsp_frame_record_t){
+        .timestamp_us = start_us,
+        .value = {
+            [BSP_FRAME_RENDER_US] = render_us > 0 ? (uint32_t)render_us : 0,
+            [BSP_FRAME_BYTES] = ctx->frame_bytes,
+            [BSP_FRAME_AREAS] = ctx->frame_areas_out,
+            [BSP_FRAME_DMA_WAIT_US] = ctx->frame_wait_us,
+            [BSP_FRAME_LOCK_WAIT_US] = ctx->lock_wait_us,
+        },
+    };
+    ctx->pending_valid = true;
+    ctx->pending_last_chunk = ctx->chunks_sent;
+    ctx->pending_first_flush_us = ctx->frame_first_flush_us;
+    ctx->lock_wait_us = 0;
+    flush_record_frame(ctx, ctx->done_us);
+    portEXIT_CRITICAL(&ctx->stats_lock);
+
+    ctx->frame_areas_in = 0;
+    ctx->frame_areas_out = 0;
+    ctx->frame_windows = 0;
+    ctx->frame_bytes = 0;
+    ctx->frame_transactions = 0;
+    ctx->frame_data_transactions = 0;
+    ctx->frame_start_us = 0;
+    ctx->frame_first_flush_us = 0;
+    ctx->frame_wait_us = 0;
+}
+
+/**
+ * Account one window: CASET and RASET are one transaction each, the RAMWR payload is split by the panel IO
+ * into transactions of at most max_transfer_sz bytes.
+ */
+static void flush_count_window(bsp_flush_ctx_t* ctx, uint32_t bytes) {
+    const uint32_t data_transactions = (bytes + ctx->max_transfer_sz - 1) / ctx->max_transfer_sz;
+
+    ctx->frame_windows++;
+    ctx->frame_bytes += bytes;
+    ctx->frame_data_transactions += data_transactions;
+    ctx->frame_transactions += data_transactions + 2;
+}
+
+static void flush_add_overlap(bsp_flush_ctx_t* ctx, int64_t until_us) {
+    if (!ctx->overlap_pending) {
+        return;
+    }
+    ctx->overlap_pending = false;
+
+    if (until_us > ctx->submit_us) {
+        portENTER_CRITICAL(&ctx->stats_lock);
+        ctx->stats.overlap_us += until_us - ctx->submit_us;
+        portEXIT_CRITICAL(&ctx->stats_lock);
+    }
+}
+
+/**
+ * Count a chunk as finished, from the panel IO ISR or after a failed send. In partial mode, the last chunk of
+ * a window hands its buffer back to LVGL. In full-frame mode this was a bounce buffer chunk, the framebuffer
+ * was released once its rows were copied.
+ */
+static void flush_chunk_done(bsp_flush_ctx_t* ctx, int64_t now_us) {
+    portENTER_CRITICAL_SAFE(&ctx->stats_lock);
+    ctx->done_us = now_us;
+    ctx->chunks_done++;
+    const bool idle = ctx->chunks_done == ctx->chunks_sent;
+    flush_record_frame(ctx, now_us);
+    portEXIT_CRITICAL_SAFE(&ctx->stats_lock);
+
+    if (idle && !ctx->full_frame) {
+        ctx->in_flight = false;
+        lv_display_flush_ready(ctx->disp);
+    }
+}
+
+static bool flush_io_done_cb(esp_lcd_panel_io_handle_t io, esp_lcd_panel_io_event_data_t* edata, void* user_ctx) {
+    bsp_flush_ctx_t* ctx = user_ctx;
+    BaseType_t need_yield = pdFALSE;
+
+    flush_chunk_done(ctx, esp_timer_get_time());
+    xSemaphoreGiveFromISR(ctx->done_sem, &need_yield);
+
+    return need_yield == pdTRUE;
+}
+
+/**
+ * Called by LVGL only when it needs a buffer that is still on the wire. Everything between the submit of
+ * the window and this call was rendering that overlapped with the transfer.
+ */
+static void flush_wait_cb(lv_display_t* disp) {
+    bsp_flush_ctx_t* ctx = &flush_ctx;
+    const int64_t wait_start_us = esp_timer_get_time();
+
+    flush_add_overlap(ctx, wait_start_us);
+    while (ctx->in_flight) {
+        xSemaphoreTake(ctx->done_sem, pdMS_TO_TICKS(100)); // NOLINT(*-avoid-magic-numbers)
+    }
+
+    const uint32_t wait_us = esp_timer_get_time() - wait_start_us;
+    ctx->frame_wait_us += wait_us;
+    portENTER_CRITICAL(&ctx->stats_lock);
+    ctx->stats.wait_us += wait_us;
+    portEXIT_CRITICAL(&ctx->stats_lock);
+}
+
+/**
+ * Send a queued brightness step before the next window, the previous window has left the bus by now
+ */
+static void flush_carry_brightness(bsp_flush_ctx_t* ctx) {
+    atomic_fetch_add_explicit(&ctx->brightness_windows, 1, memory_order_relaxed);
+    const int32_t level = atomic_exchange(&ctx->brightness, -1);
+    if (level >= 0) {
+        const uint8_t param = (uint8_t)level;
+        esp_lcd_panel_io_tx_param(ctx->io, BSP_LCD_QSPI_CMD_WRITE(BSP_LCD_CMD_WRDISBV), &param, 1);
+    }
+}
+
+/**
+ * Write a window, one chunk per span from flush_scroll_spans(). The window is in panel addressing coordinates
+ * and px_map holds its rows packed in the panel format. flip is set when the panel mirrors rows in hardware, its
+ * addressing rows then run against the panel rows. After a failed write, the chunks not sent are counted as
+ * done and false is returned.
+ */
+static bool flush_draw(bsp_flush_ctx_t* ctx, const bsp_vscroll_span_t* spans, size_t span_count, bool flip,
+                       const bsp_area_t* window, const uint8_t* px_map) {
+    const size_t row_bytes = bsp_area_width(window) * ctx->wire_bytes_per_pixel;
+
+    const bool scrolled = span_count > 1 || spans[0].mem_row1 != spans[0].row1;
+
+    for (size_t i = 0; i < span_count; i++) {
+        // Not scrolled, the window goes out as it is, also when LVGL rows are not panel rows
+        int32_t rows = bsp_area_height(window);
+        int32_t src_row = window->y1;
+        int32_t dst_row = window->y1;
+        if (scrolled) {
+            rows = spans[i].row2 - spans[i].row1 + 1;
+            src_row = flip ? BSP_LCD_V_HW_RES - 1 - spans[i].row2 : spans[i].row1;
+            dst_row = flip ? BSP_LCD_V_HW_RES - rows - spans[i].mem_row1 : spans[i].mem_row1;
+        }
+
+        const esp_err_t ret = esp_lcd_panel_draw_bitmap(ctx->panel, window->x1, dst_row, window->x2 + 1,
+                                                        dst_row + rows, px_map + (src_row - window->y1) * row_bytes);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Window write failed (%s)", esp_err_to_name(ret));
+            for (; i < span_count; i++) {
+                flush_chunk_done(ctx, esp_timer_get_time());
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Convert a block of pixels from the LVGL format into packed lines in the panel format. Works in place when
+ * dst is src and the block is packed.
+ */
+static void flush_convert(const bsp_flush_ctx_t* ctx, const uint8_t* src, uint32_t src_stride,
+                          const bsp_area_t* window, uint8_t* dst) {
+    const int32_t width = bsp_area_width(window);
+    const size_t dst_stride = width * ctx->wire_bytes_per_pixel;
+
+    for (int32_t y = window->y1; y <= window->y2; y++) {
+        bsp_color_convert(&ctx->conv, src, dst, width, window->x1, y);
+        src += src_stride;
+        dst += dst_stride;
+    }
+}
+
+/**
+ * Copy an area of the framebuffer into the bounce buffers a few lines at a time and send each chunk as its
+ * own window. One bounce buffer is filled while the other one is on the wire.
+ */
+static void flush_stream_area(bsp_flush_ctx_t* ctx, const lv_area_t* area, const uint8_t* fb, uint32_t stride) {
+    const int32_t width = lv_area_get_width(area);
+    const bool flip = !ctx->sw_rotate && ctx->panel_rotation.mirror_y;
+    bsp_vscroll_span_t spans[BSP_VSCROLL_MAX_SPANS];
+    const uint8_t* src = fb + area->y1 * stride + area->x1 * ctx->bytes_per_pixel;
+
+    for (int32_t y = area->y1; y <= area->y2; y += ctx->bounce_lines) {
+        const int32_t lines = LV_MIN(ctx->bounce_lines, area->y2 - y + 1);
+        uint8_t* bounce = ctx->bounce[ctx->bounce_idx];
+        const bsp_area_t chunk = {area->x1, y, area->x2, y + lines - 1};
+        bsp_area_t window = chunk;
+
+        // The chunks sent from this buffer last time must be done before we overwrite it
+        flush_wait_chunks(ctx, ctx->chunks_sent - ctx->bounce_seq[ctx->bounce_idx]);
+        if (ctx->sw_rotate) {
+            bsp_rotate_blit(&ctx->sw_rotation, src, stride, width, lines, ctx->bytes_per_pixel, bounce);
+            bsp_rotate_area(&ctx->sw_rotation, &window, lv_display_get_horizontal_resolution(ctx->disp),
+                            lv_display_get_vertical_resolution(ctx->disp), &window);
+            if (ctx->convert) {
+                flush_convert(ctx, bounce, bsp_area_width(&window) * ctx->bytes_per_pixel, &window, bounce);
+            }
+        } else {
+            // Copying the rows into the bounce buffer and converting them is a single pass
+            flush_convert(ctx, src, stride, &window, bounce);
+        }
+        src += lines * stride;
+
+        flush_te_wait(ctx, &chunk, lv_display_get_horizontal_resolution(ctx->disp),
+                      lv_display_get_vertical_resolution(ctx->disp), &ctx->panel_rotation, ctx->sw_rotate,
+                      lines * width * ctx->wire_bytes_per_pixel);
+        const size_t span_count = flush_scroll_spans(ctx, &chunk, lv_display_get_vertical_resolution(ctx->disp),
+                                                     spans);
+        ctx->chunks_sent += span_count;
+        flush_draw(ctx, spans, span_count, flip, &window, bounce);
+        ctx->bounce_seq[ctx->bounce_idx] = ctx->chunks_sent;
+
+        flush_count_window(ctx, lines * width * ctx->wire_bytes_per_pixel);
+        ctx->bounce_idx ^= 1;
+    }
+}
+
+/**
+ * Direct render mode: LVGL calls flush once per invalidated area with the whole framebuffer. The areas are
+ * collected until the last one of the frame, then only those rows are streamed out.
+ */
+static void flush_full_frame(bsp_flush_ctx_t* ctx, lv_display_t* disp, const lv_area_t* area, const uint8_t* fb,
+                             int64_t now_us) {
+    if (ctx->frame_area_cnt < LV_INV_BUF_SIZE) {
+        ctx->frame_areas[ctx->frame_area_cnt++] = *area;
+    } else {
+        lv_area_t* last = &ctx->frame_areas[LV_INV_BUF_SIZE - 1];
+        lv_area_join(last, last, area);
+    }
+
+    if (!lv_display_flush_is_last(disp)) {
+        lv_display_flush_ready(disp);
+        return;
+    }
+
+    const uint32_t render_wait_us = ctx->frame_wait_us;
+    const uint32_t stride = lv_draw_buf_width_to_stride(lv_display_get_horizontal_resolution(disp),
+                                                        lv_display_get_color_format(disp));
+    // Once per frame, between bounce chunks it would hold back the chunk queued behind it
+    flush_carry_brightness(ctx);
+    for (uint32_t i = 0; i < ctx->frame_area_cnt; i++) {
+        flush_stream_area(ctx, &ctx->frame_areas[i], fb, stride);
+    }
+    ctx->frame_area_cnt = 0;
+
+    // Every changed row now lives in a bounce buffer, LVGL may render the next frame
+    lv_display_flush_ready(disp);
+    flush_frame_done(ctx, now_us, render_wait_us);
+}
+
+/**
+ * Rotate, convert and send one window. Runs in the LVGL task, or in the flush task when there is one. Returns
+ * false if the window could not be sent, LVGL has then been told the buffer is free.
+ */
+static bool flush_send(bsp_flush_ctx_t* ctx, const flush_job_t* job) {
+    bsp_area_t window = job->area;
+    uint8_t* px_map = job->px_map;
+    uint32_t stride = job->stride;
+    const int32_t width = bsp_area_width(&job->area);
+
+    if (job->sw_rotate) {
+        // LVGL waits for the previous window before flushing again, so rotate_buf is free here
+        bsp_rotate_blit(&job->sw_rotation, px_map, stride, width, bsp_area_height(&job->area), ctx->bytes_per_pixel,
+                        ctx->rotate_buf);
+        bsp_rotate_area(&job->sw_rotation, &window, job->hor_res, job->ver_res, &window);
+        px_map = ctx->rotate_buf;
+        stride = bsp_area_width(&window) * ctx->bytes_per_pixel;
+    }
+    if (ctx->convert) {
+        // LVGL renders the whole draw buffer again, so the pixels can be converted in place
+        flush_convert(ctx, px_map, stride, &window, px_map);
+    }
+
+    flush_te_wait(ctx, &job->area, job->hor_res, job->ver_res, &job->panel_rotation, job->sw_rotate,
+                  width * bsp_area_height(&job->area) * ctx->wire_bytes_per_pixel);
+    flush_carry_brightness(ctx);
+    // The window is closed in flush_io_done_cb(), LVGL keeps rendering into the other buffer meanwhile
+    return flush_draw(ctx, job->spans, job->span_count, !job->sw_rotate && job->panel_rotation.mirror_y, &window,
+                      px_map);
+}
+
+static void flush_task(void* arg) {
+    bsp_flush_ctx_t* ctx = arg;
+    flush_job_t job;
+
+    for (;;) {
+        if (xQueueReceive(ctx->jobs, &job, portMAX_DELAY) == pdTRUE) {
+            flush_send(ctx, &job);
+        }
+    }
+}
+
+static void flush_cb(lv_display_t* disp, const lv_area_t* area, uint8_t* px_map) {
+    bsp_flush_ctx_t* ctx = &flush_ctx;
+    const int64_t now_us = esp_timer_get_time();
+
+    if (ctx->frame_first_flush_us == 0) {
+        ctx->frame_first_flush_us = now_us;
+    }
+    if (ctx->full_frame) {
+        flush_full_frame(ctx, disp, area, px_map, now_us);
+        return;
+    }
+
+    // The previous window finished before LVGL needed its buffer, so its whole transfer was hidden
+    flush_add_overlap(ctx, ctx->done_us);
+
+    flush_count_window(ctx, lv_area_get_size(area) * ctx->wire_bytes_per_pixel);
+
+    // Everything the job needs from the display is captured here, a rotation may change before it runs
+    flush_job_t job = {
+        .area = {area->x1, area->y1, area->x2, area->y2},
+        .px_map = px_map,
+        .stride = lv_draw_buf_width_to_stride(lv_area_get_width(area), lv_display_get_color_format(disp)),
+        .hor_res = lv_display_get_horizontal_resolution(disp),
+        .ver_res = lv_display_get_vertical_resolution(disp),
+        .sw_rotate = ctx->sw_rotate,
+        .sw_rotation = ctx->sw_rotation,
+        .panel_rotation = ctx->panel_rotation,
+    };
+    job.span_count = flush_scroll_spans(ctx, &job.area, job.ver_res, job.spans);
+
+    ctx->in_flight = true;
+    ctx->chunks_sent += job.span_count;
+    if (ctx->jobs) {
+        // Rotation and conversion run on the other core, which already overlaps with rendering
+        ctx->submit_us = now_us;
+        ctx->overlap_pending = true;
+        xQueueSend(ctx->jobs, &job, portMAX_DELAY);
+    } else if (flush_send(ctx, &job)) {
+        ctx->submit_us = esp_timer_get_time();
+        ctx->overlap_pending = true;
+    }
+
+    if (lv_display_flush_is_last(disp)) {
+        flush_frame_done(ctx, now_us, ctx->frame_wait_us);
+    }
+}
+
+/**
+ * Panel transform for an LVGL rotation, composed with the rotation selected in Kconfig. This is the same
+ * mapping esp_lvgl_port applies to the panel.
+ */
+static bsp_rotate_t flush_panel_transform(const bsp_rotate_t* base, lv_display_rotation_t rotation) {
+    switch (rotation) {
+    case LV_DISPLAY_ROTATION_90:
+        return base->swap_xy ? (bsp_rotate_t){false, !base->mirror_x, base->mirror_y}
+               : (bsp_rotate_t){true, base->mirror_x, !base->mirror_y};
+    case LV_DISPLAY_ROTATION_180:
+        return (bsp_rotate_t){base->swap_xy, !base->mirror_x, !base->mirror_y};
+    case LV_DISPLAY_ROTATION_270:
+        return base->swap_xy ? (bsp_rotate_t){false, base->mirror_x, !base->mirror_y}
+               : (bsp_rotate_t){true, !base->mirror_x, base->mirror_y};
+    default:
+        return *base;
+    }
+}
+
+/**
+ * Program the panel MADCTL for the current rotation. When the panel driver cannot swap or mirror, the panel is
+ * left unrotated and the flush stage rotates pixels instead.
+ */
+static void flush_update_rotation(bsp_flush_ctx_t* ctx) {
+    const bsp_rotate_t rot = flush_panel_transform(&ctx->base_rotation, lv_display_get_rotation(ctx->disp));
+    ctx->panel_rotation = rot;
+
+    // LVGL rows may no longer be panel rows, the scroll band goes with the next refresh
+    ctx->scroll_band_pending = ctx->scroll_band_pending || ctx->vscroll.height > 0;
+    ctx->scroll_band_height = 0;
+    ctx->scroll_dy = 0;
+
+    esp_err_t ret = esp_lcd_panel_swap_xy(ctx->panel, rot.swap_xy);
+    if (ret == ESP_OK) {
+        ret = esp_lcd_panel_mirror(ctx->panel, rot.mirror_x, rot.mirror_y);
+    }
+    if (ret == ESP_OK || bsp_rotate_is_identity(&rot)) {
+        ctx->sw_rotate = false;
+        return;
+    }
+
+    esp_lcd_panel_swap_xy(ctx->panel, false);
+    esp_lcd_panel_mirror(ctx->panel, false, false);
+
+    if (!ctx->full_frame && ctx->rotate_buf == NULL) {
+        ctx->rotate_buf = heap_caps_malloc(ctx->rotate_buf_size, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+        if (ctx->rotate_buf == NULL) {
+            ESP_LOGE(TAG, "No memory for software rotation, the screen stays unrotated");
+            ctx->sw_rotate = false;
+            return;
+        }
+    }
+
+    ESP_LOGI(TAG, "Panel cannot rotate in hardware (%s), rotating in software", esp_err_to_name(ret));
+    ctx->sw_rotation = rot;
+    ctx->sw_rotate = true;
+}
+
+static void flush_resolution_changed_cb(lv_event_t* e) {
+    flush_update_rotation(lv_event_get_user_data(e));
+}
+
+esp_err_t bsp_flush_attach(lv_display_t* disp, const bsp_flush_config_t* config) {
+    ESP_RETURN_ON_FALSE(disp && config && config->panel && config->io && config->max_transfer_sz, ESP_ERR_INVALID_ARG,
+                        TAG, "Invalid arguments");
+
+    bsp_flush_ctx_t* ctx = &flush_ctx;
+    ctx->disp = disp;
+    ctx->panel = config->panel;
+    ctx->io = config->io;
+    ctx->bytes_per_pixel = lv_color_format_get_size(lv_display_get_color_format(disp));
+    ctx->wire_bytes_per_pixel = config->bits_per_pixel / 8;
+    ctx->conv = (bsp_color_conv_t){
+        .src_bytes_per_pixel = ctx->bytes_per_pixel,
+        .dst_bytes_per_pixel = ctx->wire_bytes_per_pixel,
+        .swap_bytes = config->swap_bytes,
+        .dither = config->dither,
+    };
+    ctx->convert = !bsp_color_conv_is_copy(&ctx->conv);
+    ctx->max_transfer_sz = config->max_transfer_sz;
+    ctx->base_rotation = config->rotation;
+    ctx->rotate_buf_size = config->buffer_size * ctx->bytes_per_pixel;
+    ctx->merge_cfg = (bsp_area_merge_cfg_t){
+        .bytes_per_pixel = ctx->wire_bytes_per_pixel,
+        .window_overhead = CONFIG_BSP_LCD_FLUSH_WINDOW_COST,
+        .align = FLUSH_AREA_ALIGN,
+    };
+
+    ctx->done_sem = xSemaphoreCreateBinaryStatic(&ctx->done_sem_buf);
+    bsp_frame_stats_init(&ctx->history);
+    bsp_vscroll_init(&ctx->vscroll, BSP_LCD_V_HW_RES);
+
+    if (config->full_frame) {
+        // Windows may be as wide as the longer side once the screen is rotated. Pixels are rotated in the LVGL
+        // format and converted in place afterwards, so the buffers are sized for the larger of both formats.
+        const size_t width = LV_MAX(BSP_LCD_H_RES, BSP_LCD_V_RES);
+        const size_t bounce_size = width * config->bounce_lines * ctx->bytes_per_pixel;
+        for (int i = 0; i < 2; i++) {
+            ctx->bounce[i] = heap_caps_malloc(bounce_size, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+            ESP_RETURN_ON_FALSE(ctx->bounce[i], ESP_ERR_NO_MEM, TAG, "No memory for bounce buffers");
+        }
+        ctx->bounce_lines = (int32_t)config->bounce_lines;
+        ctx->full_frame = true;
+    }
+
+    if (config->te != BSP_FLUSH_TE_OFF) {
+        ESP_RETURN_ON_ERROR(flush_te_init(ctx, config), TAG, "Tear-free present failed");
+    }
+
+    if (config->flush_task && !config->full_frame && ctx->jobs == NULL) {
+        QueueHandle_t jobs = xQueueCreateStatic(1, sizeof(flush_job_t), ctx->jobs_storage, &ctx->jobs_buf);
+        ctx->jobs = jobs;
+        if (xTaskCreatePinnedToCore(flush_task, "bsp_flush", config->flush_task_stack, ctx,
+                                    config->flush_task_priority, NULL, config->flush_task_core) != pdPASS) {
+            ctx->jobs = NULL;
+            vQueueDelete(jobs);
+            ESP_LOGE(TAG, "No memory for the flush task");
+            return ESP_ERR_NO_MEM;
+        }
+        ESP_LOGI(TAG, "Flush task on core %d", config->flush_task_core);
+    }
+
+    // Replaces the callback registered by esp_lvgl_port, flush_ready is signalled from flush_io_done_cb()
+    const esp_lcd_panel_io_callbacks_t cbs = {
+        .on_color_trans_done = flush_io_done_cb,
+    };
+    ESP_RETURN_ON_ERROR(esp_lcd_panel_io_register_event_callbacks(ctx->io, &cbs, ctx), TAG,
+                        "IO callback registration failed");
+
+    lvgl_port_lock(0);
+    lv_display_set_flush_cb(disp, flush_cb);
+    lv_display_set_flush_wait_cb(disp, flush_wait_cb);
+    lv_display_add_event_cb(disp, flush_refr_start_cb, LV_EVENT_REFR_START, ctx);
+    lv_display_add_event_cb(disp, flush_resolution_changed_cb, LV_EVENT_RESOLUTION_CHANGED, ctx);
+    flush_update_rotation(ctx);
+    lvgl_port_unlock();
+
+    return ESP_OK;
+}
+
+esp_err_t bsp_display_get_flush_stats(bsp_display_flush_stats_t* stats) {
+    ESP_RETURN_ON_FALSE(stats, ESP_ERR_INVALID_ARG, TAG, "Invalid arguments");
+
+    portENTER_CRITICAL(&flush_ctx.stats_lock);
+    *stats = flush_ctx.stats;
+    portEXIT_CRITICAL(&flush_ctx.stats_lock);
+
+    return ESP_OK;
+}
+
+esp_err_t bsp_display_get_te_stats(bsp_display_te_stats_t* stats) {
+    ESP_RETURN_ON_FALSE(stats, ESP_ERR_INVALID_ARG, TAG, "Invalid arguments");
+    ESP_RETURN_ON_FALSE(flush_ctx.te_source != BSP_FLUSH_TE_OFF, ESP_ERR_INVALID_STATE, TAG,
+                        "Tear-free present is off");
+
+    portENTER_CRITICAL(&flush_ctx.stats_lock);
+    *stats = flush_ctx.te_stats;
+    portEXIT_CRITICAL(&flush_ctx.stats_lock);
+    stats->period_us = flush_te_get(&flush_ctx).period_us;
+
+    return ESP_OK;
+}
+
+esp_err_t bsp_flush_wait_idle(uint32_t timeout_ms) {
+    bsp_flush_ctx_t* ctx = &flush_ctx;
+    ESP_RETURN_ON_FALSE(ctx->disp, ESP_ERR_INVALID_STATE, TAG, "Flush stage not attached");
+
+    // flushing is cleared by lv_display_flush_ready(), after the last chunk of the window went out
+    const int64_t deadline_us = esp_timer_get_time() + (int64_t)timeout_ms * 1000;
+    while (ctx->disp->flushing || ctx->in_flight) {
+        ESP_RETURN_ON_FALSE(esp_timer_get_time() < deadline_us, ESP_ERR_TIMEOUT, TAG, "Flush did not complete");
+        vTaskDelay(1);
+    }
+    return bsp_lcd_io_wait_idle();
+}
+
+bool bsp_flush_queue_brightness(int32_t level) {
+    bsp_flush_ctx_t* ctx = &flush_ctx;
+
+    const uint32_t windows = atomic_load_explicit(&ctx->brightness_windows, memory_order_relaxed);
+    const bool flushing = level >= 0 && windows != ctx->brightness_windows_seen;
+    ctx->brightness_windows_seen = windows;
+    atomic_store(&ctx->brightness, flushing ? level : -1);
+    return flushing;
+}
+
+void bsp_flush_add_lock_wait(uint32_t wait_us) {
+    portENTER_CRITICAL(&flush_ctx.stats_lock);
+    flush_ctx.lock_wait_us += wait_us;
+    portEXIT_CRITICAL(&flush_ctx.stats_lock);
+}
+
+esp_err_t bsp_flush_set_scroll_band(int32_t y1, int32_t y2) {
+    bsp_flush_ctx_t* ctx = &flush_ctx;
+    ESP_RETURN_ON_FALSE(ctx->disp, ESP_ERR_INVALID_STATE, TAG, "Flush stage not attached");
+
+    const int32_t ver_res = lv_display_get_vertical_resolution(ctx->disp);
+    int32_t top = 0;
+    int32_t height = 0;
+    if (y2 >= y1) {
+        ESP_RETURN_ON_FALSE(y1 >= 0 && y2 < ver_res, ESP_ERR_INVALID_ARG, TAG, "Rows outside the display");
+        if (ctx->panel_rotation.swap_xy) {
+            // Not logged, the caller falls back to redrawing on every scroll step
+            return ESP_ERR_NOT_SUPPORTED;
+        }
+        top = ctx->panel_rotation.mirror_y ? ver_res - 1 - y2 : y1;
+        height = y2 - y1 + 1;
+    }
+
+    ctx->scroll_band_top = top;
+    ctx->scroll_band_height = height;
+    ctx->scroll_band_pending = true;
+    ctx->scroll_dy = 0;
+    return ESP_OK;
+}
+
+void bsp_flush_scroll(int32_t dy) {
+    flush_ctx.scroll_dy += dy;
+}
+
+int32_t bsp_flush_scroll_pending(void) {
+    return flush_ctx.scroll_dy;
+}
+
+static void flush_get_metric(bsp_frame_metric_t metric, bsp_display_metric_t* out) {
+    uint32_t values[BSP_FRAME_STATS_FRAMES];
+
+    // Only the copy runs under the spinlock, sorting happens outside
+    portENTER_CRITICAL(&flush_ctx.stats_lock);
+    const size_t count = bsp_frame_stats_values(&flush_ctx.history, metric, values);
+    memcpy(out->histogram, flush_ctx.history.histogram[metric], sizeof(out->histogram));
+    portEXIT_CRITICAL(&flush_ctx.stats_lock);
+
+    bsp_frame_summary_t summary;
+    bsp_frame_stats_summary(values, count, &summary);
+    out->last = summary.last;
+    out->min = summary.min;
+    out->max = summary.max;
+    out->avg = summary.avg;
+    out->p50 = summary.p50;
+    out->p95 = summary.p95;
+}
+
+esp_err_t bsp_display_get_stats(bsp_display_stats_t* stats) {
+    ESP_RETURN_ON_FALSE(stats, ESP_ERR_INVALID_ARG, TAG, "Invalid arguments");
+    _Static_assert(BSP_DISPLAY_STATS_BUCKETS == BSP_FRAME_STATS_BUCKETS, "Histogram size mismatch");
+    _Static_assert(BSP_DISPLAY_STATS_FRAMES == BSP_FRAME_STATS_FRAMES, "Ring size mismatch");
+
+    *stats = (bsp_display_stats_t){0};
+    portENTER_CRITICAL(&flush_ctx.stats_lock);
+    const bsp_frame_stats_t* history = &flush_ctx.history;
+    stats->frames = history->count;
+    stats->total_frames = history->total;
+    if (history->count > 1) {
+        const int64_t first_us = bsp_frame_stats_get(history, history->total - history->count)->timestamp_us;
+        const int64_t last_us = bsp_frame_stats_get(history, history->total - 1)->timestamp_us;
+        stats->fps = last_us > first_us ? (float)(history->count - 1) * 1e6f / (float)(last_us - first_us) : 0.0f;
+    }
+    portEXIT_CRITICAL(&flush_ctx.stats_lock);
+
+    // Metrics are copied one by one, a frame recorded in between may show up in some of them only
+    flush_get_metric(BSP_FRAME_RENDER_US, &stats->render_us);
+    flush_get_metric(BSP_FRAME_FLUSH_US, &stats->flush_us);
+    flush_get_metric(BSP_FRAME_BYTES, &stats->bytes);
+    flush_get_metric(BSP_FRAME_AREAS, &stats->areas);
+    flush_get_metric(BSP_FRAME_DMA_WAIT_US, &stats->dma_wait_us);
+    flush_get_metric(BSP_FRAME_LOCK_WAIT_US, &stats->lock_wait_us);
+
+    return ESP_OK;
+}
+
+// Bytes of binary dump per log line, a multiple of 3 so lines carry no base64 padding
+#define FLUSH_DUMP_LINE_BYTES   (48)
+
+typedef struct {
+    uint8_t buf[FLUSH_DUMP_LINE_BYTES];
+    size_t len;
+} flush_dump_writer_t;
+
+static void flush_dump_flush(flush_dump_writer_t* w) {
+    char line[FLUSH_DUMP_LINE_BYTES / 3 * 4 + 1];
+    if (w->len) {
+        bsp_frame_stats_base64(w->buf, w->len, line);
+        ESP_LOGI(TAG, "%s", line);
+        w->len = 0;
+    }
+}
+
+static void flush_dump_put(flush_dump_writer_t* w, const void* data, size_t len) {
+    const uint8_t* p = data;
+    while (len--) {
+        w->buf[w->len++] = *p++;
+        if (w->len == FLUSH_DUMP_LINE_BYTES) {
+            flush_dump_flush(w);
+        }
+    }
+}
+
+static void flush_dump_put_u32(flush_dump_writer_t* w, uint32_t v) {
+    const uint8_t le[4] = {v & 0xFF, (v >> 8) & 0xFF, (v >> 16) & 0xFF, v >> 24};
+    flush_dump_put(w, le, sizeof(le));
+}
+
+/**
+ * Copy one frame out of the live ring, false once it has been overwritten
+ */
+static bool flush_dump_frame(uint32_t seq, bsp_frame_record_t* frame) {
+    portENTER_CRITICAL(&flush_ctx.stats_lock);
+    const bsp_frame_record_t* record = bsp_frame_stats_get(&flush_ctx.history, seq);
+    if (record) {
+        *frame = *record;
+    }
+    portEXIT_CRITICAL(&flush_ctx.stats_lock);
+    return record != NULL;
+}
+
+esp_err_t bsp_display_dump_stats(bsp_display_stats_format_t format) {
+    ESP_RETURN_ON_FALSE(format == BSP_DISPLAY_STATS_CSV || format == BSP_DISPLAY_STATS_BINARY, ESP_ERR_INVALID_ARG,
+                        TAG, "Invalid format");
+
+    // Frames are copied one at a time, so logging never holds the spinlock and new frames keep being recorded
+    portENTER_CRITICAL(&flush_ctx.stats_lock);
+    const uint32_t total = flush_ctx.history.total;
+    const uint32_t count = flush_ctx.history.count;
+    portEXIT_CRITICAL(&flush_ctx.stats_lock);
+
+    bsp_frame_record_t frame;
+    if (format == BSP_DISPLAY_STATS_CSV) {
+        ESP_LOGI(TAG, "frame,timestamp_us,render_us,flush_us,bytes,areas,dma_wait_us,lock_wait_us");
+        for (uint32_t seq = total - count; seq != total; seq++) {
+            if (!flush_dump_frame(seq, &frame)) {
+                continue;
+            }
+            ESP_LOGI(TAG, "%lu,%lld,%lu,%lu,%lu,%lu,%lu,%lu", (unsigned long)seq, (long long)frame.timestamp_us,
+                     (unsigned long)frame.value[BSP_FRAME_RENDER_US], (unsigned long)frame.value[BSP_FRAME_FLUSH_US],
+                     (unsigned long)frame.value[BSP_FRAME_BYTES], (unsigned long)frame.value[BSP_FRAME_AREAS],
+                     (unsigned long)frame.value[BSP_FRAME_DMA_WAIT_US],
+                     (unsigned long)frame.value[BSP_FRAME_LOCK_WAIT_US]);
+        }
+        return ESP_OK;
+    }
+
+    flush_dump_writer_t writer = {0};
+    const uint8_t header[8] = {'B', 'S', 'P', 'F', 1, BSP_FRAME_METRICS, count & 0xFF, count >> 8};
+    ESP_LOGI(TAG, "BEGIN BSPF %lu", (unsigned long)count);
+    flush_dump_put(&writer, header, sizeof(header));
+
+    // The header promises count frames, a frame overwritten meanwhile is sent as zeros
+    int64_t first_us = 0;
+    for (uint32_t seq = total - count; seq != total; seq++) {
+        if (!flush_dump_frame(seq, &frame)) {
+            frame = (bsp_frame_record_t){0};
+        } else if (first_us == 0) {
+            first_us = frame.timestamp_us;
+        }
+        flush_dump_put_u32(&writer, frame.timestamp_us ? (uint32_t)(frame.timestamp_us - first_us) : 0);
+        for (int m = 0; m < BSP_FRAME_METRICS; m++) {
+            flush_dump_put_u32(&writer, frame.value[m]);
+        }
+    }
+    flush_dump_flush(&writer);
+    ESP_LOGI(TAG, "END BSPF");
+
+    return ESP_OK;
+}
+// NOLINTEND (*-avoid-non-const-global-variables)
+#endif // (BSP_CONFIG_NO_GRAPHIC_LIB == 0)
@@ -0,0 +1,89 @@
+#include <string.h>
+#include "bsp_frame_stats.h"
+
+void bsp_frame_stats_init(bsp_frame_stats_t* stats) {
+    memset(stats, 0, sizeof(*stats));
+}
+
+uint32_t bsp_frame_stats_bucket(uint32_t value) {
+    uint32_t bucket = 0;
+    while (value && bucket < BSP_FRAME_STATS_BUCKETS - 1) {
+        value >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+void bsp_frame_stats_push(bsp_frame_stats_t* stats, const bsp_frame_record_t* frame) {
+    bsp_frame_record_t* slot = &stats->frames[stats->total % BSP_FRAME_STATS_FRAMES];
+
+    if (stats->count == BSP_FRAME_STATS_FRAMES) {
+        for (int m = 0; m < BSP_FRAME_METRICS; m++) {
+            stats->histogram[m][bsp_frame_stats_bucket(slot->value[m])]--;
+        }
+    } else {
+        stats->count++;
+    }
+
+    *slot = *frame;
+    for (int m = 0; m < BSP_FRAME_METRICS; m++) {
+        stats->histogram[m][bsp_frame_stats_bucket(slot->value[m])]++;
+    }
+    stats->total++;
+}
+
+const bsp_frame_record_t* bsp_frame_stats_get(const bsp_frame_stats_t* stats, uint32_t seq) {
+    if (seq >= stats->total || stats->total - seq > stats->count) {
+        return NULL;
+    }
+    return &stats->frames[seq % BSP_FRAME_STATS_FRAMES];
+}
+
+size_t bsp_frame_stats_values(const bsp_frame_stats_t* stats, bsp_frame_metric_t metric, uint32_t* values) {
+    for (uint32_t i = 0; i < stats->count; i++) {
+        values[i] = stats->frames[(stats->total - stats->count + i) % BSP_FRAME_STATS_FRAMES].value[metric];
+    }
+    return stats->count;
+}
+
+void bsp_frame_stats_summary(uint32_t* values, size_t count, bsp_frame_summary_t* out) {
+    *out = (bsp_frame_summary_t){0};
+    if (count == 0) {
+        return;
+    }
+    out->last = values[count - 1];
+
+    // At most one ring of values, an insertion sort gives exact percentiles cheaply
+    uint64_t sum = 0;
+    for (size_t i = 0; i < count; i++) {
+        const uint32_t v = values[i];
+        size_t j = i;
+        for (; j > 0 && values[j - 1] > v; j--) {
+            values[j] = values[j - 1];
+        }
+        values[j] = v;
+        sum += v;
+    }
+
+    out->min = values[0];
+    out->max = values[count - 1];
+    out->avg = (uint32_t)(sum / count);
+    // Nearest rank
+    out->p50 = values[(count * 50 + 99) / 100 - 1];
+    out->p95 = values[(count * 95 + 99) / 100 - 1];
+}
+
+void bsp_frame_stats_base64(const uint8_t* src, size_t len, char* dst) {
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    for (size_t i = 0; i < len; i += 3) {
+        const uint32_t b1 = i + 1 < len ? src[i + 1] : 0;
+        const uint32_t b2 = i + 2 < len ? src[i + 2] : 0;
+        const uint32_t triple = ((uint32_t)src[i] << 16) | (b1 << 8) | b2;
+        *dst++ = alphabet[(triple >> 18) & 0x3F];
+        *dst++ = alphabet[(triple >> 12) & 0x3F];
+        *dst++ = i + 1 < len ? alphabet[(triple >> 6) & 0x3F] : '=';
+        *dst++ = i + 2 < len ? alphabet[triple & 0x3F] : '=';
+    }
+    *dst = '\0';
+}
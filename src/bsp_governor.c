@@ -0,0 +1,188 @@
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "esp_lvgl_port.h"
+#include "freertos/FreeRTOS.h"
+
+#include "bsp/lilygo-t4-s3.h"
+#include "bsp_governor.h"
+#include "bsp_governor_policy.h"
+
+#if (BSP_CONFIG_NO_GRAPHIC_LIB == 0)
+#include "src/display/lv_display_private.h"
+
+// NOLINTBEGIN (*-avoid-non-const-global-variables)
+static const char* TAG = "T4 S3 governor";
+
+// Refresh cycles further apart than this were held by the power manager or the application, not late
+#define GOVERNOR_PAUSE_US   (1000000)
+// LVGL's own pace without the governor
+#define GOVERNOR_FREE_US    (LV_DEF_REFR_PERIOD * 1000)
+
+typedef struct {
+    lv_display_t* disp;
+    lv_timer_t* refr_timer;
+
+    /* LVGL context only */
+    bsp_governor_policy_t policy;
+    uint32_t hz;
+    uint32_t period_ms;
+    bool changed;               /* Something was invalidated since the last refresh cycle */
+    bool last_changed;
+    int64_t last_cycle_us;
+    int64_t render_start_us;    /* Start of the refresh cycle being rendered, 0 when it had nothing to render */
+    int64_t render_us;          /* Averaged time a refresh cycle with changes takes */
+
+    portMUX_TYPE stats_lock;
+    bsp_display_governor_stats_t stats;
+} bsp_governor_ctx_t;
+
+static bsp_governor_ctx_t governor_ctx = {
+    .stats_lock = portMUX_INITIALIZER_UNLOCKED,
+};
+
+static void governor_set_rate(bsp_governor_ctx_t* ctx, uint32_t hz) {
+    if (hz == ctx->hz) {
+        return;
+    }
+
+    // The refresh timer counts in whole milliseconds, 60 Hz runs at 62.5 Hz
+    ctx->hz = hz;
+    ctx->period_ms = LV_MAX(1000 / hz, 1);
+    lv_timer_set_period(ctx->refr_timer, ctx->period_ms);
+
+    portENTER_CRITICAL(&ctx->stats_lock);
+    ctx->stats.hz = hz;
+    ctx->stats.rate_changes++;
+    portEXIT_CRITICAL(&ctx->stats_lock);
+}
+
+/**
+ * Runs at the start of every refresh cycle, after the flush stage has coalesced the invalidated areas
+ */
+static void governor_refr_start_cb(lv_event_t* e) {
+    bsp_governor_ctx_t* ctx = lv_event_get_user_data(e);
+    const int64_t now_us = esp_timer_get_time();
+    const bool changed = ctx->changed || ctx->disp->inv_p > 0;
+    ctx->changed = false;
+    bsp_governor_policy_frame(&ctx->policy, now_us, changed);
+
+    // Both counted against the period that paced this cycle
+    const int64_t interval_us = now_us - ctx->last_cycle_us;
+    const int64_t slot_us = (int64_t)ctx->period_ms * 1000;
+    portENTER_CRITICAL(&ctx->stats_lock);
+    if (changed) {
+        ctx->stats.frames++;
+    } else {
+        ctx->stats.idle_cycles++;
+    }
+    if (ctx->last_cycle_us && interval_us < GOVERNOR_PAUSE_US && ctx->last_changed) {
+        // Rendering and flushing the previous frame overran its slot by more than half a slot
+        if (interval_us > slot_us + slot_us / 2) {
+            ctx->stats.dropped += (uint32_t)((interval_us + slot_us / 2) / slot_us - 1);
+            ctx->stats.late_us += interval_us - slot_us;
+        }
+        // Changes ran on through the interval, left alone LVGL would have rendered them at its own pace, or as
+        // fast as it renders when that is slower
+        if (changed && ctx->render_us > 0) {
+            const int64_t free_us = LV_MAX(GOVERNOR_FREE_US, ctx->render_us);
+            const int64_t free_frames = interval_us / free_us;
+            if (free_frames > 1) {
+                ctx->stats.paced += (uint32_t)(free_frames - 1);
+                ctx->stats.saved_us += (uint64_t)((free_frames - 1) * ctx->render_us);
+            }
+        }
+    }
+    portEXIT_CRITICAL(&ctx->stats_lock);
+    ctx->last_cycle_us = now_us;
+    ctx->last_changed = changed;
+    ctx->render_start_us = changed ? now_us : 0;
+
+    governor_set_rate(ctx, bsp_governor_policy_rate(&ctx->policy, now_us));
+}
+
+/**
+ * Runs at the end of every refresh cycle, measures what a rendered frame costs the LVGL task
+ */
+static void governor_refr_ready_cb(lv_event_t* e) {
+    bsp_governor_ctx_t* ctx = lv_event_get_user_data(e);
+    if (ctx->render_start_us == 0) {
+        return;
+    }
+
+    // Averaged over about eight frames
+    const int64_t render_us = esp_timer_get_time() - ctx->render_start_us;
+    ctx->render_us = ctx->render_us ? (7 * ctx->render_us + render_us) / 8 : render_us;
+    ctx->render_start_us = 0;
+
+    portENTER_CRITICAL(&ctx->stats_lock);
+    ctx->stats.render_us = (uint32_t)ctx->render_us;
+    portEXIT_CRITICAL(&ctx->stats_lock);
+}
+
+static void governor_invalidate_cb(lv_event_t* e) {
+    bsp_governor_ctx_t* ctx = lv_event_get_user_data(e);
+    ctx->changed = true;
+}
+
+void bsp_governor_touch(int64_t event_us, bool pressed) {
+    bsp_governor_ctx_t* ctx = &governor_ctx;
+    if (ctx->disp == NULL) {
+        return;
+    }
+
+    // A new touch raises the rate at once, not one paced period later
+    if (bsp_governor_policy_touch(&ctx->policy, event_us, pressed)) {
+        portENTER_CRITICAL(&ctx->stats_lock);
+        ctx->stats.boosts++;
+        portEXIT_CRITICAL(&ctx->stats_lock);
+        governor_set_rate(ctx, ctx->policy.cfg.boost_hz);
+        lv_timer_ready(ctx->refr_timer);
+    }
+}
+
+esp_err_t bsp_display_governor_start(const bsp_display_governor_cfg_t* cfg) {
+    bsp_governor_ctx_t* ctx = &governor_ctx;
+    ESP_RETURN_ON_FALSE(cfg && cfg->idle_hz && cfg->idle_hz <= cfg->target_hz && cfg->target_hz <= cfg->boost_hz &&
+                        cfg->boost_hz <= 1000, ESP_ERR_INVALID_ARG, TAG, "Invalid rates");
+
+    lv_display_t* disp = lv_display_get_default();
+    ESP_RETURN_ON_FALSE(disp && lv_display_get_refr_timer(disp), ESP_ERR_INVALID_STATE, TAG, "Display not started");
+
+    const bsp_governor_policy_cfg_t policy_cfg = {
+        .target_hz = cfg->target_hz,
+        .idle_hz = cfg->idle_hz,
+        .boost_hz = cfg->boost_hz,
+        .idle_ms = cfg->idle_ms,
+        .boost_ms = cfg->boost_ms,
+    };
+
+    lvgl_port_lock(0);
+    if (ctx->disp == NULL) {
+        ctx->disp = disp;
+        ctx->refr_timer = lv_display_get_refr_timer(disp);
+        // Registered after the flush stage, so the areas are already coalesced
+        lv_display_add_event_cb(disp, governor_refr_start_cb, LV_EVENT_REFR_START, ctx);
+        lv_display_add_event_cb(disp, governor_refr_ready_cb, LV_EVENT_REFR_READY, ctx);
+        lv_display_add_event_cb(disp, governor_invalidate_cb, LV_EVENT_INVALIDATE_AREA, ctx);
+    }
+    bsp_governor_policy_init(&ctx->policy, &policy_cfg);
+    governor_set_rate(ctx, cfg->target_hz);
+    lvgl_port_unlock();
+
+    ESP_LOGI(TAG, "Refresh at %lu Hz, down to %lu Hz without touch, %lu Hz on touch", (unsigned long)cfg->target_hz,
+             (unsigned long)cfg->idle_hz, (unsigned long)cfg->boost_hz);
+    return ESP_OK;
+}
+
+esp_err_t bsp_display_governor_get_stats(bsp_display_governor_stats_t* stats) {
+    ESP_RETURN_ON_FALSE(stats, ESP_ERR_INVALID_ARG, TAG, "Invalid arguments");
+
+    portENTER_CRITICAL(&governor_ctx.stats_lock);
+    *stats = governor_ctx.stats;
+    portEXIT_CRITICAL(&governor_ctx.stats_lock);
+    return ESP_OK;
+}
+// NOLINTEND (*-avoid-non-const-global-variables)
+#endif // (BSP_CONFIG_NO_GRAPHIC_LIB == 0)
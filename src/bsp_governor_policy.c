@@ -0,0 +1,56 @@
+#include <string.h>
+#include "bsp_governor_policy.h"
+
+void bsp_governor_policy_init(bsp_governor_policy_t* policy, const bsp_governor_policy_cfg_t* cfg) {
+    memset(policy, 0, sizeof(*policy));
+    policy->cfg = *cfg;
+    if (policy->cfg.idle_hz == 0) {
+        policy->cfg.idle_hz = 1;
+    }
+    if (policy->cfg.target_hz < policy->cfg.idle_hz) {
+        policy->cfg.target_hz = policy->cfg.idle_hz;
+    }
+    if (policy->cfg.boost_hz < policy->cfg.target_hz) {
+        policy->cfg.boost_hz = policy->cfg.target_hz;
+    }
+}
+
+void bsp_governor_policy_frame(bsp_governor_policy_t* policy, int64_t now_us, bool changed) {
+    if (!changed) {
+        policy->run_us = 0;
+    } else if (policy->run_us == 0) {
+        policy->run_us = now_us;
+    }
+}
+
+bool bsp_governor_policy_touch(bsp_governor_policy_t* policy, int64_t now_us, bool pressed) {
+    const bool boosted = policy->pressed || now_us < policy->boost_until_us;
+
+    if (pressed || policy->pressed) {
+        // The boost runs from the press, and on for boost_ms after the release
+        policy->boost_until_us = now_us + (int64_t)policy->cfg.boost_ms * 1000;
+    }
+    policy->pressed = pressed;
+    return pressed && !boosted;
+}
+
+uint32_t bsp_governor_policy_rate(const bsp_governor_policy_t* policy, int64_t now_us) {
+    const bsp_governor_policy_cfg_t* cfg = &policy->cfg;
+
+    if (policy->pressed || now_us < policy->boost_until_us) {
+        return cfg->boost_hz;
+    }
+    if (cfg->idle_ms == 0 || policy->run_us == 0) {
+        return cfg->target_hz;
+    }
+
+    // Halved once per idle period of changes since the run started or the boost ended, the shift is bounded so
+    // it stays defined
+    const int64_t since_us = policy->run_us > policy->boost_until_us ? policy->run_us : policy->boost_until_us;
+    const int64_t periods = (now_us - since_us) / ((int64_t)cfg->idle_ms * 1000);
+    if (periods <= 0) {
+        return cfg->target_hz;
+    }
+    const uint32_t hz = periods >= 31 ? 0 : cfg->target_hz >> periods;
+    return hz > cfg->idle_hz ? hz : cfg->idle_hz;
+}
@@ -0,0 +1,284 @@
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_lvgl_port.h"
+#include "freertos/FreeRTOS.h"
+
+#include "bsp/lilygo-t4-s3.h"
+#include "bsp_flush.h"
+
+#if (BSP_CONFIG_NO_GRAPHIC_LIB == 0)
+#include "src/display/lv_display_private.h"
+
+// NOLINTBEGIN (*-avoid-non-const-global-variables)
+static const char* TAG = "T4 S3 hw scroll";
+
+typedef struct {
+    lv_display_t* disp;
+
+    /* LVGL context only */
+    lv_obj_t* obj;
+    int32_t scroll_x;
+    int32_t scroll_y;
+    lv_area_t band;             /* Screen area the panel scrolls, y2 < y1 without one */
+    bool rendering;             /* Between REFR_START and REFR_READY, a scroll step now would miss the refresh */
+    bool expect;                /* The object scrolled, its invalidation comes next */
+    int32_t expect_dy;
+
+    portMUX_TYPE stats_lock;
+    bsp_display_hw_scroll_stats_t stats;
+} bsp_hw_scroll_ctx_t;
+
+static bsp_hw_scroll_ctx_t hw_scroll_ctx = {
+    .band = {0, 0, -1, -1},
+    .stats_lock = portMUX_INITIALIZER_UNLOCKED,
+};
+
+static void hw_scroll_count(bsp_hw_scroll_ctx_t* ctx, bool step, uint32_t rows_saved) {
+    portENTER_CRITICAL(&ctx->stats_lock);
+    if (step) {
+        ctx->stats.steps++;
+        ctx->stats.rows_saved += rows_saved;
+    } else {
+        ctx->stats.fallbacks++;
+    }
+    portEXIT_CRITICAL(&ctx->stats_lock);
+}
+
+static void hw_scroll_set_band(bsp_hw_scroll_ctx_t* ctx, const lv_area_t* area) {
+    if (ctx->band.y2 >= ctx->band.y1) {
+        // The rows of the old band are scattered over panel memory
+        lv_obj_invalidate_area(lv_display_get_screen_active(ctx->disp), &ctx->band);
+    }
+
+    const esp_err_t ret = area ? bsp_flush_set_scroll_band(area->y1, area->y2) : bsp_flush_set_scroll_band(0, -1);
+    lv_area_set(&ctx->band, 0, 0, -1, -1);
+    if (area && ret == ESP_OK) {
+        ctx->band = *area;
+    }
+}
+
+/**
+ * Content moved by the panel must be everything drawn in the area: nothing on top of the object and nothing in
+ * it that stays in place while it scrolls
+ */
+static bool hw_scroll_is_covered(const bsp_hw_scroll_ctx_t* ctx, lv_obj_t* obj, const lv_area_t* area) {
+    if (ctx->disp->prev_scr || lv_obj_get_child_count(lv_display_get_layer_top(ctx->disp)) ||
+        lv_obj_get_child_count(lv_display_get_layer_sys(ctx->disp))) {
+        return true;
+    }
+
+    for (uint32_t i = 0; i < lv_obj_get_child_count(obj); i++) {
+        lv_obj_t* child = lv_obj_get_child(obj, (int32_t)i);
+        if (lv_obj_has_flag(child, LV_OBJ_FLAG_FLOATING) && !lv_obj_has_flag(child, LV_OBJ_FLAG_HIDDEN)) {
+            return true;
+        }
+    }
+
+    // Siblings after the object and after each of its parents are drawn on top of it
+    for (lv_obj_t* o = obj; lv_obj_get_parent(o); o = lv_obj_get_parent(o)) {
+        lv_obj_t* parent = lv_obj_get_parent(o);
+        for (uint32_t i = (uint32_t)lv_obj_get_index(o) + 1; i < lv_obj_get_child_count(parent); i++) {
+            lv_obj_t* sibling = lv_obj_get_child(parent, (int32_t)i);
+            lv_area_t coords;
+            lv_obj_get_coords(sibling, &coords);
+            lv_area_increase(&coords, lv_obj_get_ext_draw_size(sibling), lv_obj_get_ext_draw_size(sibling));
+            if (!lv_obj_has_flag(sibling, LV_OBJ_FLAG_HIDDEN) && lv_area_is_on(&coords, area)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * The area LVGL invalidates when the object scrolls, if the panel can scroll it: full width, with rows that
+ * only differ by what scrolls
+ */
+static bool hw_scroll_get_area(const bsp_hw_scroll_ctx_t* ctx, lv_obj_t* obj, lv_area_t* area) {
+    if (lv_obj_get_screen(obj) != lv_display_get_screen_active(ctx->disp) ||
+        lv_obj_get_ext_draw_size(obj) != 0 ||
+        lv_obj_has_flag(obj, LV_OBJ_FLAG_OVERFLOW_VISIBLE) ||
+        lv_obj_get_scrollbar_mode(obj) != LV_SCROLLBAR_MODE_OFF ||
+        lv_obj_get_style_radius(obj, LV_PART_MAIN) != 0 ||
+        lv_obj_get_style_border_width(obj, LV_PART_MAIN) != 0 ||
+        lv_obj_get_style_bg_opa(obj, LV_PART_MAIN) != LV_OPA_COVER ||
+        lv_obj_get_style_bg_grad_dir(obj, LV_PART_MAIN) != LV_GRAD_DIR_NONE ||
+        lv_obj_get_style_bg_image_src(obj, LV_PART_MAIN) != NULL) {
+        return false;
+    }
+
+    lv_obj_get_coords(obj, area);
+    if (!lv_obj_area_is_visible(obj, area) || lv_area_get_height(area) < 2 || area->x1 > 0 ||
+        area->x2 < lv_display_get_horizontal_resolution(ctx->disp) - 1) {
+        return false;
+    }
+    return !hw_scroll_is_covered(ctx, obj, area);
+}
+
+/**
+ * Areas of the band invalidated before this step hold rows the panel is about to move elsewhere. Only the
+ * strips of earlier steps of this refresh cycle are allowed, the new strip covers them.
+ */
+static bool hw_scroll_pending_inside(const bsp_hw_scroll_ctx_t* ctx, const lv_area_t* strip) {
+    for (uint32_t i = 0; i < ctx->disp->inv_p; i++) {
+        const lv_area_t* inv = &ctx->disp->inv_areas[i];
+        if (lv_area_is_on(inv, &ctx->band) && !lv_area_is_in(inv, strip, 0)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void hw_scroll_scroll_cb(lv_event_t* e) {
+    bsp_hw_scroll_ctx_t* ctx = lv_event_get_user_data(e);
+    lv_obj_t* obj = ctx->obj;
+
+    const int32_t x = lv_obj_get_scroll_x(obj);
+    const int32_t y = lv_obj_get_scroll_y(obj);
+    const int32_t dx = x - ctx->scroll_x;
+    const int32_t dy = y - ctx->scroll_y;
+    ctx->scroll_x = x;
+    ctx->scroll_y = y;
+    ctx->expect = false;
+    if (dx == 0 && dy == 0) {
+        return;
+    }
+
+    // Layout updates at the start of a refresh scroll too, but the scroll offset for it is already out
+    lv_area_t area;
+    if (dx != 0 || ctx->rendering || !hw_scroll_get_area(ctx, obj, &area)) {
+        hw_scroll_count(ctx, false, 0);
+        return;
+    }
+
+    // This step is rendered in full anyway, the band follows the object from now on
+    if (!lv_area_is_equal(&area, &ctx->band)) {
+        hw_scroll_set_band(ctx, &area);
+        hw_scroll_count(ctx, false, 0);
+        return;
+    }
+
+    ctx->expect = true;
+    ctx->expect_dy = dy;
+}
+
+/**
+ * Cut the invalidation of a scroll step down to the rows that scrolled into view
+ */
+static void hw_scroll_invalidate_cb(lv_event_t* e) {
+    bsp_hw_scroll_ctx_t* ctx = lv_event_get_user_data(e);
+    lv_area_t* area = lv_event_get_param(e);
+
+    if (!ctx->expect || !lv_area_is_equal(area, &ctx->band)) {
+        return;
+    }
+    ctx->expect = false;
+
+    // Steps add up until the next refresh, which moves the panel by all of them at once
+    const int32_t height = lv_area_get_height(&ctx->band);
+    const int32_t dy = bsp_flush_scroll_pending() + ctx->expect_dy;
+    lv_area_t strip = ctx->band;
+    if (dy > 0) {
+        strip.y1 = strip.y2 - dy + 1;
+    } else if (dy < 0) {
+        strip.y2 = strip.y1 - dy - 1;
+    } else {
+        strip.y2 = strip.y1;
+    }
+    if (LV_ABS(dy) >= height || !hw_scroll_pending_inside(ctx, &strip)) {
+        hw_scroll_count(ctx, false, 0);
+        return;
+    }
+
+    bsp_flush_scroll(ctx->expect_dy);
+    *area = strip;
+    hw_scroll_count(ctx, true, (uint32_t)(height - lv_area_get_height(&strip)));
+}
+
+static void hw_scroll_refr_cb(lv_event_t* e) {
+    bsp_hw_scroll_ctx_t* ctx = lv_event_get_user_data(e);
+
+    ctx->rendering = lv_event_get_code(e) == LV_EVENT_REFR_START;
+    if (ctx->expect) {
+        // The object was scrolled while off screen, nothing was invalidated
+        ctx->expect = false;
+        hw_scroll_count(ctx, false, 0);
+    }
+}
+
+static void hw_scroll_resolution_cb(lv_event_t* e) {
+    bsp_hw_scroll_ctx_t* ctx = lv_event_get_user_data(e);
+
+    // The flush stage dropped the band and the whole screen is redrawn
+    lv_area_set(&ctx->band, 0, 0, -1, -1);
+}
+
+static void hw_scroll_release(bsp_hw_scroll_ctx_t* ctx) {
+    ctx->obj = NULL;
+    ctx->expect = false;
+    hw_scroll_set_band(ctx, NULL);
+}
+
+static void hw_scroll_delete_cb(lv_event_t* e) {
+    hw_scroll_release(lv_event_get_user_data(e));
+}
+
+static void hw_scroll_unhook(bsp_hw_scroll_ctx_t* ctx) {
+    lv_obj_remove_event_cb_with_user_data(ctx->obj, hw_scroll_scroll_cb, ctx);
+    lv_obj_remove_event_cb_with_user_data(ctx->obj, hw_scroll_delete_cb, ctx);
+    hw_scroll_release(ctx);
+}
+
+esp_err_t bsp_display_hw_scroll_attach(lv_obj_t* obj) {
+    bsp_hw_scroll_ctx_t* ctx = &hw_scroll_ctx;
+    ESP_RETURN_ON_FALSE(obj, ESP_ERR_INVALID_ARG, TAG, "Invalid arguments");
+
+    lv_display_t* disp = lv_display_get_default();
+    ESP_RETURN_ON_FALSE(disp, ESP_ERR_INVALID_STATE, TAG, "Display not started");
+
+    lvgl_port_lock(0);
+    if (ctx->disp == NULL) {
+        ctx->disp = disp;
+        // The flush stage and the governor only need to know something was invalidated, not how much
+        lv_display_add_event_cb(disp, hw_scroll_invalidate_cb, LV_EVENT_INVALIDATE_AREA, ctx);
+        lv_display_add_event_cb(disp, hw_scroll_refr_cb, LV_EVENT_REFR_START, ctx);
+        lv_display_add_event_cb(disp, hw_scroll_refr_cb, LV_EVENT_REFR_READY, ctx);
+        lv_display_add_event_cb(disp, hw_scroll_resolution_cb, LV_EVENT_RESOLUTION_CHANGED, ctx);
+    }
+    if (ctx->obj) {
+        hw_scroll_unhook(ctx);
+    }
+
+    ctx->obj = obj;
+    ctx->scroll_x = lv_obj_get_scroll_x(obj);
+    ctx->scroll_y = lv_obj_get_scroll_y(obj);
+    lv_obj_set_scrollbar_mode(obj, LV_SCROLLBAR_MODE_OFF);
+    lv_obj_add_event_cb(obj, hw_scroll_scroll_cb, LV_EVENT_SCROLL, ctx);
+    lv_obj_add_event_cb(obj, hw_scroll_delete_cb, LV_EVENT_DELETE, ctx);
+    lvgl_port_unlock();
+
+    return ESP_OK;
+}
+
+esp_err_t bsp_display_hw_scroll_detach(void) {
+    bsp_hw_scroll_ctx_t* ctx = &hw_scroll_ctx;
+
+    lvgl_port_lock(0);
+    if (ctx->obj) {
+        hw_scroll_unhook(ctx);
+    }
+    lvgl_port_unlock();
+    return ESP_OK;
+}
+
+esp_err_t bsp_display_hw_scroll_get_stats(bsp_display_hw_scroll_stats_t* stats) {
+    ESP_RETURN_ON_FALSE(stats, ESP_ERR_INVALID_ARG, TAG, "Invalid arguments");
+
+    portENTER_CRITICAL(&hw_scroll_ctx.stats_lock);
+    *stats = hw_scroll_ctx.stats;
+    portEXIT_CRITICAL(&hw_scroll_ctx.stats_lock);
+    return ESP_OK;
+}
+// NOLINTEND (*-avoid-non-const-global-variables)
+#endif // (BSP_CONFIG_NO_GRAPHIC_LIB == 0)
@@ -0,0 +1,357 @@
+#include <stdlib.h>
+#include <string.h>
+#include <sys/cdefs.h>
+#include <sys/param.h>
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "bsp/lilygo-t4-s3.h"
+#include "bsp_i2c.h"
+#include "bsp_i2c_queue.h"
+
+// NOLINTBEGIN (*-avoid-non-const-global-variables)
+static const char* TAG = "T4 S3 i2c";
+
+#define I2C_JOBS                (16)
+#define I2C_BATCH_MAX_BYTES     (32)
+#define I2C_XFER_TIMEOUT_MS     (100)
+#define I2C_TASK_STACK          (3072)
+#define I2C_TASK_PRIORITY       (6)
+#define I2C_RATE_WINDOW_US      (1000 * 1000)
+
+struct bsp_i2c_device {
+    i2c_master_dev_handle_t handle;
+    bsp_i2c_priority_t priority;
+    bool batch_reads;
+};
+
+typedef struct {
+    bsp_i2c_job_t job;      /* Must stay first, the queue links jobs */
+    bsp_i2c_device_handle_t dev;
+    uint8_t* rx;
+    const uint8_t* tx;
+    bsp_i2c_exec_fn_t fn;
+    void* fn_ctx;
+    bsp_i2c_done_cb_t cb;
+    void* user_ctx;
+    int64_t submit_us;
+} bsp_i2c_req_t;
+
+typedef struct {
+    TaskHandle_t task;
+    portMUX_TYPE lock;      /* Guards queue, free list and stats */
+    bsp_i2c_queue_t queue;
+    bsp_i2c_req_t reqs[I2C_JOBS];
+    bsp_i2c_req_t* free[I2C_JOBS];
+    size_t free_cnt;
+
+    int64_t window_start_us;
+    uint64_t window_busy_us;
+    bsp_i2c_stats_t stats;
+} bsp_i2c_sched_t;
+
+static bsp_i2c_sched_t sched = {
+    .lock = portMUX_INITIALIZER_UNLOCKED,
+};
+
+typedef struct {
+    SemaphoreHandle_t done;
+    esp_err_t result;
+} bsp_i2c_waiter_t;
+
+static void i2c_complete(bsp_i2c_req_t* req, esp_err_t result) {
+    const bsp_i2c_done_cb_t cb = req->cb;
+    void* user_ctx = req->user_ctx;
+
+    portENTER_CRITICAL(&sched.lock);
+    sched.free[sched.free_cnt++] = req;
+    sched.stats.jobs++;
+    portEXIT_CRITICAL(&sched.lock);
+
+    if (cb) {
+        cb(result, user_ctx);
+    }
+}
+
+static esp_err_t i2c_run_batch(const bsp_i2c_batch_t* batch) {
+    bsp_i2c_req_t* first = __containerof(batch->jobs, bsp_i2c_req_t, job);
+    const int timeout_ms = I2C_XFER_TIMEOUT_MS;
+
+    switch (first->job.kind) {
+    case BSP_I2C_JOB_READ_REG:
+        if (batch->count == 1) {
+            return i2c_master_transmit_receive(first->dev->handle, &batch->reg, 1, first->rx, batch->len, timeout_ms);
+        } else {
+            uint8_t buf[I2C_BATCH_MAX_BYTES];
+            const esp_err_t ret = i2c_master_transmit_receive(first->dev->handle, &batch->reg, 1, buf, batch->len,
+                                                              timeout_ms);
+            if (ret == ESP_OK) {
+                for (bsp_i2c_job_t* job = batch->jobs; job; job = job->next) {
+                    bsp_i2c_req_t* req = __containerof(job, bsp_i2c_req_t, job);
+                    memcpy(req->rx, buf + (job->reg - batch->reg), job->len);
+                }
+            }
+            return ret;
+        }
+    case BSP_I2C_JOB_WRITE:
+        return i2c_master_transmit(first->dev->handle, first->tx, first->job.len, timeout_ms);
+    case BSP_I2C_JOB_EXEC:
+    default:
+        return first->fn(first->fn_ctx);
+    }
+}
+
+static void i2c_account(const bsp_i2c_batch_t* batch, esp_err_t result, int64_t start_us, int64_t end_us) {
+    const bsp_i2c_req_t* first = __containerof(batch->jobs, bsp_i2c_req_t, job);
+    const uint32_t busy_us = (uint32_t)(end_us - start_us);
+
+    portENTER_CRITICAL(&sched.lock);
+    sched.stats.transactions++;
+    sched.stats.batched += batch->count - 1;
+    sched.stats.errors += result != ESP_OK;
+    if (first->job.kind == BSP_I2C_JOB_READ_REG) {
+        sched.stats.bytes += 1 + batch->len;
+    } else if (first->job.kind == BSP_I2C_JOB_WRITE) {
+        sched.stats.bytes += first->job.len;
+    }
+    sched.stats.busy_us += busy_us;
+    sched.window_busy_us += busy_us;
+    for (const bsp_i2c_job_t* job = batch->jobs; job; job = job->next) {
+        const bsp_i2c_req_t* req = __containerof(job, bsp_i2c_req_t, job);
+        sched.stats.max_wait_us = MAX(sched.stats.max_wait_us, (uint32_t)(start_us - req->submit_us));
+    }
+    if (end_us - sched.window_start_us >= I2C_RATE_WINDOW_US) {
+        sched.stats.utilisation = (float)sched.window_busy_us / (float)(end_us - sched.window_start_us);
+        sched.window_start_us = end_us;
+        sched.window_busy_us = 0;
+    }
+    portEXIT_CRITICAL(&sched.lock);
+}
+
+static void i2c_task(void* arg) {
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        for (;;) {
+            bsp_i2c_batch_t batch;
+            portENTER_CRITICAL(&sched.lock);
+            const bool more = bsp_i2c_queue_pop(&sched.queue, I2C_BATCH_MAX_BYTES, &batch);
+            portEXIT_CRITICAL(&sched.lock);
+            if (!more) {
+                break;
+            }
+
+            const int64_t start_us = esp_timer_get_time();
+            const esp_err_t result = i2c_run_batch(&batch);
+            i2c_account(&batch, result, start_us, esp_timer_get_time());
+            if (result != ESP_OK) {
+                ESP_LOGD(TAG, "I2C job failed (%s)", esp_err_to_name(result));
+            }
+
+            for (bsp_i2c_job_t* job = batch.jobs; job;) {
+                bsp_i2c_job_t* next = job->next;
+                i2c_complete(__containerof(job, bsp_i2c_req_t, job), result);
+                job = next;
+            }
+        }
+    }
+}
+
+esp_err_t bsp_i2c_sched_start(void) {
+    if (sched.task) {
+        return ESP_OK;
+    }
+
+    bsp_i2c_queue_init(&sched.queue);
+    for (size_t i = 0; i < I2C_JOBS; i++) {
+        sched.free[i] = &sched.reqs[i];
+    }
+    sched.free_cnt = I2C_JOBS;
+    sched.window_start_us = esp_timer_get_time();
+
+    ESP_RETURN_ON_FALSE(xTaskCreate(i2c_task, "bsp_i2c", I2C_TASK_STACK, NULL, I2C_TASK_PRIORITY, &sched.task) ==
+                        pdPASS, ESP_ERR_NO_MEM, TAG, "No memory for I2C task");
+    return ESP_OK;
+}
+
+static bsp_i2c_req_t* i2c_req_alloc(void) {
+    bsp_i2c_req_t* req = NULL;
+
+    portENTER_CRITICAL(&sched.lock);
+    if (sched.free_cnt > 0) {
+        req = sched.free[--sched.free_cnt];
+    }
+    portEXIT_CRITICAL(&sched.lock);
+
+    if (req) {
+        *req = (bsp_i2c_req_t){.submit_us = esp_timer_get_time()};
+    }
+    return req;
+}
+
+static void i2c_submit(bsp_i2c_req_t* req) {
+    portENTER_CRITICAL(&sched.lock);
+    bsp_i2c_queue_push(&sched.queue, &req->job);
+    sched.stats.max_depth = MAX(sched.stats.max_depth, (uint32_t)sched.queue.depth);
+    portEXIT_CRITICAL(&sched.lock);
+
+    xTaskNotifyGive(sched.task);
+}
+
+esp_err_t bsp_i2c_add_device(const bsp_i2c_device_config_t* config, bsp_i2c_device_handle_t* ret_dev) {
+    ESP_RETURN_ON_FALSE(config && ret_dev, ESP_ERR_INVALID_ARG, TAG, "Invalid arguments");
+    ESP_RETURN_ON_ERROR(bsp_i2c_init(), TAG, "I2C init failed");
+
+    bsp_i2c_device_handle_t dev = calloc(1, sizeof(*dev));
+    ESP_RETURN_ON_FALSE(dev, ESP_ERR_NO_MEM, TAG, "No memory for I2C device");
+
+    const i2c_device_config_t dev_config = {
+        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+        .device_address = config->address,
+        .scl_speed_hz = config->scl_speed_hz,
+    };
+    const esp_err_t ret = i2c_master_bus_add_device(bsp_i2c_get_handle(), &dev_config, &dev->handle);
+    if (ret != ESP_OK) {
+        free(dev);
+        ESP_LOGE(TAG, "Adding I2C device 0x%02x failed (%s)", config->address, esp_err_to_name(ret));
+        return ret;
+    }
+
+    dev->priority = config->priority;
+    dev->batch_reads = config->batch_reads;
+    *ret_dev = dev;
+    return ESP_OK;
+}
+
+esp_err_t bsp_i2c_read_reg_async(bsp_i2c_device_handle_t dev, uint8_t reg, uint8_t* data, size_t len,
+                                 bsp_i2c_done_cb_t cb, void* user_ctx) {
+    ESP_RETURN_ON_FALSE(dev && data && len > 0, ESP_ERR_INVALID_ARG, TAG, "Invalid arguments");
+
+    bsp_i2c_req_t* req = i2c_req_alloc();
+    ESP_RETURN_ON_FALSE(req, ESP_ERR_NO_MEM, TAG, "Too many I2C jobs queued");
+    req->job = (bsp_i2c_job_t){
+        .dev = dev,
+        .kind = BSP_I2C_JOB_READ_REG,
+        .priority = dev->priority,
+        .batchable = dev->batch_reads && len <= I2C_BATCH_MAX_BYTES,
+        .reg = reg,
+        .len = len,
+    };
+    req->dev = dev;
+    req->rx = data;
+    req->cb = cb;
+    req->user_ctx = user_ctx;
+    i2c_submit(req);
+    return ESP_OK;
+}
+
+esp_err_t bsp_i2c_write_async(bsp_i2c_device_handle_t dev, const uint8_t* data, size_t len, bsp_i2c_done_cb_t cb,
+                              void* user_ctx) {
+    ESP_RETURN_ON_FALSE(dev && data && len > 0, ESP_ERR_INVALID_ARG, TAG, "Invalid arguments");
+
+    bsp_i2c_req_t* req = i2c_req_alloc();
+    ESP_RETURN_ON_FALSE(req, ESP_ERR_NO_MEM, TAG, "Too many I2C jobs queued");
+    req->job = (bsp_i2c_job_t){
+        .dev = dev,
+        .kind = BSP_I2C_JOB_WRITE,
+        .priority = dev->priority,
+        .len = len,
+    };
+    req->dev = dev;
+    req->tx = data;
+    req->cb = cb;
+    req->user_ctx = user_ctx;
+    i2c_submit(req);
+    return ESP_OK;
+}
+
+static void i2c_wake_waiter(esp_err_t result, void* user_ctx) {
+    bsp_i2c_waiter_t* waiter = user_ctx;
+    waiter->result = result;
+    xSemaphoreGive(waiter->done);
+}
+
+/**
+ * Wait for a job submitted with i2c_wake_waiter(). A full queue is not an error for blocking callers, they
+ * retry until a job slot frees up. Completion callbacks and function jobs run on the bus manager task, which
+ * would wait for itself.
+ */
+#define I2C_SUBMIT_AND_WAIT(submit_expr, waiter)                                        \
+    do {                                                                                \
+        ESP_RETURN_ON_FALSE(xTaskGetCurrentTaskHandle() != sched.task,                  \
+                            ESP_ERR_INVALID_STATE, TAG,                                 \
+                            "Blocking I2C call from the bus manager task");             \
+        StaticSemaphore_t sem_buf_;                                                     \
+        (waiter).done = xSemaphoreCreateBinaryStatic(&sem_buf_);                        \
+        esp_err_t ret_;                                                                 \
+        while ((ret_ = (submit_expr)) == ESP_ERR_NO_MEM) {                              \
+            vTaskDelay(1);                                                              \
+        }                                                                               \
+        if (ret_ != ESP_OK) {                                                           \
+            return ret_;                                                                \
+        }                                                                               \
+        xSemaphoreTake((waiter).done, portMAX_DELAY);                                   \
+        vSemaphoreDelete((waiter).done);                                                \
+    } while (0)
+
+esp_err_t bsp_i2c_read_reg(bsp_i2c_device_handle_t dev, uint8_t reg, uint8_t* data, size_t len) {
+    bsp_i2c_waiter_t waiter = {0};
+    I2C_SUBMIT_AND_WAIT(bsp_i2c_read_reg_async(dev, reg, data, len, i2c_wake_waiter, &waiter), waiter);
+    return waiter.result;
+}
+
+esp_err_t bsp_i2c_write(bsp_i2c_device_handle_t dev, const uint8_t* data, size_t len) {
+    bsp_i2c_waiter_t waiter = {0};
+    I2C_SUBMIT_AND_WAIT(bsp_i2c_write_async(dev, data, len, i2c_wake_waiter, &waiter), waiter);
+    return waiter.result;
+}
+
+static esp_err_t i2c_exec_async(bsp_i2c_priority_t priority, bsp_i2c_exec_fn_t fn, void* ctx,
+                                bsp_i2c_waiter_t* waiter) {
+    bsp_i2c_req_t* req = i2c_req_alloc();
+    if (req == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    req->job = (bsp_i2c_job_t){
+        .dev = NULL,
+        .kind = BSP_I2C_JOB_EXEC,
+        .priority = priority,
+    };
+    req->fn = fn;
+    req->fn_ctx = ctx;
+    req->cb = i2c_wake_waiter;
+    req->user_ctx = waiter;
+    i2c_submit(req);
+    return ESP_OK;
+}
+
+esp_err_t bsp_i2c_exec(bsp_i2c_priority_t priority, bsp_i2c_exec_fn_t fn, void* ctx) {
+    ESP_RETURN_ON_FALSE(fn, ESP_ERR_INVALID_ARG, TAG, "Invalid arguments");
+    ESP_RETURN_ON_ERROR(bsp_i2c_init(), TAG, "I2C init failed");
+
+    bsp_i2c_waiter_t waiter = {0};
+    I2C_SUBMIT_AND_WAIT(i2c_exec_async(priority, fn, ctx, &waiter), waiter);
+    return waiter.result;
+}
+
+esp_err_t bsp_i2c_get_stats(bsp_i2c_stats_t* stats) {
+    ESP_RETURN_ON_FALSE(stats, ESP_ERR_INVALID_ARG, TAG, "Invalid arguments");
+
+    const int64_t now_us = esp_timer_get_time();
+    portENTER_CRITICAL(&sched.lock);
+    *stats = sched.stats;
+    // An idle bus does not close its window, so report it as it stands
+    const int64_t elapsed_us = now_us - sched.window_start_us;
+    if (sched.task && elapsed_us >= I2C_RATE_WINDOW_US) {
+        stats->utilisation = (float)sched.window_busy_us / (float)elapsed_us;
+    }
+    portEXIT_CRITICAL(&sched.lock);
+
+    return ESP_OK;
+}
+// NOLINTEND (*-avoid-non-const-global-variables)
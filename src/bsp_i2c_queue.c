@@ -0,0 +1,105 @@
+#include "bsp_i2c_queue.h"
+
+void bsp_i2c_queue_init(bsp_i2c_queue_t* queue) {
+    *queue = (bsp_i2c_queue_t){0};
+}
+
+void bsp_i2c_queue_push(bsp_i2c_queue_t* queue, bsp_i2c_job_t* job) {
+    const uint8_t prio = job->priority < BSP_I2C_QUEUE_PRIORITIES ? job->priority : BSP_I2C_QUEUE_PRIORITIES - 1;
+
+    job->priority = prio;
+    job->next = NULL;
+    if (queue->tail[prio]) {
+        queue->tail[prio]->next = job;
+    } else {
+        queue->head[prio] = job;
+    }
+    queue->tail[prio] = job;
+    queue->depth++;
+}
+
+static bool queue_can_batch(const bsp_i2c_job_t* job, const bsp_i2c_job_t* first, uint8_t reg, size_t len,
+                            size_t max_bytes) {
+    if (job->kind != BSP_I2C_JOB_READ_REG || !job->batchable || job->dev != first->dev) {
+        return false;
+    }
+
+    // The two ranges must touch or overlap, and their union must fit a single read
+    const size_t lo = job->reg < reg ? job->reg : reg;
+    const size_t hi_job = (size_t)job->reg + job->len;
+    const size_t hi = hi_job > reg + len ? hi_job : reg + len;
+    return job->reg <= reg + len && reg <= hi_job && hi - lo <= max_bytes;
+}
+
+bool bsp_i2c_queue_pop(bsp_i2c_queue_t* queue, size_t max_bytes, bsp_i2c_batch_t* batch) {
+    uint8_t prio = 0;
+    while (prio < BSP_I2C_QUEUE_PRIORITIES && queue->head[prio] == NULL) {
+        prio++;
+    }
+    if (prio == BSP_I2C_QUEUE_PRIORITIES) {
+        return false;
+    }
+
+    bsp_i2c_job_t* first = queue->head[prio];
+    queue->head[prio] = first->next;
+    if (queue->head[prio] == NULL) {
+        queue->tail[prio] = NULL;
+    }
+    first->next = NULL;
+    queue->depth--;
+
+    *batch = (bsp_i2c_batch_t){
+        .jobs = first,
+        .count = 1,
+        .reg = first->reg,
+        .len = first->len,
+    };
+    if (first->kind != BSP_I2C_JOB_READ_REG || !first->batchable) {
+        return true;
+    }
+
+    // A device has one priority, so its other reads wait in the same list. Growing the range can make an
+    // earlier skipped read adjacent, so scan again until nothing more joins.
+    bsp_i2c_job_t* last = first;
+    bool joined = true;
+    while (joined) {
+        joined = false;
+        bsp_i2c_job_t* prev = NULL;
+        for (bsp_i2c_job_t* job = queue->head[prio]; job;) {
+            bsp_i2c_job_t* next = job->next;
+            if (queue_can_batch(job, first, batch->reg, batch->len, max_bytes)) {
+                const size_t hi_job = (size_t)job->reg + job->len;
+                const size_t hi_batch = (size_t)batch->reg + batch->len;
+                const size_t hi = hi_job > hi_batch ? hi_job : hi_batch;
+                batch->reg = job->reg < batch->reg ? job->reg : batch->reg;
+                batch->len = hi - batch->reg;
+
+                if (prev) {
+                    prev->next = next;
+                } else {
+                    queue->head[prio] = next;
+                }
+                if (queue->tail[prio] == job) {
+                    queue->tail[prio] = prev;
+                }
+                queue->depth--;
+
+                job->next = NULL;
+                last->next = job;
+                last = job;
+                batch->count++;
+                joined = true;
+            } else if (job->kind == BSP_I2C_JOB_EXEC ||
+                       (job->dev == first->dev && (job->kind != BSP_I2C_JOB_READ_REG || !job->batchable))) {
+                // Reads queued behind a write to the same device must see its effect. A function job has no
+                // device and may talk to any of them.
+                break;
+            } else {
+                prev = job;
+            }
+            job = next;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,176 @@
+#include <stdlib.h>
+#include <sys/cdefs.h>
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_lcd_panel_io.h"
+#include "esp_lcd_panel_io_interface.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "bsp_lcd_io.h"
+#include "bsp_sim_panel.h"
+
+// NOLINTBEGIN (*-avoid-non-const-global-variables)
+static const char* TAG = "T4 S3 io";
+
+typedef struct {
+    esp_lcd_panel_io_t base;                /* Must stay first, handed out as the panel IO */
+    esp_lcd_panel_io_handle_t spi_io;       /* SPI panel IO doing the work, NULL if recreating it failed */
+    spi_host_device_t host;
+    esp_lcd_panel_io_spi_config_t spi_config;
+    SemaphoreHandle_t lock;
+    StaticSemaphore_t lock_buf;
+    esp_lcd_panel_io_color_trans_done_cb_t on_color_trans_done;
+    void* user_ctx;
+    volatile bool muted;
+} bsp_lcd_io_t;
+
+static bsp_lcd_io_t* lcd_io = NULL;
+
+static bool io_color_trans_done(esp_lcd_panel_io_handle_t spi_io, esp_lcd_panel_io_event_data_t* edata,
+                                void* user_ctx) {
+    bsp_lcd_io_t* io = user_ctx;
+    if (io->muted || io->on_color_trans_done == NULL) {
+        return false;
+    }
+    return io->on_color_trans_done(&io->base, edata, io->user_ctx);
+}
+
+static esp_err_t io_rx_param(esp_lcd_panel_io_t* base, int lcd_cmd, void* param, size_t param_size) {
+    bsp_lcd_io_t* io = __containerof(base, bsp_lcd_io_t, base);
+    xSemaphoreTake(io->lock, portMAX_DELAY);
+    const esp_err_t ret = io->spi_io ? esp_lcd_panel_io_rx_param(io->spi_io, lcd_cmd, param, param_size)
+                                     : ESP_ERR_INVALID_STATE;
+    xSemaphoreGive(io->lock);
+    return ret;
+}
+
+static esp_err_t io_tx_param(esp_lcd_panel_io_t* base, int lcd_cmd, const void* param, size_t param_size) {
+    bsp_lcd_io_t* io = __containerof(base, bsp_lcd_io_t, base);
+    xSemaphoreTake(io->lock, portMAX_DELAY);
+    const esp_err_t ret = io->spi_io ? esp_lcd_panel_io_tx_param(io->spi_io, lcd_cmd, param, param_size)
+                                     : ESP_ERR_INVALID_STATE;
+    xSemaphoreGive(io->lock);
+    return ret;
+}
+
+static esp_err_t io_tx_color(esp_lcd_panel_io_t* base, int lcd_cmd, const void* color, size_t color_size) {
+    bsp_lcd_io_t* io = __containerof(base, bsp_lcd_io_t, base);
+    xSemaphoreTake(io->lock, portMAX_DELAY);
+    const esp_err_t ret = io->spi_io ? esp_lcd_panel_io_tx_color(io->spi_io, lcd_cmd, color, color_size)
+                                     : ESP_ERR_INVALID_STATE;
+    xSemaphoreGive(io->lock);
+    return ret;
+}
+
+static esp_err_t io_register_event_callbacks(esp_lcd_panel_io_t* base, const esp_lcd_panel_io_callbacks_t* cbs,
+                                             void* user_ctx) {
+    bsp_lcd_io_t* io = __containerof(base, bsp_lcd_io_t, base);
+    io->on_color_trans_done = cbs->on_color_trans_done;
+    io->user_ctx = user_ctx;
+    return ESP_OK;
+}
+
+static esp_err_t io_del(esp_lcd_panel_io_t* base) {
+    bsp_lcd_io_t* io = __containerof(base, bsp_lcd_io_t, base);
+    const esp_err_t ret = io->spi_io ? esp_lcd_panel_io_del(io->spi_io) : ESP_OK;
+    lcd_io = NULL;
+    free(io);
+    return ret;
+}
+
+static esp_err_t io_create_spi(bsp_lcd_io_t* io) {
+    // Every SPI IO reports to the proxy, which forwards to whoever registered on the proxy
+    io->spi_config.on_color_trans_done = io_color_trans_done;
+    io->spi_config.user_ctx = io;
+#ifdef CONFIG_BSP_LCD_SIMULATED
+    return bsp_sim_io_new(&io->spi_config, &io->spi_io);
+#else
+    return esp_lcd_new_panel_io_spi(io->host, &io->spi_config, &io->spi_io);
+#endif
+}
+
+esp_err_t bsp_lcd_io_new(spi_host_device_t host, const esp_lcd_panel_io_spi_config_t* config,
+                         esp_lcd_panel_io_handle_t* ret_io) {
+    ESP_RETURN_ON_FALSE(config && ret_io, ESP_ERR_INVALID_ARG, TAG, "Invalid arguments");
+    ESP_RETURN_ON_FALSE(lcd_io == NULL, ESP_ERR_INVALID_STATE, TAG, "Panel IO already created");
+
+    bsp_lcd_io_t* io = calloc(1, sizeof(bsp_lcd_io_t));
+    ESP_RETURN_ON_FALSE(io, ESP_ERR_NO_MEM, TAG, "No memory for panel IO");
+
+    io->host = host;
+    io->spi_config = *config;
+    io->lock = xSemaphoreCreateMutexStatic(&io->lock_buf);
+    io->on_color_trans_done = config->on_color_trans_done;
+    io->user_ctx = config->user_ctx;
+
+    const esp_err_t ret = io_create_spi(io);
+    if (ret != ESP_OK) {
+        free(io);
+        return ret;
+    }
+
+    io->base.rx_param = io_rx_param;
+    io->base.tx_param = io_tx_param;
+    io->base.tx_color = io_tx_color;
+    io->base.register_event_callbacks = io_register_event_callbacks;
+    io->base.del = io_del;
+
+    lcd_io = io;
+    *ret_io = &io->base;
+    return ESP_OK;
+}
+
+esp_lcd_panel_io_handle_t bsp_lcd_io_get(void) {
+    return lcd_io ? &lcd_io->base : NULL;
+}
+
+esp_err_t bsp_lcd_io_set_pclk(uint32_t pclk_hz) {
+    ESP_RETURN_ON_FALSE(lcd_io, ESP_ERR_INVALID_STATE, TAG, "Panel IO not created");
+    ESP_RETURN_ON_FALSE(pclk_hz > 0, ESP_ERR_INVALID_ARG, TAG, "Invalid clock");
+
+    bsp_lcd_io_t* io = lcd_io;
+    xSemaphoreTake(io->lock, portMAX_DELAY);
+
+    // Deleting the SPI IO waits for every queued transaction to complete. A proxy left without an SPI IO by an
+    // earlier failure gets a new one here.
+    esp_err_t ret = io->spi_io ? esp_lcd_panel_io_del(io->spi_io) : ESP_OK;
+    if (ret == ESP_OK) {
+        io->spi_io = NULL;
+        const uint32_t old_pclk_hz = io->spi_config.pclk_hz;
+        io->spi_config.pclk_hz = pclk_hz;
+        ret = io_create_spi(io);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Panel IO at %lu Hz failed (%s), restoring %lu Hz", (unsigned long)pclk_hz,
+                     esp_err_to_name(ret), (unsigned long)old_pclk_hz);
+            io->spi_config.pclk_hz = old_pclk_hz;
+            if (io_create_spi(io) != ESP_OK) {
+                // Transfers fail with ESP_ERR_INVALID_STATE until a later call succeeds
+                io->spi_io = NULL;
+                ESP_LOGE(TAG, "Panel IO at %lu Hz failed too, display is offline", (unsigned long)old_pclk_hz);
+            }
+        }
+    }
+
+    xSemaphoreGive(io->lock);
+    return ret;
+}
+
+uint32_t bsp_lcd_io_get_pclk(void) {
+    return lcd_io ? lcd_io->spi_config.pclk_hz : 0;
+}
+
+esp_err_t bsp_lcd_io_wait_idle(void) {
+    ESP_RETURN_ON_FALSE(lcd_io, ESP_ERR_INVALID_STATE, TAG, "Panel IO not created");
+
+    // A parameter write is sent in polling mode, after every queued color transaction has finished
+    return esp_lcd_panel_io_tx_param(&lcd_io->base, BSP_LCD_QSPI_CMD_WRITE(BSP_LCD_CMD_NOP), NULL, 0);
+}
+
+void bsp_lcd_io_mute_callbacks(bool mute) {
+    if (lcd_io) {
+        lcd_io->muted = mute;
+    }
+}
+// NOLINTEND (*-avoid-non-const-global-variables)
@@ -0,0 +1,348 @@
+#include <stdatomic.h>
+#include <sys/param.h>
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_sleep.h"
+#include "esp_timer.h"
+#include "esp_lcd_panel_ops.h"
+#include "esp_lvgl_port.h"
+#include "driver/gpio.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "bsp/lilygo-t4-s3.h"
+#include "bsp_brightness.h"
+#include "bsp_flush.h"
+#include "bsp_power.h"
+
+#if (BSP_CONFIG_NO_GRAPHIC_LIB == 0)
+
+// NOLINTBEGIN (*-avoid-non-const-global-variables)
+static const char* TAG = "T4 S3 power";
+
+// Wakes follow touches, so the task runs at the touch reader priority
+#define POWER_TASK_STACK            (3072)
+#define POWER_TASK_PRIORITY         (5)
+// Longest a window may take to leave the flush stage before sleep-in gives up
+#define POWER_FLUSH_TIMEOUT_MS      (500)
+// After a wake source other than touch, time left to the application before light sleep is entered again
+#define POWER_LIGHT_SLEEP_SETTLE_MS (20)
+// Pause before a failed transition is tried again
+#define POWER_RETRY_MS              (100)
+// Dimming is slow enough to notice before it is complete, a touch restores the brightness at once
+#define POWER_DIM_FADE_MS           (500)
+#define POWER_UNDIM_FADE_MS         (80)
+
+typedef struct {
+    TaskHandle_t task;
+    SemaphoreHandle_t lock;         /* Serializes transitions with bsp_display_brightness_set() */
+    StaticSemaphore_t lock_buf;
+    lv_display_t* disp;
+    esp_lcd_panel_handle_t panel;
+    esp_lcd_touch_handle_t tp;
+
+    /* Under lock */
+    bsp_display_power_cfg_t cfg;
+    int level;                      /* Brightness set by the application */
+
+    _Atomic int64_t activity_us;
+    _Atomic int state;
+    int64_t state_since_us;         /* Under stats_lock */
+
+    portMUX_TYPE stats_lock;
+    bsp_display_power_stats_t stats;
+} bsp_power_ctx_t;
+
+static bsp_power_ctx_t power_ctx = {
+    .level = 100,
+    .stats_lock = portMUX_INITIALIZER_UNLOCKED,
+};
+
+/**
+ * State the display should be in after idle_us without activity
+ */
+static bsp_display_power_state_t power_target(const bsp_display_power_cfg_t* cfg, int64_t idle_us) {
+    const int64_t idle_ms = idle_us / 1000;
+
+    if (cfg->light_sleep_ms && idle_ms >= cfg->light_sleep_ms) {
+        return BSP_DISPLAY_POWER_LIGHT_SLEEP;
+    }
+    if (cfg->sleep_ms && idle_ms >= cfg->sleep_ms) {
+        return BSP_DISPLAY_POWER_SLEEP;
+    }
+    if (cfg->dim_ms && idle_ms >= cfg->dim_ms) {
+        return BSP_DISPLAY_POWER_DIMMED;
+    }
+    return BSP_DISPLAY_POWER_ACTIVE;
+}
+
+/**
+ * Time until the next timeout expires, or -1 when no timeout is left
+ */
+static int64_t power_next_timeout_us(const bsp_display_power_cfg_t* cfg, int64_t idle_us) {
+    const uint32_t timeouts_ms[] = {cfg->dim_ms, cfg->sleep_ms, cfg->light_sleep_ms};
+    int64_t wait_us = -1;
+
+    for (size_t i = 0; i < sizeof(timeouts_ms) / sizeof(timeouts_ms[0]); i++) {
+        const int64_t left_us = (int64_t)timeouts_ms[i] * 1000 - idle_us;
+        if (timeouts_ms[i] && left_us > 0 && (wait_us < 0 || left_us < wait_us)) {
+            wait_us = left_us;
+        }
+    }
+    return wait_us;
+}
+
+static void power_set_state(bsp_power_ctx_t* ctx, bsp_display_power_state_t state) {
+    const int64_t now_us = esp_timer_get_time();
+    const bsp_display_power_state_t prev = atomic_exchange(&ctx->state, state);
+
+    portENTER_CRITICAL(&ctx->stats_lock);
+    ctx->stats.time_us[prev] += now_us - ctx->state_since_us;
+    ctx->stats.entered[state]++;
+    ctx->stats.state = state;
+    ctx->state_since_us = now_us;
+    portEXIT_CRITICAL(&ctx->stats_lock);
+}
+
+static esp_err_t power_panel_sleep(bsp_power_ctx_t* ctx) {
+    const int64_t start_us = esp_timer_get_time();
+
+    // Taking the lock waits for a refresh in progress, none starts after lvgl_port_stop()
+    lvgl_port_stop();
+    lvgl_port_lock(0);
+    lvgl_port_unlock();
+    esp_err_t ret = bsp_flush_wait_idle(POWER_FLUSH_TIMEOUT_MS);
+    if (ret == ESP_OK) {
+        ret = esp_lcd_panel_disp_on_off(ctx->panel, false);
+    }
+    if (ret == ESP_OK) {
+        ret = esp_lcd_panel_disp_sleep(ctx->panel, true);
+    }
+    if (ret != ESP_OK) {
+        lvgl_port_resume();
+        return ret;
+    }
+
+    const uint32_t sleep_in_us = (uint32_t)(esp_timer_get_time() - start_us);
+    portENTER_CRITICAL(&ctx->stats_lock);
+    ctx->stats.sleep_in_us = sleep_in_us;
+    ctx->stats.sleep_in_max_us = MAX(ctx->stats.sleep_in_max_us, sleep_in_us);
+    portEXIT_CRITICAL(&ctx->stats_lock);
+    return ESP_OK;
+}
+
+static esp_err_t power_panel_wake(bsp_power_ctx_t* ctx, int brightness_percent) {
+    ESP_RETURN_ON_ERROR(esp_lcd_panel_disp_sleep(ctx->panel, false), TAG, "Sleep out failed");
+    // The RM690B0 needs its supplies settled before the display is switched on again
+    vTaskDelay(MAX(pdMS_TO_TICKS(CONFIG_BSP_DISPLAY_POWER_SLEEP_OUT_MS), 1));
+    ESP_RETURN_ON_ERROR(bsp_brightness_ramp(brightness_percent, 0), TAG, "Brightness failed");
+    ESP_RETURN_ON_ERROR(esp_lcd_panel_disp_on_off(ctx->panel, true), TAG, "Display on failed");
+    // The panel RAM is kept in sleep-in, LVGL only redraws what changed meanwhile
+    lvgl_port_resume();
+
+    const uint32_t wake_us = (uint32_t)(esp_timer_get_time() - atomic_load(&ctx->activity_us));
+    portENTER_CRITICAL(&ctx->stats_lock);
+    ctx->stats.wake_us = wake_us;
+    ctx->stats.wake_max_us = MAX(ctx->stats.wake_max_us, wake_us);
+    portEXIT_CRITICAL(&ctx->stats_lock);
+    return ESP_OK;
+}
+
+/**
+ * Bring the display from its current state to target. Called with lock held.
+ */
+static esp_err_t power_transition(bsp_power_ctx_t* ctx, bsp_display_power_state_t target) {
+    const bsp_display_power_state_t state = atomic_load(&ctx->state);
+    const bool asleep = state >= BSP_DISPLAY_POWER_SLEEP;
+    const int brightness = target == BSP_DISPLAY_POWER_DIMMED ? ctx->cfg.dim_percent : ctx->level;
+    esp_err_t ret = ESP_OK;
+
+    if (target >= BSP_DISPLAY_POWER_SLEEP) {
+        if (!asleep) {
+            // Touches from here on wake the panel again instead of reaching LVGL
+            power_set_state(ctx, BSP_DISPLAY_POWER_SLEEP);
+            ret = power_panel_sleep(ctx);
+        }
+    } else if (asleep) {
+        ret = power_panel_wake(ctx, brightness);
+    } else {
+        const uint32_t fade_ms = target == BSP_DISPLAY_POWER_DIMMED ? POWER_DIM_FADE_MS : POWER_UNDIM_FADE_MS;
+        ret = bsp_brightness_ramp(brightness, fade_ms);
+    }
+
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Transition to state %d failed (%s)", (int)target, esp_err_to_name(ret));
+        if (atomic_load(&ctx->state) != state) {
+            power_set_state(ctx, state);
+        }
+        return ret;
+    }
+    if (atomic_load(&ctx->state) != target) {
+        power_set_state(ctx, target);
+    }
+    return ESP_OK;
+}
+
+/**
+ * Sleep until touched. Returns after any wake source, the caller decides whether to sleep again.
+ */
+static void power_light_sleep(bsp_power_ctx_t* ctx) {
+    const gpio_num_t int_gpio = ctx->tp->config.int_gpio_num;
+    const bool active_high = ctx->tp->config.levels.interrupt;
+
+    // The touch driver interrupt fires on an edge, the wake source needs a level. Keep the interrupt masked
+    // while the pin is level triggered, so it cannot fire repeatedly after the wake.
+    gpio_intr_disable(int_gpio);
+    gpio_wakeup_enable(int_gpio, active_high ? GPIO_INTR_HIGH_LEVEL : GPIO_INTR_LOW_LEVEL);
+    esp_sleep_enable_gpio_wakeup();
+
+    esp_light_sleep_start();
+
+    gpio_wakeup_disable(int_gpio);
+    gpio_set_intr_type(int_gpio, active_high ? GPIO_INTR_POSEDGE : GPIO_INTR_NEGEDGE);
+    gpio_intr_enable(int_gpio);
+
+    if (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_GPIO) {
+        // The touch reader may miss the edge that woke the chip, the wake does not depend on it
+        atomic_store(&ctx->activity_us, esp_timer_get_time());
+    } else {
+        // Woken by a source of the application, let it run before sleeping again
+        ulTaskNotifyTake(pdTRUE, MAX(pdMS_TO_TICKS(POWER_LIGHT_SLEEP_SETTLE_MS), 1));
+    }
+}
+
+static void power_task(void* arg) {
+    bsp_power_ctx_t* ctx = arg;
+
+    for (;;) {
+        xSemaphoreTake(ctx->lock, portMAX_DELAY);
+        int64_t idle_us = esp_timer_get_time() - atomic_load(&ctx->activity_us);
+        bsp_display_power_state_t target = power_target(&ctx->cfg, idle_us);
+        esp_err_t ret = ESP_OK;
+        if (target != atomic_load(&ctx->state)) {
+            ret = power_transition(ctx, target);
+        }
+        // Transitions take time, and a touch may have come in meanwhile
+        idle_us = esp_timer_get_time() - atomic_load(&ctx->activity_us);
+        target = power_target(&ctx->cfg, idle_us);
+        const int64_t wait_us = power_next_timeout_us(&ctx->cfg, idle_us);
+        xSemaphoreGive(ctx->lock);
+
+        if (ret != ESP_OK) {
+            ulTaskNotifyTake(pdTRUE, MAX(pdMS_TO_TICKS(POWER_RETRY_MS), 1));
+            continue;
+        }
+        if (target != atomic_load(&ctx->state)) {
+            continue;
+        }
+        if (target == BSP_DISPLAY_POWER_LIGHT_SLEEP) {
+            power_light_sleep(ctx);
+            continue;
+        }
+        ulTaskNotifyTake(pdTRUE, wait_us < 0 ? portMAX_DELAY : pdMS_TO_TICKS(wait_us / 1000) + 1);
+    }
+}
+
+esp_err_t bsp_power_attach(lv_display_t* disp, esp_lcd_panel_handle_t panel, esp_lcd_touch_handle_t tp) {
+    ESP_RETURN_ON_FALSE(disp && panel, ESP_ERR_INVALID_ARG, TAG, "Invalid arguments");
+
+    power_ctx.disp = disp;
+    power_ctx.panel = panel;
+    power_ctx.tp = tp;
+    return ESP_OK;
+}
+
+bool bsp_power_touch_activity(int64_t event_us) {
+    bsp_power_ctx_t* ctx = &power_ctx;
+
+    atomic_store(&ctx->activity_us, event_us);
+    const bsp_display_power_state_t state = atomic_load(&ctx->state);
+    if (state == BSP_DISPLAY_POWER_ACTIVE) {
+        return true;
+    }
+
+    xTaskNotifyGive(ctx->task);
+    if (state == BSP_DISPLAY_POWER_DIMMED) {
+        return true;
+    }
+    portENTER_CRITICAL(&ctx->stats_lock);
+    ctx->stats.swallowed++;
+    portEXIT_CRITICAL(&ctx->stats_lock);
+    return false;
+}
+
+esp_err_t bsp_power_brightness_set(int brightness_percent, uint32_t fade_ms) {
+    bsp_power_ctx_t* ctx = &power_ctx;
+    ESP_RETURN_ON_FALSE(brightness_percent >= 0 && brightness_percent <= 100, ESP_ERR_INVALID_ARG, TAG,
+                        "Invalid brightness");
+
+    if (ctx->task == NULL) {
+        ctx->level = brightness_percent;
+        return bsp_brightness_ramp(brightness_percent, fade_ms);
+    }
+
+    esp_err_t ret = ESP_OK;
+    xSemaphoreTake(ctx->lock, portMAX_DELAY);
+    ctx->level = brightness_percent;
+    if (atomic_load(&ctx->state) == BSP_DISPLAY_POWER_ACTIVE) {
+        ret = bsp_brightness_ramp(brightness_percent, fade_ms);
+    }
+    xSemaphoreGive(ctx->lock);
+    return ret;
+}
+
+esp_err_t bsp_display_power_start(const bsp_display_power_cfg_t* cfg) {
+    bsp_power_ctx_t* ctx = &power_ctx;
+    ESP_RETURN_ON_FALSE(cfg && cfg->dim_percent <= 100, ESP_ERR_INVALID_ARG, TAG, "Invalid arguments");
+    ESP_RETURN_ON_FALSE(!cfg->light_sleep_ms || (cfg->sleep_ms && cfg->light_sleep_ms >= cfg->sleep_ms),
+                        ESP_ERR_INVALID_ARG, TAG, "Light sleep needs the panel asleep first");
+    ESP_RETURN_ON_FALSE(ctx->disp, ESP_ERR_INVALID_STATE, TAG, "Display not started");
+    ESP_RETURN_ON_FALSE(!cfg->light_sleep_ms || (ctx->tp && ctx->tp->config.int_gpio_num != GPIO_NUM_NC),
+                        ESP_ERR_NOT_SUPPORTED, TAG, "Light sleep needs the touch INT line");
+
+    if (ctx->task) {
+        xSemaphoreTake(ctx->lock, portMAX_DELAY);
+        ctx->cfg = *cfg;
+        xSemaphoreGive(ctx->lock);
+        xTaskNotifyGive(ctx->task);
+        return ESP_OK;
+    }
+
+    const int64_t now_us = esp_timer_get_time();
+    ctx->cfg = *cfg;
+    ctx->lock = xSemaphoreCreateMutexStatic(&ctx->lock_buf);
+    atomic_store(&ctx->activity_us, now_us);
+    portENTER_CRITICAL(&ctx->stats_lock);
+    ctx->state_since_us = now_us;
+    ctx->stats.entered[BSP_DISPLAY_POWER_ACTIVE] = 1;
+    portEXIT_CRITICAL(&ctx->stats_lock);
+    ESP_RETURN_ON_FALSE(xTaskCreate(power_task, "bsp_power", POWER_TASK_STACK, ctx, POWER_TASK_PRIORITY,
+                                    &ctx->task) == pdPASS, ESP_ERR_NO_MEM, TAG, "No memory for power task");
+    return ESP_OK;
+}
+
+void bsp_display_power_activity(void) {
+    bsp_power_touch_activity(esp_timer_get_time());
+}
+
+bsp_display_power_state_t bsp_display_power_get_state(void) {
+    return atomic_load(&power_ctx.state);
+}
+
+esp_err_t bsp_display_power_get_stats(bsp_display_power_stats_t* stats) {
+    ESP_RETURN_ON_FALSE(stats, ESP_ERR_INVALID_ARG, TAG, "Invalid arguments");
+
+    const int64_t now_us = esp_timer_get_time();
+    portENTER_CRITICAL(&power_ctx.stats_lock);
+    *stats = power_ctx.stats;
+    // The current state counts up to now
+    if (power_ctx.task) {
+        stats->time_us[stats->state] += now_us - power_ctx.state_since_us;
+    }
+    portEXIT_CRITICAL(&power_ctx.stats_lock);
+    return ESP_OK;
+}
+// NOLINTEND (*-avoid-non-const-global-variables)
+#endif // (BSP_CONFIG_NO_GRAPHIC_LIB == 0)
@@ -0,0 +1,113 @@
+#include "bsp_rotate.h"
+
+// Tile edge in pixels: a 16x16 RGB565 tile touches 16 source and 16 destination lines of 32 bytes
+#define ROTATE_TILE     (16)
+
+void bsp_rotate_area(const bsp_rotate_t* rot, const bsp_area_t* area, int32_t hor_res, int32_t ver_res,
+                     bsp_area_t* res) {
+    const int32_t phys_w = rot->swap_xy ? ver_res : hor_res;
+    const int32_t phys_h = rot->swap_xy ? hor_res : ver_res;
+
+    bsp_area_t out = rot->swap_xy ? (bsp_area_t){area->y1, area->x1, area->y2, area->x2} : *area;
+    if (rot->mirror_x) {
+        const int32_t x1 = phys_w - 1 - out.x2;
+        out.x2 = phys_w - 1 - out.x1;
+        out.x1 = x1;
+    }
+    if (rot->mirror_y) {
+        const int32_t y1 = phys_h - 1 - out.y2;
+        out.y2 = phys_h - 1 - out.y1;
+        out.y1 = y1;
+    }
+    *res = out;
+}
+
+/*
+ * Every transform is affine with unit steps: source pixel (x, y) lands at dst[base + x * step_x + y * step_y].
+ */
+typedef struct {
+    ptrdiff_t base;
+    ptrdiff_t step_x;
+    ptrdiff_t step_y;
+} rotate_map_t;
+
+static rotate_map_t rotate_map(const bsp_rotate_t* rot, int32_t width, int32_t height) {
+    const ptrdiff_t dst_w = rot->swap_xy ? height : width;
+    const ptrdiff_t dst_h = rot->swap_xy ? width : height;
+
+    // Source coordinate feeding the destination column (dx) and row (dy)
+    ptrdiff_t step_dx = 1;
+    ptrdiff_t step_dy = dst_w;
+    ptrdiff_t base = 0;
+    if (rot->mirror_x) {
+        base += dst_w - 1;
+        step_dx = -step_dx;
+    }
+    if (rot->mirror_y) {
+        base += (dst_h - 1) * dst_w;
+        step_dy = -step_dy;
+    }
+
+    return rot->swap_xy ? (rotate_map_t){base, step_dy, step_dx} : (rotate_map_t){base, step_dx, step_dy};
+}
+
+#define ROTATE_TILES(type, src, src_stride, width, height, dst, map)                                    \
+    do {                                                                                                \
+        const uint8_t* src_ = (const uint8_t*)(src);                                                    \
+        type* dst_ = (type*)(dst);                                                                      \
+        for (int32_t ty = 0; ty < (height); ty += ROTATE_TILE) {                                        \
+            const int32_t y_end = ty + ROTATE_TILE < (height) ? ty + ROTATE_TILE : (height);            \
+            for (int32_t tx = 0; tx < (width); tx += ROTATE_TILE) {                                     \
+                const int32_t x_end = tx + ROTATE_TILE < (width) ? tx + ROTATE_TILE : (width);          \
+                for (int32_t y = ty; y < y_end; y++) {                                                  \
+                    const type* row = (const type*)(src_ + (size_t)y * (src_stride));                   \
+                    ptrdiff_t d = (map).base + tx * (map).step_x + y * (map).step_y;                    \
+                    for (int32_t x = tx; x < x_end; x++) {                                              \
+                        dst_[d] = row[x];                                                               \
+                        d += (map).step_x;                                                              \
+                    }                                                                                   \
+                }                                                                                       \
+            }                                                                                           \
+        }                                                                                               \
+    } while (0)
+
+static void rotate_rgb888(const uint8_t* src, size_t src_stride, int32_t width, int32_t height, uint8_t* dst,
+                          rotate_map_t map) {
+    for (int32_t ty = 0; ty < height; ty += ROTATE_TILE) {
+        const int32_t y_end = ty + ROTATE_TILE < height ? ty + ROTATE_TILE : height;
+        for (int32_t tx = 0; tx < width; tx += ROTATE_TILE) {
+            const int32_t x_end = tx + ROTATE_TILE < width ? tx + ROTATE_TILE : width;
+            for (int32_t y = ty; y < y_end; y++) {
+                const uint8_t* px = src + (size_t)y * src_stride + (size_t)tx * 3;
+                ptrdiff_t d = map.base + tx * map.step_x + y * map.step_y;
+                for (int32_t x = tx; x < x_end; x++) {
+                    uint8_t* out = dst + d * 3;
+                    out[0] = px[0];
+                    out[1] = px[1];
+                    out[2] = px[2];
+                    px += 3;
+                    d += map.step_x;
+                }
+            }
+        }
+    }
+}
+
+void bsp_rotate_blit(const bsp_rotate_t* rot, const void* src, size_t src_stride, int32_t width, int32_t height,
+                     uint32_t bytes_per_pixel, void* dst) {
+    const rotate_map_t map = rotate_map(rot, width, height);
+
+    switch (bytes_per_pixel) {
+    case 2:
+        ROTATE_TILES(uint16_t, src, src_stride, width, height, dst, map);
+        break;
+    case 3:
+        rotate_rgb888(src, src_stride, width, height, dst, map);
+        break;
+    case 4:
+        ROTATE_TILES(uint32_t, src, src_stride, width, height, dst, map);
+        break;
+    default:
+        break;
+    }
+}
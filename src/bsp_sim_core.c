@@ -0,0 +1,127 @@
+#include <string.h>
+#include "bsp_sim_core.h"
+
+/* Opcode and 24-bit address phase of every transaction, always single line */
+#define SIM_QSPI_CMD_CLOCKS (32U)
+
+void bsp_sim_core_init(bsp_sim_core_t* core, uint8_t* fb, uint16_t h_res, uint16_t v_res, uint32_t pclk_hz,
+                       uint32_t trans_overhead_ns) {
+    *core = (bsp_sim_core_t){
+        .fb = fb,
+        .h_res = h_res,
+        .v_res = v_res,
+        .pclk_hz = pclk_hz,
+        .trans_overhead_ns = trans_overhead_ns,
+        .bytes_per_pixel = 2,
+        .scroll_rows = v_res,
+    };
+}
+
+uint64_t bsp_sim_core_wire_ns(const bsp_sim_core_t* core, size_t bytes, bool quad) {
+    const uint64_t data_clocks = (uint64_t)bytes * 8U / (quad ? 4U : 1U);
+    return (SIM_QSPI_CMD_CLOCKS + data_clocks) * 1000000000ULL / core->pclk_hz + core->trans_overhead_ns;
+}
+
+void bsp_sim_core_account(bsp_sim_core_t* core, size_t pixel_bytes, size_t bytes, bool quad) {
+    if (pixel_bytes) {
+        core->stats.pixel_writes++;
+        core->stats.pixel_bytes += pixel_bytes;
+    } else {
+        core->stats.commands++;
+    }
+    core->stats.wire_ns += bsp_sim_core_wire_ns(core, bytes, quad);
+}
+
+static uint16_t sim_be16(const uint8_t* p) {
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static void sim_put_pixel(bsp_sim_core_t* core, uint16_t col, uint16_t row, const uint8_t* color) {
+    // Addressing coordinates to panel memory, MV exchanges first and the mirrors act on the result
+    uint32_t x = (core->madctl & BSP_SIM_MADCTL_MV) ? row : col;
+    uint32_t y = (core->madctl & BSP_SIM_MADCTL_MV) ? col : row;
+    if (core->madctl & BSP_SIM_MADCTL_MX) {
+        x = core->h_res - 1U - x;
+    }
+    if (core->madctl & BSP_SIM_MADCTL_MY) {
+        y = core->v_res - 1U - y;
+    }
+    if (x >= core->h_res || y >= core->v_res) {
+        return;
+    }
+    memcpy(&core->fb[((size_t)y * core->h_res + x) * core->bytes_per_pixel], color, core->bytes_per_pixel);
+}
+
+void bsp_sim_core_tx_param(bsp_sim_core_t* core, uint8_t cmd, const uint8_t* param, size_t size) {
+    switch (cmd) {
+    case BSP_SIM_CMD_CASET:
+        if (size >= 4) {
+            core->x0 = sim_be16(param);
+            core->x1 = sim_be16(param + 2);
+        }
+        break;
+    case BSP_SIM_CMD_RASET:
+        if (size >= 4) {
+            core->y0 = sim_be16(param);
+            core->y1 = sim_be16(param + 2);
+        }
+        break;
+    case BSP_SIM_CMD_MADCTL:
+        if (size >= 1) {
+            core->madctl = param[0];
+        }
+        break;
+    case BSP_SIM_CMD_COLMOD:
+        if (size >= 1) {
+            core->bytes_per_pixel = param[0] == BSP_SIM_COLMOD_RGB565 ? 2 : 3;
+        }
+        break;
+    case BSP_SIM_CMD_VSCRDEF:
+        if (size >= 6) {
+            core->scroll_top = sim_be16(param);
+            core->scroll_rows = sim_be16(param + 2);
+        }
+        break;
+    case BSP_SIM_CMD_VSCSAD:
+        if (size >= 2) {
+            core->scroll_start = sim_be16(param);
+        }
+        break;
+    case BSP_SIM_CMD_DISPON:
+    case BSP_SIM_CMD_DISPOFF:
+        core->display_on = cmd == BSP_SIM_CMD_DISPON;
+        break;
+    default:
+        break;
+    }
+}
+
+void bsp_sim_core_tx_color(bsp_sim_core_t* core, uint8_t cmd, const uint8_t* data, size_t size) {
+    if (cmd == BSP_SIM_CMD_RAMWR) {
+        core->cx = core->x0;
+        core->cy = core->y0;
+    }
+    if (core->fb == NULL || (cmd != BSP_SIM_CMD_RAMWR && cmd != BSP_SIM_CMD_RAMWRC) || core->x1 < core->x0 ||
+            core->y1 < core->y0) {
+        return;
+    }
+
+    for (size_t i = 0; i + core->bytes_per_pixel <= size; i += core->bytes_per_pixel) {
+        sim_put_pixel(core, core->cx, core->cy, data + i);
+        if (++core->cx > core->x1) {
+            core->cx = core->x0;
+            // The RM690B0 wraps back to the top of the window after its last row
+            core->cy = core->cy >= core->y1 ? core->y0 : core->cy + 1;
+        }
+    }
+}
+
+uint32_t bsp_sim_core_screen_row(const bsp_sim_core_t* core, uint32_t row) {
+    const int32_t top = core->scroll_top;
+    const int32_t rows = core->scroll_rows;
+    if (rows == 0 || (int32_t)row < top || (int32_t)row >= top + rows) {
+        return row;
+    }
+    const int32_t shift = ((int32_t)core->scroll_start - top) % rows;
+    return (uint32_t)(top + ((int32_t)row - top + shift + rows) % rows);
+}
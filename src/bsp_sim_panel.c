@@ -0,0 +1,299 @@
+#include <stdlib.h>
+#include <string.h>
+#include <sys/cdefs.h>
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_lcd_panel_io.h"
+#include "esp_lcd_panel_io_interface.h"
+#include "esp_lcd_panel_interface.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+#include "bsp/display.h"
+#include "bsp_lcd_io.h"
+#include "bsp_sim_core.h"
+#include "bsp_sim_panel.h"
+
+// NOLINTBEGIN (*-avoid-non-const-global-variables)
+static const char* TAG = "T4 S3 sim";
+
+/* Pixel data opcode of the RM690B0: command and address on one line, data on four */
+#define SIM_QSPI_OP_COLOR   (0x32U)
+
+#ifdef CONFIG_BSP_LCD_SIM_TRANS_OVERHEAD_NS
+#define SIM_TRANS_OVERHEAD_NS   (CONFIG_BSP_LCD_SIM_TRANS_OVERHEAD_NS)
+#else
+#define SIM_TRANS_OVERHEAD_NS   (0)
+#endif
+
+/* Scan of the simulated panel, GSCAN answers follow the clock */
+#define SIM_REFRESH_US      (1000000 / CONFIG_BSP_LCD_REFRESH_HZ)
+#define SIM_SCAN_LINES      (BSP_LCD_V_HW_RES + BSP_LCD_TE_BLANK_ROWS)
+
+/* Answer to RDDID */
+static const uint8_t sim_id[3] = {0x01, 0x90, 0xB0};
+
+typedef struct {
+    esp_lcd_panel_io_t base;
+    bool quad_mode;
+    esp_lcd_panel_io_color_trans_done_cb_t on_color_trans_done;
+    void* user_ctx;
+} sim_io_t;
+
+typedef struct {
+    bsp_sim_core_t core;        /* Decoder and framebuffer, stats are guarded by stats_lock */
+    portMUX_TYPE stats_lock;
+    sim_io_t* io;
+} sim_state_t;
+
+static sim_state_t sim = {
+    .stats_lock = portMUX_INITIALIZER_UNLOCKED,
+};
+
+static void sim_account(size_t pixel_bytes, size_t bytes, bool quad) {
+    portENTER_CRITICAL(&sim.stats_lock);
+    bsp_sim_core_account(&sim.core, pixel_bytes, bytes, quad);
+    portEXIT_CRITICAL(&sim.stats_lock);
+}
+
+static esp_err_t sim_io_rx_param(esp_lcd_panel_io_t* base, int lcd_cmd, void* param, size_t param_size) {
+    (void)base;
+    const uint8_t cmd = (uint8_t)(lcd_cmd >> 8);
+
+    if (param && param_size) {
+        memset(param, 0, param_size);
+        if (cmd == BSP_LCD_CMD_RDDID) {
+            memcpy(param, sim_id, param_size < sizeof(sim_id) ? param_size : sizeof(sim_id));
+        } else if (cmd == BSP_LCD_CMD_GSCAN && param_size >= 2) {
+            const uint32_t line = (uint32_t)(esp_timer_get_time() % SIM_REFRESH_US) * SIM_SCAN_LINES / SIM_REFRESH_US;
+            ((uint8_t*)param)[0] = (uint8_t)(line >> 8);
+            ((uint8_t*)param)[1] = (uint8_t)line;
+        }
+    }
+    sim_account(0, param_size, false);
+    return ESP_OK;
+}
+
+static esp_err_t sim_io_tx_param(esp_lcd_panel_io_t* base, int lcd_cmd, const void* param, size_t param_size) {
+    (void)base;
+    bsp_sim_core_tx_param(&sim.core, (uint8_t)(lcd_cmd >> 8), param, param_size);
+    sim_account(0, param_size, false);
+    return ESP_OK;
+}
+
+static esp_err_t sim_io_tx_color(esp_lcd_panel_io_t* base, int lcd_cmd, const void* color, size_t color_size) {
+    sim_io_t* io = __containerof(base, sim_io_t, base);
+    bsp_sim_core_tx_color(&sim.core, (uint8_t)(lcd_cmd >> 8), color, color_size);
+
+    const bool quad = io->quad_mode && ((uint32_t)lcd_cmd >> 24) == SIM_QSPI_OP_COLOR;
+    sim_account(color_size, color_size, quad);
+
+    if (io->on_color_trans_done) {
+        io->on_color_trans_done(&io->base, NULL, io->user_ctx);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t sim_io_register_event_callbacks(esp_lcd_panel_io_t* base, const esp_lcd_panel_io_callbacks_t* cbs,
+                                                 void* user_ctx) {
+    sim_io_t* io = __containerof(base, sim_io_t, base);
+    io->on_color_trans_done = cbs->on_color_trans_done;
+    io->user_ctx = user_ctx;
+    return ESP_OK;
+}
+
+static esp_err_t sim_io_del(esp_lcd_panel_io_t* base) {
+    sim_io_t* io = __containerof(base, sim_io_t, base);
+    if (sim.io == io) {
+        sim.io = NULL;
+    }
+    free(io);
+    return ESP_OK;
+}
+
+esp_err_t bsp_sim_io_new(const esp_lcd_panel_io_spi_config_t* config, esp_lcd_panel_io_handle_t* ret_io) {
+    ESP_RETURN_ON_FALSE(config && ret_io && config->pclk_hz > 0, ESP_ERR_INVALID_ARG, TAG, "Invalid arguments");
+    ESP_RETURN_ON_FALSE(sim.io == NULL, ESP_ERR_INVALID_STATE, TAG, "Simulated IO already created");
+
+    // The framebuffer outlives the IO, bsp_lcd_io_set_pclk() replaces the IO and the panel keeps its contents
+    if (sim.core.fb == NULL) {
+        uint8_t* fb = calloc((size_t)BSP_LCD_H_HW_RES * BSP_LCD_V_HW_RES, 3);
+        ESP_RETURN_ON_FALSE(fb, ESP_ERR_NO_MEM, TAG, "No memory for the simulated framebuffer");
+        bsp_sim_core_init(&sim.core, fb, BSP_LCD_H_HW_RES, BSP_LCD_V_HW_RES, config->pclk_hz,
+                          SIM_TRANS_OVERHEAD_NS);
+    }
+
+    sim_io_t* io = calloc(1, sizeof(sim_io_t));
+    ESP_RETURN_ON_FALSE(io, ESP_ERR_NO_MEM, TAG, "No memory for simulated IO");
+
+    portENTER_CRITICAL(&sim.stats_lock);
+    sim.core.pclk_hz = config->pclk_hz;
+    portEXIT_CRITICAL(&sim.stats_lock);
+    io->quad_mode = config->flags.quad_mode;
+    io->on_color_trans_done = config->on_color_trans_done;
+    io->user_ctx = config->user_ctx;
+    io->base.rx_param = sim_io_rx_param;
+    io->base.tx_param = sim_io_tx_param;
+    io->base.tx_color = sim_io_tx_color;
+    io->base.register_event_callbacks = sim_io_register_event_callbacks;
+    io->base.del = sim_io_del;
+
+    sim.io = io;
+    *ret_io = &io->base;
+    ESP_LOGD(TAG, "Simulated panel IO at %lu Hz", (unsigned long)config->pclk_hz);
+    return ESP_OK;
+}
+
+typedef struct {
+    esp_lcd_panel_t base;
+    esp_lcd_panel_io_handle_t io;
+    uint8_t colmod;
+    uint8_t madctl;
+    int x_gap;
+    int y_gap;
+} sim_panel_t;
+
+static esp_err_t sim_panel_tx(const sim_panel_t* panel, uint8_t cmd, const void* param, size_t size) {
+    return esp_lcd_panel_io_tx_param(panel->io, (int)BSP_LCD_QSPI_CMD_WRITE(cmd), param, size);
+}
+
+static esp_err_t sim_panel_reset(esp_lcd_panel_t* base) {
+    (void)base;
+    return ESP_OK;
+}
+
+static esp_err_t sim_panel_init(esp_lcd_panel_t* base) {
+    sim_panel_t* panel = __containerof(base, sim_panel_t, base);
+    ESP_RETURN_ON_ERROR(sim_panel_tx(panel, BSP_SIM_CMD_SLPOUT, NULL, 0), TAG, "");
+    ESP_RETURN_ON_ERROR(sim_panel_tx(panel, BSP_SIM_CMD_COLMOD, &panel->colmod, 1), TAG, "");
+    ESP_RETURN_ON_ERROR(sim_panel_tx(panel, BSP_SIM_CMD_MADCTL, &panel->madctl, 1), TAG, "");
+    return sim_panel_tx(panel, BSP_SIM_CMD_DISPON, NULL, 0);
+}
+
+static esp_err_t sim_panel_draw_bitmap(esp_lcd_panel_t* base, int x_start, int y_start, int x_end, int y_end,
+                                       const void* color_data) {
+    sim_panel_t* panel = __containerof(base, sim_panel_t, base);
+    ESP_RETURN_ON_FALSE(x_start < x_end && y_start < y_end, ESP_ERR_INVALID_ARG, TAG, "Invalid window");
+
+    x_start += panel->x_gap;
+    x_end += panel->x_gap;
+    y_start += panel->y_gap;
+    y_end += panel->y_gap;
+
+    const uint8_t caset[4] = {x_start >> 8, x_start & 0xFF, (x_end - 1) >> 8, (x_end - 1) & 0xFF};
+    const uint8_t raset[4] = {y_start >> 8, y_start & 0xFF, (y_end - 1) >> 8, (y_end - 1) & 0xFF};
+    ESP_RETURN_ON_ERROR(sim_panel_tx(panel, BSP_SIM_CMD_CASET, caset, sizeof(caset)), TAG, "");
+    ESP_RETURN_ON_ERROR(sim_panel_tx(panel, BSP_SIM_CMD_RASET, raset, sizeof(raset)), TAG, "");
+
+    const size_t bytes_per_pixel = panel->colmod == BSP_SIM_COLMOD_RGB565 ? 2 : 3;
+    const size_t size = (size_t)(x_end - x_start) * (size_t)(y_end - y_start) * bytes_per_pixel;
+    const int cmd = (int)((SIM_QSPI_OP_COLOR << 24) | ((uint32_t)BSP_SIM_CMD_RAMWR << 8));
+    return esp_lcd_panel_io_tx_color(panel->io, cmd, color_data, size);
+}
+
+static esp_err_t sim_panel_set_madctl(sim_panel_t* panel, uint8_t bit, bool set) {
+    panel->madctl = set ? (panel->madctl | bit) : (panel->madctl & ~bit);
+    return sim_panel_tx(panel, BSP_SIM_CMD_MADCTL, &panel->madctl, 1);
+}
+
+static esp_err_t sim_panel_mirror(esp_lcd_panel_t* base, bool mirror_x, bool mirror_y) {
+    sim_panel_t* panel = __containerof(base, sim_panel_t, base);
+    panel->madctl = (panel->madctl & ~(BSP_SIM_MADCTL_MX | BSP_SIM_MADCTL_MY)) | (mirror_x ? BSP_SIM_MADCTL_MX : 0) |
+                    (mirror_y ? BSP_SIM_MADCTL_MY : 0);
+    return sim_panel_tx(panel, BSP_SIM_CMD_MADCTL, &panel->madctl, 1);
+}
+
+static esp_err_t sim_panel_swap_xy(esp_lcd_panel_t* base, bool swap_axes) {
+    sim_panel_t* panel = __containerof(base, sim_panel_t, base);
+    return sim_panel_set_madctl(panel, BSP_SIM_MADCTL_MV, swap_axes);
+}
+
+static esp_err_t sim_panel_set_gap(esp_lcd_panel_t* base, int x_gap, int y_gap) {
+    sim_panel_t* panel = __containerof(base, sim_panel_t, base);
+    panel->x_gap = x_gap;
+    panel->y_gap = y_gap;
+    return ESP_OK;
+}
+
+static esp_err_t sim_panel_invert_color(esp_lcd_panel_t* base, bool invert_color_data) {
+    sim_panel_t* panel = __containerof(base, sim_panel_t, base);
+    return sim_panel_tx(panel, invert_color_data ? BSP_SIM_CMD_INVON : BSP_SIM_CMD_INVOFF, NULL, 0);
+}
+
+static esp_err_t sim_panel_disp_on_off(esp_lcd_panel_t* base, bool on_off) {
+    sim_panel_t* panel = __containerof(base, sim_panel_t, base);
+    return sim_panel_tx(panel, on_off ? BSP_SIM_CMD_DISPON : BSP_SIM_CMD_DISPOFF, NULL, 0);
+}
+
+static esp_err_t sim_panel_disp_sleep(esp_lcd_panel_t* base, bool sleep) {
+    sim_panel_t* panel = __containerof(base, sim_panel_t, base);
+    return sim_panel_tx(panel, sleep ? BSP_SIM_CMD_SLPIN : BSP_SIM_CMD_SLPOUT, NULL, 0);
+}
+
+static esp_err_t sim_panel_del(esp_lcd_panel_t* base) {
+    sim_panel_t* panel = __containerof(base, sim_panel_t, base);
+    free(panel);
+    return ESP_OK;
+}
+
+esp_err_t bsp_sim_panel_new(esp_lcd_panel_io_handle_t io, uint32_t bits_per_pixel,
+                            esp_lcd_panel_handle_t* ret_panel) {
+    ESP_RETURN_ON_FALSE(io && ret_panel, ESP_ERR_INVALID_ARG, TAG, "Invalid arguments");
+    ESP_RETURN_ON_FALSE(bits_per_pixel == 16 || bits_per_pixel == 24, ESP_ERR_NOT_SUPPORTED, TAG,
+                        "Unsupported pixel size");
+
+    sim_panel_t* panel = calloc(1, sizeof(sim_panel_t));
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_NO_MEM, TAG, "No memory for simulated panel");
+
+    panel->io = io;
+    panel->colmod = bits_per_pixel == 16 ? BSP_SIM_COLMOD_RGB565 : BSP_SIM_COLMOD_RGB888;
+    panel->base.reset = sim_panel_reset;
+    panel->base.init = sim_panel_init;
+    panel->base.draw_bitmap = sim_panel_draw_bitmap;
+    panel->base.mirror = sim_panel_mirror;
+    panel->base.swap_xy = sim_panel_swap_xy;
+    panel->base.set_gap = sim_panel_set_gap;
+    panel->base.invert_color = sim_panel_invert_color;
+    panel->base.disp_on_off = sim_panel_disp_on_off;
+    panel->base.disp_sleep = sim_panel_disp_sleep;
+    panel->base.del = sim_panel_del;
+
+    *ret_panel = &panel->base;
+    return ESP_OK;
+}
+
+esp_err_t bsp_display_sim_get_stats(bsp_display_sim_stats_t* stats) {
+    ESP_RETURN_ON_FALSE(stats, ESP_ERR_INVALID_ARG, TAG, "Invalid arguments");
+    ESP_RETURN_ON_FALSE(sim.core.fb, ESP_ERR_INVALID_STATE, TAG, "Simulated panel not in use");
+
+    portENTER_CRITICAL(&sim.stats_lock);
+    const bsp_sim_stats_t core_stats = sim.core.stats;
+    portEXIT_CRITICAL(&sim.stats_lock);
+
+    *stats = (bsp_display_sim_stats_t){
+        .commands = core_stats.commands,
+        .pixel_writes = core_stats.pixel_writes,
+        .pixel_bytes = core_stats.pixel_bytes,
+        .wire_ns = core_stats.wire_ns,
+    };
+    return ESP_OK;
+}
+
+void bsp_display_sim_reset_stats(void) {
+    portENTER_CRITICAL(&sim.stats_lock);
+    sim.core.stats = (bsp_sim_stats_t){0};
+    portEXIT_CRITICAL(&sim.stats_lock);
+}
+
+const uint8_t* bsp_display_sim_get_framebuffer(uint32_t* bits_per_pixel) {
+    if (bits_per_pixel) {
+        *bits_per_pixel = sim.core.bytes_per_pixel * 8;
+    }
+    return sim.core.fb;
+}
+
+uint32_t bsp_display_sim_get_screen_row(uint32_t row) {
+    return bsp_sim_core_screen_row(&sim.core, row);
+}
+// NOLINTEND (*-avoid-non-const-global-variables)
@@ -0,0 +1,107 @@
+#include "bsp_te_sched.h"
+
+static int64_t te_max(int64_t a, int64_t b) {
+    return a > b ? a : b;
+}
+
+static int64_t te_mod(int64_t a, int64_t m) {
+    const int64_t r = a % m;
+    return r < 0 ? r + m : r;
+}
+
+static int64_t te_abs(int64_t a) {
+    return a < 0 ? -a : a;
+}
+
+static int32_t te_lines(const bsp_te_sched_t* sched) {
+    return sched->cfg.rows + sched->cfg.blank_rows;
+}
+
+/* Time the scan takes for a number of lines */
+static int64_t te_line_time(const bsp_te_sched_t* sched, int64_t lines) {
+    return lines * sched->period_us / te_lines(sched);
+}
+
+void bsp_te_sched_init(bsp_te_sched_t* sched, const bsp_te_sched_cfg_t* cfg) {
+    sched->cfg = *cfg;
+    sched->te_us = 0;
+    sched->period_us = cfg->frame_us;
+    sched->period_x8 = cfg->frame_us * 8;
+    sched->slack_us = 0;
+}
+
+void bsp_te_sched_on_te(bsp_te_sched_t* sched, int64_t te_us) {
+    if (sched->te_us != 0) {
+        const int64_t interval_us = te_us - sched->te_us;
+        const int64_t period_us = sched->period_us;
+        // Averaged over about eight frames, TE jitters by a few microseconds
+        if (interval_us > period_us / 2 && interval_us < period_us + period_us / 2) {
+            const int64_t error_us = te_abs(interval_us - period_us);
+            const uint32_t decayed_us = sched->slack_us - sched->slack_us / 8;
+            sched->slack_us = error_us > decayed_us ? (uint32_t)error_us : decayed_us;
+            sched->period_x8 = (uint32_t)((int64_t)sched->period_x8 + interval_us - sched->period_x8 / 8);
+            sched->period_us = (sched->period_x8 + 4) / 8;
+        }
+    }
+    sched->te_us = te_us;
+}
+
+void bsp_te_sched_on_scanline(bsp_te_sched_t* sched, int64_t now_us, int32_t line) {
+    // In the middle of the line that was read
+    const int64_t lines = te_lines(sched);
+    sched->te_us = now_us - (te_mod(line, lines) * sched->period_us + sched->period_us / 2) / lines;
+    sched->slack_us = (uint32_t)te_line_time(sched, 1) / 2 + 1;
+}
+
+int32_t bsp_te_sched_lines_behind(const bsp_te_sched_t* sched, int64_t now_us, int32_t row) {
+    if (sched->te_us == 0) {
+        return 0;
+    }
+
+    const int64_t lines = te_lines(sched);
+    const int64_t scan_line = te_mod(now_us - sched->te_us, sched->period_us) * lines / sched->period_us;
+    return (int32_t)te_mod(scan_line - (sched->cfg.blank_rows + row), lines);
+}
+
+int64_t bsp_te_sched_start(const bsp_te_sched_t* sched, int64_t earliest_us, int32_t row1, int32_t row2,
+                           uint32_t write_us, bool progressive, bool* synced) {
+    *synced = false;
+    if (sched->te_us == 0 || row2 < row1) {
+        return earliest_us;
+    }
+
+    // Offsets from the time the scan reaches row1 within which the write may start
+    const int64_t period_us = sched->period_us;
+    const int64_t rows = row2 - row1 + 1;
+    int64_t lo_us;
+    int64_t hi_us;
+    if (progressive) {
+        // Row r is written (r - row1) * row_write_us after the start and scanned (r - row1) lines after row1.
+        // The write of every row must fall after the scan left it and before the next frame reaches it, the
+        // margin changes linearly over the window so the first and last row bound it.
+        const int64_t row_write_us = write_us / rows;
+        const int64_t drift_us = (rows - 1) * (int64_t)write_us / rows - te_line_time(sched, rows - 1);
+        lo_us = te_line_time(sched, 1) + te_max(0, -drift_us);
+        hi_us = period_us - row_write_us - te_max(0, drift_us);
+    } else {
+        lo_us = te_line_time(sched, rows);
+        hi_us = period_us - write_us;
+    }
+    // Each line time above and the one to row1 below round down by up to a microsecond
+    lo_us += 2 + sched->slack_us;
+    hi_us -= 2 + sched->slack_us;
+    if (lo_us > hi_us) {
+        return earliest_us;
+    }
+
+    *synced = true;
+    const int64_t row1_us = sched->te_us + te_line_time(sched, sched->cfg.blank_rows + row1);
+    const int64_t offset_us = te_mod(earliest_us - row1_us, period_us);
+    if (offset_us < lo_us) {
+        return earliest_us + lo_us - offset_us;
+    }
+    if (offset_us <= hi_us) {
+        return earliest_us;
+    }
+    return earliest_us + period_us - offset_us + lo_us;
+}
@@ -0,0 +1,297 @@
+#include <sys/param.h>
+#include "esp_attr.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+#include "bsp/lilygo-t4-s3.h"
+#include "bsp/touch.h"
+#include "bsp_governor.h"
+#include "bsp_power.h"
+#include "bsp_touch.h"
+#include "bsp_touch_filter.h"
+
+// NOLINTBEGIN (*-avoid-non-const-global-variables)
+static const char* TAG = "T4 S3 touch";
+
+#define TOUCH_QUEUE_LEN         (16)
+#define TOUCH_TASK_STACK        (3072)
+#define TOUCH_TASK_PRIORITY     (5)
+#define TOUCH_RATE_WINDOW_US    (1000 * 1000)
+// In interrupt mode the controller is still read this often while idle, to notice an INT line that never fires
+#define TOUCH_INT_CHECK_MS      (1000)
+// A contact without a single INT edge for this long means the line does not work
+#define TOUCH_INT_TIMEOUT_US    (200 * 1000)
+
+typedef struct {
+    esp_lcd_touch_handle_t tp;
+    TaskHandle_t task;
+    QueueHandle_t queue;
+    bool interrupt_mode;
+    bool pressed;
+    bool swallow;                   /* The contact woke the panel, it is not passed on until lifted */
+    volatile int64_t irq_us;
+    int64_t contact_us;             /* First read of the current contact */
+    bool contact_irq;               /* An INT edge arrived during the current contact */
+    bsp_touch_filter_t filter;
+
+    /* Rate window for i2c_reads_per_s, only written by the reader task */
+    int64_t window_start_us;
+    uint32_t window_reads;
+
+    portMUX_TYPE stats_lock;
+    bsp_touch_stats_t stats;
+    uint64_t latency_sum_us;
+} bsp_touch_ctx_t;
+
+static bsp_touch_ctx_t touch_ctx = {
+    .stats_lock = portMUX_INITIALIZER_UNLOCKED,
+};
+
+static void IRAM_ATTR touch_isr_cb(esp_lcd_touch_handle_t tp) {
+    BaseType_t need_yield = pdFALSE;
+
+    touch_ctx.irq_us = esp_timer_get_time();
+    vTaskNotifyGiveFromISR(touch_ctx.task, &need_yield);
+    portYIELD_FROM_ISR(need_yield);
+}
+
+static void touch_count_read(bsp_touch_ctx_t* ctx, int64_t now_us) {
+    const int64_t elapsed_us = now_us - ctx->window_start_us;
+
+    portENTER_CRITICAL(&ctx->stats_lock);
+    ctx->stats.i2c_reads++;
+    if (elapsed_us >= TOUCH_RATE_WINDOW_US) {
+        ctx->stats.i2c_reads_per_s = (float)ctx->window_reads * 1e6f / (float)elapsed_us;
+        ctx->window_start_us = now_us;
+        ctx->window_reads = 0;
+    }
+    ctx->window_reads++;
+    portEXIT_CRITICAL(&ctx->stats_lock);
+}
+
+static void touch_queue_sample(bsp_touch_ctx_t* ctx, const bsp_touch_sample_t* sample) {
+    if (xQueueSend(ctx->queue, sample, 0) == pdTRUE) {
+        return;
+    }
+
+    // LVGL fell behind, the oldest sample is the least useful one
+    bsp_touch_sample_t oldest;
+    xQueueReceive(ctx->queue, &oldest, 0);
+    xQueueSend(ctx->queue, sample, 0);
+
+    portENTER_CRITICAL(&ctx->stats_lock);
+    ctx->stats.dropped++;
+    portEXIT_CRITICAL(&ctx->stats_lock);
+}
+
+static esp_err_t touch_read_data(void* tp) {
+    return esp_lcd_touch_read_data(tp);
+}
+
+static void touch_read(bsp_touch_ctx_t* ctx, int64_t event_us) {
+    uint16_t x = 0;
+    uint16_t y = 0;
+    uint8_t count = 0;
+
+    // Goes through the bus manager, so sensor traffic queued meanwhile waits behind the touch read
+    const esp_err_t ret = bsp_i2c_exec(BSP_I2C_PRIO_TOUCH, touch_read_data, ctx->tp);
+    touch_count_read(ctx, esp_timer_get_time());
+    if (ret != ESP_OK) {
+        ESP_LOGD(TAG, "Touch read failed (%s)", esp_err_to_name(ret));
+        return;
+    }
+
+    const bool pressed = esp_lcd_touch_get_coordinates(ctx->tp, &x, &y, NULL, &count, 1) && count > 0;
+    if (!pressed && !ctx->pressed) {
+        // Nothing changed, LVGL already has the release
+        return;
+    }
+
+    // The user could not see what they touched on a sleeping panel
+    if (pressed && !bsp_power_touch_activity(event_us) && !ctx->pressed) {
+        ctx->swallow = true;
+    }
+    ctx->pressed = pressed;
+    if (ctx->swallow) {
+        ctx->swallow = pressed;
+        return;
+    }
+    bsp_touch_filter_apply(&ctx->filter, event_us, pressed, &x, &y);
+    const bsp_touch_sample_t sample = {
+        .x = x,
+        .y = y,
+        .pressed = pressed,
+        .timestamp_us = event_us,
+    };
+    touch_queue_sample(ctx, &sample);
+}
+
+/**
+ * The controller raises INT for every report while a finger is down. A contact found by a timed read with
+ * no edge since it started means the INT line is not wired or not working, touch is then polled for good.
+ */
+static void touch_check_interrupt(bsp_touch_ctx_t* ctx, bool irq, bool was_pressed, int64_t now_us) {
+    if (!ctx->pressed) {
+        return;
+    }
+    if (!was_pressed) {
+        ctx->contact_us = now_us;
+        ctx->contact_irq = false;
+    }
+    ctx->contact_irq |= irq;
+    if (ctx->contact_irq || now_us - ctx->contact_us < TOUCH_INT_TIMEOUT_US) {
+        return;
+    }
+
+    ESP_LOGW(TAG, "No touch interrupt on GPIO %d for %d ms of contact, falling back to polling",
+             (int)ctx->tp->config.int_gpio_num, TOUCH_INT_TIMEOUT_US / 1000);
+    esp_lcd_touch_register_interrupt_callback(ctx->tp, NULL);
+    ctx->interrupt_mode = false;
+    portENTER_CRITICAL(&ctx->stats_lock);
+    ctx->stats.interrupt_mode = false;
+    portEXIT_CRITICAL(&ctx->stats_lock);
+}
+
+static void touch_task(void* arg) {
+    bsp_touch_ctx_t* ctx = arg;
+    uint32_t idle_period_ms = CONFIG_BSP_TOUCH_POLL_MIN_MS;
+
+    for (;;) {
+        TickType_t timeout;
+        if (ctx->pressed) {
+            // Track the finger, and catch the release if the controller does not raise INT for it
+            timeout = pdMS_TO_TICKS(CONFIG_BSP_TOUCH_POLL_MIN_MS);
+            idle_period_ms = CONFIG_BSP_TOUCH_POLL_MIN_MS;
+        } else if (ctx->interrupt_mode) {
+            timeout = pdMS_TO_TICKS(TOUCH_INT_CHECK_MS);
+        } else {
+            timeout = pdMS_TO_TICKS(idle_period_ms);
+            idle_period_ms = MIN(idle_period_ms * 2, CONFIG_BSP_TOUCH_POLL_MAX_MS);
+        }
+
+        const bool irq = ulTaskNotifyTake(pdTRUE, timeout) > 0;
+        const bool was_pressed = ctx->pressed;
+        const int64_t now_us = esp_timer_get_time();
+        touch_read(ctx, irq ? ctx->irq_us : now_us);
+        if (ctx->interrupt_mode) {
+            touch_check_interrupt(ctx, irq, was_pressed, now_us);
+        }
+    }
+}
+
+esp_err_t bsp_touch_reader_start(esp_lcd_touch_handle_t tp) {
+    bsp_touch_ctx_t* ctx = &touch_ctx;
+    ESP_RETURN_ON_FALSE(tp, ESP_ERR_INVALID_ARG, TAG, "Invalid arguments");
+    ESP_RETURN_ON_FALSE(ctx->task == NULL, ESP_ERR_INVALID_STATE, TAG, "Touch reader already running");
+
+    ctx->tp = tp;
+    ctx->queue = xQueueCreate(TOUCH_QUEUE_LEN, sizeof(bsp_touch_sample_t));
+    ESP_RETURN_ON_FALSE(ctx->queue, ESP_ERR_NO_MEM, TAG, "No memory for touch queue");
+    ctx->window_start_us = esp_timer_get_time();
+
+    const bsp_touch_filter_cfg_t filter_cfg = {
+        .median_taps = CONFIG_BSP_TOUCH_MEDIAN_TAPS,
+#ifdef CONFIG_BSP_TOUCH_ONE_EURO
+        .one_euro = true,
+        .min_cutoff_hz = CONFIG_BSP_TOUCH_ONE_EURO_MIN_CUTOFF_MHZ / 1000.0f,
+        .beta = CONFIG_BSP_TOUCH_ONE_EURO_BETA_MICRO / 1000000.0f,
+#endif
+        .d_cutoff_hz = 1.0f,
+        .predict_us = CONFIG_BSP_TOUCH_PREDICT_MS * 1000,
+        .x_max = tp->config.x_max - 1,
+        .y_max = tp->config.y_max - 1,
+    };
+    bsp_touch_filter_init(&ctx->filter, &filter_cfg);
+
+    if (xTaskCreate(touch_task, "bsp_touch", TOUCH_TASK_STACK, ctx, TOUCH_TASK_PRIORITY, &ctx->task) != pdPASS) {
+        vQueueDelete(ctx->queue);
+        ctx->queue = NULL;
+        ESP_LOGE(TAG, "No memory for touch task");
+        return ESP_ERR_NO_MEM;
+    }
+
+    // The task must exist before the first edge can notify it
+    ctx->interrupt_mode = tp->config.int_gpio_num != GPIO_NUM_NC &&
+                          esp_lcd_touch_register_interrupt_callback(tp, touch_isr_cb) == ESP_OK;
+    ESP_LOGI(TAG, "Touch %s", ctx->interrupt_mode ? "interrupt driven" : "polled");
+
+    portENTER_CRITICAL(&ctx->stats_lock);
+    ctx->stats.interrupt_mode = ctx->interrupt_mode;
+    portEXIT_CRITICAL(&ctx->stats_lock);
+
+    return ESP_OK;
+}
+
+bool bsp_touch_reader_take(bsp_touch_sample_t* sample) {
+    if (touch_ctx.queue == NULL || xQueueReceive(touch_ctx.queue, sample, 0) != pdTRUE) {
+        return false;
+    }
+
+    const int64_t latency_us = esp_timer_get_time() - sample->timestamp_us;
+    portENTER_CRITICAL(&touch_ctx.stats_lock);
+    touch_ctx.stats.samples++;
+    touch_ctx.stats.latency_us = (uint32_t)latency_us;
+    touch_ctx.stats.latency_max_us = MAX(touch_ctx.stats.latency_max_us, (uint32_t)latency_us);
+    touch_ctx.latency_sum_us += latency_us;
+    touch_ctx.stats.latency_avg_us = (uint32_t)(touch_ctx.latency_sum_us / touch_ctx.stats.samples);
+    portEXIT_CRITICAL(&touch_ctx.stats_lock);
+
+    return true;
+}
+
+esp_err_t bsp_touch_get_stats(bsp_touch_stats_t* stats) {
+    ESP_RETURN_ON_FALSE(stats, ESP_ERR_INVALID_ARG, TAG, "Invalid arguments");
+    ESP_RETURN_ON_FALSE(touch_ctx.task, ESP_ERR_INVALID_STATE, TAG, "Touch reader not running");
+
+    const int64_t now_us = esp_timer_get_time();
+    portENTER_CRITICAL(&touch_ctx.stats_lock);
+    *stats = touch_ctx.stats;
+    // The reader may sleep for long in interrupt mode, so an idle window is reported as it stands
+    const int64_t elapsed_us = now_us - touch_ctx.window_start_us;
+    if (elapsed_us >= TOUCH_RATE_WINDOW_US) {
+        stats->i2c_reads_per_s = (float)touch_ctx.window_reads * 1e6f / (float)elapsed_us;
+    }
+    portEXIT_CRITICAL(&touch_ctx.stats_lock);
+
+    return ESP_OK;
+}
+
+#if (BSP_CONFIG_NO_GRAPHIC_LIB == 0)
+static void touch_indev_read_cb(lv_indev_t* indev, lv_indev_data_t* data) {
+    static bsp_touch_sample_t last;
+
+    // Every sample read since the last poll is delivered: one per call, LVGL calls again right away while
+    // more are waiting, so gestures see the whole path and not only its end
+    if (bsp_touch_reader_take(&last)) {
+        data->continue_reading = uxQueueMessagesWaiting(touch_ctx.queue) > 0;
+        bsp_governor_touch(last.timestamp_us, last.pressed);
+    }
+
+    data->point.x = last.x;
+    data->point.y = last.y;
+    data->state = last.pressed ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
+}
+
+lv_indev_t* bsp_touch_indev_create(lv_display_t* disp, esp_lcd_touch_handle_t tp) {
+    if (bsp_touch_reader_start(tp) != ESP_OK) {
+        return NULL;
+    }
+
+    lvgl_port_lock(0);
+    lv_indev_t* indev = lv_indev_create();
+    if (indev) {
+        lv_indev_set_type(indev, LV_INDEV_TYPE_POINTER);
+        lv_indev_set_read_cb(indev, touch_indev_read_cb);
+        lv_indev_set_display(indev, disp);
+    }
+    lvgl_port_unlock();
+
+    return indev;
+}
+#endif // BSP_CONFIG_NO_GRAPHIC_LIB == 0
+// NOLINTEND (*-avoid-non-const-global-variables)
@@ -0,0 +1,110 @@
+#include <math.h>
+#include <string.h>
+#include "bsp_touch_filter.h"
+
+// Samples closer than this are treated as this far apart, the controller cannot report faster
+#define FILTER_MIN_DT_S     (0.001f)
+
+void bsp_touch_filter_init(bsp_touch_filter_t* filter, const bsp_touch_filter_cfg_t* cfg) {
+    memset(filter, 0, sizeof(*filter));
+    filter->cfg = *cfg;
+    if (filter->cfg.median_taps > BSP_TOUCH_FILTER_MAX_TAPS) {
+        filter->cfg.median_taps = BSP_TOUCH_FILTER_MAX_TAPS;
+    }
+    if (filter->cfg.median_taps == 0) {
+        filter->cfg.median_taps = 1;
+    }
+}
+
+static uint16_t filter_median(const uint16_t* window, uint8_t count) {
+    uint16_t sorted[BSP_TOUCH_FILTER_MAX_TAPS];
+    memcpy(sorted, window, count * sizeof(sorted[0]));
+    for (uint8_t i = 1; i < count; i++) {
+        const uint16_t v = sorted[i];
+        uint8_t j = i;
+        for (; j > 0 && sorted[j - 1] > v; j--) {
+            sorted[j] = sorted[j - 1];
+        }
+        sorted[j] = v;
+    }
+    return sorted[count / 2];
+}
+
+static inline float filter_alpha(float cutoff_hz, float dt_s) {
+    const float tau = 1.0f / (2.0f * (float)M_PI * cutoff_hz);
+    return 1.0f / (1.0f + tau / dt_s);
+}
+
+static void filter_axis(const bsp_touch_filter_cfg_t* cfg, bsp_touch_filter_axis_t* axis, float raw, float dt_s) {
+    const float d_alpha = filter_alpha(cfg->d_cutoff_hz, dt_s);
+    const float speed = (raw - axis->value) / dt_s;
+    axis->velocity += d_alpha * (speed - axis->velocity);
+
+    if (cfg->one_euro) {
+        const float cutoff = cfg->min_cutoff_hz + cfg->beta * fabsf(axis->velocity);
+        axis->value += filter_alpha(cutoff, dt_s) * (raw - axis->value);
+    } else {
+        axis->value = raw;
+    }
+}
+
+static uint16_t filter_output(const bsp_touch_filter_axis_t* axis, float lead_s, uint16_t max) {
+    float v = axis->value + axis->velocity * lead_s;
+    if (v < 0.0f) {
+        v = 0.0f;
+    } else if (v > (float)max) {
+        v = (float)max;
+    }
+    return (uint16_t)lrintf(v);
+}
+
+void bsp_touch_filter_apply(bsp_touch_filter_t* filter, int64_t t_us, bool pressed, uint16_t* x, uint16_t* y) {
+    const bsp_touch_filter_cfg_t* cfg = &filter->cfg;
+
+    if (!pressed) {
+        if (filter->tracking) {
+            *x = filter_output(&filter->axis[0], 0.0f, cfg->x_max);
+            *y = filter_output(&filter->axis[1], 0.0f, cfg->y_max);
+        }
+        filter->tracking = false;
+        return;
+    }
+
+    // New contact: nothing to filter against yet
+    const bool first = !filter->tracking;
+    if (first) {
+        filter->tracking = true;
+        filter->taps = 0;
+        filter->head = 0;
+        filter->last_us = t_us;
+        filter->axis[0] = (bsp_touch_filter_axis_t){.value = (float)*x};
+        filter->axis[1] = (bsp_touch_filter_axis_t){.value = (float)*y};
+    }
+
+    // Median over the last samples of this contact
+    filter->axis[0].window[filter->head] = *x;
+    filter->axis[1].window[filter->head] = *y;
+    filter->head = (filter->head + 1) % cfg->median_taps;
+    if (filter->taps < cfg->median_taps) {
+        filter->taps++;
+    }
+    const float raw_x = filter_median(filter->axis[0].window, filter->taps);
+    const float raw_y = filter_median(filter->axis[1].window, filter->taps);
+
+    if (first) {
+        return;
+    }
+
+    float dt_s = (float)(t_us - filter->last_us) * 1e-6f;
+    if (dt_s < FILTER_MIN_DT_S) {
+        dt_s = FILTER_MIN_DT_S;
+    }
+    filter->last_us = t_us;
+
+    filter_axis(cfg, &filter->axis[0], raw_x, dt_s);
+    filter_axis(cfg, &filter->axis[1], raw_y, dt_s);
+
+    const float lead_s = (float)cfg->predict_us * 1e-6f;
+    *x = filter_output(&filter->axis[0], lead_s, cfg->x_max);
+    *y = filter_output(&filter->axis[1], lead_s, cfg->y_max);
+}
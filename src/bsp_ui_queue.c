@@ -0,0 +1,231 @@
+#include <string.h>
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "esp_lvgl_port.h"
+
+#include "bsp/lilygo-t4-s3.h"
+#include "bsp_ui_queue.h"
+#include "bsp_ui_ring.h"
+
+#if (BSP_CONFIG_NO_GRAPHIC_LIB == 0)
+
+// NOLINTBEGIN (*-avoid-non-const-global-variables)
+static const char* TAG = "T4 S3 ui";
+
+/* How often the LVGL task looks for posts while no refresh is running, one panel refresh */
+#define UI_POLL_MS      (1000 / CONFIG_BSP_LCD_REFRESH_HZ)
+
+_Static_assert((CONFIG_BSP_DISPLAY_POST_QUEUE_LEN & (CONFIG_BSP_DISPLAY_POST_QUEUE_LEN - 1)) == 0,
+               "CONFIG_BSP_DISPLAY_POST_QUEUE_LEN must be a power of two");
+_Static_assert(sizeof(bsp_display_post_arg_t) == sizeof(((bsp_ui_msg_t*)0)->arg), "Post argument size mismatch");
+
+static bsp_ui_cell_t ui_cells[CONFIG_BSP_DISPLAY_POST_QUEUE_LEN];
+static bsp_ui_ring_t ui_ring;
+static _Atomic bool ui_attached = false;
+/* Set after every post, so the poll timer can apply posts on a screen LVGL does not refresh */
+static _Atomic bool ui_pending = false;
+
+/* Written by posting tasks */
+static _Atomic uint32_t ui_posted;
+static _Atomic uint32_t ui_dropped;
+static _Atomic uint32_t ui_contended;
+static _Atomic uint32_t ui_max_depth;
+
+/* Written by the LVGL task only */
+static lv_display_t* ui_disp;
+static lv_timer_t* ui_timer;
+static uint32_t ui_applied;
+static uint32_t ui_coalesced;
+static uint32_t ui_drain_us_max;
+
+/**
+ * A coalescable update is stale when a newer one for the same object and callback is already published
+ */
+static bool ui_superseded(const bsp_ui_msg_t* msg, size_t ready) {
+    for (size_t i = 1; i < ready; i++) {
+        const bsp_ui_msg_t* next = bsp_ui_ring_at(&ui_ring, i);
+        if (next->coalesce && next->obj == msg->obj && next->apply == msg->apply) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Apply the published updates, in the LVGL task. Returns the number of messages taken from the queue.
+ */
+static size_t ui_drain(void) {
+    // Cleared first, a producer publishing after the ready count sets it again for the next poll
+    atomic_store(&ui_pending, false);
+    // Only what is published now is drained, producers posting meanwhile wait for the next refresh or poll
+    size_t ready = bsp_ui_ring_ready(&ui_ring, CONFIG_BSP_DISPLAY_POST_QUEUE_LEN);
+    if (ready == 0) {
+        return 0;
+    }
+    const size_t drained = ready;
+
+    const int64_t start_us = esp_timer_get_time();
+    for (; ready > 0; ready--) {
+        const bsp_ui_msg_t* msg = bsp_ui_ring_at(&ui_ring, 0);
+        if (msg->coalesce && ui_superseded(msg, ready)) {
+            ui_coalesced++;
+        } else {
+            const bsp_display_post_cb_t cb = (bsp_display_post_cb_t)msg->apply;
+            cb(msg->obj, (const bsp_display_post_arg_t*)&msg->arg);
+            ui_applied++;
+        }
+        bsp_ui_ring_release(&ui_ring, 1);
+    }
+
+    const uint32_t drain_us = (uint32_t)(esp_timer_get_time() - start_us);
+    if (drain_us > ui_drain_us_max) {
+        ui_drain_us_max = drain_us;
+    }
+    return drained;
+}
+
+/**
+ * Runs in the LVGL task before the layout update, so applied updates are rendered in this refresh
+ */
+static void ui_refr_start_cb(lv_event_t* e) {
+    (void)e;
+    ui_drain();
+}
+
+/**
+ * LVGL pauses the refresh timer while nothing is invalidated, so on a static screen REFR_START never comes.
+ * This timer applies posts that arrive meanwhile and starts a refresh right away to show them.
+ */
+static void ui_poll_cb(lv_timer_t* timer) {
+    (void)timer;
+    if (!atomic_load(&ui_pending) || ui_drain() == 0) {
+        return;
+    }
+    lv_timer_t* refr_timer = lv_display_get_refr_timer(ui_disp);
+    if (refr_timer) {
+        lv_timer_resume(refr_timer);
+        lv_timer_ready(refr_timer);
+    }
+}
+
+esp_err_t bsp_ui_queue_attach(lv_display_t* disp) {
+    ESP_RETURN_ON_FALSE(disp, ESP_ERR_INVALID_ARG, TAG, "Invalid arguments");
+
+    if (!atomic_load(&ui_attached)) {
+        bsp_ui_ring_init(&ui_ring, ui_cells, CONFIG_BSP_DISPLAY_POST_QUEUE_LEN);
+    }
+
+    lvgl_port_lock(0);
+    lv_display_add_event_cb(disp, ui_refr_start_cb, LV_EVENT_REFR_START, NULL);
+    ui_disp = disp;
+    if (ui_timer == NULL) {
+        ui_timer = lv_timer_create(ui_poll_cb, UI_POLL_MS, NULL);
+    }
+    lvgl_port_unlock();
+    ESP_RETURN_ON_FALSE(ui_timer, ESP_ERR_NO_MEM, TAG, "No memory for the post timer");
+
+    atomic_store(&ui_attached, true);
+    return ESP_OK;
+}
+
+esp_err_t bsp_display_post(lv_obj_t* obj, bsp_display_post_cb_t cb, const bsp_display_post_arg_t* arg,
+                           bool coalesce) {
+    ESP_RETURN_ON_FALSE(obj && cb, ESP_ERR_INVALID_ARG, TAG, "Invalid arguments");
+    ESP_RETURN_ON_FALSE(atomic_load(&ui_attached), ESP_ERR_INVALID_STATE, TAG, "Display not started");
+
+    bsp_ui_msg_t msg = {
+        .obj = obj,
+        .apply = (void (*)(void))cb,
+        .coalesce = coalesce,
+    };
+    if (arg) {
+        memcpy(&msg.arg, arg, sizeof(msg.arg));
+    }
+
+    uint32_t retries = 0;
+    const bool queued = bsp_ui_ring_push(&ui_ring, &msg, &retries);
+    if (retries) {
+        atomic_fetch_add_explicit(&ui_contended, retries, memory_order_relaxed);
+    }
+    if (!queued) {
+        atomic_fetch_add_explicit(&ui_dropped, 1, memory_order_relaxed);
+        return ESP_ERR_NO_MEM;
+    }
+    atomic_fetch_add_explicit(&ui_posted, 1, memory_order_relaxed);
+    atomic_store(&ui_pending, true);
+
+    const uint32_t depth = bsp_ui_ring_depth(&ui_ring);
+    uint32_t max_depth = atomic_load_explicit(&ui_max_depth, memory_order_relaxed);
+    while (depth > max_depth && !atomic_compare_exchange_weak_explicit(&ui_max_depth, &max_depth, depth,
+                                                                       memory_order_relaxed,
+                                                                       memory_order_relaxed)) {
+    }
+    return ESP_OK;
+}
+
+static void ui_apply_text(lv_obj_t* obj, const bsp_display_post_arg_t* arg) {
+#if LV_USE_LABEL
+    lv_label_set_text(obj, arg->text);
+#else
+    (void)obj;
+    (void)arg;
+#endif
+}
+
+esp_err_t bsp_display_post_text(lv_obj_t* label, const char* text) {
+    ESP_RETURN_ON_FALSE(text, ESP_ERR_INVALID_ARG, TAG, "Invalid arguments");
+
+    bsp_display_post_arg_t arg;
+    strncpy(arg.text, text, sizeof(arg.text) - 1);
+    arg.text[sizeof(arg.text) - 1] = '\0';
+    return bsp_display_post(label, ui_apply_text, &arg, true);
+}
+
+static void ui_apply_value(lv_obj_t* obj, const bsp_display_post_arg_t* arg) {
+#if LV_USE_SLIDER
+    if (lv_obj_check_type(obj, &lv_slider_class)) {
+        lv_slider_set_value(obj, arg->value, LV_ANIM_OFF);
+        return;
+    }
+#endif
+#if LV_USE_BAR
+    if (lv_obj_check_type(obj, &lv_bar_class)) {
+        lv_bar_set_value(obj, arg->value, LV_ANIM_OFF);
+        return;
+    }
+#endif
+#if LV_USE_ARC
+    if (lv_obj_check_type(obj, &lv_arc_class)) {
+        lv_arc_set_value(obj, arg->value);
+        return;
+    }
+#endif
+    ESP_LOGW(TAG, "Posted value for an object that is not a bar, slider or arc");
+}
+
+esp_err_t bsp_display_post_value(lv_obj_t* obj, int32_t value) {
+    const bsp_display_post_arg_t arg = {
+        .value = value,
+    };
+    return bsp_display_post(obj, ui_apply_value, &arg, true);
+}
+
+esp_err_t bsp_display_get_post_stats(bsp_display_post_stats_t* stats) {
+    ESP_RETURN_ON_FALSE(stats, ESP_ERR_INVALID_ARG, TAG, "Invalid arguments");
+
+    *stats = (bsp_display_post_stats_t){
+        .posted = atomic_load_explicit(&ui_posted, memory_order_relaxed),
+        .applied = ui_applied,
+        .coalesced = ui_coalesced,
+        .dropped = atomic_load_explicit(&ui_dropped, memory_order_relaxed),
+        .contended = atomic_load_explicit(&ui_contended, memory_order_relaxed),
+        .depth = atomic_load(&ui_attached) ? bsp_ui_ring_depth(&ui_ring) : 0,
+        .max_depth = atomic_load_explicit(&ui_max_depth, memory_order_relaxed),
+        .drain_us_max = ui_drain_us_max,
+    };
+    return ESP_OK;
+}
+// NOLINTEND (*-avoid-non-const-global-variables)
+#endif // (BSP_CONFIG_NO_GRAPHIC_LIB == 0)
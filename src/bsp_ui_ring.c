@@ -0,0 +1,80 @@
+#include "bsp_ui_ring.h"
+
+void bsp_ui_ring_init(bsp_ui_ring_t* ring, bsp_ui_cell_t* cells, uint32_t capacity) {
+    ring->cells = cells;
+    ring->mask = capacity - 1;
+    for (uint32_t i = 0; i < capacity; i++) {
+        atomic_init(&cells[i].seq, i);
+    }
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->head, 0);
+}
+
+bool bsp_ui_ring_push(bsp_ui_ring_t* ring, const bsp_ui_msg_t* msg, uint32_t* retries) {
+    uint32_t pos = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    bsp_ui_cell_t* cell;
+
+    for (;;) {
+        cell = &ring->cells[pos & ring->mask];
+        const uint32_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        const int32_t diff = (int32_t)(seq - pos);
+        if (diff == 0) {
+            // The cell is free for this lap, claim it. On failure pos is reloaded with the current tail.
+            if (atomic_compare_exchange_weak_explicit(&ring->tail, &pos, pos + 1, memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                break;
+            }
+            (*retries)++;
+        } else if (diff < 0) {
+            // The consumer has not released this cell from the previous lap yet
+            return false;
+        } else {
+            // Another producer claimed pos first
+            pos = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+            (*retries)++;
+        }
+    }
+
+    cell->msg = *msg;
+    atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+    return true;
+}
+
+size_t bsp_ui_ring_ready(const bsp_ui_ring_t* ring, size_t max) {
+    const uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t count = 0;
+
+    // Stop at the first cell that is claimed but not published yet, messages are read strictly in order. The
+    // position is compared in 32 bits, so it wraps like the sequence numbers.
+    while (count < max && count <= ring->mask) {
+        const uint32_t pos = head + (uint32_t)count;
+        const bsp_ui_cell_t* cell = &ring->cells[pos & ring->mask];
+        if (atomic_load_explicit(&cell->seq, memory_order_acquire) != pos + 1) {
+            break;
+        }
+        count++;
+    }
+    return count;
+}
+
+bsp_ui_msg_t* bsp_ui_ring_at(bsp_ui_ring_t* ring, size_t offset) {
+    const uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    return &ring->cells[(head + offset) & ring->mask].msg;
+}
+
+void bsp_ui_ring_release(bsp_ui_ring_t* ring, size_t count) {
+    const uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+    for (size_t i = 0; i < count; i++) {
+        // Free for the producer that claims this position one lap later
+        const uint32_t pos = head + (uint32_t)i;
+        atomic_store_explicit(&ring->cells[pos & ring->mask].seq, pos + ring->mask + 1, memory_order_release);
+    }
+    atomic_store_explicit(&ring->head, head + (uint32_t)count, memory_order_relaxed);
+}
+
+uint32_t bsp_ui_ring_depth(const bsp_ui_ring_t* ring) {
+    const uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    const uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    return tail - head;
+}
@@ -0,0 +1,87 @@
+#include "bsp_vscroll.h"
+
+static int32_t vscroll_mod(int32_t a, int32_t m) {
+    const int32_t r = a % m;
+    return r < 0 ? r + m : r;
+}
+
+static int32_t vscroll_clamp(int32_t v, int32_t lo, int32_t hi) {
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+void bsp_vscroll_init(bsp_vscroll_t* vscroll, int32_t rows) {
+    *vscroll = (bsp_vscroll_t){
+        .rows = rows,
+    };
+}
+
+void bsp_vscroll_set_band(bsp_vscroll_t* vscroll, int32_t top, int32_t height) {
+    vscroll->top = vscroll_clamp(top, 0, vscroll->rows);
+    vscroll->height = vscroll_clamp(height, 0, vscroll->rows - vscroll->top);
+    vscroll->offset = 0;
+}
+
+void bsp_vscroll_scroll(bsp_vscroll_t* vscroll, int32_t dy) {
+    if (vscroll->height) {
+        vscroll->offset = vscroll_mod(vscroll->offset + dy, vscroll->height);
+    }
+}
+
+void bsp_vscroll_def(const bsp_vscroll_t* vscroll, uint16_t def[3]) {
+    if (vscroll->height == 0) {
+        def[0] = 0;
+        def[1] = (uint16_t)vscroll->rows;
+        def[2] = 0;
+        return;
+    }
+    def[0] = (uint16_t)vscroll->top;
+    def[1] = (uint16_t)vscroll->height;
+    def[2] = (uint16_t)(vscroll->rows - vscroll->top - vscroll->height);
+}
+
+uint16_t bsp_vscroll_start(const bsp_vscroll_t* vscroll) {
+    return vscroll->height ? (uint16_t)(vscroll->top + vscroll->offset) : 0;
+}
+
+/**
+ * Append a run, joining it to the previous one when the memory rows continue
+ */
+static size_t vscroll_add(bsp_vscroll_span_t* spans, size_t count, int32_t row1, int32_t row2, int32_t mem_row1) {
+    if (row2 < row1) {
+        return count;
+    }
+    if (count) {
+        bsp_vscroll_span_t* last = &spans[count - 1];
+        if (last->row2 + 1 == row1 && last->mem_row1 + (row1 - last->row1) == mem_row1) {
+            last->row2 = row2;
+            return count;
+        }
+    }
+    spans[count] = (bsp_vscroll_span_t){row1, row2, mem_row1};
+    return count + 1;
+}
+
+size_t bsp_vscroll_map(const bsp_vscroll_t* vscroll, int32_t row1, int32_t row2, bsp_vscroll_span_t* spans) {
+    const int32_t top = vscroll->top;
+    const int32_t bottom = top + vscroll->height - 1;
+    size_t count = 0;
+
+    if (vscroll->height == 0) {
+        return vscroll_add(spans, 0, row1, row2, row1);
+    }
+
+    count = vscroll_add(spans, count, row1, row2 < top - 1 ? row2 : top - 1, row1);
+
+    // Inside the band the rows run from the start row to the end of the band, then wrap to its top
+    const int32_t band1 = row1 > top ? row1 : top;
+    const int32_t band2 = row2 < bottom ? row2 : bottom;
+    if (band1 <= band2) {
+        const int32_t mem1 = top + vscroll_mod(band1 - top + vscroll->offset, vscroll->height);
+        const int32_t wrap = band1 + (bottom - mem1);
+        count = vscroll_add(spans, count, band1, band2 < wrap ? band2 : wrap, mem1);
+        count = vscroll_add(spans, count, wrap + 1, band2, top);
+    }
+
+    const int32_t below1 = row1 > bottom + 1 ? row1 : bottom + 1;
+    return vscroll_add(spans, count, below1, row2, below1);
+}
@@ -0,0 +1,70 @@
+#!/usr/bin/env python3
+"""Pack the asset codec fixtures of test_asset_codec with tools/bsp_assets_pack.py.
+
+    make_codec_fixtures.py [output directory]
+
+Writes codec_rgb565.bin and codec_rgb888.bin. The images are computed, test_asset_codec.c computes the same
+pixels and compares them with what the C decoder makes of the blobs. Run it again after a change to the
+packer's encoder, the host tests also pack a fresh copy and decode it.
+"""
+
+import os
+import sys
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "..", "..", "tools"))
+import bsp_assets_pack as pack  # noqa: E402
+
+TILE_LINES = 16
+PALETTE = [0x000000, 0xFFFFFF, 0x123456, 0xABCDEF, 0x00FF00, 0xF81F07, 0x7F7F7F, 0x010203]
+
+
+def test_rand(state):
+    """Same generator as test_rand() in test_common.h, returns (value, state)."""
+    state = (state * 1103515245 + 12345) & 0xFFFFFFFF
+    return (state >> 16) & 0x7FFF, state
+
+
+def images(mask):
+    """(name, width, height, pixels), kept in step with fixture_pixels() in test_asset_codec.c."""
+    out = []
+
+    # Smooth gradient: mostly literals
+    w, h = 64, 40
+    out.append(("gradient", w, h, [((x * 37 + y * 101) * 0x010203) & mask for y in range(h) for x in range(w)]))
+
+    # Few colours at random: table hits, short runs and literals
+    w, h = 64, 48
+    state = 5
+    pixels = []
+    for _ in range(w * h):
+        r, state = test_rand(state)
+        pixels.append(PALETTE[r % len(PALETTE)] & mask)
+    out.append(("palette", w, h, pixels))
+
+    # One colour over more than a long run per tile, and a single other pixel
+    w, h = 1100, 20
+    pixels = [0x5A5A5A & mask] * (w * h)
+    pixels[5 * w + 550] = 0xA5A5A5 & mask
+    out.append(("flat", w, h, pixels))
+
+    # Three-line bands, the last tile is short
+    w, h = 100, 33
+    out.append(("stripes", w, h, [((y // 3) * 0x111111) & mask for y in range(h) for x in range(w)]))
+    return out
+
+
+def main():
+    out_dir = sys.argv[1] if len(sys.argv) > 1 else os.path.dirname(os.path.abspath(__file__))
+    for name, fmt, mask in (("codec_rgb565.bin", pack.FORMAT_RGB565, 0xFFFF),
+                            ("codec_rgb888.bin", pack.FORMAT_RGB888, 0xFFFFFF)):
+        imgs = images(mask)
+        blob = pack.pack(imgs, fmt, TILE_LINES)
+        if pack.verify(blob, {n: p for n, _, _, p in imgs}):
+            return 1
+        with open(os.path.join(out_dir, name), "wb") as f:
+            f.write(blob)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
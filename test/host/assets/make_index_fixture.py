@@ -0,0 +1,47 @@
+#!/usr/bin/env python3
+"""Build the flash asset partition fixture of test_asset_index with tools/bsp_flash_assets.py.
+
+    make_index_fixture.py [output directory]
+
+Writes index.bin. The assets are computed, test_asset_index.c computes the same bytes and checks that the C
+index finds every asset where the builder put it. Run it again after a change to the builder, the host tests
+also build a fresh copy and check it.
+"""
+
+import os
+import sys
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "..", "..", "tools"))
+import bsp_flash_assets as fa  # noqa: E402
+
+
+def pattern(seed, length):
+    """Byte i of an asset is (seed + i * 7) & 0xFF, kept in step with asset_byte() in test_asset_index.c."""
+    return bytes((seed + i * 7) & 0xFF for i in range(length))
+
+
+def assets():
+    """(name, kind, format, width, height, data), kept in step with fixtures[] in test_asset_index.c."""
+    return [
+        ("logo", fa.KIND_IMAGE, fa.PIXEL_RGB565, 20, 10, pattern(1, 20 * 10 * 2)),
+        ("photo", fa.KIND_IMAGE, fa.PIXEL_RGB888, 5, 3, pattern(2, 5 * 3 * 3)),
+        ("icon", fa.KIND_IMAGE, fa.PIXEL_ARGB8888, 8, 8, pattern(3, 8 * 8 * 4)),
+        ("Montserrat", fa.KIND_FONT, fa.PIXEL_NONE, 0, 0, pattern(4, 1000)),
+        ("a", fa.KIND_DATA, fa.PIXEL_NONE, 0, 0, pattern(5, 1)),
+        ("abcdefghijklmnopqrstuvwx", fa.KIND_DATA, fa.PIXEL_NONE, 0, 0, pattern(6, 33)),
+        ("empty", fa.KIND_DATA, fa.PIXEL_NONE, 0, 0, b""),
+    ]
+
+
+def main():
+    out_dir = sys.argv[1] if len(sys.argv) > 1 else os.path.dirname(os.path.abspath(__file__))
+    image = fa.build(assets(), 0)
+    if fa.check(image):
+        return 1
+    with open(os.path.join(out_dir, "index.bin"), "wb") as f:
+        f.write(image)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,215 @@
+/*
+ * Dirty-area coalescing of the flush stage
+ *
+ * The area lists are what LVGL invalidates in one refresh cycle for typical screens, in 450x600 screen
+ * coordinates, before lvgl_round_cb() aligns them. The merge is run with the cost model of the flush stage.
+ */
+
+#include <string.h>
+#include "bsp_area.h"
+#include "test_common.h"
+
+#define SCREEN_W    (450)
+#define SCREEN_H    (600)
+
+// Same model as bsp_flush.c with the Kconfig defaults: RGB565 on the wire, 200 bytes per window, 2-pixel rule
+static const bsp_area_merge_cfg_t merge_cfg = {
+    .bytes_per_pixel = 2,
+    .window_overhead = 200,
+    .align = 2,
+};
+
+typedef struct {
+    const char* name;
+    const bsp_area_t* areas;
+    size_t count;
+    size_t expected_windows;
+} area_trace_t;
+
+// A label changes from "12:59" to "13:00": old and new text boxes overlap
+static const bsp_area_t trace_label[] = {
+    {21, 40, 140, 71},
+    {21, 40, 151, 71},
+};
+
+// Spinner arc moving, LVGL invalidates the old and new arc segments of a 60x60 widget
+static const bsp_area_t trace_spinner[] = {
+    {195, 271, 224, 300},
+    {225, 271, 254, 285},
+    {225, 286, 254, 330},
+    {195, 301, 238, 330},
+};
+
+// Status icons in two opposite corners
+static const bsp_area_t trace_corners[] = {
+    {5, 3, 28, 26},
+    {421, 573, 444, 596},
+};
+
+// List scrolled by a few pixels, one invalidated area per visible row
+static const bsp_area_t trace_list[] = {
+    {0, 80, 449, 139},
+    {0, 140, 449, 199},
+    {0, 200, 449, 259},
+    {0, 260, 449, 319},
+    {0, 320, 449, 379},
+    {0, 380, 449, 439},
+};
+
+// Button pressed: the button, its shadow and its label, all inside each other
+static const bsp_area_t trace_button[] = {
+    {150, 500, 299, 559},
+    {140, 495, 309, 569},
+    {190, 520, 259, 539},
+};
+
+// Slider knob dragged: knob old and new position plus the indicator bar, and an unrelated value label far off
+static const bsp_area_t trace_slider[] = {
+    {41, 301, 61, 321},
+    {57, 301, 77, 321},
+    {30, 309, 69, 313},
+    {300, 20, 379, 41},
+};
+
+static const area_trace_t traces[] = {
+    {"label", trace_label, sizeof(trace_label) / sizeof(trace_label[0]), 1},
+    {"spinner", trace_spinner, sizeof(trace_spinner) / sizeof(trace_spinner[0]), 1},
+    {"corners", trace_corners, sizeof(trace_corners) / sizeof(trace_corners[0]), 2},
+    {"list", trace_list, sizeof(trace_list) / sizeof(trace_list[0]), 1},
+    {"button", trace_button, sizeof(trace_button) / sizeof(trace_button[0]), 1},
+    {"slider", trace_slider, sizeof(trace_slider) / sizeof(trace_slider[0]), 2},
+};
+
+static uint64_t total_cost(const bsp_area_t* areas, size_t count) {
+    uint64_t cost = 0;
+    for (size_t i = 0; i < count; i++) {
+        cost += bsp_area_cost(&areas[i], &merge_cfg);
+    }
+    return cost;
+}
+
+/**
+ * Properties every merge result must have: aligned windows, every input pixel covered, no window inside
+ * another, no pair left whose merge would still pay off, and never more expensive than the input
+ */
+static void check_merge(const bsp_area_t* in, size_t in_count, const bsp_area_t* out, size_t out_count) {
+    TEST_CHECK(out_count >= 1 && out_count <= in_count);
+
+    for (size_t i = 0; i < out_count; i++) {
+        TEST_CHECK(out[i].x1 % 2 == 0 && out[i].y1 % 2 == 0);
+        TEST_CHECK(bsp_area_width(&out[i]) % 2 == 0 && bsp_area_height(&out[i]) % 2 == 0);
+        for (size_t j = 0; j < out_count; j++) {
+            TEST_CHECK(j == i || !bsp_area_contains(&out[j], &out[i]));
+            if (j > i) {
+                bsp_area_t merged;
+                bsp_area_union(&merged, &out[i], &out[j]);
+                TEST_CHECK(bsp_area_cost(&merged, &merge_cfg) >
+                           bsp_area_cost(&out[i], &merge_cfg) + bsp_area_cost(&out[j], &merge_cfg));
+            }
+        }
+    }
+
+    // Every input pixel is sent by at least one window
+    for (size_t i = 0; i < in_count; i++) {
+        for (int32_t y = in[i].y1; y <= in[i].y2; y++) {
+            for (int32_t x = in[i].x1; x <= in[i].x2; x++) {
+                bool covered = false;
+                for (size_t j = 0; j < out_count && !covered; j++) {
+                    covered = x >= out[j].x1 && x <= out[j].x2 && y >= out[j].y1 && y <= out[j].y2;
+                }
+                if (!covered) {
+                    fprintf(stderr, "pixel %d,%d of area %zu not covered\n", (int)x, (int)y, i);
+                    TEST_CHECK(covered);
+                    return;
+                }
+            }
+        }
+    }
+
+    bsp_area_t aligned[16];
+    memcpy(aligned, in, in_count * sizeof(in[0]));
+    for (size_t i = 0; i < in_count; i++) {
+        bsp_area_align(&aligned[i], merge_cfg.align);
+    }
+    TEST_CHECK(total_cost(out, out_count) <= total_cost(aligned, in_count));
+}
+
+static void test_align(void) {
+    bsp_area_t a = {3, 5, 10, 12};
+    bsp_area_align(&a, 2);
+    TEST_CHECK_EQ(a.x1, 2);
+    TEST_CHECK_EQ(a.y1, 4);
+    TEST_CHECK_EQ(a.x2, 11);
+    TEST_CHECK_EQ(a.y2, 13);
+
+    bsp_area_t b = {3, 5, 10, 12};
+    bsp_area_align(&b, 1);
+    TEST_CHECK_EQ(b.x1, 3);
+    TEST_CHECK_EQ(b.y2, 12);
+}
+
+static void test_traces(void) {
+    for (size_t t = 0; t < sizeof(traces) / sizeof(traces[0]); t++) {
+        bsp_area_t areas[16];
+        memcpy(areas, traces[t].areas, traces[t].count * sizeof(areas[0]));
+        const size_t count = bsp_area_merge(areas, traces[t].count, &merge_cfg);
+        if (count != traces[t].expected_windows) {
+            fprintf(stderr, "trace %s: %zu windows, expected %zu\n", traces[t].name, count,
+                    traces[t].expected_windows);
+        }
+        TEST_CHECK_EQ(count, traces[t].expected_windows);
+        check_merge(traces[t].areas, traces[t].count, areas, count);
+    }
+}
+
+static void test_list_is_one_stripe(void) {
+    bsp_area_t areas[6];
+    memcpy(areas, trace_list, sizeof(trace_list));
+    TEST_CHECK_EQ(bsp_area_merge(areas, 6, &merge_cfg), 1);
+    TEST_CHECK_EQ(areas[0].x1, 0);
+    TEST_CHECK_EQ(areas[0].y1, 80);
+    TEST_CHECK_EQ(areas[0].x2, 449);
+    TEST_CHECK_EQ(areas[0].y2, 439);
+}
+
+static void test_overhead_decides(void) {
+    // Two 20x20 areas 40 pixels apart: 1600 extra bytes in the bounding box
+    const bsp_area_t pair[] = {{0, 0, 19, 19}, {60, 0, 79, 19}};
+    bsp_area_t areas[2];
+
+    memcpy(areas, pair, sizeof(pair));
+    TEST_CHECK_EQ(bsp_area_merge(areas, 2, &merge_cfg), 2);
+
+    bsp_area_merge_cfg_t expensive = merge_cfg;
+    expensive.window_overhead = 2048;
+    memcpy(areas, pair, sizeof(pair));
+    TEST_CHECK_EQ(bsp_area_merge(areas, 2, &expensive), 1);
+}
+
+static void test_random_lists(void) {
+    unsigned seed = 1;
+    for (int run = 0; run < 300; run++) {
+        bsp_area_t in[12];
+        bsp_area_t out[12];
+        const size_t count = 1 + test_rand(&seed) % 12;
+        for (size_t i = 0; i < count; i++) {
+            const int32_t w = 1 + (int32_t)(test_rand(&seed) % 120);
+            const int32_t h = 1 + (int32_t)(test_rand(&seed) % 120);
+            in[i].x1 = (int32_t)(test_rand(&seed) % (SCREEN_W - w));
+            in[i].y1 = (int32_t)(test_rand(&seed) % (SCREEN_H - h));
+            in[i].x2 = in[i].x1 + w - 1;
+            in[i].y2 = in[i].y1 + h - 1;
+        }
+        memcpy(out, in, count * sizeof(in[0]));
+        check_merge(in, count, out, bsp_area_merge(out, count, &merge_cfg));
+    }
+}
+
+int main(void) {
+    TEST_RUN(test_align);
+    TEST_RUN(test_traces);
+    TEST_RUN(test_list_is_one_stripe);
+    TEST_RUN(test_overhead_decides);
+    TEST_RUN(test_random_lists);
+    return test_failures;
+}
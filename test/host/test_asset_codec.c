@@ -0,0 +1,269 @@
+/*
+ * Asset blob parser and tile decoder against the packer
+ *
+ * The blobs in test/host/assets are written by tools/bsp_assets_pack.py from computed images (see
+ * make_codec_fixtures.py). Every tile is decoded by the C decoder and compared with the same images computed
+ * here, so the C and Python sides of the format cannot drift apart. Other blobs can be passed on the command
+ * line, the host tests pass a freshly packed copy.
+ *
+ * Every tile is then decoded truncated at each length, and with random bytes flipped, and hand-made tiles
+ * carry runs and literals longer than the tile. Such tiles must be rejected, and the decoder must never write
+ * past the tile. Guard bytes catch writes, the address sanitizer catches reads where the compiler has one.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "bsp_asset_codec.h"
+#include "test_common.h"
+
+#define GUARD           (0xEE)
+#define GUARD_BYTES     (64)
+#define CORRUPT_RUNS    (200)
+
+static const uint32_t palette[8] = {0x000000, 0xFFFFFF, 0x123456, 0xABCDEF, 0x00FF00, 0xF81F07, 0x7F7F7F, 0x010203};
+
+static uint8_t* read_file(const char* path, size_t* size) {
+    FILE* f = fopen(path, "rb");
+    if (f == NULL) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    *size = (size_t)ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t* data = malloc(*size);
+    if (fread(data, 1, *size, f) != *size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    return data;
+}
+
+static uint32_t rd32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * Pixels of a fixture image, kept in step with images() in make_codec_fixtures.py. The palette image is drawn
+ * from test_rand() in order, so its pixels are generated in one go.
+ */
+static uint32_t* fixture_pixels(const char* name, uint16_t w, uint16_t h, uint32_t mask) {
+    uint32_t* pixels = malloc((size_t)w * h * sizeof(uint32_t));
+    unsigned seed = 5;
+    for (uint32_t y = 0; y < h; y++) {
+        for (uint32_t x = 0; x < w; x++) {
+            uint32_t px = 0;
+            if (strcmp(name, "gradient") == 0) {
+                px = (x * 37 + y * 101) * 0x010203U;
+            } else if (strcmp(name, "palette") == 0) {
+                px = palette[test_rand(&seed) % 8];
+            } else if (strcmp(name, "flat") == 0) {
+                px = (x == 550 && y == 5) ? 0xA5A5A5 : 0x5A5A5A;
+            } else if (strcmp(name, "stripes") == 0) {
+                px = (y / 3) * 0x111111U;
+            } else {
+                free(pixels);
+                return NULL;
+            }
+            pixels[y * w + x] = px & mask;
+        }
+    }
+    return pixels;
+}
+
+/**
+ * Decode into a buffer of exactly the tile size followed by guard bytes. Returns false if the guard was hit.
+ */
+static bool decode_guarded(const uint8_t* src, size_t src_len, size_t pixels, uint8_t bpp, bool* ok,
+                           uint8_t** out) {
+    const size_t bytes = pixels * bpp;
+    uint8_t* dst = malloc(bytes + GUARD_BYTES);
+    memset(dst + bytes, GUARD, GUARD_BYTES);
+    // A copy of exactly src_len bytes, so the sanitizer sees any read past the tile
+    uint8_t* copy = malloc(src_len ? src_len : 1);
+    memcpy(copy, src, src_len);
+    *ok = bsp_asset_decode(copy, src_len, dst, pixels, bpp);
+    free(copy);
+
+    bool guard_ok = true;
+    for (size_t i = 0; i < GUARD_BYTES; i++) {
+        guard_ok &= dst[bytes + i] == GUARD;
+    }
+    if (out) {
+        *out = dst;
+    } else {
+        free(dst);
+    }
+    return guard_ok;
+}
+
+/**
+ * Decode every tile of a blob and compare with the computed images, then damage each tile
+ */
+static void check_blob(const char* path) {
+    size_t size = 0;
+    uint8_t* blob = read_file(path, &size);
+    printf("  %s\n", path);
+    TEST_CHECK(blob != NULL);
+    if (blob == NULL) {
+        return;
+    }
+
+    bsp_asset_header_t header;
+    TEST_CHECK(size >= BSP_ASSET_HEADER_SIZE && bsp_asset_parse_header(blob, &header));
+    TEST_CHECK_EQ(header.count, 4);
+    unsigned seed = 23;
+    int wrong_pixels = 0;
+    int accepted_truncated = 0;
+    int guard_hits = 0;
+    int tiles_checked = 0;
+
+    for (uint16_t a = 0; a < header.count; a++) {
+        bsp_asset_entry_t entry;
+        TEST_CHECK(bsp_asset_parse_entry(blob + BSP_ASSET_HEADER_SIZE + a * BSP_ASSET_ENTRY_SIZE, &entry));
+        const uint8_t bpp = bsp_asset_bytes_per_pixel(entry.format);
+        const uint32_t mask = bpp == 2 ? 0xFFFF : 0xFFFFFF;
+        uint32_t* expected = fixture_pixels(entry.name, entry.width, entry.height, mask);
+        TEST_CHECK(expected != NULL);
+        TEST_CHECK_EQ(entry.tiles, (entry.height + header.tile_lines - 1) / header.tile_lines);
+        if (expected == NULL) {
+            continue;
+        }
+
+        for (uint16_t t = 0; t < entry.tiles; t++) {
+            const uint8_t* table = blob + entry.table_offset + 4U * t;
+            const uint32_t begin = rd32(table);
+            const uint32_t end = rd32(table + 4);
+            TEST_CHECK(begin <= end && end <= size && end - begin <= header.max_tile_bytes);
+            const uint32_t left = entry.height - (uint32_t)t * header.tile_lines;
+            const uint32_t lines = left < header.tile_lines ? left : header.tile_lines;
+            const size_t pixels = (size_t)lines * entry.width;
+            const uint8_t* tile = blob + begin;
+            const size_t tile_len = end - begin;
+
+            bool ok;
+            uint8_t* dst;
+            guard_hits += !decode_guarded(tile, tile_len, pixels, bpp, &ok, &dst);
+            TEST_CHECK(ok);
+            const uint32_t* want = expected + (size_t)t * header.tile_lines * entry.width;
+            for (size_t i = 0; i < pixels; i++) {
+                uint32_t px = 0;
+                memcpy(&px, dst + i * bpp, bpp);
+                wrong_pixels += px != want[i];
+            }
+            free(dst);
+            tiles_checked++;
+
+            // Every truncation is rejected
+            for (size_t len = 0; len < tile_len; len++) {
+                guard_hits += !decode_guarded(tile, len, pixels, bpp, &ok, NULL);
+                accepted_truncated += ok;
+            }
+
+            // Flipped bytes may still make a valid tile, but never one written past its end
+            uint8_t* corrupt = malloc(tile_len);
+            for (int r = 0; r < CORRUPT_RUNS; r++) {
+                memcpy(corrupt, tile, tile_len);
+                corrupt[test_rand(&seed) % tile_len] ^= (uint8_t)(1 + test_rand(&seed) % 255);
+                guard_hits += !decode_guarded(corrupt, tile_len, pixels, bpp, &ok, NULL);
+            }
+            free(corrupt);
+        }
+        free(expected);
+    }
+    printf("  %d tiles, %d wrong pixels, %d truncations accepted, %d guard hits\n", tiles_checked, wrong_pixels,
+           accepted_truncated, guard_hits);
+    TEST_CHECK(tiles_checked > 0);
+    TEST_CHECK_EQ(wrong_pixels, 0);
+    TEST_CHECK_EQ(accepted_truncated, 0);
+    TEST_CHECK_EQ(guard_hits, 0);
+    free(blob);
+}
+
+static const char** blob_paths;
+static int blob_count;
+
+static void test_packed_blobs(void) {
+    for (int i = 0; i < blob_count; i++) {
+        check_blob(blob_paths[i]);
+    }
+}
+
+/**
+ * Hand-made tiles around the length limits
+ */
+static void test_lengths(void) {
+    static const struct {
+        uint8_t src[8];
+        size_t len;
+        size_t pixels;
+        bool ok;
+    } cases[] = {
+        {{0x44}, 1, 5, true},                                   // Run of 5
+        {{0x44}, 1, 4, false},                                  // Run longer than the tile
+        {{0x44}, 1, 6, false},                                  // Tile ends a pixel short
+        {{0x44, 0x00}, 2, 5, false},                            // Bytes left after the last pixel
+        {{0xC0, 0x00}, 2, 65, true},                            // Shortest long run
+        {{0xC0, 0x00}, 2, 64, false},                           // Long run longer than the tile
+        {{0xFF, 0xFF}, 2, 1000, false},                         // Longest long run, 16447 pixels
+        {{0xC0}, 1, 100, false},                                // Long run without its count byte
+        {{0x81, 0x11, 0x22, 0x33, 0x44}, 5, 2, true},           // Two literal pixels
+        {{0x81, 0x11, 0x22, 0x33, 0x44}, 5, 1, false},          // Literal longer than the tile
+        {{0x82, 0x11, 0x22, 0x33, 0x44}, 5, 3, false},          // Literal bytes missing
+        {{0x00, 0x3F}, 2, 2, true},                             // Table entries, empty table
+        {{0}, 0, 1, false},                                     // Empty tile
+        {{0}, 0, 0, true},                                      // Empty tile of no pixels
+    };
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        bool ok;
+        TEST_CHECK(decode_guarded(cases[i].src, cases[i].len, cases[i].pixels, 2, &ok, NULL));
+        if (ok != cases[i].ok) {
+            fprintf(stderr, "case %zu decoded %s\n", i, ok ? "ok" : "failed");
+        }
+        TEST_CHECK(ok == cases[i].ok);
+    }
+
+    // The longest long run fills exactly its length
+    bool ok;
+    const uint8_t longest[2] = {0xFF, 0xFF};
+    TEST_CHECK(decode_guarded(longest, 2, 0x3FFF + 65, 3, &ok, NULL));
+    TEST_CHECK(ok);
+}
+
+static void test_header_and_entry(void) {
+    uint8_t raw[BSP_ASSET_HEADER_SIZE] = {'B', 'S', 'P', 'A', 1, 0, 2, 0, 16, 0, 0, 0, 0x10, 0x20, 0, 0};
+    bsp_asset_header_t header;
+    TEST_CHECK(bsp_asset_parse_header(raw, &header));
+    TEST_CHECK_EQ(header.count, 2);
+    TEST_CHECK_EQ(header.max_tile_bytes, 0x2010);
+    raw[4] = 2;
+    TEST_CHECK(!bsp_asset_parse_header(raw, &header));
+    raw[4] = 1;
+    raw[8] = 0;
+    TEST_CHECK(!bsp_asset_parse_header(raw, &header));
+
+    // A name filling all 20 bytes is terminated, an unknown format is rejected
+    uint8_t entry_raw[BSP_ASSET_ENTRY_SIZE];
+    memset(entry_raw, 'n', BSP_ASSET_NAME_LEN);
+    const uint8_t rest[12] = {10, 0, 20, 0, 1, 0, 2, 0, 0x40, 0, 0, 0};
+    memcpy(entry_raw + BSP_ASSET_NAME_LEN, rest, sizeof(rest));
+    bsp_asset_entry_t entry;
+    TEST_CHECK(bsp_asset_parse_entry(entry_raw, &entry));
+    TEST_CHECK_EQ(strlen(entry.name), BSP_ASSET_NAME_LEN);
+    TEST_CHECK_EQ(entry.tiles, 2);
+    TEST_CHECK_EQ(entry.table_offset, 0x40);
+    entry_raw[24] = 3;
+    TEST_CHECK(!bsp_asset_parse_entry(entry_raw, &entry));
+}
+
+int main(int argc, char** argv) {
+    static const char* fixtures[] = {TEST_ASSET_DIR "/codec_rgb565.bin", TEST_ASSET_DIR "/codec_rgb888.bin"};
+    blob_paths = argc > 1 ? (const char**)argv + 1 : fixtures;
+    blob_count = argc > 1 ? argc - 1 : 2;
+
+    TEST_RUN(test_header_and_entry);
+    TEST_RUN(test_lengths);
+    TEST_RUN(test_packed_blobs);
+    return test_failures;
+}
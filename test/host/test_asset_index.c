@@ -0,0 +1,256 @@
+/*
+ * Index of the flash asset partition against tools/bsp_flash_assets.py
+ *
+ * assets/index.bin is built by the tool from computed assets (see make_index_fixture.py). The C index must open
+ * it, find every asset by name with the geometry and bytes the tool wrote, and find nothing else. Another image
+ * can be passed on the command line, the host tests pass a freshly built copy.
+ *
+ * Every byte of the header and the entries is then changed in turn, and the image truncated at every length,
+ * and each such image must be rejected. Entries that carry a valid CRC but break a rule of the layout, such as
+ * order, bounds, alignment or image geometry, must be rejected too.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "bsp_asset_index.h"
+#include "test_common.h"
+
+typedef struct {
+    const char* name;
+    uint8_t kind;
+    uint8_t format;
+    uint16_t width;
+    uint16_t height;
+    uint32_t size;
+    uint8_t seed;
+} fixture_t;
+
+// Kept in step with assets() in make_index_fixture.py
+static const fixture_t fixtures[] = {
+    {"logo", BSP_ASSET_KIND_IMAGE, BSP_ASSET_PIXEL_RGB565, 20, 10, 20 * 10 * 2, 1},
+    {"photo", BSP_ASSET_KIND_IMAGE, BSP_ASSET_PIXEL_RGB888, 5, 3, 5 * 3 * 3, 2},
+    {"icon", BSP_ASSET_KIND_IMAGE, BSP_ASSET_PIXEL_ARGB8888, 8, 8, 8 * 8 * 4, 3},
+    {"Montserrat", BSP_ASSET_KIND_FONT, BSP_ASSET_PIXEL_NONE, 0, 0, 1000, 4},
+    {"a", BSP_ASSET_KIND_DATA, BSP_ASSET_PIXEL_NONE, 0, 0, 1, 5},
+    {"abcdefghijklmnopqrstuvwx", BSP_ASSET_KIND_DATA, BSP_ASSET_PIXEL_NONE, 0, 0, 33, 6},
+    {"empty", BSP_ASSET_KIND_DATA, BSP_ASSET_PIXEL_NONE, 0, 0, 0, 7},
+};
+#define FIXTURES    (sizeof(fixtures) / sizeof(fixtures[0]))
+
+static const char* image_path = TEST_ASSET_DIR "/index.bin";
+
+static uint8_t* read_file(const char* path, size_t* size) {
+    FILE* f = fopen(path, "rb");
+    if (f == NULL) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    *size = (size_t)ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t* data = malloc(*size);
+    if (fread(data, 1, *size, f) != *size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    return data;
+}
+
+static uint8_t asset_byte(uint8_t seed, uint32_t i) {
+    return (uint8_t)(seed + i * 7);
+}
+
+static void wr32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t entries_size(const uint8_t* image) {
+    return (uint32_t)(image[6] | (image[7] << 8)) * BSP_ASSET_INDEX_ENTRY_SIZE;
+}
+
+/**
+ * Recompute the CRC of the entries, so a change to an entry reaches the checks behind it
+ */
+static void fix_crc(uint8_t* image) {
+    wr32(image + 12, bsp_asset_index_crc32(image + BSP_ASSET_INDEX_HEADER_SIZE, entries_size(image)));
+}
+
+static void test_crc(void) {
+    const char* check = "123456789";
+    TEST_CHECK_EQ(bsp_asset_index_crc32((const uint8_t*)check, strlen(check)), 0xCBF43926U);
+    TEST_CHECK_EQ(bsp_asset_index_crc32(NULL, 0), 0);
+}
+
+static void test_lookup(void) {
+    size_t size = 0;
+    uint8_t* image = read_file(image_path, &size);
+    printf("  %s\n", image_path);
+    TEST_CHECK(image != NULL);
+    if (image == NULL) {
+        return;
+    }
+
+    bsp_asset_index_t index;
+    TEST_CHECK(bsp_asset_index_open(image, size, &index));
+    TEST_CHECK_EQ(index.count, FIXTURES);
+    TEST_CHECK_EQ(index.image_size, size);
+
+    int wrong_bytes = 0;
+    for (size_t i = 0; i < FIXTURES; i++) {
+        const fixture_t* fx = &fixtures[i];
+        bsp_asset_index_entry_t entry;
+        const bool found = bsp_asset_index_find(&index, fx->name, &entry);
+        TEST_CHECK(found);
+        if (!found) {
+            fprintf(stderr, "%s not found\n", fx->name);
+            continue;
+        }
+        TEST_CHECK(strcmp(entry.name, fx->name) == 0);
+        TEST_CHECK_EQ(entry.kind, fx->kind);
+        TEST_CHECK_EQ(entry.format, fx->format);
+        TEST_CHECK_EQ(entry.width, fx->width);
+        TEST_CHECK_EQ(entry.height, fx->height);
+        TEST_CHECK_EQ(entry.size, fx->size);
+        TEST_CHECK_EQ(entry.offset % BSP_ASSET_INDEX_ALIGN, 0);
+        if (fx->kind == BSP_ASSET_KIND_IMAGE) {
+            TEST_CHECK_EQ(entry.stride * entry.height, entry.size);
+        }
+        for (uint32_t b = 0; b < entry.size; b++) {
+            wrong_bytes += image[entry.offset + b] != asset_byte(fx->seed, b);
+        }
+    }
+    TEST_CHECK_EQ(wrong_bytes, 0);
+
+    // Entries come sorted by bytes, so upper case before lower case
+    bsp_asset_index_entry_t entry;
+    bsp_asset_index_entry(&index, 0, &entry);
+    TEST_CHECK(strcmp(entry.name, "Montserrat") == 0);
+
+    // Prefixes, extensions, case and names longer than an entry can hold are not found
+    static const char* const missing[] = {"", "log", "logo2", "LOGO", "montserrat", "b", "zzz",
+                                          "abcdefghijklmnopqrstuvw", "abcdefghijklmnopqrstuvwxy"};
+    for (size_t i = 0; i < sizeof(missing) / sizeof(missing[0]); i++) {
+        const bool found = bsp_asset_index_find(&index, missing[i], &entry);
+        if (found) {
+            fprintf(stderr, "\"%s\" found\n", missing[i]);
+        }
+        TEST_CHECK(!found);
+    }
+    free(image);
+}
+
+static void test_damaged(void) {
+    size_t size = 0;
+    uint8_t* image = read_file(image_path, &size);
+    TEST_CHECK(image != NULL);
+    if (image == NULL) {
+        return;
+    }
+    uint8_t* copy = malloc(size);
+    bsp_asset_index_t index;
+
+    // Any change to the header or the entries
+    const size_t index_end = BSP_ASSET_INDEX_HEADER_SIZE + entries_size(image);
+    int accepted = 0;
+    for (size_t i = 0; i < index_end; i++) {
+        for (int bit = 0; bit < 8; bit++) {
+            memcpy(copy, image, size);
+            copy[i] ^= (uint8_t)(1U << bit);
+            accepted += bsp_asset_index_open(copy, size, &index);
+        }
+    }
+    TEST_CHECK_EQ(accepted, 0);
+
+    // Any image shorter than it says, and one without room for its entries
+    accepted = 0;
+    for (size_t len = 0; len < size; len++) {
+        accepted += bsp_asset_index_open(image, len, &index);
+    }
+    TEST_CHECK_EQ(accepted, 0);
+    memcpy(copy, image, size);
+    wr32(copy + 8, (uint32_t)index_end - 1);
+    TEST_CHECK(!bsp_asset_index_open(copy, size, &index));
+
+    // Asset data is not covered, it is used in place as it is
+    memcpy(copy, image, size);
+    copy[size - 1] ^= 0xFF;
+    TEST_CHECK(bsp_asset_index_open(copy, size, &index));
+
+    free(copy);
+    free(image);
+}
+
+/**
+ * Entries with a valid CRC that break one rule each. Entry 0 is "Montserrat", then "a", then
+ * "abcdefghijklmnopqrstuvwx", "empty", "icon", "logo" and "photo".
+ */
+static void test_rules(void) {
+    size_t size = 0;
+    uint8_t* image = read_file(image_path, &size);
+    TEST_CHECK(image != NULL);
+    if (image == NULL) {
+        return;
+    }
+    uint8_t* copy = malloc(size);
+    bsp_asset_index_t index;
+
+    enum { NAME = 0, KIND = 24, FORMAT = 25, WIDTH = 26, STRIDE = 32, OFFSET = 36, SIZE = 40 };
+    static const struct {
+        const char* what;
+        uint32_t entry;
+        uint32_t field;
+        uint32_t value;
+        uint32_t bytes;
+    } cases[] = {
+        {"empty name", 1, NAME, 0, 1},
+        {"names out of order", 1, NAME, 'z', 1},
+        {"same name twice", 2, NAME + 1, 0, 1},
+        {"offset inside the index", 0, OFFSET, BSP_ASSET_INDEX_HEADER_SIZE, 4},
+        {"offset not aligned", 0, OFFSET, 0x168, 4},
+        {"data past the end", 6, SIZE, 0x1000, 4},
+        {"size wrapping around", 0, SIZE, 0xFFFFFFF0U, 4},
+        {"unknown kind", 1, KIND, 3, 1},
+        {"image without format", 4, FORMAT, BSP_ASSET_PIXEL_NONE, 1},
+        {"unknown format", 4, FORMAT, 4, 1},
+        {"image of no width", 4, WIDTH, 0, 2},
+        {"stride shorter than a line", 4, STRIDE, 8 * 4 - 1, 4},
+        {"size not stride times height", 5, SIZE, 20 * 10 * 2 - 2, 4},
+    };
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        memcpy(copy, image, size);
+        uint8_t* field = copy + BSP_ASSET_INDEX_HEADER_SIZE + cases[i].entry * BSP_ASSET_INDEX_ENTRY_SIZE +
+                         cases[i].field;
+        for (uint32_t b = 0; b < cases[i].bytes; b++) {
+            field[b] = (uint8_t)(cases[i].value >> (8 * b));
+        }
+        fix_crc(copy);
+        const bool ok = bsp_asset_index_open(copy, size, &index);
+        if (ok) {
+            fprintf(stderr, "%s accepted\n", cases[i].what);
+        }
+        TEST_CHECK(!ok);
+    }
+
+    // Recomputing the CRC alone changes nothing, so each case above fails on its own rule
+    memcpy(copy, image, size);
+    fix_crc(copy);
+    TEST_CHECK(bsp_asset_index_open(copy, size, &index));
+
+    free(copy);
+    free(image);
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1) {
+        image_path = argv[1];
+    }
+    TEST_RUN(test_crc);
+    TEST_RUN(test_lookup);
+    TEST_RUN(test_damaged);
+    TEST_RUN(test_rules);
+    return test_failures;
+}
@@ -0,0 +1,200 @@
+/*
+ * Pixel format conversion of the flush stage
+ *
+ * Every kernel is compared with a plain per-pixel reference, at all source and destination alignments, with
+ * lengths around the unrolled block sizes, and in place where the flush stage runs it in place. Throughput per
+ * 450x600 frame is printed as BENCH lines.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "bsp_color.h"
+#include "test_common.h"
+
+#define MAX_PIXELS      (67)
+#define FRAME_PIXELS    (450 * 600)
+#define BENCH_FRAMES    (20)
+
+static const uint8_t bayer_ref[4][4] = {
+    {0, 8, 2, 10},
+    {12, 4, 14, 6},
+    {3, 11, 1, 9},
+    {15, 7, 13, 5},
+};
+
+static uint8_t sat_add(uint8_t c, uint32_t t) {
+    return c + t > 0xFF ? 0xFF : (uint8_t)(c + t);
+}
+
+/**
+ * One pixel of bsp_color_to_rgb565() written out channel by channel, source bytes are B, G, R
+ */
+static uint16_t ref_to_rgb565(const uint8_t* s, int32_t x, int32_t y, bool dither) {
+    const uint32_t t = dither ? bayer_ref[y & 3][x & 3] : 0;
+    const uint8_t b = sat_add(s[0], t >> 1);
+    const uint8_t g = sat_add(s[1], t >> 2);
+    const uint8_t r = sat_add(s[2], t >> 1);
+    return (uint16_t)(((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3));
+}
+
+static void fill_random(uint8_t* buf, size_t len, unsigned* seed) {
+    for (size_t i = 0; i < len; i++) {
+        buf[i] = (uint8_t)test_rand(seed);
+    }
+    // Keep saturating values in every run
+    if (len > 8) {
+        memset(buf, 0xFF, 6);
+    }
+}
+
+static void test_swap_rgb565(void) {
+    unsigned seed = 7;
+    uint8_t src[MAX_PIXELS * 2 + 8];
+    uint8_t dst[MAX_PIXELS * 2 + 8];
+    uint8_t ref[MAX_PIXELS * 2];
+
+    for (size_t count = 0; count <= MAX_PIXELS; count++) {
+        for (int so = 0; so < 4; so++) {
+            for (int doff = 0; doff < 4; doff++) {
+                fill_random(src, sizeof(src), &seed);
+                for (size_t i = 0; i < count; i++) {
+                    ref[2 * i] = src[so + 2 * i + 1];
+                    ref[2 * i + 1] = src[so + 2 * i];
+                }
+                memset(dst, 0xEE, sizeof(dst));
+                bsp_color_swap_rgb565(src + so, dst + doff, count);
+                TEST_CHECK(memcmp(dst + doff, ref, count * 2) == 0);
+                // Nothing written past the last pixel
+                TEST_CHECK(dst[doff + count * 2] == 0xEE);
+
+                // In place
+                bsp_color_swap_rgb565(src + so, src + so, count);
+                TEST_CHECK(memcmp(src + so, ref, count * 2) == 0);
+            }
+        }
+    }
+}
+
+static void test_pack_xrgb8888(void) {
+    unsigned seed = 11;
+    uint8_t src[MAX_PIXELS * 4 + 8];
+    uint8_t dst[MAX_PIXELS * 4 + 8];
+    uint8_t ref[MAX_PIXELS * 3];
+
+    for (size_t count = 0; count <= MAX_PIXELS; count++) {
+        for (int so = 0; so < 4; so++) {
+            for (int doff = 0; doff < 4; doff++) {
+                fill_random(src, sizeof(src), &seed);
+                for (size_t i = 0; i < count; i++) {
+                    memcpy(&ref[3 * i], &src[so + 4 * i], 3);
+                }
+                memset(dst, 0xEE, sizeof(dst));
+                bsp_color_pack_xrgb8888(src + so, dst + doff, count);
+                TEST_CHECK(memcmp(dst + doff, ref, count * 3) == 0);
+                TEST_CHECK(dst[doff + count * 3] == 0xEE);
+
+                // In place, the destination starts at the source
+                bsp_color_pack_xrgb8888(src + so, src + so, count);
+                TEST_CHECK(memcmp(src + so, ref, count * 3) == 0);
+            }
+        }
+    }
+}
+
+static void test_to_rgb565(void) {
+    unsigned seed = 13;
+    uint8_t src[MAX_PIXELS * 4 + 8];
+    uint8_t dst[MAX_PIXELS * 2 + 8];
+    uint8_t ref[MAX_PIXELS * 2];
+    int failures = 0;
+
+    for (uint32_t bpp = 3; bpp <= 4; bpp++) {
+        for (int flags = 0; flags < 4; flags++) {
+            const bool swap = flags & 1;
+            const bool dither = flags & 2;
+            for (size_t count = 0; count <= MAX_PIXELS; count++) {
+                for (int so = 0; so < 4; so++) {
+                    const int32_t x = (int32_t)test_rand(&seed) % 450;
+                    const int32_t y = (int32_t)test_rand(&seed) % 600;
+                    fill_random(src, sizeof(src), &seed);
+                    for (size_t i = 0; i < count; i++) {
+                        const uint16_t p = ref_to_rgb565(&src[so + bpp * i], x + (int32_t)i, y, dither);
+                        ref[2 * i] = (uint8_t)(swap ? p >> 8 : p);
+                        ref[2 * i + 1] = (uint8_t)(swap ? p : p >> 8);
+                    }
+
+                    for (int doff = 0; doff < 4; doff++) {
+                        memset(dst, 0xEE, sizeof(dst));
+                        bsp_color_to_rgb565(src + so, bpp, dst + doff, count, x, y, swap, dither);
+                        failures += memcmp(dst + doff, ref, count * 2) != 0;
+                        failures += dst[doff + count * 2] != 0xEE;
+                    }
+
+                    // In place, as the flush stage converts the draw buffer
+                    bsp_color_to_rgb565(src + so, bpp, src + so, count, x, y, swap, dither);
+                    failures += memcmp(src + so, ref, count * 2) != 0;
+                }
+            }
+        }
+    }
+    TEST_CHECK_EQ(failures, 0);
+}
+
+static void test_convert_dispatch(void) {
+    uint8_t src[12] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+    uint8_t dst[12];
+
+    const bsp_color_conv_t copy = {.src_bytes_per_pixel = 3, .dst_bytes_per_pixel = 3};
+    TEST_CHECK(bsp_color_conv_is_copy(&copy));
+    bsp_color_convert(&copy, src, dst, 4, 0, 0);
+    TEST_CHECK(memcmp(src, dst, 12) == 0);
+
+    const bsp_color_conv_t swap = {.src_bytes_per_pixel = 2, .dst_bytes_per_pixel = 2, .swap_bytes = true};
+    TEST_CHECK(!bsp_color_conv_is_copy(&swap));
+    bsp_color_convert(&swap, src, dst, 2, 0, 0);
+    TEST_CHECK(dst[0] == 2 && dst[1] == 1 && dst[2] == 4 && dst[3] == 3);
+
+    const bsp_color_conv_t pack = {.src_bytes_per_pixel = 4, .dst_bytes_per_pixel = 3};
+    bsp_color_convert(&pack, src, dst, 3, 0, 0);
+    TEST_CHECK(dst[2] == 3 && dst[3] == 5 && dst[6] == 9 && dst[8] == 11);
+}
+
+static void bench(const char* name, const bsp_color_conv_t* conv) {
+    uint8_t* src = malloc((size_t)FRAME_PIXELS * conv->src_bytes_per_pixel);
+    uint8_t* dst = malloc((size_t)FRAME_PIXELS * conv->dst_bytes_per_pixel);
+    unsigned seed = 17;
+    fill_random(src, (size_t)FRAME_PIXELS * conv->src_bytes_per_pixel, &seed);
+
+    // Line by line, like the flush stage
+    double best = 0;
+    for (int f = 0; f < BENCH_FRAMES; f++) {
+        const double start = test_now_us();
+        for (int32_t y = 0; y < 600; y++) {
+            bsp_color_convert(conv, src + (size_t)y * 450 * conv->src_bytes_per_pixel,
+                              dst + (size_t)y * 450 * conv->dst_bytes_per_pixel, 450, 0, y);
+        }
+        const double us = test_now_us() - start;
+        best = f == 0 || us < best ? us : best;
+    }
+    printf("BENCH,%s,%.2f,us\n", name, best);
+    free(src);
+    free(dst);
+}
+
+static void test_bench(void) {
+    bench("swap rgb565", &(bsp_color_conv_t){.src_bytes_per_pixel = 2, .dst_bytes_per_pixel = 2,
+                                             .swap_bytes = true});
+    bench("pack xrgb8888", &(bsp_color_conv_t){.src_bytes_per_pixel = 4, .dst_bytes_per_pixel = 3});
+    bench("rgb888 to rgb565", &(bsp_color_conv_t){.src_bytes_per_pixel = 3, .dst_bytes_per_pixel = 2});
+    bench("rgb888 to rgb565 dither", &(bsp_color_conv_t){.src_bytes_per_pixel = 3, .dst_bytes_per_pixel = 2,
+                                                         .dither = true});
+}
+
+int main(void) {
+    TEST_RUN(test_swap_rgb565);
+    TEST_RUN(test_pack_xrgb8888);
+    TEST_RUN(test_to_rgb565);
+    TEST_RUN(test_convert_dispatch);
+    TEST_RUN(test_bench);
+    return test_failures;
+}
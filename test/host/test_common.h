@@ -0,0 +1,54 @@
+/**
+ * @file
+ * @brief Minimal check macros shared by the host tests
+ *
+ * Each test is a plain executable that runs its cases from main() and returns the number of failed checks,
+ * so ctest reports it as failed as soon as one check does not hold.
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include <time.h>
+
+static int test_failures;
+
+#define TEST_CHECK(cond)                                                                    \
+    do {                                                                                    \
+        if (!(cond)) {                                                                      \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);        \
+            test_failures++;                                                                \
+        }                                                                                   \
+    } while (0)
+
+#define TEST_CHECK_EQ(actual, expected)                                                     \
+    do {                                                                                    \
+        const long long test_a = (long long)(actual);                                       \
+        const long long test_e = (long long)(expected);                                     \
+        if (test_a != test_e) {                                                             \
+            fprintf(stderr, "%s:%d: %s is %lld, expected %lld\n", __FILE__, __LINE__, #actual, \
+                    test_a, test_e);                                                        \
+            test_failures++;                                                                \
+        }                                                                                   \
+    } while (0)
+
+#define TEST_RUN(fn)                                                                        \
+    do {                                                                                    \
+        const int test_before = test_failures;                                              \
+        fn();                                                                               \
+        printf("%-40s %s\n", #fn, test_failures == test_before ? "ok" : "FAILED");          \
+    } while (0)
+
+static inline double test_now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec / 1e3;
+}
+
+/**
+ * Small deterministic generator, so every run sees the same "random" input
+ */
+static inline unsigned test_rand(unsigned* state) {
+    *state = *state * 1103515245U + 12345U;
+    return (*state >> 16) & 0x7FFFU;
+}
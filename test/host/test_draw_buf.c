@@ -0,0 +1,191 @@
+/*
+ * Draw buffer geometry of bsp_display_start()
+ *
+ * The screen, bus and alignment are those of the T4 S3 with RGB565 and double buffering. Heights are rounded and
+ * clamped to whole aligned stripes, a budget picks the fewest flushes, then the fewest transactions, then the
+ * lowest height among all heights that fit, and a budget wins over lines, which win over a pixel count. Every
+ * buffer the BSP derives from BSP_LCD_DRAW_BUFF_LINES or BSP_LCD_DRAW_BUFF_SIZE must hold whole aligned lines.
+ */
+
+#include "bsp_draw_buf.h"
+#include "test_common.h"
+
+/* BSP_LCD_H_RES, BSP_LCD_V_RES, BSP_LCD_DRAW_BUFF_ALIGN and BSP_LCD_SPI_MAX_TRANS_SZ */
+#define SCREEN_W        (450)
+#define SCREEN_H        (600)
+#define ALIGN           (2)
+#define MAX_TRANS       (32768)
+
+static const bsp_draw_buf_cfg_t buf_cfg = {
+    .width = SCREEN_W,
+    .height = SCREEN_H,
+    .bytes_per_pixel = 2,
+    .wire_bytes_per_pixel = 2,
+    .buffers = 2,
+    .align = ALIGN,
+    .max_trans_bytes = MAX_TRANS,
+};
+
+static void test_eval(void) {
+    bsp_draw_buf_geom_t geom;
+
+    // The default of a tenth of the screen: 54000 bytes a stripe in two transactions of 27000
+    bsp_draw_buf_eval(&buf_cfg, SCREEN_H / 10, &geom);
+    TEST_CHECK_EQ(geom.lines, 60);
+    TEST_CHECK_EQ(geom.bytes, 60 * SCREEN_W * 2 * 2);
+    TEST_CHECK_EQ(geom.flushes, 10);
+    TEST_CHECK_EQ(geom.transactions, 20);
+    TEST_CHECK_EQ(geom.trans_bytes, 27000);
+
+    // Rounded down to the alignment, and clamped to one stripe and to the screen
+    bsp_draw_buf_eval(&buf_cfg, 61, &geom);
+    TEST_CHECK_EQ(geom.lines, 60);
+    bsp_draw_buf_eval(&buf_cfg, 0, &geom);
+    TEST_CHECK_EQ(geom.lines, ALIGN);
+    bsp_draw_buf_eval(&buf_cfg, 1, &geom);
+    TEST_CHECK_EQ(geom.lines, ALIGN);
+    bsp_draw_buf_eval(&buf_cfg, 10000, &geom);
+    TEST_CHECK_EQ(geom.lines, SCREEN_H);
+    TEST_CHECK_EQ(geom.flushes, 1);
+
+    // A short last stripe of an odd screen still takes a whole aligned window
+    bsp_draw_buf_cfg_t odd = buf_cfg;
+    odd.height = SCREEN_H - 1;
+    bsp_draw_buf_eval(&odd, 10000, &geom);
+    TEST_CHECK_EQ(geom.lines, SCREEN_H);
+    TEST_CHECK_EQ(geom.flushes, 1);
+
+    // Transaction sizes stay word-aligned and within the bus limit
+    int failures = 0;
+    for (uint32_t lines = 1; lines <= SCREEN_H; lines++) {
+        bsp_draw_buf_eval(&buf_cfg, lines, &geom);
+        failures += geom.trans_bytes % 4 != 0 || geom.trans_bytes > MAX_TRANS || geom.lines % ALIGN != 0;
+    }
+    TEST_CHECK_EQ(failures, 0);
+}
+
+/**
+ * Best geometry by brute force over every height that fits
+ */
+static void best_fit(size_t budget, size_t max_buffer, bsp_draw_buf_geom_t* best) {
+    best->lines = 0;
+    for (uint32_t lines = ALIGN; lines <= SCREEN_H; lines += ALIGN) {
+        bsp_draw_buf_geom_t geom;
+        bsp_draw_buf_eval(&buf_cfg, lines, &geom);
+        if (geom.bytes > budget || geom.bytes / buf_cfg.buffers > max_buffer) {
+            continue;
+        }
+        if (best->lines == 0 || geom.flushes < best->flushes ||
+            (geom.flushes == best->flushes && geom.transactions < best->transactions)) {
+            *best = geom;
+        }
+    }
+}
+
+static void test_tune(void) {
+    bsp_draw_buf_geom_t geom;
+
+    // The Kconfig default budget: 50 to 54 lines take 12 flushes, 54 leave a last stripe of one transaction
+    TEST_CHECK(bsp_draw_buf_tune(&buf_cfg, 96 * 1024, SIZE_MAX, &geom));
+    TEST_CHECK_EQ(geom.lines, 54);
+    TEST_CHECK_EQ(geom.flushes, 12);
+    TEST_CHECK_EQ(geom.transactions, 23);
+
+    // 110 lines fit and take 4 transactions a stripe, 106 lines the same 6 flushes with 3, and 2 for the last
+    TEST_CHECK(bsp_draw_buf_tune(&buf_cfg, 110 * SCREEN_W * 2 * 2, SIZE_MAX, &geom));
+    TEST_CHECK_EQ(geom.lines, 106);
+    TEST_CHECK_EQ(geom.flushes, 6);
+    TEST_CHECK_EQ(geom.transactions, 17);
+
+    // The largest free block limits a single buffer
+    TEST_CHECK(bsp_draw_buf_tune(&buf_cfg, 96 * 1024, 20 * SCREEN_W * 2, &geom));
+    TEST_CHECK(geom.lines <= 20);
+
+    // A budget above a full frame stops at the screen height
+    TEST_CHECK(bsp_draw_buf_tune(&buf_cfg, 4 * 1024 * 1024, SIZE_MAX, &geom));
+    TEST_CHECK_EQ(geom.lines, SCREEN_H);
+
+    // Not even one aligned stripe
+    TEST_CHECK(!bsp_draw_buf_tune(&buf_cfg, ALIGN * SCREEN_W * 2 * 2 - 1, SIZE_MAX, &geom));
+    TEST_CHECK(!bsp_draw_buf_tune(&buf_cfg, 1024 * 1024, ALIGN * SCREEN_W * 2 - 1, &geom));
+
+    // Against brute force: the same flushes and transactions, at the lowest such height
+    unsigned seed = 7;
+    int failures = 0;
+    for (int i = 0; i < 2000; i++) {
+        const size_t budget = ALIGN * SCREEN_W * 2 * 2 + (size_t)test_rand(&seed) * 40;
+        const size_t max_buffer = (i & 1) ? SIZE_MAX : budget / 2 - (size_t)test_rand(&seed) % 4096;
+        bsp_draw_buf_geom_t best;
+        best_fit(budget, max_buffer, &best);
+        if (best.lines == 0) {
+            failures += bsp_draw_buf_tune(&buf_cfg, budget, max_buffer, &geom);
+            continue;
+        }
+        if (!bsp_draw_buf_tune(&buf_cfg, budget, max_buffer, &geom) || geom.flushes != best.flushes ||
+            geom.transactions != best.transactions || geom.lines > best.lines || geom.bytes > budget) {
+            if (failures++ < 5) {
+                fprintf(stderr, "budget %zu: %lu lines, brute force %lu\n", budget, (unsigned long)geom.lines,
+                        (unsigned long)best.lines);
+            }
+        }
+    }
+    TEST_CHECK_EQ(failures, 0);
+}
+
+static void test_select(void) {
+    bsp_draw_buf_geom_t geom;
+
+    // A budget wins over lines and pixels
+    bsp_draw_buf_req_t req = {.budget = 96 * 1024, .max_buffer = SIZE_MAX, .lines = 100, .pixels = SCREEN_W * 10};
+    TEST_CHECK(bsp_draw_buf_select(&buf_cfg, &req, &geom));
+    TEST_CHECK_EQ(geom.lines, 54);
+
+    // Lines win over pixels
+    req.budget = 0;
+    TEST_CHECK(bsp_draw_buf_select(&buf_cfg, &req, &geom));
+    TEST_CHECK_EQ(geom.lines, 100);
+
+    // Pixels are rounded down to whole aligned lines
+    req.lines = 0;
+    req.pixels = SCREEN_W * 61 + 17;
+    TEST_CHECK(bsp_draw_buf_select(&buf_cfg, &req, &geom));
+    TEST_CHECK_EQ(geom.lines, 60);
+    req.pixels = 100;
+    TEST_CHECK(bsp_draw_buf_select(&buf_cfg, &req, &geom));
+    TEST_CHECK_EQ(geom.lines, ALIGN);
+
+    // A budget too small falls back to the smallest buffer, not to lines or pixels
+    req = (bsp_draw_buf_req_t){.budget = 1000, .max_buffer = SIZE_MAX, .lines = 100, .pixels = SCREEN_W * 60};
+    TEST_CHECK(!bsp_draw_buf_select(&buf_cfg, &req, &geom));
+    TEST_CHECK_EQ(geom.lines, ALIGN);
+}
+
+/**
+ * BSP_LCD_DRAW_BUFF_SIZE is BSP_LCD_H_RES * BSP_LCD_DRAW_BUFF_LINES. Whatever the lines, the buffer handed to
+ * LVGL must be whole aligned lines no larger than asked for, so every stripe is a window the panel accepts.
+ */
+static void test_draw_buff_size(void) {
+    int failures = 0;
+    for (uint32_t lines = ALIGN; lines <= SCREEN_H; lines++) {
+        const bsp_draw_buf_req_t by_lines = {.lines = lines, .pixels = SCREEN_W * (SCREEN_H / 10)};
+        const bsp_draw_buf_req_t by_size = {.pixels = SCREEN_W * lines};
+        bsp_draw_buf_geom_t a;
+        bsp_draw_buf_geom_t b;
+        bsp_draw_buf_select(&buf_cfg, &by_lines, &a);
+        bsp_draw_buf_select(&buf_cfg, &by_size, &b);
+        failures += a.lines != b.lines;
+        failures += a.lines % ALIGN != 0 || a.lines > lines || lines - a.lines >= ALIGN;
+    }
+    TEST_CHECK_EQ(failures, 0);
+
+    // The default lines, and with them the default size, are aligned already
+    TEST_CHECK_EQ((SCREEN_H / 10) % ALIGN, 0);
+}
+
+int main(void) {
+    TEST_RUN(test_eval);
+    TEST_RUN(test_tune);
+    TEST_RUN(test_select);
+    TEST_RUN(test_draw_buff_size);
+    return test_failures;
+}
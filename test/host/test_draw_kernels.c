@@ -0,0 +1,205 @@
+/*
+ * Fill and copy kernels of the BSP draw unit
+ *
+ * Fills are compared with a per-pixel memcpy() reference, and with memset() where the pixel is one repeated
+ * byte, at every destination alignment and with lengths around the unrolled block sizes. Copies are compared
+ * with memcpy() line by line, for contiguous and strided buffers. Nothing may be written outside the
+ * rectangle. Their cost on a draw buffer stripe is printed as BENCH lines next to the plain loops they replace.
+ */
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bsp_draw_kernels.h"
+#include "test_common.h"
+
+#define MAX_PIXELS      (67)
+#define GUARD           (0xEE)
+#define STRIPE_W        (450)
+#define STRIPE_H        (60)
+#define BENCH_RUNS      (200)
+
+static void test_fill_line(void) {
+    static const uint8_t pixels[3][4] = {{0x12, 0x34, 0x56, 0x78}, {0xAB, 0xCD, 0xEF, 0x01}, {0x80, 0x01, 0xFE, 0x7F}};
+    uint8_t dst[MAX_PIXELS * 4 + 16];
+    uint8_t ref[MAX_PIXELS * 4 + 16];
+    int failures = 0;
+
+    for (uint8_t bpp = 2; bpp <= 4; bpp++) {
+        for (size_t p = 0; p < 3; p++) {
+            for (size_t count = 0; count <= MAX_PIXELS; count++) {
+                for (size_t off = 0; off < 4; off++) {
+                    memset(dst, GUARD, sizeof(dst));
+                    memset(ref, GUARD, sizeof(ref));
+                    for (size_t i = 0; i < count; i++) {
+                        memcpy(&ref[off + i * bpp], pixels[p], bpp);
+                    }
+                    bsp_draw_fill_line(dst + off, count, pixels[p], bpp);
+                    // The guard bytes around the line are part of the comparison
+                    failures += memcmp(dst, ref, sizeof(dst)) != 0;
+                }
+            }
+        }
+    }
+    TEST_CHECK_EQ(failures, 0);
+}
+
+static void test_fill_matches_memset(void) {
+    uint8_t dst[MAX_PIXELS * 4 + 8];
+    uint8_t ref[MAX_PIXELS * 4 + 8];
+    int failures = 0;
+
+    for (uint8_t bpp = 2; bpp <= 4; bpp++) {
+        const uint8_t pixel[4] = {0x5A, 0x5A, 0x5A, 0x5A};
+        for (size_t count = 0; count <= MAX_PIXELS; count++) {
+            for (size_t off = 0; off < 4; off++) {
+                memset(dst, 0, sizeof(dst));
+                memset(ref, 0, sizeof(ref));
+                memset(ref + off, 0x5A, count * bpp);
+                bsp_draw_fill_line(dst + off, count, pixel, bpp);
+                failures += memcmp(dst, ref, sizeof(dst)) != 0;
+            }
+        }
+    }
+    TEST_CHECK_EQ(failures, 0);
+}
+
+static void test_fill_rect(void) {
+    const uint8_t pixel[3] = {0x11, 0x22, 0x33};
+    const int32_t w = 37;
+    const int32_t h = 9;
+    for (uint8_t bpp = 2; bpp <= 3; bpp++) {
+        const uint32_t stride = (uint32_t)w * bpp + 6;
+        uint8_t* dst = malloc(stride * (h + 1));
+        memset(dst, GUARD, stride * (h + 1));
+        bsp_draw_fill(dst + 1, stride, w, h, pixel, bpp);
+
+        int wrong = 0;
+        for (int32_t y = 0; y <= h; y++) {
+            for (uint32_t b = 0; b < stride; b++) {
+                const uint8_t got = dst[y * stride + b];
+                const bool inside = y < h && b >= 1 && b < 1 + (uint32_t)w * bpp;
+                wrong += got != (inside ? pixel[(b - 1) % bpp] : GUARD);
+            }
+        }
+        TEST_CHECK_EQ(wrong, 0);
+
+        // Empty rectangles write nothing
+        memset(dst, GUARD, stride);
+        bsp_draw_fill(dst, stride, 0, h, pixel, bpp);
+        bsp_draw_fill(dst, stride, w, 0, pixel, bpp);
+        TEST_CHECK(dst[0] == GUARD && dst[stride - 1] == GUARD);
+        free(dst);
+    }
+}
+
+static void test_copy(void) {
+    unsigned seed = 19;
+    const int32_t h = 11;
+    static const size_t line_bytes[] = {1, 2, 3, 31, 64, 900};
+    static const uint32_t pads[] = {0, 0, 2, 5};  // Destination, source: both contiguous, then strided
+
+    for (size_t l = 0; l < sizeof(line_bytes) / sizeof(line_bytes[0]); l++) {
+        for (size_t p = 0; p + 1 < sizeof(pads) / sizeof(pads[0]); p++) {
+            const size_t len = line_bytes[l];
+            const uint32_t dst_stride = (uint32_t)len + pads[p];
+            const uint32_t src_stride = (uint32_t)len + pads[p + 1];
+            uint8_t* src = malloc((size_t)src_stride * h);
+            uint8_t* dst = malloc((size_t)dst_stride * h + 1);
+            uint8_t* ref = malloc((size_t)dst_stride * h + 1);
+            for (size_t i = 0; i < (size_t)src_stride * h; i++) {
+                src[i] = (uint8_t)test_rand(&seed);
+            }
+            memset(dst, GUARD, (size_t)dst_stride * h + 1);
+            memset(ref, GUARD, (size_t)dst_stride * h + 1);
+            for (int32_t y = 0; y < h; y++) {
+                memcpy(ref + (size_t)y * dst_stride, src + (size_t)y * src_stride, len);
+            }
+
+            bsp_draw_copy(dst, dst_stride, src, src_stride, len, h);
+            TEST_CHECK(memcmp(dst, ref, (size_t)dst_stride * h + 1) == 0);
+            free(src);
+            free(dst);
+            free(ref);
+        }
+    }
+}
+
+/**
+ * Per-pixel 16-bit fill, the loop a renderer without word stores runs
+ */
+static void fill_reference(uint8_t* dst, uint32_t stride, int32_t w, int32_t h, uint16_t pixel) {
+    for (int32_t y = 0; y < h; y++) {
+        uint16_t* d = (uint16_t*)(dst + (size_t)y * stride);
+        for (int32_t x = 0; x < w; x++) {
+            d[x] = pixel;
+        }
+    }
+}
+
+static void test_bench(void) {
+    const uint32_t stride = STRIPE_W * 2;
+    uint8_t* dst = malloc((size_t)stride * STRIPE_H);
+    uint8_t* src = malloc((size_t)stride * STRIPE_H);
+    const uint8_t pixel[2] = {0x1F, 0xF8};
+    memset(src, 0x3C, (size_t)stride * STRIPE_H);
+    // Inset by one pixel, so lines are not contiguous and start at a 2-byte boundary
+    const int32_t w = STRIPE_W - 2;
+    const size_t line = (size_t)w * 2;
+
+    double start = test_now_us();
+    for (int r = 0; r < BENCH_RUNS; r++) {
+        bsp_draw_fill(dst + 2, stride, w, STRIPE_H, pixel, 2);
+    }
+    const double fill_us = (test_now_us() - start) / BENCH_RUNS;
+
+    start = test_now_us();
+    for (int r = 0; r < BENCH_RUNS; r++) {
+        fill_reference(dst + 2, stride, w, STRIPE_H, 0xF81F);
+    }
+    const double fill_ref_us = (test_now_us() - start) / BENCH_RUNS;
+
+    start = test_now_us();
+    for (int r = 0; r < BENCH_RUNS; r++) {
+        for (int32_t y = 0; y < STRIPE_H; y++) {
+            memset(dst + 2 + (size_t)y * stride, 0x5A, line);
+        }
+    }
+    const double memset_us = (test_now_us() - start) / BENCH_RUNS;
+
+    start = test_now_us();
+    for (int r = 0; r < BENCH_RUNS; r++) {
+        bsp_draw_copy(dst + 2, stride, src + 2, stride, line, STRIPE_H);
+    }
+    const double copy_us = (test_now_us() - start) / BENCH_RUNS;
+
+    start = test_now_us();
+    for (int r = 0; r < BENCH_RUNS; r++) {
+        for (int32_t y = 0; y < STRIPE_H; y++) {
+            const uint16_t* s = (const uint16_t*)(src + 2 + (size_t)y * stride);
+            uint16_t* d = (uint16_t*)(dst + 2 + (size_t)y * stride);
+            for (int32_t x = 0; x < w; x++) {
+                d[x] = s[x];
+            }
+        }
+    }
+    const double copy_ref_us = (test_now_us() - start) / BENCH_RUNS;
+
+    printf("BENCH,fill rgb565 stripe,%.2f,us\n", fill_us);
+    printf("BENCH,fill rgb565 stripe per pixel,%.2f,us\n", fill_ref_us);
+    printf("BENCH,fill rgb565 stripe memset,%.2f,us\n", memset_us);
+    printf("BENCH,copy rgb565 stripe,%.2f,us\n", copy_us);
+    printf("BENCH,copy rgb565 stripe per pixel,%.2f,us\n", copy_ref_us);
+    TEST_CHECK(fill_us > 0 && copy_us > 0);
+    free(dst);
+    free(src);
+}
+
+int main(void) {
+    TEST_RUN(test_fill_line);
+    TEST_RUN(test_fill_matches_memset);
+    TEST_RUN(test_fill_rect);
+    TEST_RUN(test_copy);
+    TEST_RUN(test_bench);
+    return test_failures;
+}
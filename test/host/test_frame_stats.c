@@ -0,0 +1,186 @@
+/*
+ * Rolling frame history behind bsp_display_get_stats()
+ *
+ * Frames with random metrics are pushed well past the size of the ring. After every push the histogram must
+ * match one rebuilt from the frames in the ring, lookups must find exactly the frames still in it, and the
+ * summary must match a sorted copy. Base64 output is checked against the RFC 4648 test vectors.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "bsp_frame_stats.h"
+#include "test_common.h"
+
+#define PUSHES  (BSP_FRAME_STATS_FRAMES * 5 + 7)
+
+static void test_bucket(void) {
+    TEST_CHECK_EQ(bsp_frame_stats_bucket(0), 0);
+    TEST_CHECK_EQ(bsp_frame_stats_bucket(1), 1);
+    TEST_CHECK_EQ(bsp_frame_stats_bucket(2), 2);
+    TEST_CHECK_EQ(bsp_frame_stats_bucket(3), 2);
+    TEST_CHECK_EQ(bsp_frame_stats_bucket(4), 3);
+    TEST_CHECK_EQ(bsp_frame_stats_bucket(1U << 13), 14);
+    TEST_CHECK_EQ(bsp_frame_stats_bucket((1U << 14) - 1), 14);
+    TEST_CHECK_EQ(bsp_frame_stats_bucket(1U << 14), BSP_FRAME_STATS_BUCKETS - 1);
+    TEST_CHECK_EQ(bsp_frame_stats_bucket(UINT32_MAX), BSP_FRAME_STATS_BUCKETS - 1);
+}
+
+static int compare_u32(const void* a, const void* b) {
+    const uint32_t x = *(const uint32_t*)a;
+    const uint32_t y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * Check the ring against the last frames pushed, all[0] to all[pushed - 1]. Returns the number of mismatches.
+ */
+static int check_ring(const bsp_frame_stats_t* stats, const bsp_frame_record_t* all, uint32_t pushed) {
+    int wrong = 0;
+    const uint32_t count = pushed < BSP_FRAME_STATS_FRAMES ? pushed : BSP_FRAME_STATS_FRAMES;
+    wrong += stats->count != count || stats->total != pushed;
+
+    // The histogram describes exactly the frames in the ring
+    uint16_t histogram[BSP_FRAME_METRICS][BSP_FRAME_STATS_BUCKETS] = {{0}};
+    for (uint32_t seq = pushed - count; seq < pushed; seq++) {
+        for (int m = 0; m < BSP_FRAME_METRICS; m++) {
+            histogram[m][bsp_frame_stats_bucket(all[seq].value[m])]++;
+        }
+    }
+    wrong += memcmp(histogram, stats->histogram, sizeof(histogram)) != 0;
+
+    // Frames that left the ring or are still to come are not found
+    for (uint32_t seq = 0; seq < pushed + 2; seq++) {
+        const bsp_frame_record_t* frame = bsp_frame_stats_get(stats, seq);
+        if (seq < pushed - count || seq >= pushed) {
+            wrong += frame != NULL;
+        } else {
+            wrong += frame == NULL || memcmp(frame, &all[seq], sizeof(*frame)) != 0;
+        }
+    }
+
+    // Values come oldest first, and the summary matches a sorted copy
+    for (int m = 0; m < BSP_FRAME_METRICS; m++) {
+        uint32_t values[BSP_FRAME_STATS_FRAMES];
+        uint32_t sorted[BSP_FRAME_STATS_FRAMES];
+        const size_t n = bsp_frame_stats_values(stats, (bsp_frame_metric_t)m, values);
+        wrong += n != count;
+        uint64_t sum = 0;
+        for (size_t i = 0; i < n; i++) {
+            wrong += values[i] != all[pushed - count + i].value[m];
+            sorted[i] = values[i];
+            sum += values[i];
+        }
+        if (n == 0) {
+            continue;
+        }
+        qsort(sorted, n, sizeof(sorted[0]), compare_u32);
+
+        bsp_frame_summary_t summary;
+        bsp_frame_stats_summary(values, n, &summary);
+        wrong += summary.last != all[pushed - 1].value[m];
+        wrong += summary.min != sorted[0] || summary.max != sorted[n - 1];
+        wrong += summary.avg != (uint32_t)(sum / n);
+        // Nearest rank: the smallest value with at least p percent of the values at or below it
+        wrong += summary.p50 != sorted[(n * 50 + 99) / 100 - 1];
+        wrong += summary.p95 != sorted[(n * 95 + 99) / 100 - 1];
+        wrong += memcmp(values, sorted, n * sizeof(sorted[0])) != 0;
+    }
+    return wrong;
+}
+
+static void test_ring(void) {
+    bsp_frame_record_t* all = calloc(PUSHES, sizeof(bsp_frame_record_t));
+    bsp_frame_stats_t stats;
+    bsp_frame_stats_init(&stats);
+    unsigned seed = 3;
+    int wrong = check_ring(&stats, all, 0);
+
+    for (uint32_t i = 0; i < PUSHES; i++) {
+        all[i].timestamp_us = 16667LL * i;
+        for (int m = 0; m < BSP_FRAME_METRICS; m++) {
+            // Spread over every bucket, with repeats and zeros
+            const uint32_t shift = test_rand(&seed) % 20;
+            all[i].value[m] = (i % 9 == 0) ? 0 : ((uint32_t)test_rand(&seed) << 16 | test_rand(&seed)) >> shift;
+        }
+        bsp_frame_stats_push(&stats, &all[i]);
+        wrong += check_ring(&stats, all, i + 1);
+    }
+    TEST_CHECK_EQ(wrong, 0);
+
+    // Emptied again
+    bsp_frame_stats_init(&stats);
+    TEST_CHECK(bsp_frame_stats_get(&stats, 0) == NULL);
+    uint32_t values[BSP_FRAME_STATS_FRAMES];
+    TEST_CHECK_EQ(bsp_frame_stats_values(&stats, BSP_FRAME_RENDER_US, values), 0);
+    free(all);
+}
+
+static void test_summary(void) {
+    bsp_frame_summary_t summary;
+
+    // No values gives zeros
+    bsp_frame_stats_summary(NULL, 0, &summary);
+    TEST_CHECK(summary.last == 0 && summary.min == 0 && summary.max == 0 && summary.p95 == 0);
+
+    // One value is every statistic
+    uint32_t one[1] = {42};
+    bsp_frame_stats_summary(one, 1, &summary);
+    TEST_CHECK(summary.last == 42 && summary.min == 42 && summary.max == 42 && summary.avg == 42);
+    TEST_CHECK(summary.p50 == 42 && summary.p95 == 42);
+
+    // 1 to 20 in reverse: the median is the 10th value, the 95th percentile the 19th
+    uint32_t values[20];
+    for (uint32_t i = 0; i < 20; i++) {
+        values[i] = 20 - i;
+    }
+    bsp_frame_stats_summary(values, 20, &summary);
+    TEST_CHECK_EQ(summary.last, 1);
+    TEST_CHECK_EQ(summary.avg, 10);
+    TEST_CHECK_EQ(summary.p50, 10);
+    TEST_CHECK_EQ(summary.p95, 19);
+
+    // The average of large values does not overflow
+    uint32_t large[3] = {UINT32_MAX, UINT32_MAX, UINT32_MAX - 3};
+    bsp_frame_stats_summary(large, 3, &summary);
+    TEST_CHECK_EQ(summary.avg, UINT32_MAX - 1);
+}
+
+static void test_base64(void) {
+    static const char* const vectors[][2] = {
+        {"", ""},
+        {"f", "Zg=="},
+        {"fo", "Zm8="},
+        {"foo", "Zm9v"},
+        {"foob", "Zm9vYg=="},
+        {"fooba", "Zm9vYmE="},
+        {"foobar", "Zm9vYmFy"},
+    };
+    char out[16];
+    for (size_t i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++) {
+        memset(out, 'x', sizeof(out));
+        bsp_frame_stats_base64((const uint8_t*)vectors[i][0], strlen(vectors[i][0]), out);
+        if (strcmp(out, vectors[i][1]) != 0) {
+            fprintf(stderr, "\"%s\" encoded as \"%s\"\n", vectors[i][0], out);
+        }
+        TEST_CHECK(strcmp(out, vectors[i][1]) == 0);
+    }
+
+    // Every byte value, and the output length the header promises
+    uint8_t all[256];
+    for (int i = 0; i < 256; i++) {
+        all[i] = (uint8_t)i;
+    }
+    char encoded[4 * ((256 + 2) / 3) + 1];
+    bsp_frame_stats_base64(all, sizeof(all), encoded);
+    TEST_CHECK_EQ(strlen(encoded), sizeof(encoded) - 1);
+    TEST_CHECK(strncmp(encoded, "AAECAwQF", 8) == 0);
+    TEST_CHECK(strcmp(encoded + sizeof(encoded) - 9, "/P3+/w==") == 0);
+}
+
+int main(void) {
+    TEST_RUN(test_bucket);
+    TEST_RUN(test_ring);
+    TEST_RUN(test_summary);
+    TEST_RUN(test_base64);
+    return test_failures;
+}
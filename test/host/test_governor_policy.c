@@ -0,0 +1,127 @@
+/*
+ * Refresh rate policy of the frame governor
+ *
+ * Refresh cycles are fed at the rate the policy asks for, with or without changes, and touch samples at the
+ * rate of the touch reader. The rate must stay at the target while changes come and go, step down for a run of
+ * changes nobody interacts with, return to the target on the first cycle without changes, and boost from the
+ * first press to boost_ms after the release.
+ */
+
+#include "bsp_governor_policy.h"
+#include "test_common.h"
+
+#define TARGET_HZ   (30)
+#define IDLE_HZ     (10)
+#define BOOST_HZ    (60)
+#define IDLE_MS     (1000)
+#define BOOST_MS    (300)
+
+static void init_policy(bsp_governor_policy_t* policy) {
+    const bsp_governor_policy_cfg_t cfg = {
+        .target_hz = TARGET_HZ,
+        .idle_hz = IDLE_HZ,
+        .boost_hz = BOOST_HZ,
+        .idle_ms = IDLE_MS,
+        .boost_ms = BOOST_MS,
+    };
+    bsp_governor_policy_init(policy, &cfg);
+}
+
+/**
+ * Run refresh cycles at the rate the policy picks until end_us, returns the rate at the end
+ */
+static uint32_t run_cycles(bsp_governor_policy_t* policy, int64_t* now_us, int64_t end_us, bool changed) {
+    uint32_t hz = bsp_governor_policy_rate(policy, *now_us);
+    while (*now_us < end_us) {
+        *now_us += 1000000 / hz;
+        bsp_governor_policy_frame(policy, *now_us, changed);
+        hz = bsp_governor_policy_rate(policy, *now_us);
+    }
+    return hz;
+}
+
+static void test_clamped_rates(void) {
+    const bsp_governor_policy_cfg_t cfg = {.target_hz = 5, .idle_hz = 0, .boost_hz = 2, .idle_ms = 100};
+    bsp_governor_policy_t policy;
+    bsp_governor_policy_init(&policy, &cfg);
+    TEST_CHECK_EQ(policy.cfg.idle_hz, 1);
+    TEST_CHECK_EQ(policy.cfg.target_hz, 5);
+    TEST_CHECK_EQ(policy.cfg.boost_hz, 5);
+}
+
+static void test_static_screen(void) {
+    bsp_governor_policy_t policy;
+    init_policy(&policy);
+    int64_t now_us = 1000000;
+
+    // Nothing to render for a long time, the next change is picked up at the target rate
+    TEST_CHECK_EQ(run_cycles(&policy, &now_us, now_us + 10000000, false), TARGET_HZ);
+    // Changes now and then, each followed by a cycle without any
+    for (int i = 0; i < 20; i++) {
+        bsp_governor_policy_frame(&policy, now_us, true);
+        TEST_CHECK_EQ(run_cycles(&policy, &now_us, now_us + 500000, false), TARGET_HZ);
+    }
+}
+
+static void test_running_changes(void) {
+    bsp_governor_policy_t policy;
+    init_policy(&policy);
+    int64_t now_us = 1000000;
+    const int64_t run_us = now_us;
+
+    // A looping animation: target rate for one idle period, then halved down to the idle rate
+    TEST_CHECK_EQ(run_cycles(&policy, &now_us, run_us + IDLE_MS * 1000 - 50000, true), TARGET_HZ);
+    TEST_CHECK_EQ(run_cycles(&policy, &now_us, run_us + 2 * IDLE_MS * 1000 - 100000, true), TARGET_HZ / 2);
+    TEST_CHECK_EQ(run_cycles(&policy, &now_us, run_us + 10 * IDLE_MS * 1000, true), IDLE_HZ);
+
+    // The animation stops: the first cycle without changes is back at the target rate
+    TEST_CHECK_EQ(run_cycles(&policy, &now_us, now_us + 1, false), TARGET_HZ);
+    // And a new run of changes starts over at the target rate
+    TEST_CHECK_EQ(run_cycles(&policy, &now_us, now_us + 500000, true), TARGET_HZ);
+}
+
+static void test_touch_boost(void) {
+    bsp_governor_policy_t policy;
+    init_policy(&policy);
+    int64_t now_us = 1000000;
+
+    // Paced down by a long animation
+    TEST_CHECK_EQ(run_cycles(&policy, &now_us, now_us + 10 * IDLE_MS * 1000, true), IDLE_HZ);
+
+    // The first sample of a press starts the boost, the following ones do not
+    TEST_CHECK(bsp_governor_policy_touch(&policy, now_us, true));
+    TEST_CHECK_EQ(bsp_governor_policy_rate(&policy, now_us), BOOST_HZ);
+    for (int i = 1; i <= 100; i++) {
+        TEST_CHECK(!bsp_governor_policy_touch(&policy, now_us + i * 10000, true));
+    }
+    now_us += 1000000;
+    TEST_CHECK_EQ(run_cycles(&policy, &now_us, now_us + 2000000, true), BOOST_HZ);
+
+    // Released: boosted for boost_ms, then the target rate, the animation counts as new from the boost end
+    const int64_t release_us = now_us;
+    TEST_CHECK(!bsp_governor_policy_touch(&policy, release_us, false));
+    TEST_CHECK_EQ(bsp_governor_policy_rate(&policy, release_us + BOOST_MS * 1000 - 1), BOOST_HZ);
+    TEST_CHECK_EQ(bsp_governor_policy_rate(&policy, release_us + BOOST_MS * 1000), TARGET_HZ);
+    TEST_CHECK_EQ(bsp_governor_policy_rate(&policy, release_us + (BOOST_MS + IDLE_MS) * 1000 - 1), TARGET_HZ);
+    TEST_CHECK_EQ(bsp_governor_policy_rate(&policy, release_us + (BOOST_MS + IDLE_MS) * 1000), TARGET_HZ / 2);
+
+    // A press during the boost after a release does not count as a new boost
+    TEST_CHECK(!bsp_governor_policy_touch(&policy, release_us + 100000, true));
+}
+
+static void test_no_idle_steps(void) {
+    const bsp_governor_policy_cfg_t cfg = {.target_hz = TARGET_HZ, .idle_hz = IDLE_HZ, .boost_hz = BOOST_HZ};
+    bsp_governor_policy_t policy;
+    bsp_governor_policy_init(&policy, &cfg);
+    int64_t now_us = 1000000;
+    TEST_CHECK_EQ(run_cycles(&policy, &now_us, now_us + 60000000, true), TARGET_HZ);
+}
+
+int main(void) {
+    TEST_RUN(test_clamped_rates);
+    TEST_RUN(test_static_screen);
+    TEST_RUN(test_running_changes);
+    TEST_RUN(test_touch_boost);
+    TEST_RUN(test_no_idle_steps);
+    return test_failures;
+}
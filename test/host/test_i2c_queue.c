@@ -0,0 +1,295 @@
+/*
+ * Scheduling core of the I2C bus manager, against a fake bus
+ *
+ * The fake bus holds a 256-byte register file per device, with auto-incrementing register addresses. Batches
+ * popped from the queue are executed on it the way bsp_i2c.c does: one combined read split between the jobs
+ * it serves, or one write. Read results are compared with running every job of a device in submission order.
+ */
+
+#include <string.h>
+#include "bsp_i2c_queue.h"
+#include "test_common.h"
+
+#define DEVICES         (3)
+#define MAX_JOBS        (64)
+#define MAX_LEN         (8)
+#define BATCH_MAX_BYTES (32)
+
+typedef struct {
+    uint8_t regs[256];
+    uint32_t transactions;
+} fake_dev_t;
+
+typedef struct {
+    bsp_i2c_job_t job;      /* First, so a bsp_i2c_job_t pointer is a test_job_t pointer */
+    uint8_t data[MAX_LEN];  /* Write payload, or read result */
+    uint8_t expected[MAX_LEN];
+    int served_order;
+    fake_dev_t* exec_dev;   /* EXEC: device the function writes data[0] to at reg, like a vendor driver */
+} test_job_t;
+
+static fake_dev_t devs[DEVICES];
+static int served;
+
+static void fake_bus_run(const bsp_i2c_batch_t* batch) {
+    if (batch->jobs->kind == BSP_I2C_JOB_EXEC) {
+        test_job_t* t = (test_job_t*)batch->jobs;
+        TEST_CHECK(batch->count == 1);
+        t->exec_dev->regs[t->job.reg] = t->data[0];
+        t->exec_dev->transactions++;
+        t->served_order = served++;
+        return;
+    }
+
+    fake_dev_t* dev = (fake_dev_t*)batch->jobs->dev;
+    dev->transactions++;
+    if (batch->jobs->kind == BSP_I2C_JOB_WRITE) {
+        test_job_t* t = (test_job_t*)batch->jobs;
+        memcpy(&dev->regs[t->job.reg], t->data, t->job.len);
+        t->served_order = served++;
+        return;
+    }
+    uint8_t buf[BATCH_MAX_BYTES];
+    TEST_CHECK(batch->len <= BATCH_MAX_BYTES);
+    memcpy(buf, &dev->regs[batch->reg], batch->len);
+    for (bsp_i2c_job_t* job = batch->jobs; job; job = job->next) {
+        test_job_t* t = (test_job_t*)job;
+        TEST_CHECK(job->dev == dev && job->kind == BSP_I2C_JOB_READ_REG);
+        TEST_CHECK(job->reg >= batch->reg && job->reg + job->len <= (size_t)batch->reg + batch->len);
+        memcpy(t->data, &buf[job->reg - batch->reg], job->len);
+        t->served_order = served++;
+    }
+}
+
+static size_t drain(bsp_i2c_queue_t* queue) {
+    bsp_i2c_batch_t batch;
+    size_t transactions = 0;
+    while (bsp_i2c_queue_pop(queue, BATCH_MAX_BYTES, &batch)) {
+        size_t count = 0;
+        for (bsp_i2c_job_t* job = batch.jobs; job; job = job->next) {
+            count++;
+        }
+        TEST_CHECK_EQ(count, batch.count);
+        fake_bus_run(&batch);
+        transactions++;
+    }
+    TEST_CHECK_EQ(queue->depth, 0);
+    return transactions;
+}
+
+static void reset_bus(void) {
+    for (int d = 0; d < DEVICES; d++) {
+        for (int r = 0; r < 256; r++) {
+            devs[d].regs[r] = (uint8_t)(r + d * 64);
+        }
+        devs[d].transactions = 0;
+    }
+    served = 0;
+}
+
+static test_job_t read_job(int dev, uint8_t prio, uint8_t reg, size_t len) {
+    return (test_job_t){.job = {.dev = &devs[dev], .kind = BSP_I2C_JOB_READ_REG, .priority = prio,
+                                .batchable = true, .reg = reg, .len = len}, .served_order = -1};
+}
+
+static test_job_t write_job(int dev, uint8_t prio, uint8_t reg, uint8_t value) {
+    test_job_t t = {.job = {.dev = &devs[dev], .kind = BSP_I2C_JOB_WRITE, .priority = prio, .reg = reg,
+                            .len = 1}, .served_order = -1};
+    t.data[0] = value;
+    return t;
+}
+
+static void test_priority_and_fifo(void) {
+    bsp_i2c_queue_t queue;
+    bsp_i2c_queue_init(&queue);
+    reset_bus();
+
+    // A sensor burst is queued, then the touch read arrives
+    test_job_t sensor[3] = {read_job(1, 2, 0x00, 2), read_job(2, 2, 0x00, 2), read_job(1, 2, 0x80, 2)};
+    test_job_t touch = read_job(0, 0, 0x02, 7);
+    test_job_t pmu = (test_job_t){.job = {.dev = NULL, .kind = BSP_I2C_JOB_EXEC, .priority = 1, .reg = 0xF0},
+                                  .served_order = -1, .exec_dev = &devs[2]};
+    for (int i = 0; i < 3; i++) {
+        bsp_i2c_queue_push(&queue, &sensor[i].job);
+    }
+    bsp_i2c_queue_push(&queue, &pmu.job);
+    bsp_i2c_queue_push(&queue, &touch.job);
+    TEST_CHECK_EQ(queue.depth, 5);
+
+    drain(&queue);
+    TEST_CHECK_EQ(touch.served_order, 0);
+    TEST_CHECK_EQ(pmu.served_order, 1);
+    TEST_CHECK(sensor[0].served_order < sensor[1].served_order);
+    TEST_CHECK(sensor[1].served_order < sensor[2].served_order);
+}
+
+static void test_batching(void) {
+    bsp_i2c_queue_t queue;
+    bsp_i2c_queue_init(&queue);
+    reset_bus();
+
+    // Touching and overlapping ranges of one device, pushed out of order, and one range too far away
+    test_job_t jobs[] = {
+        read_job(0, 1, 0x14, 2),
+        read_job(1, 1, 0x10, 4),   // Other device, never joined
+        read_job(0, 1, 0x10, 4),
+        read_job(0, 1, 0x40, 2),   // Gap to the others
+        read_job(0, 1, 0x12, 4),
+        read_job(0, 1, 0x16, 4),
+    };
+    const size_t n = sizeof(jobs) / sizeof(jobs[0]);
+    for (size_t i = 0; i < n; i++) {
+        bsp_i2c_queue_push(&queue, &jobs[i].job);
+    }
+
+    bsp_i2c_batch_t batch;
+    TEST_CHECK(bsp_i2c_queue_pop(&queue, BATCH_MAX_BYTES, &batch));
+    TEST_CHECK_EQ(batch.count, 4);
+    TEST_CHECK_EQ(batch.reg, 0x10);
+    TEST_CHECK_EQ(batch.len, 10);
+    fake_bus_run(&batch);
+    drain(&queue);
+
+    TEST_CHECK_EQ(devs[0].transactions, 2);
+    TEST_CHECK_EQ(devs[1].transactions, 1);
+    for (size_t i = 0; i < n; i++) {
+        const fake_dev_t* dev = jobs[i].job.dev;
+        TEST_CHECK(memcmp(jobs[i].data, &dev->regs[jobs[i].job.reg], jobs[i].job.len) == 0);
+    }
+}
+
+static void test_batch_limits(void) {
+    bsp_i2c_queue_t queue;
+    bsp_i2c_queue_init(&queue);
+    reset_bus();
+
+    // Adjacent, but together longer than one read may be
+    test_job_t a = read_job(0, 0, 0x00, 20);
+    test_job_t b = read_job(0, 0, 0x14, 20);
+    // Adjacent, but the device does not auto-increment
+    test_job_t c = read_job(1, 0, 0x00, 2);
+    test_job_t d = read_job(1, 0, 0x02, 2);
+    c.job.batchable = false;
+    d.job.batchable = false;
+    bsp_i2c_queue_push(&queue, &a.job);
+    bsp_i2c_queue_push(&queue, &b.job);
+    bsp_i2c_queue_push(&queue, &c.job);
+    bsp_i2c_queue_push(&queue, &d.job);
+
+    TEST_CHECK_EQ(drain(&queue), 4);
+}
+
+static void test_reads_stay_behind_writes(void) {
+    bsp_i2c_queue_t queue;
+    bsp_i2c_queue_init(&queue);
+    reset_bus();
+
+    test_job_t before = read_job(0, 1, 0x20, 2);
+    test_job_t write = write_job(0, 1, 0x21, 0xAB);
+    test_job_t after = read_job(0, 1, 0x20, 2);
+    test_job_t other = read_job(1, 1, 0x20, 2);
+    bsp_i2c_queue_push(&queue, &before.job);
+    bsp_i2c_queue_push(&queue, &write.job);
+    bsp_i2c_queue_push(&queue, &other.job);
+    bsp_i2c_queue_push(&queue, &after.job);
+    drain(&queue);
+
+    TEST_CHECK_EQ(before.data[1], 0x21);
+    TEST_CHECK_EQ(after.data[1], 0xAB);
+    TEST_CHECK(before.served_order < write.served_order && write.served_order < after.served_order);
+}
+
+/**
+ * A function job has no device, it may write to any of them through its own driver handle
+ */
+static void test_reads_stay_behind_exec(void) {
+    bsp_i2c_queue_t queue;
+    bsp_i2c_queue_init(&queue);
+    reset_bus();
+
+    test_job_t before = read_job(0, 1, 0x20, 2);
+    test_job_t exec = {.job = {.dev = NULL, .kind = BSP_I2C_JOB_EXEC, .priority = 1, .reg = 0x21},
+                       .served_order = -1, .exec_dev = &devs[0]};
+    exec.data[0] = 0xCD;
+    test_job_t after = read_job(0, 1, 0x21, 1);
+    test_job_t other_before = read_job(1, 1, 0x40, 1);
+    test_job_t other_after = read_job(1, 1, 0x41, 1);
+    bsp_i2c_queue_push(&queue, &before.job);
+    bsp_i2c_queue_push(&queue, &other_before.job);
+    bsp_i2c_queue_push(&queue, &exec.job);
+    bsp_i2c_queue_push(&queue, &after.job);
+    bsp_i2c_queue_push(&queue, &other_after.job);
+    drain(&queue);
+
+    TEST_CHECK_EQ(before.data[1], 0x21);
+    TEST_CHECK_EQ(after.data[0], 0xCD);
+    TEST_CHECK(before.served_order < exec.served_order && exec.served_order < after.served_order);
+    // Reads of other devices do not pass it either
+    TEST_CHECK(other_before.served_order < exec.served_order && exec.served_order < other_after.served_order);
+}
+
+/**
+ * Random reads and writes on three devices, each device at its own priority, pushed and popped interleaved.
+ * Every read must return what it would have returned with all jobs run one by one in submission order.
+ */
+static void test_random_against_serial(void) {
+    unsigned seed = 5;
+    for (int run = 0; run < 200; run++) {
+        bsp_i2c_queue_t queue;
+        bsp_i2c_queue_init(&queue);
+        reset_bus();
+
+        static test_job_t jobs[MAX_JOBS];
+        uint8_t shadow[DEVICES][256];
+        for (int d = 0; d < DEVICES; d++) {
+            memcpy(shadow[d], devs[d].regs, 256);
+        }
+
+        const size_t n = 8 + test_rand(&seed) % (MAX_JOBS - 8);
+        size_t transactions = 0;
+        for (size_t i = 0; i < n; i++) {
+            const int dev = (int)(test_rand(&seed) % DEVICES);
+            const uint8_t reg = (uint8_t)(test_rand(&seed) % 24);
+            if (test_rand(&seed) % 4 == 0) {
+                jobs[i] = write_job(dev, (uint8_t)dev, reg, (uint8_t)test_rand(&seed));
+                shadow[dev][reg] = jobs[i].data[0];
+            } else {
+                const size_t len = 1 + test_rand(&seed) % MAX_LEN;
+                jobs[i] = read_job(dev, (uint8_t)dev, reg, len);
+                memcpy(jobs[i].expected, &shadow[dev][reg], len);
+            }
+            bsp_i2c_queue_push(&queue, &jobs[i].job);
+
+            // The bus runs now and then while jobs keep arriving
+            bsp_i2c_batch_t batch;
+            if (test_rand(&seed) % 3 == 0 && bsp_i2c_queue_pop(&queue, BATCH_MAX_BYTES, &batch)) {
+                fake_bus_run(&batch);
+                transactions++;
+            }
+        }
+        transactions += drain(&queue);
+        TEST_CHECK(transactions <= n);
+
+        for (size_t i = 0; i < n; i++) {
+            TEST_CHECK(jobs[i].served_order >= 0);
+            if (jobs[i].job.kind == BSP_I2C_JOB_READ_REG &&
+                    memcmp(jobs[i].data, jobs[i].expected, jobs[i].job.len) != 0) {
+                fprintf(stderr, "run %d job %zu: read differs from serial order\n", run, i);
+                TEST_CHECK(false);
+            }
+        }
+        for (int d = 0; d < DEVICES; d++) {
+            TEST_CHECK(memcmp(devs[d].regs, shadow[d], 256) == 0);
+        }
+    }
+}
+
+int main(void) {
+    TEST_RUN(test_priority_and_fifo);
+    TEST_RUN(test_batching);
+    TEST_RUN(test_batch_limits);
+    TEST_RUN(test_reads_stay_behind_writes);
+    TEST_RUN(test_reads_stay_behind_exec);
+    TEST_RUN(test_random_against_serial);
+    return test_failures;
+}
@@ -0,0 +1,173 @@
+/*
+ * Software rotation fallback of the flush stage
+ *
+ * Checks bsp_rotate_blit() against bsp_rotate_area() pixel by pixel for all eight transforms, then compares
+ * its cost per rotated frame with the loop LVGL's software rotation (lv_draw_sw_rotate(), used by
+ * esp_lvgl_port when sw_rotate is set) runs: one destination line at a time, reading the source down a column.
+ * Timings are printed as "BENCH,<name>,<value>,<unit>" lines, like the on-target benchmark.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "bsp_rotate.h"
+#include "test_common.h"
+
+// LVGL resolution at 90 or 270 degrees
+#define FRAME_W         (600)
+#define FRAME_H         (450)
+// Draw buffer height bsp_display_start() uses at 90 and 270 degrees
+#define STRIPE_LINES    (44)
+#define BENCH_FRAMES    (20)
+
+static uint32_t pixel_value(int32_t x, int32_t y) {
+    return ((uint32_t)y * 7919U + (uint32_t)x * 104729U) ^ 0xA5C3E1F7U;
+}
+
+static void fill_block(uint8_t* buf, size_t stride, int32_t w, int32_t h, uint32_t bpp) {
+    for (int32_t y = 0; y < h; y++) {
+        for (int32_t x = 0; x < w; x++) {
+            const uint32_t v = pixel_value(x, y);
+            memcpy(buf + (size_t)y * stride + (size_t)x * bpp, &v, bpp);
+        }
+    }
+}
+
+/**
+ * Destination-order rotation: every destination pixel fetches its source pixel, so consecutive reads are a
+ * whole source line apart
+ */
+static void rotate_reference(const bsp_rotate_t* rot, const uint8_t* src, size_t src_stride, int32_t w, int32_t h,
+                             uint32_t bpp, uint8_t* dst) {
+    const int32_t dst_w = rot->swap_xy ? h : w;
+    const int32_t dst_h = rot->swap_xy ? w : h;
+    for (int32_t dy = 0; dy < dst_h; dy++) {
+        const int32_t py = rot->mirror_y ? dst_h - 1 - dy : dy;
+        for (int32_t dx = 0; dx < dst_w; dx++) {
+            const int32_t px = rot->mirror_x ? dst_w - 1 - dx : dx;
+            const int32_t sx = rot->swap_xy ? py : px;
+            const int32_t sy = rot->swap_xy ? px : py;
+            const uint8_t* s = src + (size_t)sy * src_stride + (size_t)sx * bpp;
+            uint8_t* d = dst + ((size_t)dy * dst_w + dx) * bpp;
+            // Typed copies like LVGL's per-format loops
+            if (bpp == 2) {
+                *(uint16_t*)d = *(const uint16_t*)s;
+            } else {
+                d[0] = s[0];
+                d[1] = s[1];
+                d[2] = s[2];
+                if (bpp == 4) {
+                    d[3] = s[3];
+                }
+            }
+        }
+    }
+}
+
+static void test_all_transforms(void) {
+    // Odd sizes and a padded stride, so partial tiles and line ends are covered
+    const int32_t w = 37;
+    const int32_t h = 23;
+    const size_t pad = 12;
+    static const uint32_t bpps[] = {2, 3, 4};
+
+    for (size_t b = 0; b < sizeof(bpps) / sizeof(bpps[0]); b++) {
+        const uint32_t bpp = bpps[b];
+        const size_t stride = (size_t)w * bpp + pad;
+        uint8_t* src = malloc(stride * h);
+        uint8_t* dst = malloc((size_t)w * h * bpp);
+        fill_block(src, stride, w, h, bpp);
+
+        for (int t = 0; t < 8; t++) {
+            const bsp_rotate_t rot = {.swap_xy = t & 1, .mirror_x = (t >> 1) & 1, .mirror_y = (t >> 2) & 1};
+            const int32_t dst_w = rot.swap_xy ? h : w;
+            memset(dst, 0, (size_t)w * h * bpp);
+            bsp_rotate_blit(&rot, src, stride, w, h, bpp, dst);
+
+            int mismatches = 0;
+            for (int32_t y = 0; y < h; y++) {
+                for (int32_t x = 0; x < w; x++) {
+                    const bsp_area_t px = {x, y, x, y};
+                    bsp_area_t out;
+                    bsp_rotate_area(&rot, &px, w, h, &out);
+                    const uint8_t* got = dst + ((size_t)out.y1 * dst_w + out.x1) * bpp;
+                    mismatches += memcmp(got, src + (size_t)y * stride + (size_t)x * bpp, bpp) != 0;
+                }
+            }
+            if (mismatches) {
+                fprintf(stderr, "bpp %u swap %d mirror %d/%d: %d pixels wrong\n", (unsigned)bpp, rot.swap_xy,
+                        rot.mirror_x, rot.mirror_y, mismatches);
+            }
+            TEST_CHECK_EQ(mismatches, 0);
+        }
+        free(src);
+        free(dst);
+    }
+}
+
+static void test_matches_reference(void) {
+    const bsp_rotate_t rot = {.swap_xy = true, .mirror_x = true};
+    const int32_t w = 450;
+    const int32_t h = 61;
+    const size_t stride = (size_t)w * 2;
+    uint8_t* src = malloc(stride * h);
+    uint8_t* a = malloc(stride * h);
+    uint8_t* b = malloc(stride * h);
+    fill_block(src, stride, w, h, 2);
+
+    bsp_rotate_blit(&rot, src, stride, w, h, 2, a);
+    rotate_reference(&rot, src, stride, w, h, 2, b);
+    TEST_CHECK(memcmp(a, b, stride * h) == 0);
+    free(src);
+    free(a);
+    free(b);
+}
+
+/**
+ * Rotate a full frame the way the flush stage sees it: stripes of STRIPE_LINES full-width lines
+ */
+static double bench_frames(const bsp_rotate_t* rot, const uint8_t* frame, uint32_t bpp, uint8_t* dst, bool tiled) {
+    const size_t stride = (size_t)FRAME_W * bpp;
+    const double start = test_now_us();
+    for (int f = 0; f < BENCH_FRAMES; f++) {
+        for (int32_t y = 0; y < FRAME_H; y += STRIPE_LINES) {
+            const int32_t lines = FRAME_H - y < STRIPE_LINES ? FRAME_H - y : STRIPE_LINES;
+            const uint8_t* stripe = frame + (size_t)y * stride;
+            if (tiled) {
+                bsp_rotate_blit(rot, stripe, stride, FRAME_W, lines, bpp, dst);
+            } else {
+                rotate_reference(rot, stripe, stride, FRAME_W, lines, bpp, dst);
+            }
+        }
+    }
+    return (test_now_us() - start) / BENCH_FRAMES;
+}
+
+static void test_bench(void) {
+    static const uint32_t bpps[] = {2, 3};
+    // 90 degrees as set up by display.h: swap, then mirror the panel columns
+    const bsp_rotate_t rot = {.swap_xy = true, .mirror_x = true};
+
+    for (size_t b = 0; b < sizeof(bpps) / sizeof(bpps[0]); b++) {
+        const uint32_t bpp = bpps[b];
+        uint8_t* frame = malloc((size_t)FRAME_W * FRAME_H * bpp);
+        uint8_t* dst = malloc((size_t)FRAME_W * STRIPE_LINES * bpp);
+        fill_block(frame, (size_t)FRAME_W * bpp, FRAME_W, FRAME_H, bpp);
+
+        // Warm up caches and page in the buffers
+        bench_frames(&rot, frame, bpp, dst, true);
+        const double tiled_us = bench_frames(&rot, frame, bpp, dst, true);
+        const double reference_us = bench_frames(&rot, frame, bpp, dst, false);
+        printf("BENCH,rotate %ubpp tiled,%.2f,us\n", (unsigned)bpp * 8, tiled_us);
+        printf("BENCH,rotate %ubpp per pixel,%.2f,us\n", (unsigned)bpp * 8, reference_us);
+        TEST_CHECK(tiled_us > 0 && reference_us > 0);
+        free(frame);
+        free(dst);
+    }
+}
+
+int main(void) {
+    TEST_RUN(test_all_transforms);
+    TEST_RUN(test_matches_reference);
+    TEST_RUN(test_bench);
+    return test_failures;
+}
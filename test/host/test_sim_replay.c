@@ -0,0 +1,405 @@
+/*
+ * Flush window planning replayed against the simulated panel
+ *
+ * A scene is the list of areas LVGL invalidated in each refresh cycle, in the format BSP_LCD_FLUSH_TRACE logs
+ * (see scenes/). Every frame goes through what the flush stage does between LVGL and the wire: the areas are
+ * merged with the Kconfig defaults, each window is rendered in stripes of the draw buffer height, and each
+ * stripe is sent as CASET, RASET and RAMWR into the simulated RM690B0. The framebuffer must then hold the new
+ * pixels in every invalidated area and nothing new outside the windows.
+ *
+ * Commands, bytes and modelled wire time per frame are printed as BENCH lines and compared with
+ * scenes/baseline.csv, so a change that sends more windows, bytes or wire time fails here. The numbers come
+ * from the model, not from a clock, so they are the same on every host. After an intended change, regenerate
+ * the baseline with "test_sim_replay --update". Extra log files given on the command line are replayed and
+ * printed, but not compared.
+ *
+ * LVGL itself does not run here: rendering cost, draw units and the LVGL task are only measured on target.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "bsp_area.h"
+#include "bsp_sim_core.h"
+#include "test_common.h"
+
+#define SCREEN_W        (450)
+#define SCREEN_H        (600)
+#define MAX_AREAS       (32)    /* LV_INV_BUF_SIZE */
+
+/* Kconfig defaults: RGB565 on the wire, BSP_LCD_FLUSH_WINDOW_COST, BSP_LCD_DRAW_BUFF_LINES */
+#define WIRE_BPP        (2)
+#define WINDOW_COST     (200)
+#define AREA_ALIGN      (2)
+#define BUFFER_PIXELS   (SCREEN_W * 60)
+
+/* Link model: a common RM690B0 clock and BSP_LCD_SIM_TRANS_OVERHEAD_NS */
+#define PCLK_HZ         (40000000)
+#define OVERHEAD_NS     (2000)
+
+typedef struct {
+    bsp_area_t areas[MAX_AREAS];
+    size_t count;
+} frame_t;
+
+typedef struct {
+    frame_t* frames;
+    size_t count;
+} scene_t;
+
+typedef struct {
+    uint64_t frames;
+    uint64_t windows;
+    uint64_t flushes;
+    bsp_sim_stats_t link;
+} replay_result_t;
+
+static const char* const scene_files[] = {
+    "empty_screen.csv",
+    "single_rectangle.csv",
+    "multiple_rectangles.csv",
+    "multiple_labels.csv",
+    "containers_with_scrolling.csv",
+};
+
+static frame_t* scene_frame(scene_t* scene, size_t index) {
+    while (scene->count <= index) {
+        scene->frames = realloc(scene->frames, (scene->count + 1) * sizeof(frame_t));
+        scene->frames[scene->count++].count = 0;
+    }
+    return &scene->frames[index];
+}
+
+/**
+ * Read SCREEN and AREA lines, anywhere in a line so a raw monitor log works. Frames are numbered from the
+ * first one in the file.
+ */
+static bool load_scene(const char* path, scene_t* scene) {
+    FILE* f = fopen(path, "r");
+    if (f == NULL) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return false;
+    }
+
+    *scene = (scene_t){0};
+    char line[256];
+    long first = -1;
+    bool ok = true;
+    while (fgets(line, sizeof(line), f)) {
+        long w, h, frame, x1, y1, x2, y2;
+        const char* p;
+        if ((p = strstr(line, "SCREEN,")) && sscanf(p, "SCREEN,%ld,%ld", &w, &h) == 2 &&
+                (w != SCREEN_W || h != SCREEN_H)) {
+            fprintf(stderr, "%s: %ldx%ld, only scenes at the native %dx%d are replayed\n", path, w, h, SCREEN_W,
+                    SCREEN_H);
+            ok = false;
+            break;
+        }
+        if ((p = strstr(line, "AREA,")) == NULL ||
+                sscanf(p, "AREA,%ld,%ld,%ld,%ld,%ld", &frame, &x1, &y1, &x2, &y2) != 5) {
+            continue;
+        }
+        first = first < 0 ? frame : first;
+        if (frame < first) {
+            continue;
+        }
+        frame_t* fr = scene_frame(scene, (size_t)(frame - first));
+        if (fr->count < MAX_AREAS) {
+            fr->areas[fr->count++] = (bsp_area_t){(int32_t)x1, (int32_t)y1, (int32_t)x2, (int32_t)y2};
+        }
+    }
+    fclose(f);
+    return ok && scene->count > 0;
+}
+
+static void send(bsp_sim_core_t* core, uint8_t cmd, const uint8_t* param, size_t size) {
+    bsp_sim_core_tx_param(core, cmd, param, size);
+    bsp_sim_core_account(core, 0, size, false);
+}
+
+/**
+ * What sim_panel_draw_bitmap() puts on the wire for one flush, x2 and y2 inclusive
+ */
+static void draw_bitmap(bsp_sim_core_t* core, int32_t x1, int32_t y1, int32_t x2, int32_t y2, const uint8_t* px) {
+    const uint8_t caset[4] = {x1 >> 8, x1 & 0xFF, x2 >> 8, x2 & 0xFF};
+    const uint8_t raset[4] = {y1 >> 8, y1 & 0xFF, y2 >> 8, y2 & 0xFF};
+    send(core, BSP_SIM_CMD_CASET, caset, sizeof(caset));
+    send(core, BSP_SIM_CMD_RASET, raset, sizeof(raset));
+
+    const size_t size = (size_t)(x2 - x1 + 1) * (size_t)(y2 - y1 + 1) * WIRE_BPP;
+    bsp_sim_core_tx_color(core, BSP_SIM_CMD_RAMWR, px, size);
+    bsp_sim_core_account(core, size, size, true);
+}
+
+static bool clip(bsp_area_t* area) {
+    area->x1 = area->x1 < 0 ? 0 : area->x1;
+    area->y1 = area->y1 < 0 ? 0 : area->y1;
+    area->x2 = area->x2 > SCREEN_W - 1 ? SCREEN_W - 1 : area->x2;
+    area->y2 = area->y2 > SCREEN_H - 1 ? SCREEN_H - 1 : area->y2;
+    return area->x1 <= area->x2 && area->y1 <= area->y2;
+}
+
+/**
+ * Pixels of the invalidated areas must carry the frame's value, pixels outside every window must be unchanged
+ */
+static int verify_frame(const uint8_t* fb, const uint8_t* prev, const frame_t* frame, const bsp_area_t* windows,
+                        size_t count, const uint8_t* value) {
+    static uint8_t covered[SCREEN_W * SCREEN_H];
+    memset(covered, 0, sizeof(covered));
+    for (size_t i = 0; i < count; i++) {
+        for (int32_t y = windows[i].y1; y <= windows[i].y2; y++) {
+            memset(&covered[y * SCREEN_W + windows[i].x1], 1, (size_t)bsp_area_width(&windows[i]));
+        }
+    }
+
+    int wrong = 0;
+    for (size_t i = 0; i < frame->count; i++) {
+        bsp_area_t area = frame->areas[i];
+        if (!clip(&area)) {
+            continue;
+        }
+        for (int32_t y = area.y1; y <= area.y2; y++) {
+            for (int32_t x = area.x1; x <= area.x2; x++) {
+                wrong += memcmp(&fb[(y * SCREEN_W + x) * WIRE_BPP], value, WIRE_BPP) != 0;
+            }
+        }
+    }
+    for (size_t p = 0; p < SCREEN_W * SCREEN_H; p++) {
+        wrong += !covered[p] && memcmp(&fb[p * WIRE_BPP], &prev[p * WIRE_BPP], WIRE_BPP) != 0;
+    }
+    return wrong;
+}
+
+static replay_result_t replay(const scene_t* scene, uint32_t window_cost) {
+    uint8_t* fb = calloc((size_t)SCREEN_W * SCREEN_H, 3);
+    uint8_t* prev = malloc((size_t)SCREEN_W * SCREEN_H * 3);
+    uint8_t* stripe = malloc((size_t)BUFFER_PIXELS * WIRE_BPP);
+    const bsp_area_merge_cfg_t cfg = {.bytes_per_pixel = WIRE_BPP, .window_overhead = window_cost,
+                                      .align = AREA_ALIGN};
+    replay_result_t res = {0};
+
+    bsp_sim_core_t core;
+    bsp_sim_core_init(&core, fb, SCREEN_W, SCREEN_H, PCLK_HZ, OVERHEAD_NS);
+    const uint8_t colmod = BSP_SIM_COLMOD_RGB565;
+    send(&core, BSP_SIM_CMD_COLMOD, &colmod, 1);
+    core.stats = (bsp_sim_stats_t){0};
+
+    int wrong = 0;
+    for (size_t f = 0; f < scene->count; f++) {
+        const frame_t* frame = &scene->frames[f];
+        bsp_area_t windows[MAX_AREAS];
+        memcpy(windows, frame->areas, frame->count * sizeof(bsp_area_t));
+        size_t count = bsp_area_merge(windows, frame->count, &cfg);
+
+        // The new content of this frame, one value for all its pixels
+        const uint8_t value[WIRE_BPP] = {(uint8_t)(f >> 8) | 0x80, (uint8_t)f};
+        for (size_t i = 0; i < BUFFER_PIXELS; i++) {
+            memcpy(&stripe[i * WIRE_BPP], value, WIRE_BPP);
+        }
+        memcpy(prev, fb, (size_t)SCREEN_W * SCREEN_H * 3);
+
+        size_t kept = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (!clip(&windows[i])) {
+                continue;
+            }
+            windows[kept++] = windows[i];
+
+            // LVGL renders a window in stripes of as many lines as fit the buffer, an even count for the rounder
+            const int32_t w = bsp_area_width(&windows[i]);
+            int32_t lines = (BUFFER_PIXELS / w) & ~(AREA_ALIGN - 1);
+            lines = lines > 0 ? lines : 1;
+            for (int32_t y = windows[i].y1; y <= windows[i].y2; y += lines) {
+                const int32_t y2 = y + lines - 1 < windows[i].y2 ? y + lines - 1 : windows[i].y2;
+                draw_bitmap(&core, windows[i].x1, y, windows[i].x2, y2, stripe);
+                res.flushes++;
+            }
+        }
+        res.windows += kept;
+        wrong += verify_frame(fb, prev, frame, windows, kept, value);
+    }
+    if (wrong) {
+        fprintf(stderr, "%d pixels wrong after replay\n", wrong);
+    }
+    TEST_CHECK_EQ(wrong, 0);
+
+    res.frames = scene->count;
+    res.link = core.stats;
+    free(fb);
+    free(prev);
+    free(stripe);
+    return res;
+}
+
+static void print_result(const char* name, const char* variant, const replay_result_t* r, bool all) {
+    const double frames = (double)r->frames;
+    printf("BENCH,replay %s%s windows,%.2f,/frame\n", name, variant, (double)r->windows / frames);
+    if (all) {
+        printf("BENCH,replay %s%s flushes,%.2f,/frame\n", name, variant, (double)r->flushes / frames);
+        printf("BENCH,replay %s%s bytes,%.0f,B/frame\n", name, variant, (double)r->link.pixel_bytes / frames);
+    }
+    printf("BENCH,replay %s%s wire,%.1f,us/frame\n", name, variant, (double)r->link.wire_ns / frames / 1000.0);
+}
+
+typedef struct {
+    char name[64];
+    unsigned long long windows;
+    unsigned long long transactions;
+    unsigned long long pixel_bytes;
+    unsigned long long wire_ns;
+} baseline_t;
+
+static bool baseline_find(const char* name, baseline_t* out) {
+    FILE* f = fopen(TEST_SCENE_DIR "/baseline.csv", "r");
+    if (f == NULL) {
+        return false;
+    }
+    char line[256];
+    bool found = false;
+    while (!found && fgets(line, sizeof(line), f)) {
+        found = line[0] != '#' && sscanf(line, "%63[^,],%llu,%llu,%llu,%llu", out->name, &out->windows,
+                                         &out->transactions, &out->pixel_bytes, &out->wire_ns) == 5 &&
+                strcmp(out->name, name) == 0;
+    }
+    fclose(f);
+    return found;
+}
+
+static void check_baseline(const char* name, const replay_result_t* r) {
+    baseline_t b;
+    if (!baseline_find(name, &b)) {
+        fprintf(stderr, "%s: not in scenes/baseline.csv, run test_sim_replay --update\n", name);
+        TEST_CHECK(false);
+        return;
+    }
+
+    const unsigned long long now[4] = {r->windows, (unsigned long long)r->link.commands + r->link.pixel_writes,
+                                       r->link.pixel_bytes, r->link.wire_ns};
+    const unsigned long long base[4] = {b.windows, b.transactions, b.pixel_bytes, b.wire_ns};
+    static const char* const what[4] = {"windows", "transactions", "pixel bytes", "wire ns"};
+    for (int i = 0; i < 4; i++) {
+        if (now[i] > base[i]) {
+            fprintf(stderr, "%s: %s went up from %llu to %llu\n", name, what[i], base[i], now[i]);
+            TEST_CHECK(false);
+        } else if (now[i] < base[i]) {
+            printf("  %s: %s went down from %llu to %llu, run test_sim_replay --update\n", name, what[i], base[i],
+                   now[i]);
+        }
+    }
+}
+
+static void test_scenes(bool update) {
+    FILE* out = NULL;
+    if (update) {
+        out = fopen(TEST_SCENE_DIR "/baseline.csv", "w");
+        TEST_CHECK(out != NULL);
+        if (out == NULL) {
+            return;
+        }
+        fprintf(out, "# Totals of test_sim_replay per scene, regenerate with test_sim_replay --update\n");
+        fprintf(out, "# scene,windows,transactions,pixel_bytes,wire_ns\n");
+    }
+
+    for (size_t i = 0; i < sizeof(scene_files) / sizeof(scene_files[0]); i++) {
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s", TEST_SCENE_DIR, scene_files[i]);
+        scene_t scene;
+        TEST_CHECK(load_scene(path, &scene));
+        if (scene.count == 0) {
+            continue;
+        }
+
+        char name[64];
+        snprintf(name, sizeof(name), "%.*s", (int)(strlen(scene_files[i]) - 4), scene_files[i]);
+        const replay_result_t merged = replay(&scene, WINDOW_COST);
+        const replay_result_t unmerged = replay(&scene, 0);
+        print_result(name, "", &merged, true);
+        print_result(name, " no window cost", &unmerged, false);
+
+        // The window cost trades bytes for windows, it never adds windows or wire time
+        TEST_CHECK(merged.windows <= unmerged.windows);
+        TEST_CHECK(merged.link.wire_ns <= unmerged.link.wire_ns);
+        if (out) {
+            fprintf(out, "%s,%llu,%llu,%llu,%llu\n", name, (unsigned long long)merged.windows,
+                    (unsigned long long)merged.link.commands + merged.link.pixel_writes,
+                    (unsigned long long)merged.link.pixel_bytes, (unsigned long long)merged.link.wire_ns);
+        } else {
+            check_baseline(name, &merged);
+        }
+        free(scene.frames);
+    }
+    if (out) {
+        fclose(out);
+    }
+}
+
+static bool update_baseline;
+
+static void test_baseline(void) {
+    test_scenes(update_baseline);
+}
+
+static void test_wire_model(void) {
+    bsp_sim_core_t core;
+    bsp_sim_core_init(&core, NULL, SCREEN_W, SCREEN_H, PCLK_HZ, 0);
+
+    // 32 clocks of opcode and address, then 4 bytes on one line: 64 clocks at 40 MHz
+    TEST_CHECK_EQ(bsp_sim_core_wire_ns(&core, 4, false), 1600);
+    // A full RGB565 frame on four lines
+    TEST_CHECK_EQ(bsp_sim_core_wire_ns(&core, SCREEN_W * SCREEN_H * 2, true), (32 + SCREEN_W * SCREEN_H * 4) * 25);
+
+    // The window cost is what CASET, RASET and the RAMWR command take, in pixel bytes on four lines
+    bsp_sim_core_init(&core, NULL, SCREEN_W, SCREEN_H, PCLK_HZ, OVERHEAD_NS);
+    const uint64_t window_ns = 2 * bsp_sim_core_wire_ns(&core, 4, false) + bsp_sim_core_wire_ns(&core, 0, true);
+    const uint64_t byte_ns = 2ULL * 1000000000ULL / PCLK_HZ;
+    TEST_CHECK_EQ(window_ns / byte_ns, WINDOW_COST);
+}
+
+static void test_window_wrap(void) {
+    uint8_t* fb = calloc((size_t)SCREEN_W * SCREEN_H, 3);
+    bsp_sim_core_t core;
+    bsp_sim_core_init(&core, fb, SCREEN_W, SCREEN_H, PCLK_HZ, 0);
+
+    // A 2x2 window written with six pixels wraps back to its top left corner
+    const uint8_t caset[4] = {0, 10, 0, 11};
+    const uint8_t raset[4] = {0, 20, 0, 21};
+    const uint8_t px[12] = {1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6};
+    bsp_sim_core_tx_param(&core, BSP_SIM_CMD_CASET, caset, 4);
+    bsp_sim_core_tx_param(&core, BSP_SIM_CMD_RASET, raset, 4);
+    bsp_sim_core_tx_color(&core, BSP_SIM_CMD_RAMWR, px, sizeof(px));
+    TEST_CHECK_EQ(fb[(20 * SCREEN_W + 10) * 2], 5);
+    TEST_CHECK_EQ(fb[(20 * SCREEN_W + 11) * 2], 6);
+    TEST_CHECK_EQ(fb[(21 * SCREEN_W + 10) * 2], 3);
+    TEST_CHECK_EQ(fb[(21 * SCREEN_W + 11) * 2], 4);
+
+    // With MX the same window lands mirrored
+    const uint8_t madctl = BSP_SIM_MADCTL_MX;
+    bsp_sim_core_tx_param(&core, BSP_SIM_CMD_MADCTL, &madctl, 1);
+    bsp_sim_core_tx_color(&core, BSP_SIM_CMD_RAMWR, px, 2);
+    TEST_CHECK_EQ(fb[(20 * SCREEN_W + SCREEN_W - 1 - 10) * 2], 1);
+    free(fb);
+}
+
+int main(int argc, char** argv) {
+    int first_log = 1;
+    if (argc > 1 && strcmp(argv[1], "--update") == 0) {
+        update_baseline = true;
+        first_log = 2;
+    }
+
+    TEST_RUN(test_wire_model);
+    TEST_RUN(test_window_wrap);
+    TEST_RUN(test_baseline);
+
+    // Captured logs, reported only
+    for (int i = first_log; i < argc; i++) {
+        scene_t scene;
+        if (!load_scene(argv[i], &scene)) {
+            test_failures++;
+            continue;
+        }
+        const replay_result_t r = replay(&scene, WINDOW_COST);
+        print_result(argv[i], "", &r, true);
+        free(scene.frames);
+    }
+    return test_failures;
+}
@@ -0,0 +1,244 @@
+/*
+ * Tear-free write scheduling against a simulated panel scan
+ *
+ * The simulated panel scans 16 blanking lines and 600 rows per refresh at its own period, which is not the
+ * nominal one the scheduler starts from. The scheduler only sees what the flush stage gives it: TE events with
+ * a few microseconds of jitter, or one scanline read. Every start time it reports as synced is then checked
+ * against the true scan: a window written at once must not be scanned while it is written, and a window
+ * written top to bottom must have every row written after the scan left it and before the next frame reaches
+ * it. A frame of draw buffer stripes written with and without the scheduler shows the tears it avoids and the
+ * time it waits, printed as BENCH lines.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include "bsp_te_sched.h"
+#include "test_common.h"
+
+#define ROWS            (600)
+#define BLANK_ROWS      (16)
+#define LINES           (ROWS + BLANK_ROWS)
+#define NOMINAL_US      (1000000 / 60)
+#define CASES           (20000)
+
+typedef struct {
+    double te0_us;      /* First TE */
+    double period_us;
+} scan_t;
+
+/**
+ * Time the scan reaches a row in frame k
+ */
+static double scan_row_us(const scan_t* scan, int64_t k, int32_t row) {
+    return scan->te0_us + (double)k * scan->period_us + (double)(BLANK_ROWS + row) * scan->period_us / LINES;
+}
+
+static double line_us(const scan_t* scan) {
+    return scan->period_us / LINES;
+}
+
+/**
+ * Frame in which the scan last reached a row at or before t
+ */
+static int64_t scan_frame(const scan_t* scan, double t, int32_t row) {
+    return (int64_t)floor((t - scan_row_us(scan, 0, row)) / scan->period_us);
+}
+
+static bool torn(const scan_t* scan, int64_t start_us, uint32_t write_us, int32_t row1, int32_t row2,
+                 bool progressive) {
+    const double start = (double)start_us;
+    const double end = start + write_us;
+    if (!progressive) {
+        // The scan of the window, [reaches row1, leaves row2), must not overlap the write in any frame
+        for (int64_t k = scan_frame(scan, start, row1) - 1; k <= scan_frame(scan, end, row1) + 1; k++) {
+            const double a = scan_row_us(scan, k, row1);
+            const double b = scan_row_us(scan, k, row2) + line_us(scan);
+            if (a < end && b > start) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Rows are written at a constant rate, each after the scan of frame k left it and before frame k + 1
+    const int64_t k = scan_frame(scan, start, row1);
+    const double row_write = (double)write_us / (row2 - row1 + 1);
+    for (int32_t r = row1; r <= row2; r++) {
+        const double w1 = start + (r - row1) * row_write;
+        const double w2 = w1 + row_write;
+        if (w1 < scan_row_us(scan, k, r) + line_us(scan) || w2 > scan_row_us(scan, k + 1, r)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static int32_t scan_line_at(const scan_t* scan, double t) {
+    const double in_frame = fmod(t - scan->te0_us, scan->period_us);
+    return (int32_t)(in_frame * LINES / scan->period_us);
+}
+
+static void init_sched(bsp_te_sched_t* sched) {
+    const bsp_te_sched_cfg_t cfg = {.frame_us = NOMINAL_US, .rows = ROWS, .blank_rows = BLANK_ROWS};
+    bsp_te_sched_init(sched, &cfg);
+}
+
+/**
+ * Feed TE events of a scan with up to +-2 us of jitter, returns the time of the last one
+ */
+static int64_t feed_te(bsp_te_sched_t* sched, const scan_t* scan, int frames, unsigned* seed) {
+    int64_t te_us = 0;
+    for (int k = 0; k < frames; k++) {
+        te_us = (int64_t)llround(scan->te0_us + k * scan->period_us) + (int64_t)(test_rand(seed) % 5) - 2;
+        bsp_te_sched_on_te(sched, te_us);
+    }
+    return te_us;
+}
+
+/**
+ * Random windows and write lengths from a random time within horizon_us. Returns the number of synced starts
+ * that tear on the true scan, and counts the synced ones.
+ */
+static int check_random_windows(const bsp_te_sched_t* sched, const scan_t* scan, int64_t from_us,
+                                uint32_t horizon_us, unsigned* seed, int* synced_count) {
+    int tears = 0;
+    *synced_count = 0;
+    for (int i = 0; i < CASES; i++) {
+        const int32_t row1 = (int32_t)(test_rand(seed) % ROWS);
+        const int32_t height = 1 + (int32_t)(test_rand(seed) % 300);
+        const int32_t row2 = row1 + height - 1 < ROWS ? row1 + height - 1 : ROWS - 1;
+        // From a small window to a 60-line stripe at 40 MHz
+        const uint32_t write_us = 20 + test_rand(seed) % 2800;
+        const bool progressive = test_rand(seed) & 1;
+        const int64_t earliest_us = from_us + (int64_t)((uint64_t)test_rand(seed) * horizon_us / 0x8000U);
+
+        bool synced;
+        const int64_t start_us = bsp_te_sched_start(sched, earliest_us, row1, row2, write_us, progressive, &synced);
+        TEST_CHECK(start_us >= earliest_us);
+        if (!synced) {
+            TEST_CHECK_EQ(start_us, earliest_us);
+            continue;
+        }
+        (*synced_count)++;
+        // Never more than a frame and a window late
+        TEST_CHECK(start_us - earliest_us <= (int64_t)sched->period_us + (int64_t)sched->period_us * height / ROWS);
+        if (torn(scan, start_us, write_us, row1, row2, progressive)) {
+            if (tears++ < 5) {
+                fprintf(stderr, "rows %ld-%ld, %lu us, %s: start %lld tears\n", (long)row1, (long)row2,
+                        (unsigned long)write_us, progressive ? "progressive" : "at once", (long long)start_us);
+            }
+        }
+    }
+    return tears;
+}
+
+static void test_unknown_scan(void) {
+    bsp_te_sched_t sched;
+    init_sched(&sched);
+    bool synced = true;
+    TEST_CHECK_EQ(bsp_te_sched_start(&sched, 1000, 0, 99, 500, true, &synced), 1000);
+    TEST_CHECK(!synced);
+    TEST_CHECK_EQ(bsp_te_sched_lines_behind(&sched, 1000, 10), 0);
+}
+
+static void test_period_tracking(void) {
+    // A panel running at 61 Hz behind a 60 Hz nominal period
+    const scan_t scan = {.te0_us = 1000000.0, .period_us = 16390.0};
+    bsp_te_sched_t sched;
+    init_sched(&sched);
+    unsigned seed = 3;
+    const int64_t last_us = feed_te(&sched, &scan, 64, &seed);
+    printf("  period %lu us after 64 TE, true %.0f us\n", (unsigned long)sched.period_us, scan.period_us);
+    TEST_CHECK(fabs(sched.period_us - scan.period_us) <= 2);
+
+    // A missed event moves the scan position but not the period
+    const uint32_t period_us = sched.period_us;
+    bsp_te_sched_on_te(&sched, last_us + 2 * (int64_t)period_us);
+    TEST_CHECK_EQ(sched.period_us, period_us);
+}
+
+static void test_te_no_tears(void) {
+    const scan_t scan = {.te0_us = 1000000.0, .period_us = 16390.0};
+    bsp_te_sched_t sched;
+    init_sched(&sched);
+    unsigned seed = 7;
+    const int64_t last_us = feed_te(&sched, &scan, 64, &seed);
+
+    // Up to two frames after the last TE, as when a TE is late or the flush stage is busy
+    int synced;
+    const int tears = check_random_windows(&sched, &scan, last_us, 2 * (uint32_t)scan.period_us, &seed, &synced);
+    printf("  TE: %d of %d windows synced, %d torn\n", synced, CASES, tears);
+    TEST_CHECK(synced > CASES / 2);
+    TEST_CHECK_EQ(tears, 0);
+}
+
+static void test_scanline_no_tears(void) {
+    // The scanline read runs once per frame, the model keeps the nominal period in between
+    const scan_t scan = {.te0_us = 2000123.0, .period_us = NOMINAL_US};
+    bsp_te_sched_t sched;
+    init_sched(&sched);
+    unsigned seed = 11;
+
+    const int64_t read_us = 2500000;
+    const int32_t line = scan_line_at(&scan, (double)read_us);
+    bsp_te_sched_on_scanline(&sched, read_us, line);
+
+    // The model puts the scan on the line that was read, and every row at its distance behind it
+    for (int32_t row = 0; row < ROWS; row += 37) {
+        const int32_t expected = (line - BLANK_ROWS - row + 2 * LINES) % LINES;
+        const int32_t behind = bsp_te_sched_lines_behind(&sched, read_us, row);
+        TEST_CHECK(abs(behind - expected) <= 1 || abs(behind - expected) >= LINES - 1);
+    }
+
+    int synced;
+    const int tears = check_random_windows(&sched, &scan, read_us, (uint32_t)scan.period_us, &seed, &synced);
+    printf("  scanline: %d of %d windows synced, %d torn\n", synced, CASES, tears);
+    TEST_CHECK(synced > CASES / 2);
+    TEST_CHECK_EQ(tears, 0);
+}
+
+/**
+ * Ten full-width 60-line stripes written top to bottom, back to back, from random frame starts
+ */
+static void test_frame_of_stripes(void) {
+    const scan_t scan = {.te0_us = 1000000.0, .period_us = 16390.0};
+    bsp_te_sched_t sched;
+    init_sched(&sched);
+    unsigned seed = 13;
+    const int64_t last_us = feed_te(&sched, &scan, 64, &seed);
+
+    // 450 x 60 RGB565 at 40 MHz on four lines, plus the window overhead of the flush stage
+    const uint32_t write_us = 20 + 450 * 60 * 2 * 2000000ULL / 40000000ULL;
+    const int frames = 200;
+    int naive_tears = 0;
+    int tears = 0;
+    int64_t waited_us = 0;
+    for (int f = 0; f < frames; f++) {
+        const int64_t frame_us = last_us + (int64_t)((uint64_t)test_rand(&seed) * (uint32_t)scan.period_us / 0x8000U);
+        int64_t bus_free_us = frame_us;
+        for (int32_t row = 0; row < ROWS; row += 60) {
+            naive_tears += torn(&scan, frame_us + (row / 60) * (int64_t)write_us, write_us, row, row + 59, true);
+
+            bool synced;
+            const int64_t start_us = bsp_te_sched_start(&sched, bus_free_us, row, row + 59, write_us, true, &synced);
+            TEST_CHECK(synced);
+            tears += torn(&scan, start_us, write_us, row, row + 59, true);
+            waited_us += start_us - bus_free_us;
+            bus_free_us = start_us + write_us;
+        }
+    }
+    printf("BENCH,te stripes torn unsynced,%.2f,/frame\n", (double)naive_tears / frames);
+    printf("BENCH,te stripes torn synced,%.2f,/frame\n", (double)tears / frames);
+    printf("BENCH,te stripes wait,%.0f,us/frame\n", (double)waited_us / frames);
+    TEST_CHECK(naive_tears > 0);
+    TEST_CHECK_EQ(tears, 0);
+}
+
+int main(void) {
+    TEST_RUN(test_unknown_scan);
+    TEST_RUN(test_period_tracking);
+    TEST_RUN(test_te_no_tears);
+    TEST_RUN(test_scanline_no_tears);
+    TEST_RUN(test_frame_of_stripes);
+    return test_failures;
+}
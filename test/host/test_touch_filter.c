@@ -0,0 +1,237 @@
+/*
+ * Touch sample filtering and prediction
+ *
+ * The traces in traces/ hold one bsp_touch sample per line, "t_us,x,y,pressed", at the CST226SE report rate:
+ * a finger held still with one spike, a fast vertical scroll, and two taps. They are synthetic, made to look
+ * like controller output (a few pixels of jitter, uneven report spacing). A trace captured on a board in the
+ * same format can be added to trace_files[] and is run through the generic checks.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bsp_touch_filter.h"
+#include "test_common.h"
+
+#define MAX_SAMPLES     (512)
+
+typedef struct {
+    int64_t t_us;
+    uint16_t x;
+    uint16_t y;
+    bool pressed;
+} trace_sample_t;
+
+typedef struct {
+    trace_sample_t s[MAX_SAMPLES];
+    size_t count;
+} trace_t;
+
+static const char* const trace_files[] = {"hold.csv", "swipe.csv", "taps.csv"};
+
+// Kconfig defaults of bsp_touch_reader_start()
+static const bsp_touch_filter_cfg_t default_cfg = {
+    .median_taps = 3,
+    .one_euro = true,
+    .min_cutoff_hz = 1.0f,
+    .beta = 0.007f,
+    .d_cutoff_hz = 1.0f,
+    .x_max = 449,
+    .y_max = 599,
+};
+
+static bool load_trace(const char* name, trace_t* trace) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", TEST_TRACE_DIR, name);
+    FILE* f = fopen(path, "r");
+    if (f == NULL) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return false;
+    }
+
+    char line[128];
+    trace->count = 0;
+    while (fgets(line, sizeof(line), f) && trace->count < MAX_SAMPLES) {
+        long long t;
+        unsigned x, y, pressed;
+        if (line[0] == '#' || sscanf(line, "%lld,%u,%u,%u", &t, &x, &y, &pressed) != 4) {
+            continue;
+        }
+        trace->s[trace->count++] = (trace_sample_t){t, (uint16_t)x, (uint16_t)y, pressed != 0};
+    }
+    fclose(f);
+    return trace->count > 0;
+}
+
+static void run_filter(const bsp_touch_filter_cfg_t* cfg, const trace_t* in, trace_t* out) {
+    bsp_touch_filter_t filter;
+    bsp_touch_filter_init(&filter, cfg);
+    *out = *in;
+    for (size_t i = 0; i < out->count; i++) {
+        bsp_touch_filter_apply(&filter, out->s[i].t_us, out->s[i].pressed, &out->s[i].x, &out->s[i].y);
+    }
+}
+
+/**
+ * Straight line through the pressed samples of a trace, least squares on each axis
+ */
+static void fit_line(const trace_t* trace, double* y0, double* vy) {
+    double st = 0, sy = 0, stt = 0, sty = 0;
+    size_t n = 0;
+    for (size_t i = 0; i < trace->count; i++) {
+        if (trace->s[i].pressed) {
+            const double t = (double)trace->s[i].t_us * 1e-6;
+            st += t;
+            sy += trace->s[i].y;
+            stt += t * t;
+            sty += t * trace->s[i].y;
+            n++;
+        }
+    }
+    *vy = (n * sty - st * sy) / (n * stt - st * st);
+    *y0 = (sy - *vy * st) / n;
+}
+
+static double spread(const trace_t* trace, size_t from, size_t to, bool use_x) {
+    double sum = 0, sum2 = 0;
+    for (size_t i = from; i < to; i++) {
+        const double v = use_x ? trace->s[i].x : trace->s[i].y;
+        sum += v;
+        sum2 += v * v;
+    }
+    const double n = (double)(to - from);
+    return sqrt(sum2 / n - (sum / n) * (sum / n));
+}
+
+// Checks that hold for any trace and any configuration
+static void check_generic(const bsp_touch_filter_cfg_t* cfg, const trace_t* in, const trace_t* out) {
+    bool contact = false;
+    for (size_t i = 0; i < in->count; i++) {
+        TEST_CHECK(out->s[i].x <= cfg->x_max && out->s[i].y <= cfg->y_max);
+        if (in->s[i].pressed && !contact) {
+            // First sample of a contact passes unchanged
+            TEST_CHECK_EQ(out->s[i].x, in->s[i].x);
+            TEST_CHECK_EQ(out->s[i].y, in->s[i].y);
+        }
+        contact = in->s[i].pressed;
+    }
+}
+
+static void test_traces_generic(void) {
+    static const uint8_t taps[] = {1, 3, 5};
+    for (size_t f = 0; f < sizeof(trace_files) / sizeof(trace_files[0]); f++) {
+        trace_t in, out;
+        TEST_CHECK(load_trace(trace_files[f], &in));
+        for (size_t t = 0; t < sizeof(taps) / sizeof(taps[0]); t++) {
+            for (int predict = 0; predict <= 1; predict++) {
+                bsp_touch_filter_cfg_t cfg = default_cfg;
+                cfg.median_taps = taps[t];
+                cfg.predict_us = predict ? 16000 : 0;
+                run_filter(&cfg, &in, &out);
+                check_generic(&cfg, &in, &out);
+            }
+        }
+    }
+}
+
+static void test_hold_jitter(void) {
+    trace_t in, out;
+    TEST_CHECK(load_trace("hold.csv", &in));
+    run_filter(&default_cfg, &in, &out);
+
+    // Skip the settling at the start of the contact and the release
+    const size_t from = 10;
+    const size_t to = in.count - 1;
+    const double raw = spread(&in, from, to, false);
+    const double filtered = spread(&out, from, to, false);
+    printf("  hold: y spread %.2f px raw, %.2f px filtered\n", raw, filtered);
+    TEST_CHECK(filtered < raw / 2);
+
+    // The spike is removed by the median
+    for (size_t i = from; i < to; i++) {
+        TEST_CHECK(abs((int)out.s[i].x - 225) <= 4);
+    }
+}
+
+static void test_median_off_still_filters(void) {
+    // One tap: the median window is always full, which must not be taken for the first sample of a contact
+    trace_t in, out;
+    bsp_touch_filter_cfg_t cfg = default_cfg;
+    cfg.median_taps = 1;
+    TEST_CHECK(load_trace("hold.csv", &in));
+    run_filter(&cfg, &in, &out);
+
+    size_t changed = 0;
+    for (size_t i = 1; i + 1 < in.count; i++) {
+        changed += out.s[i].x != in.s[i].x || out.s[i].y != in.s[i].y;
+    }
+    TEST_CHECK(changed > in.count / 2);
+    TEST_CHECK(spread(&out, 10, in.count - 1, false) < spread(&in, 10, in.count - 1, false) / 2);
+
+    // Without 1-euro, prediction alone still moves the point ahead of a moving finger
+    TEST_CHECK(load_trace("swipe.csv", &in));
+    cfg.one_euro = false;
+    cfg.predict_us = 16000;
+    run_filter(&cfg, &in, &out);
+    int ahead = 0;
+    for (size_t i = 5; i + 1 < in.count; i++) {
+        ahead += out.s[i].y > in.s[i].y;
+    }
+    TEST_CHECK(ahead > (int)(in.count - 6) / 2);
+}
+
+static double swipe_lag_px(const bsp_touch_filter_cfg_t* cfg, const trace_t* in) {
+    trace_t out;
+    double y0, vy;
+    fit_line(in, &y0, &vy);
+    run_filter(cfg, in, &out);
+
+    // Mean distance behind the finger once the filter settled
+    double lag = 0;
+    size_t n = 0;
+    for (size_t i = 5; i + 1 < in->count; i++) {
+        lag += y0 + vy * (double)in->s[i].t_us * 1e-6 - out.s[i].y;
+        n++;
+    }
+    return lag / (double)n;
+}
+
+static void test_swipe_prediction(void) {
+    trace_t in;
+    TEST_CHECK(load_trace("swipe.csv", &in));
+
+    bsp_touch_filter_cfg_t cfg = default_cfg;
+    const double lag = swipe_lag_px(&cfg, &in);
+    cfg.predict_us = 10000;
+    const double lag_predicted = swipe_lag_px(&cfg, &in);
+    printf("  swipe: %.1f px behind the finger, %.1f px with 10 ms prediction\n", lag, lag_predicted);
+
+    // 1-euro follows a fast finger closely, and prediction takes out most of what is left
+    TEST_CHECK(lag > 0 && lag < 40);
+    TEST_CHECK(fabs(lag_predicted) < lag / 2);
+}
+
+static void test_release_keeps_position(void) {
+    trace_t in, out;
+    TEST_CHECK(load_trace("taps.csv", &in));
+    bsp_touch_filter_cfg_t cfg = default_cfg;
+    cfg.predict_us = 16000;
+    run_filter(&cfg, &in, &out);
+
+    for (size_t i = 1; i < in.count; i++) {
+        if (!in.s[i].pressed && in.s[i - 1].pressed) {
+            // A tap does not move, so the release lands within the jitter of the press
+            TEST_CHECK(abs((int)out.s[i].x - (int)in.s[i].x) <= 2);
+            TEST_CHECK(abs((int)out.s[i].y - (int)in.s[i].y) <= 2);
+        }
+    }
+}
+
+int main(void) {
+    TEST_RUN(test_traces_generic);
+    TEST_RUN(test_hold_jitter);
+    TEST_RUN(test_median_off_still_filters);
+    TEST_RUN(test_swipe_prediction);
+    TEST_RUN(test_release_keeps_position);
+    return test_failures;
+}
@@ -0,0 +1,190 @@
+/*
+ * Lock-free UI update ring of bsp_display_post()
+ *
+ * Single-threaded cases cover the empty and full ring, look-ahead before release, and positions wrapping past
+ * the capacity and past UINT32_MAX. Then several producer threads push numbered messages against one consumer
+ * thread, with the positions starting just below UINT32_MAX. Every message must arrive exactly once, and the
+ * messages of each producer in the order it pushed them.
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bsp_ui_ring.h"
+#include "test_common.h"
+
+#define CAPACITY        (8)
+#define PRODUCERS       (4)
+#define PER_PRODUCER    (100000)
+
+/**
+ * Empty ring whose next position is start, as if start messages had gone through it
+ */
+static void init_at(bsp_ui_ring_t* ring, bsp_ui_cell_t* cells, uint32_t capacity, uint32_t start) {
+    bsp_ui_ring_init(ring, cells, capacity);
+    for (uint32_t i = 0; i < capacity; i++) {
+        const uint32_t pos = start + i;
+        atomic_store(&cells[pos & (capacity - 1)].seq, pos);
+    }
+    atomic_store(&ring->tail, start);
+    atomic_store(&ring->head, start);
+}
+
+static bsp_ui_msg_t msg_of(int32_t value) {
+    return (bsp_ui_msg_t){.obj = NULL, .arg.value = value};
+}
+
+static void test_empty_and_full(void) {
+    bsp_ui_cell_t cells[CAPACITY];
+    bsp_ui_ring_t ring;
+    bsp_ui_ring_init(&ring, cells, CAPACITY);
+    uint32_t retries = 0;
+
+    TEST_CHECK_EQ(bsp_ui_ring_ready(&ring, 100), 0);
+    TEST_CHECK_EQ(bsp_ui_ring_depth(&ring), 0);
+
+    for (int32_t i = 0; i < CAPACITY; i++) {
+        const bsp_ui_msg_t msg = msg_of(i);
+        TEST_CHECK(bsp_ui_ring_push(&ring, &msg, &retries));
+    }
+    const bsp_ui_msg_t extra = msg_of(99);
+    TEST_CHECK(!bsp_ui_ring_push(&ring, &extra, &retries));
+    TEST_CHECK_EQ(bsp_ui_ring_depth(&ring), CAPACITY);
+    TEST_CHECK_EQ(bsp_ui_ring_ready(&ring, 100), CAPACITY);
+    TEST_CHECK_EQ(bsp_ui_ring_ready(&ring, 3), 3);
+
+    // Looking ahead does not free anything
+    TEST_CHECK_EQ(bsp_ui_ring_at(&ring, 5)->arg.value, 5);
+    TEST_CHECK(!bsp_ui_ring_push(&ring, &extra, &retries));
+
+    // One released cell takes one more message, at the end
+    bsp_ui_ring_release(&ring, 1);
+    TEST_CHECK(bsp_ui_ring_push(&ring, &extra, &retries));
+    TEST_CHECK(!bsp_ui_ring_push(&ring, &extra, &retries));
+    TEST_CHECK_EQ(bsp_ui_ring_at(&ring, 0)->arg.value, 1);
+    TEST_CHECK_EQ(bsp_ui_ring_at(&ring, CAPACITY - 1)->arg.value, 99);
+
+    bsp_ui_ring_release(&ring, CAPACITY);
+    TEST_CHECK_EQ(bsp_ui_ring_ready(&ring, 100), 0);
+    TEST_CHECK_EQ(bsp_ui_ring_depth(&ring), 0);
+    TEST_CHECK_EQ(retries, 0);
+}
+
+/**
+ * Push and pop in uneven steps across many laps, from a given start position
+ */
+static void run_laps(uint32_t start) {
+    bsp_ui_cell_t cells[CAPACITY];
+    bsp_ui_ring_t ring;
+    init_at(&ring, cells, CAPACITY, start);
+    uint32_t retries = 0;
+    int32_t pushed = 0;
+    int32_t popped = 0;
+    int failures = 0;
+
+    for (int step = 0; step < 500; step++) {
+        const int burst = 1 + step % (CAPACITY + 2);
+        for (int i = 0; i < burst; i++) {
+            const bsp_ui_msg_t msg = msg_of(pushed);
+            const bool full = bsp_ui_ring_depth(&ring) == CAPACITY;
+            failures += bsp_ui_ring_push(&ring, &msg, &retries) == full;
+            pushed += full ? 0 : 1;
+        }
+        const size_t ready = bsp_ui_ring_ready(&ring, (size_t)(1 + step % 5));
+        for (size_t i = 0; i < ready; i++) {
+            failures += bsp_ui_ring_at(&ring, i)->arg.value != popped + (int32_t)i;
+        }
+        bsp_ui_ring_release(&ring, ready);
+        popped += (int32_t)ready;
+        failures += bsp_ui_ring_depth(&ring) != (uint32_t)(pushed - popped);
+    }
+    TEST_CHECK_EQ(failures, 0);
+    TEST_CHECK(pushed > 1000);
+    // The positions went round the 32-bit counter
+    TEST_CHECK_EQ(atomic_load(&ring.head), start + (uint32_t)popped);
+}
+
+static void test_wraparound(void) {
+    run_laps(0);
+    run_laps(UINT32_MAX - 3 * CAPACITY);
+    run_laps(UINT32_MAX);
+}
+
+typedef struct {
+    bsp_ui_ring_t* ring;
+    int32_t id;
+    uint32_t retries;
+    uint32_t full;
+} producer_t;
+
+static void* producer_main(void* arg) {
+    producer_t* p = arg;
+    for (int32_t n = 0; n < PER_PRODUCER; n++) {
+        const bsp_ui_msg_t msg = {.obj = (void*)(intptr_t)p->id, .arg.value = n};
+        while (!bsp_ui_ring_push(p->ring, &msg, &p->retries)) {
+            p->full++;
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void test_producers_against_consumer(void) {
+    bsp_ui_cell_t cells[CAPACITY * 4];
+    bsp_ui_ring_t ring;
+    init_at(&ring, cells, CAPACITY * 4, UINT32_MAX - 1000);
+
+    pthread_t threads[PRODUCERS];
+    producer_t producers[PRODUCERS];
+    for (int32_t i = 0; i < PRODUCERS; i++) {
+        producers[i] = (producer_t){.ring = &ring, .id = i};
+        TEST_CHECK(pthread_create(&threads[i], NULL, producer_main, &producers[i]) == 0);
+    }
+
+    // The consumer: each producer's messages must come in the order it pushed them, none lost or twice
+    int32_t next[PRODUCERS] = {0};
+    int failures = 0;
+    int64_t received = 0;
+    while (received < (int64_t)PRODUCERS * PER_PRODUCER) {
+        const size_t ready = bsp_ui_ring_ready(&ring, 7);
+        if (ready == 0) {
+            sched_yield();
+            continue;
+        }
+        for (size_t i = 0; i < ready; i++) {
+            const bsp_ui_msg_t* msg = bsp_ui_ring_at(&ring, i);
+            const intptr_t id = (intptr_t)msg->obj;
+            if (id < 0 || id >= PRODUCERS || msg->arg.value != next[id]) {
+                if (failures++ < 5) {
+                    fprintf(stderr, "producer %ld: got %ld\n", (long)id, (long)msg->arg.value);
+                }
+                continue;
+            }
+            next[id]++;
+        }
+        bsp_ui_ring_release(&ring, ready);
+        received += (int64_t)ready;
+    }
+
+    uint32_t retries = 0;
+    uint32_t full = 0;
+    for (int32_t i = 0; i < PRODUCERS; i++) {
+        pthread_join(threads[i], NULL);
+        retries += producers[i].retries;
+        full += producers[i].full;
+        TEST_CHECK_EQ(next[i], PER_PRODUCER);
+    }
+    printf("  %d producers x %d messages, %lu lost races, %lu pushes to a full ring\n", PRODUCERS, PER_PRODUCER,
+           (unsigned long)retries, (unsigned long)full);
+    TEST_CHECK_EQ(failures, 0);
+    TEST_CHECK_EQ(bsp_ui_ring_ready(&ring, 100), 0);
+    TEST_CHECK_EQ(bsp_ui_ring_depth(&ring), 0);
+}
+
+int main(void) {
+    TEST_RUN(test_empty_and_full);
+    TEST_RUN(test_wraparound);
+    TEST_RUN(test_producers_against_consumer);
+    return test_failures;
+}
@@ -0,0 +1,190 @@
+/*
+ * Panel memory layout under hardware vertical scrolling
+ *
+ * A model panel shows its memory the way the RM690B0 does under VSCRDEF and VSCSAD: rows of the band come from
+ * the start row on, wrapping inside the band, rows outside it come straight from memory. Rows written through
+ * bsp_vscroll_map() must then show up on the screen rows they were written for, with any band and after any
+ * scroll, and scrolling must move what is on the screen by dy rows inside the band, in both directions.
+ */
+
+#include <string.h>
+#include "bsp_vscroll.h"
+#include "test_common.h"
+
+#define ROWS    (600)
+
+/**
+ * Memory row the panel shows on a screen row, from the VSCRDEF and VSCSAD parameters alone
+ */
+static int32_t panel_row(const bsp_vscroll_t* vscroll, int32_t row) {
+    uint16_t def[3];
+    bsp_vscroll_def(vscroll, def);
+    const int32_t top = def[0];
+    const int32_t height = def[1];
+    const int32_t start = bsp_vscroll_start(vscroll);
+    if (row < top || row >= top + height) {
+        return row;
+    }
+    return top + (row - top + start - top) % height;
+}
+
+/**
+ * Write rows row1 to row2 into memory through the mapping, each with its screen row as value. Returns the
+ * number of broken spans.
+ */
+static int write_rows(const bsp_vscroll_t* vscroll, int32_t* memory, int32_t row1, int32_t row2) {
+    bsp_vscroll_span_t spans[BSP_VSCROLL_MAX_SPANS + 1];
+    spans[BSP_VSCROLL_MAX_SPANS].row1 = -1;
+    const size_t count = bsp_vscroll_map(vscroll, row1, row2, spans);
+    int broken = count == 0 || count > BSP_VSCROLL_MAX_SPANS || spans[BSP_VSCROLL_MAX_SPANS].row1 != -1;
+    if (broken) {
+        return broken;
+    }
+
+    // Spans cover the rows in screen order, without gaps, and stay inside the panel memory
+    int32_t next = row1;
+    for (size_t i = 0; i < count; i++) {
+        const int32_t mem2 = spans[i].mem_row1 + spans[i].row2 - spans[i].row1;
+        broken += spans[i].row1 != next || spans[i].row2 < spans[i].row1 || spans[i].mem_row1 < 0 || mem2 >= ROWS;
+        for (int32_t r = spans[i].row1; r <= spans[i].row2 && r - spans[i].row1 + spans[i].mem_row1 < ROWS; r++) {
+            memory[spans[i].mem_row1 + r - spans[i].row1] = r;
+        }
+        next = spans[i].row2 + 1;
+    }
+    broken += next != row2 + 1;
+    return broken;
+}
+
+static void test_registers(void) {
+    bsp_vscroll_t vscroll;
+    uint16_t def[3];
+
+    // Without a band the whole panel is one scroll area at its first row
+    bsp_vscroll_init(&vscroll, ROWS);
+    bsp_vscroll_def(&vscroll, def);
+    TEST_CHECK(def[0] == 0 && def[1] == ROWS && def[2] == 0);
+    TEST_CHECK_EQ(bsp_vscroll_start(&vscroll), 0);
+    bsp_vscroll_scroll(&vscroll, 17);
+    TEST_CHECK_EQ(bsp_vscroll_start(&vscroll), 0);
+
+    bsp_vscroll_set_band(&vscroll, 100, 300);
+    bsp_vscroll_def(&vscroll, def);
+    TEST_CHECK(def[0] == 100 && def[1] == 300 && def[2] == 200);
+    TEST_CHECK_EQ(bsp_vscroll_start(&vscroll), 100);
+    bsp_vscroll_scroll(&vscroll, 10);
+    TEST_CHECK_EQ(bsp_vscroll_start(&vscroll), 110);
+
+    // Negative steps and steps longer than the band wrap inside it
+    bsp_vscroll_scroll(&vscroll, -20);
+    TEST_CHECK_EQ(bsp_vscroll_start(&vscroll), 390);
+    bsp_vscroll_scroll(&vscroll, 300 * 3 + 15);
+    TEST_CHECK_EQ(bsp_vscroll_start(&vscroll), 105);
+    bsp_vscroll_scroll(&vscroll, -300 * 5 - 5);
+    TEST_CHECK_EQ(bsp_vscroll_start(&vscroll), 100);
+
+    // A new band starts unscrolled, and is clamped to the panel
+    bsp_vscroll_scroll(&vscroll, 42);
+    bsp_vscroll_set_band(&vscroll, -5, 1000);
+    bsp_vscroll_def(&vscroll, def);
+    TEST_CHECK(def[0] == 0 && def[1] == ROWS && def[2] == 0);
+    TEST_CHECK_EQ(bsp_vscroll_start(&vscroll), 0);
+    bsp_vscroll_set_band(&vscroll, 550, 100);
+    bsp_vscroll_def(&vscroll, def);
+    TEST_CHECK(def[0] == 550 && def[1] == 50 && def[2] == 0);
+
+    // A band of no rows is no band
+    bsp_vscroll_set_band(&vscroll, 200, 0);
+    bsp_vscroll_scroll(&vscroll, 5);
+    bsp_vscroll_def(&vscroll, def);
+    TEST_CHECK(def[0] == 0 && def[1] == ROWS && def[2] == 0);
+    TEST_CHECK_EQ(bsp_vscroll_start(&vscroll), 0);
+}
+
+static void test_map(void) {
+    bsp_vscroll_t vscroll;
+    bsp_vscroll_span_t spans[BSP_VSCROLL_MAX_SPANS];
+    bsp_vscroll_init(&vscroll, ROWS);
+
+    // Unscrolled, memory matches the screen in one run
+    TEST_CHECK_EQ(bsp_vscroll_map(&vscroll, 10, 500, spans), 1);
+    bsp_vscroll_set_band(&vscroll, 100, 300);
+    TEST_CHECK_EQ(bsp_vscroll_map(&vscroll, 0, ROWS - 1, spans), 1);
+    TEST_CHECK(spans[0].row1 == 0 && spans[0].row2 == ROWS - 1 && spans[0].mem_row1 == 0);
+
+    // Scrolled by 50: the band shows memory rows 150 to 399, then 100 to 149
+    bsp_vscroll_scroll(&vscroll, 50);
+    TEST_CHECK_EQ(bsp_vscroll_map(&vscroll, 0, ROWS - 1, spans), 4);
+    TEST_CHECK(spans[0].row1 == 0 && spans[0].row2 == 99 && spans[0].mem_row1 == 0);
+    TEST_CHECK(spans[1].row1 == 100 && spans[1].row2 == 349 && spans[1].mem_row1 == 150);
+    TEST_CHECK(spans[2].row1 == 350 && spans[2].row2 == 399 && spans[2].mem_row1 == 100);
+    TEST_CHECK(spans[3].row1 == 400 && spans[3].row2 == ROWS - 1 && spans[3].mem_row1 == 400);
+
+    // Rows on one side of the wrap are one run
+    TEST_CHECK_EQ(bsp_vscroll_map(&vscroll, 360, 380, spans), 1);
+    TEST_CHECK(spans[0].row1 == 360 && spans[0].row2 == 380 && spans[0].mem_row1 == 110);
+    TEST_CHECK_EQ(bsp_vscroll_map(&vscroll, 348, 351, spans), 2);
+    TEST_CHECK(spans[0].row2 == 349 && spans[0].mem_row1 == 398 && spans[1].row1 == 350 && spans[1].mem_row1 == 100);
+
+    // Scrolled back by 60: the band shows memory rows 390 to 399, then 100 to 389
+    bsp_vscroll_scroll(&vscroll, -60);
+    TEST_CHECK_EQ(bsp_vscroll_map(&vscroll, 100, 399, spans), 2);
+    TEST_CHECK(spans[0].row1 == 100 && spans[0].row2 == 109 && spans[0].mem_row1 == 390);
+    TEST_CHECK(spans[1].row1 == 110 && spans[1].row2 == 399 && spans[1].mem_row1 == 100);
+
+    // Rows outside the band are never moved
+    TEST_CHECK_EQ(bsp_vscroll_map(&vscroll, 420, 430, spans), 1);
+    TEST_CHECK(spans[0].mem_row1 == 420);
+}
+
+/**
+ * Random bands, steps and writes against the model panel
+ */
+static void test_against_panel(void) {
+    static int32_t memory[ROWS];
+    unsigned seed = 11;
+    int broken = 0;
+    int wrong = 0;
+    int moved_wrong = 0;
+
+    for (int band = 0; band < 300; band++) {
+        bsp_vscroll_t vscroll;
+        bsp_vscroll_init(&vscroll, ROWS);
+        const int32_t top = (int32_t)(test_rand(&seed) % ROWS);
+        const int32_t height = band % 10 == 0 ? 0 : 1 + (int32_t)(test_rand(&seed) % (ROWS - top));
+        bsp_vscroll_set_band(&vscroll, top, height);
+
+        for (int step = 0; step < 20; step++) {
+            // Fill the screen in chunks of random height, each row with its screen row as value
+            for (int32_t row = 0; row < ROWS;) {
+                const int32_t row2 = row + (int32_t)(test_rand(&seed) % 97);
+                broken += write_rows(&vscroll, memory, row, row2 < ROWS ? row2 : ROWS - 1);
+                row = row2 + 1;
+            }
+            for (int32_t row = 0; row < ROWS; row++) {
+                wrong += memory[panel_row(&vscroll, row)] != row;
+            }
+
+            // Scrolling moves the band content dy rows towards row 0, wrapping, and leaves the rest alone
+            const int32_t span = height ? 2 * height : 10;
+            const int32_t dy = (int32_t)(test_rand(&seed) % (2 * span + 1)) - span;
+            bsp_vscroll_scroll(&vscroll, dy);
+            for (int32_t row = 0; row < ROWS; row++) {
+                int32_t expected = row;
+                if (height && row >= top && row < top + height) {
+                    expected = top + ((row - top + dy) % height + height) % height;
+                }
+                moved_wrong += memory[panel_row(&vscroll, row)] != expected;
+            }
+        }
+    }
+    TEST_CHECK_EQ(broken, 0);
+    TEST_CHECK_EQ(wrong, 0);
+    TEST_CHECK_EQ(moved_wrong, 0);
+}
+
+int main(void) {
+    TEST_RUN(test_registers);
+    TEST_RUN(test_map);
+    TEST_RUN(test_against_panel);
+    return test_failures;
+}
@@ -0,0 +1,241 @@
+#!/usr/bin/env python3
+"""Pack images into an asset blob for the LilyGo T4 S3 BSP.
+
+The blob is read by bsp_assets_open() and its images are shown with BSP_ASSET("name"). See
+priv_include/bsp_asset_codec.h for the format.
+
+    bsp_assets_pack.py -o spiffs/assets.bin logo.png background.png
+    bsp_assets_pack.py --verify spiffs/assets.bin
+
+Images are named after their file name without extension, at most 20 characters. Packing needs Pillow,
+verifying a blob does not.
+"""
+
+import argparse
+import os
+import struct
+import sys
+import time
+
+MAGIC = b"BSPA"
+VERSION = 1
+HEADER = struct.Struct("<4sHHHHI")
+ENTRY = struct.Struct("<20sHHBBHI")
+NAME_LEN = 20
+
+FORMAT_RGB565 = 1
+FORMAT_RGB888 = 2
+FORMATS = {"rgb565": FORMAT_RGB565, "rgb888": FORMAT_RGB888}
+BYTES_PER_PIXEL = {FORMAT_RGB565: 2, FORMAT_RGB888: 3}
+
+OP_INDEX = 0x00
+OP_RUN = 0x40
+OP_LITERAL = 0x80
+OP_LONG_RUN = 0xC0
+RUN_MAX = 64
+LONG_RUN_BIAS = 65
+LONG_RUN_MAX = 0x3FFF + LONG_RUN_BIAS
+LITERAL_MAX = 64
+
+
+def pixel_hash(px):
+    return ((px * 0x9E3779B1) & 0xFFFFFFFF) >> 26
+
+
+def to_pixels(rgb, fmt):
+    """Convert RGB888 bytes to the pixel values the panel format stores, matching LVGL's conversion."""
+    pixels = []
+    for i in range(0, len(rgb), 3):
+        r, g, b = rgb[i], rgb[i + 1], rgb[i + 2]
+        if fmt == FORMAT_RGB565:
+            pixels.append(((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3))
+        else:
+            pixels.append(b | (g << 8) | (r << 16))
+    return pixels
+
+
+def encode(pixels, bpp):
+    out = bytearray()
+    table = [0] * 64
+    prev = 0
+    i = 0
+    n = len(pixels)
+    while i < n:
+        px = pixels[i]
+        if px == prev:
+            run = 1
+            while i + run < n and run < LONG_RUN_MAX and pixels[i + run] == prev:
+                run += 1
+            if run <= RUN_MAX:
+                out.append(OP_RUN | (run - 1))
+            else:
+                count = run - LONG_RUN_BIAS
+                out.append(OP_LONG_RUN | (count >> 8))
+                out.append(count & 0xFF)
+            i += run
+        elif table[pixel_hash(px)] == px:
+            out.append(OP_INDEX | pixel_hash(px))
+            prev = px
+            i += 1
+        else:
+            start = i
+            # A literal ends where a run or a table hit can take over
+            while i < n and i - start < LITERAL_MAX:
+                px = pixels[i]
+                if i > start and (px == prev or table[pixel_hash(px)] == px):
+                    break
+                table[pixel_hash(px)] = px
+                prev = px
+                i += 1
+            out.append(OP_LITERAL | (i - start - 1))
+            for px in pixels[start:i]:
+                out += px.to_bytes(bpp, "little")
+    return bytes(out)
+
+
+def decode(data, pixels, bpp):
+    out = []
+    table = [0] * 64
+    prev = 0
+    pos = 0
+    while len(out) < pixels and pos < len(data):
+        op = data[pos]
+        pos += 1
+        kind = op & 0xC0
+        count = (op & 0x3F) + 1
+        if kind == OP_INDEX:
+            prev = table[op & 0x3F]
+            out.append(prev)
+        elif kind == OP_LITERAL:
+            for _ in range(count):
+                prev = int.from_bytes(data[pos:pos + bpp], "little")
+                table[pixel_hash(prev)] = prev
+                out.append(prev)
+                pos += bpp
+        else:
+            if kind == OP_LONG_RUN:
+                count = ((op & 0x3F) << 8 | data[pos]) + LONG_RUN_BIAS
+                pos += 1
+            out.extend([prev] * count)
+    if len(out) != pixels or pos != len(data):
+        raise ValueError("tile decodes to %d of %d pixels" % (len(out), pixels))
+    return out
+
+
+def pack(images, fmt, tile_lines):
+    """images is a list of (name, width, height, pixels). Returns the blob."""
+    bpp = BYTES_PER_PIXEL[fmt]
+    index = bytearray()
+    body = bytearray()
+    max_tile = 0
+    body_start = HEADER.size + ENTRY.size * len(images)
+
+    for name, width, height, pixels in images:
+        tiles = []
+        for y in range(0, height, tile_lines):
+            lines = min(tile_lines, height - y)
+            tiles.append(encode(pixels[y * width:(y + lines) * width], bpp))
+        table_offset = body_start + len(body)
+        offset = table_offset + 4 * (len(tiles) + 1)
+        for tile in tiles:
+            body += struct.pack("<I", offset)
+            offset += len(tile)
+        body += struct.pack("<I", offset)
+        for tile in tiles:
+            body += tile
+            max_tile = max(max_tile, len(tile))
+        index += ENTRY.pack(name.encode()[:NAME_LEN], width, height, fmt, 0, len(tiles), table_offset)
+
+    return HEADER.pack(MAGIC, VERSION, len(images), tile_lines, 0, max_tile) + bytes(index) + bytes(body)
+
+
+def verify(blob, originals=None):
+    """Check the index and decode every tile. Returns the number of problems found."""
+    magic, version, count, tile_lines, _, max_tile = HEADER.unpack_from(blob, 0)
+    if magic != MAGIC or version != VERSION or tile_lines == 0:
+        print("not an asset blob of version %d" % VERSION)
+        return 1
+
+    errors = 0
+    for i in range(count):
+        raw_name, width, height, fmt, _, tiles, table_offset = ENTRY.unpack_from(blob, HEADER.size + i * ENTRY.size)
+        name = raw_name.rstrip(b"\0").decode()
+        bpp = BYTES_PER_PIXEL.get(fmt)
+        if bpp is None or tiles != (height + tile_lines - 1) // tile_lines:
+            print("%s: bad format or tile count" % name)
+            errors += 1
+            continue
+        offsets = struct.unpack_from("<%dI" % (tiles + 1), blob, table_offset)
+        pixels = []
+        start = time.perf_counter()
+        for t in range(tiles):
+            begin, end = offsets[t], offsets[t + 1]
+            if not begin <= end <= len(blob) or end - begin > max_tile:
+                print("%s: tile %d out of bounds" % (name, t))
+                errors += 1
+                break
+            lines = min(tile_lines, height - t * tile_lines)
+            try:
+                pixels += decode(blob[begin:end], width * lines, bpp)
+            except ValueError as e:
+                print("%s: tile %d: %s" % (name, t, e))
+                errors += 1
+                break
+        elapsed = time.perf_counter() - start
+        if originals is not None and name in originals and originals[name] != pixels:
+            print("%s: decoded pixels differ from the source image" % name)
+            errors += 1
+        raw = width * height * bpp
+        packed = offsets[-1] - offsets[0]
+        print("%-20s %4dx%-4d %7d bytes, %5.1f%% of %7d, %d tiles, host decode %.0f ms" %
+              (name, width, height, packed, 100.0 * packed / raw, raw, tiles, elapsed * 1000))
+    return errors
+
+
+def load_image(path, fmt):
+    from PIL import Image
+
+    with Image.open(path) as img:
+        img = img.convert("RGB")
+        return img.width, img.height, to_pixels(img.tobytes(), fmt)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("images", nargs="*", help="images to pack")
+    parser.add_argument("-o", "--output", help="blob to write")
+    parser.add_argument("-f", "--format", choices=FORMATS, default="rgb565", help="pixel format (default rgb565)")
+    parser.add_argument("-t", "--tile-lines", type=int, default=16, help="lines per tile (default 16)")
+    parser.add_argument("--verify", metavar="BLOB", help="check and decode an existing blob")
+    args = parser.parse_args()
+
+    if args.verify:
+        with open(args.verify, "rb") as f:
+            return 1 if verify(f.read()) else 0
+
+    if not args.images or not args.output:
+        parser.error("images and --output are required to pack")
+    if not 1 <= args.tile_lines <= 0xFFFF:
+        parser.error("--tile-lines must be between 1 and 65535")
+
+    fmt = FORMATS[args.format]
+    images = []
+    for path in args.images:
+        name = os.path.splitext(os.path.basename(path))[0]
+        if len(name.encode()) > NAME_LEN:
+            parser.error("%s: name longer than %d bytes" % (name, NAME_LEN))
+        width, height, pixels = load_image(path, fmt)
+        images.append((name, width, height, pixels))
+
+    blob = pack(images, fmt, args.tile_lines)
+    errors = verify(blob, {name: pixels for name, _, _, pixels in images})
+    if errors:
+        return 1
+    with open(args.output, "wb") as f:
+        f.write(blob)
+    print("%s: %d images, %d bytes" % (args.output, len(images), len(blob)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,138 @@
+#!/usr/bin/env python3
+"""Collect the results of examples/display_benchmark and regenerate the benchmark table of the README.
+
+The benchmark logs one "BENCH,<name>,<value>,<unit>" line per BSP microbenchmark, and LVGL logs its summary
+table of the benchmark scenes at the end. Capture the whole log, then:
+
+    idf.py -p PORT flash monitor | tee bench.log
+    bsp_benchmark_readme.py bench.log --json bench.json --readme README.md
+
+The README is rewritten between "<!-- START_BENCHMARK -->" and "<!-- END_BENCHMARK -->". With --check nothing
+is written, the exit status tells whether the README differs from the log, so CI can flag stale numbers.
+
+The host scene replay prints the same BENCH lines. Its block is selected with --marker:
+
+    test_sim_replay | bsp_benchmark_readme.py - --marker HOST_BENCHMARK --readme README.md
+"""
+
+import argparse
+import json
+import re
+import sys
+
+DEFAULT_MARKER = "BENCHMARK"
+LVGL_COLUMNS = ("Name", "Avg. CPU", "Avg. FPS", "Avg. time", "render time", "flush time")
+
+BENCH_LINE = re.compile(r"BENCH,([^,]+),(-?[0-9.]+),(\S*)")
+ANSI = re.compile(r"\x1b\[[0-9;]*m")
+
+
+def parse_lvgl_row(line):
+    """One scene of the LVGL summary, comma separated or as a markdown table row. None if it is not one."""
+    fields = [f.strip() for f in re.split(r"[,|]", line.strip().strip("|"))]
+    if len(fields) != len(LVGL_COLUMNS) or not fields[1].endswith("%"):
+        return None
+    try:
+        values = [int(fields[1][:-1])] + [int(f) for f in fields[2:]]
+    except ValueError:
+        return None
+    return dict(zip(("name", "cpu", "fps", "time", "render", "flush"), [fields[0]] + values))
+
+
+def parse_log(lines):
+    """Returns (LVGL scenes, BSP microbenchmarks). The last LVGL summary in the log wins."""
+    scenes = []
+    bench = {}
+    in_summary = False
+
+    for raw in lines:
+        line = ANSI.sub("", raw).rstrip()
+        match = BENCH_LINE.search(line)
+        if match:
+            bench[match.group(1)] = {"value": float(match.group(2)), "unit": match.group(3)}
+            continue
+        if "Avg. CPU" in line and "Avg. FPS" in line:
+            scenes = []
+            in_summary = True
+            continue
+        if in_summary:
+            row = parse_lvgl_row(line)
+            if row:
+                scenes.append(row)
+            elif scenes:
+                in_summary = False
+
+    return scenes, [dict(name=name, **result) for name, result in bench.items()]
+
+
+def render_tables(scenes, bench):
+    out = []
+    if scenes:
+        out.append("| " + " | ".join(LVGL_COLUMNS) + " |")
+        out.append("| ---- | :------: | :------: | :-------: | :---------: | :--------: |")
+        for s in scenes:
+            out.append(f"| {s['name']} | {s['cpu']}%  | {s['fps']}  | {s['time']}  | {s['render']}  | {s['flush']}  |")
+        out.append("")
+    if bench:
+        out.append("| BSP benchmark | Result |")
+        out.append("| ------------- | -----: |")
+        for b in bench:
+            out.append(f"| {b['name']} | {b['value']:.2f} {b['unit']} |")
+        out.append("")
+    return "\n".join(out)
+
+
+def update_readme(text, tables, marker=DEFAULT_MARKER):
+    """Returns the README with the block between the START_<marker> and END_<marker> comments replaced."""
+    start_marker = f"<!-- START_{marker} -->"
+    end_marker = f"<!-- END_{marker} -->"
+    start = text.find(start_marker)
+    end = text.find(end_marker)
+    if start < 0 or end < start:
+        raise ValueError(f"README needs {start_marker} followed by {end_marker}")
+    return text[:start + len(start_marker)] + "\n\n" + tables + "\n" + text[end:]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("log", help="Captured benchmark log, - for stdin")
+    parser.add_argument("--json", help="Write the results as JSON to this file")
+    parser.add_argument("--readme", help="README to update")
+    parser.add_argument("--check", action="store_true", help="Only check that the README is up to date")
+    parser.add_argument("--marker", default=DEFAULT_MARKER,
+                        help="README block to rewrite, between START_<marker> and END_<marker> comments")
+    args = parser.parse_args()
+
+    if args.log == "-":
+        scenes, bench = parse_log(sys.stdin)
+    else:
+        with open(args.log, encoding="utf-8", errors="replace") as f:
+            scenes, bench = parse_log(f)
+    if not scenes and not bench:
+        sys.exit(f"{args.log}: no benchmark results found")
+    print(f"{len(scenes)} LVGL scenes, {len(bench)} BSP results")
+
+    if args.json:
+        with open(args.json, "w", encoding="utf-8") as f:
+            json.dump({"lvgl": scenes, "bsp": bench}, f, indent=2)
+            f.write("\n")
+
+    if args.readme:
+        with open(args.readme, encoding="utf-8") as f:
+            text = f.read()
+        try:
+            updated = update_readme(text, render_tables(scenes, bench), args.marker)
+        except ValueError as e:
+            sys.exit(f"{args.readme}: {e}")
+        if args.check:
+            if updated != text:
+                sys.exit(f"{args.readme}: benchmark table is out of date")
+            print(f"{args.readme}: up to date")
+        elif updated != text:
+            with open(args.readme, "w", encoding="utf-8") as f:
+                f.write(updated)
+            print(f"{args.readme}: updated")
+
+
+if __name__ == "__main__":
+    main()
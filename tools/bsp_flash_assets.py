@@ -0,0 +1,183 @@
+#!/usr/bin/env python3
+"""Build and check the memory-mapped asset partition of the LilyGo T4 S3 BSP.
+
+The partition is mapped by bsp_flash_assets_mount(), and its assets are used in place from flash. See
+priv_include/bsp_asset_index.h for the layout.
+
+    bsp_flash_assets.py build -o assets.img --size 0x200000 logo.png icons.png Montserrat.ttf
+    bsp_flash_assets.py check assets.img
+    parttool.py write_partition --partition-name assets --input assets.img
+
+Assets are named after their file name without extension, at most 24 characters. PNG, JPEG and BMP files
+become images (RGB565 by default, ARGB8888 when they have transparency), TTF and OTF files become fonts, and
+anything else is stored as raw data. Building images needs Pillow, checking does not.
+"""
+
+import argparse
+import os
+import struct
+import sys
+import zlib
+
+MAGIC = b"BSPM"
+VERSION = 1
+HEADER = struct.Struct("<4sHHII")
+ENTRY = struct.Struct("<24sBBHHHIIII")
+NAME_LEN = 24
+ALIGN = 16
+
+KIND_DATA = 0
+KIND_IMAGE = 1
+KIND_FONT = 2
+KIND_NAMES = {KIND_DATA: "data", KIND_IMAGE: "image", KIND_FONT: "font"}
+
+PIXEL_NONE = 0
+PIXEL_RGB565 = 1
+PIXEL_RGB888 = 2
+PIXEL_ARGB8888 = 3
+PIXELS = {"rgb565": PIXEL_RGB565, "rgb888": PIXEL_RGB888, "argb8888": PIXEL_ARGB8888}
+BYTES_PER_PIXEL = {PIXEL_RGB565: 2, PIXEL_RGB888: 3, PIXEL_ARGB8888: 4}
+
+IMAGE_EXT = (".png", ".jpg", ".jpeg", ".bmp")
+FONT_EXT = (".ttf", ".otf")
+
+
+def convert_image(path, fmt):
+    """Returns (format, width, height, pixel bytes) in the byte order LVGL uses."""
+    from PIL import Image
+
+    with Image.open(path) as img:
+        has_alpha = img.mode in ("RGBA", "LA", "PA") or "transparency" in img.info
+        if fmt is None:
+            fmt = PIXEL_ARGB8888 if has_alpha else PIXEL_RGB565
+        rgba = img.convert("RGBA").tobytes()
+        width, height = img.width, img.height
+
+    out = bytearray()
+    for i in range(0, len(rgba), 4):
+        r, g, b, a = rgba[i:i + 4]
+        if fmt == PIXEL_RGB565:
+            out += struct.pack("<H", ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3))
+        elif fmt == PIXEL_RGB888:
+            out += bytes((b, g, r))
+        else:
+            out += bytes((b, g, r, a))
+    return fmt, width, height, bytes(out)
+
+
+def build(assets, size):
+    """assets is a list of (name, kind, format, width, height, data). Returns the partition image."""
+    assets = sorted(assets, key=lambda a: a[0].encode())
+    offset = HEADER.size + ENTRY.size * len(assets)
+    entries = bytearray()
+    body = bytearray()
+
+    for name, kind, fmt, width, height, data in assets:
+        offset = (offset + ALIGN - 1) & ~(ALIGN - 1)
+        body += bytes(offset - HEADER.size - ENTRY.size * len(assets) - len(body))
+        stride = width * BYTES_PER_PIXEL[fmt] if kind == KIND_IMAGE else 0
+        entries += ENTRY.pack(name.encode(), kind, fmt, width, height, 0, stride, offset, len(data), 0)
+        body += data
+        offset += len(data)
+
+    image_size = HEADER.size + len(entries) + len(body)
+    if size and image_size > size:
+        raise ValueError("assets need %d bytes, the partition has %d" % (image_size, size))
+    header = HEADER.pack(MAGIC, VERSION, len(assets), image_size, zlib.crc32(entries) & 0xFFFFFFFF)
+    return header + bytes(entries) + bytes(body)
+
+
+def check(image, size=None):
+    """Validate the index as bsp_flash_assets_mount() does. Returns a list of problems."""
+    if len(image) < HEADER.size:
+        return ["image too small"]
+    magic, version, count, image_size, crc = HEADER.unpack_from(image, 0)
+    if magic != MAGIC or version != VERSION:
+        return ["not an asset partition of version %d" % VERSION]
+
+    problems = []
+    entries_end = HEADER.size + ENTRY.size * count
+    if image_size > len(image) or entries_end > image_size:
+        return ["image size %d does not match the file (%d bytes)" % (image_size, len(image))]
+    if size and image_size > size:
+        problems.append("image needs %d bytes, the partition has %d" % (image_size, size))
+    if zlib.crc32(image[HEADER.size:entries_end]) & 0xFFFFFFFF != crc:
+        problems.append("index CRC mismatch")
+
+    prev = None
+    for i in range(count):
+        raw_name, kind, fmt, width, height, _, stride, offset, length, _ = ENTRY.unpack_from(
+            image, HEADER.size + i * ENTRY.size)
+        name = raw_name.rstrip(b"\0")
+        label = name.decode(errors="replace")
+        if not name:
+            problems.append("entry %d has no name" % i)
+        if prev is not None and name <= prev:
+            problems.append("%s: entries are not sorted by name" % label)
+        if offset < entries_end or offset % ALIGN or offset + length > image_size:
+            problems.append("%s: data out of bounds" % label)
+        if kind == KIND_IMAGE:
+            bpp = BYTES_PER_PIXEL.get(fmt)
+            if bpp is None or width == 0 or height == 0 or stride < width * bpp or length != stride * height:
+                problems.append("%s: bad image geometry" % label)
+        elif kind not in KIND_NAMES:
+            problems.append("%s: unknown kind %d" % (label, kind))
+        prev = name
+        geometry = "%dx%d" % (width, height) if kind == KIND_IMAGE else ""
+        print("%-24s %-5s %-9s %8d bytes at 0x%06x" % (label, KIND_NAMES.get(kind, "?"), geometry, length, offset))
+    print("%d assets, %d bytes" % (count, image_size))
+    return problems
+
+
+def parse_size(text):
+    return int(text, 0)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="command", required=True)
+    p_build = sub.add_parser("build", help="build a partition image")
+    p_build.add_argument("files", nargs="+")
+    p_build.add_argument("-o", "--output", required=True)
+    p_build.add_argument("-s", "--size", type=parse_size, default=0, help="partition size, checked if given")
+    p_build.add_argument("-f", "--format", choices=PIXELS, help="pixel format of all images")
+    p_check = sub.add_parser("check", help="validate a partition image")
+    p_check.add_argument("image")
+    p_check.add_argument("-s", "--size", type=parse_size, default=0, help="partition size")
+    args = parser.parse_args()
+
+    if args.command == "check":
+        with open(args.image, "rb") as f:
+            problems = check(f.read(), args.size)
+    else:
+        assets = []
+        for path in args.files:
+            name, ext = os.path.splitext(os.path.basename(path))
+            if len(name.encode()) > NAME_LEN:
+                parser.error("%s: name longer than %d bytes" % (name, NAME_LEN))
+            ext = ext.lower()
+            if ext in IMAGE_EXT:
+                fmt, width, height, data = convert_image(path, PIXELS.get(args.format))
+                assets.append((name, KIND_IMAGE, fmt, width, height, data))
+            else:
+                with open(path, "rb") as f:
+                    data = f.read()
+                assets.append((name, KIND_FONT if ext in FONT_EXT else KIND_DATA, PIXEL_NONE, 0, 0, data))
+        if len({a[0] for a in assets}) != len(assets):
+            parser.error("asset names must be unique")
+        try:
+            image = build(assets, args.size)
+        except ValueError as e:
+            parser.error(str(e))
+        problems = check(image, args.size)
+        if not problems:
+            with open(args.output, "wb") as f:
+                f.write(image)
+
+    for problem in problems:
+        print("error: %s" % problem)
+    return 1 if problems else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())